@@ -41,6 +41,15 @@
 # Per ora e' hard-coded
 # Lo script produce anche il file genomic-exonforCCDS.txt degli esoni da RefSeq
 #
+# ATTENZIONE: il comportamento e' cambiato rispetto allo script originale
+# compact-compositions.pl. Le composizioni sono visitate in ordine di chiave
+# (e non nell'ordine casuale degli hash di Perl), cosi' il risultato e'
+# deterministico. L'ordine delle visite cambia gli esoni fusi e tagliati,
+# quindi build-ests.txt e le isoforme predette possono differire da quelle
+# dello script originale (gli output di riferimento in regressionTest sono
+# stati rigenerati).
+# Implementazione di riferimento del programma compact-compositions.
+#
 ####
 
 use Time::HiRes;
@@ -373,7 +382,7 @@ my @keys;
 #}
 #exit;
 
-@keys=keys %composition_hash;
+@keys=sort keys %composition_hash;
 foreach my $key(@keys){
     #print $key, "\n";
     my @temp_list=@{$composition_hash{$key}};
@@ -473,7 +482,7 @@ foreach my $key(@keys){
 #    }
 #}
 
-@keys=keys %composition_hash;
+@keys=sort keys %composition_hash;
 foreach my $key(@keys){
     #print $key, "\n";
     my @temp_list=@{$composition_hash{$key}};
@@ -655,7 +664,7 @@ my @print_exon_seq_list=();
  
 my $exon_index=0;
 
-@keys=keys %composition_hash;
+@keys=sort keys %composition_hash;
 my $min_left=$gen_length+1;
 my $max_right=0;
 
@@ -775,7 +784,7 @@ foreach my $key(@keys){
 #}
 #exit;
 
-my @keys_compositions=keys %print_compositions;
+my @keys_compositions=sort keys %print_compositions;
 print scalar(@keys_compositions), "\n"; #number of compositions
 print scalar(@print_exon_list), "\n";   #number of exons
 my $coverage_length=$max_right;
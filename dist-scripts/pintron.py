@@ -43,6 +43,8 @@ import pprint
 import traceback
 import csv
 import hashlib
+import copy
+import multiprocessing
 
 from optparse import OptionParser
 
@@ -211,12 +213,45 @@ def parse_command_line():
                       dest="max_factorization_memory", type="int", default=3000,
                       help="[Expert use only] Set a limit (in MiB) for the memory used by the factorization step"
                       " (default = 3000 MiB, approx. 3GB)")
+    parser.add_option("--threads",
+                      dest="threads", type="int", default=1,
+                      help="Number of threads used by the factorization step (default = 1)")
+    parser.add_option("--batch-manifest",
+                      dest="batch_manifest", default=None,
+                      help="FILE listing the loci to process in a single run, one per line: "
+                      "the locus ID (also the name of its output directory), the genomic file, "
+                      "the EST file and, optionally, the gene symbol (options -g, -s and -e are ignored)",
+                      metavar="MANIFEST_FILE")
+    parser.add_option("--in-process",
+                      dest="in_process", default=False, action="store_true",
+                      help="Compute the factorizations, the exon agreement, the intron agreement "
+                      "and the compaction of the compositions (steps 2-5) in a single process "
+                      "(program pintron-core), without writing the intermediate files "
+                      "(always enabled in batch mode)")
+    parser.add_option("--genomic-index",
+                      dest="genomic_index", default=None,
+                      help="File storing the index of the genomic sequence. "
+                      "It is reused by subsequent runs on the same genomic sequence (built if missing)")
+    parser.add_option("--genomic-index-type",
+                      dest="genomic_index_type", type="choice", choices=["tree", "array"],
+                      default="tree",
+                      help="Representation of the genomic index: 'tree' (suffix tree, faster) or "
+                      "'array' (enhanced suffix array, about 7 times less memory) (default = tree)")
     parser.add_option("--set-max-exon-agreement-time",
                       dest="max_exon_agreement_time", type="int", default=15,
                       help="[Expert use only] Set a time limit (in mins) for the exon agreement step")
     parser.add_option("--set-max-intron-agreement-time",
                       dest="max_intron_agreement_time", type="int", default=30,
                       help="[Expert use only] Set a time limit (in mins) for the intron agreement step")
+    parser.add_option("--max-isoforms",
+                      dest="max_isoforms", type="int", default=0,
+                      help="[Expert use only] Maximum number of maximal paths of the transcript graph "
+                      "considered when computing the full-length isoforms (default = 0, no limit)")
+    parser.add_option("--dag-paths",
+                      dest="dag_paths", default=False, action="store_true",
+                      help="[Expert use only] Also count the distinct full-length isoforms with a depth-first visit "
+                      "of the transcript graph (without keeping the breadth-first frontier in memory) and report "
+                      "the count in the log. The computed isoforms are the same as the default")
     parser.add_option("--pas-tolerance",
                       dest="pas_tolerance", type="int", default=30,
                       help="[Expert use only] Maximum allowed difference on the exon final coordinate to identify a PAS")
@@ -825,13 +860,11 @@ def pintron_pipeline(options):
 
     logging.debug("Using main program 'pintron' in dir '{}' (md5: {})".format(os.path.realpath(os.path.abspath(sys.argv[0])),
                                                                               md5Checksum(sys.argv[0])))
-    exes = check_executables(options.bindir, ["est-fact",
-                                             "min-factorization",
-                                             "intron-agreement",
-                                             "compact-compositions",
-                                             "maximal-transcripts",
-                                             "cds-annotation"
-                                             ])
+    exes = check_executables(options.bindir,
+                             (["pintron-core"] if options.in_process
+                              else ["est-fact", "min-factorization", "intron-agreement",
+                                    "compact-compositions"]) +
+                             ["maximal-transcripts", "cds-annotation"])
 
     if not os.path.isfile(options.genome_filename) or not os.access(options.genome_filename, os.R_OK):
         raise PIntronIOError(options.genome_filename,
@@ -872,58 +905,109 @@ def pintron_pipeline(options):
             cmd_label='cmd-1b-copy-ests',
             output_file='raw-multifasta-out.txt')
 
+    index_options = (" --threads=" + str(options.threads) +
+                     " --genomic-index-type=" + options.genomic_index_type +
+                     (" --genomic-index=" + os.path.abspath(options.genomic_index)
+                      if options.genomic_index else ""))
+
+    if options.in_process:
+        # Factorizations, exon agreement, intron prediction and transcript alignments
+        logging.info("STEPS 2-5:  Pre-aligning transcript data, predicting introns and "
+                     "computing the final transcript alignments...")
+
+        exec_system_command(
+            command="ulimit -t " + str(options.max_factorization_time * 60 * options.threads +
+                                       (options.max_exon_agreement_time +
+                                        options.max_intron_agreement_time) * 60) +
+            " && ulimit -v " + str(options.max_factorization_memory * 1024) + " && " +
+            exes["pintron-core"] + index_options +
+            " --max-exon-agreement-time=" + str(exon_agreement_search_time(options)),
+            error_comment="Could not compute the factorizations",
+            logfile=options.plogfile,
+            cmd_label='cmd-2-pintron-core',
+            output_file='build-ests.txt')
+
+        compute_gene_structure(options, exes, core_done=True)
+        return
+
     # Compute factorizations
     logging.info("STEP  2:  Pre-aligning transcript data...")
 
     exec_system_command(
-        command="ulimit -t " + str(options.max_factorization_time * 60) + " && ulimit -v " +
-        str(options.max_factorization_memory * 1024) + " && " + exes["est-fact"],
+        command="ulimit -t " + str(options.max_factorization_time * 60 * options.threads) +
+        " && ulimit -v " + str(options.max_factorization_memory * 1024) + " && " +
+        exes["est-fact"] + index_options,
         error_comment="Could not compute the factorizations",
         logfile=options.plogfile,
         cmd_label='cmd-2-est-fact',
         output_file='raw-multifasta-out.txt')
 
-    # Min factorization agreement
-    logging.info("STEP  3:  Computing a raw consensus gene structure...")
+    compute_gene_structure(options, exes)
 
-    exec_system_command(
-        command="ulimit -t " + str(options.max_exon_agreement_time * 60) + " && " +
-        exes["min-factorization"] + " < raw-multifasta-out.txt >out-agree.txt",
-        error_comment="Could not minimize the factorizations",
-        logfile=options.plogfile,
-        cmd_label='cmd-3-min-factorization',
-        output_file='out-agree.txt')
 
-    # Intron prediction
-    logging.info("STEP  4:  Predicting introns...")
+def exon_agreement_search_time(options):
+    """Returns the time limit (in seconds) of the search of the minimum factorization.
+    It is lower than the time limit of the exon agreement step, so that the
+    search is interrupted (and a greedy solution is used) before the process
+    is killed.
+    """
+    return max(1, options.max_exon_agreement_time * 60 * 9 // 10)
 
-    exec_system_command(
-        command="ulimit -t " + str(options.max_intron_agreement_time * 60) + " && " +
-        exes["intron-agreement"],
-        error_comment="Could not compute the factorizations",
-        logfile=options.plogfile,
-        cmd_label='cmd-4-intron-agreement',
-        output_file='out-after-intron-agree.txt')
 
-    # The computation of the full-length isoforms should not be avoided
-    # if options.step1:
-    #     sys.exit(0)
+def compute_gene_structure(options, exes, core_done=False):
+    """Executes the steps of the pipeline following the factorization (STEP 2)
+    on the files of the current directory.
+    If core_done is True, steps 3 to 5 have already been performed
+    (by pintron-core).
+    """
 
-    # Transform compositions into exons
-    logging.info("STEP  5:  Computing the final transcript alignments...")
+    if not core_done:
+        # Min factorization agreement
+        logging.info("STEP  3:  Computing a raw consensus gene structure...")
 
-    exec_system_command(
-        command=exes["compact-compositions"] + " < out-after-intron-agree.txt > build-ests.txt",
-        error_comment="Could not transform factorizations into exons",
-        logfile=options.plogfile,
-        cmd_label='cmd-5-compact-compositions',
-        output_file='build-ests.txt')
+        exec_system_command(
+            command="ulimit -t " + str(options.max_exon_agreement_time * 60) + " && " +
+            exes["min-factorization"] +
+            " --max-exon-agreement-time=" + str(exon_agreement_search_time(options)) +
+            " < raw-multifasta-out.txt >out-agree.txt",
+            error_comment="Could not minimize the factorizations",
+            logfile=options.plogfile,
+            cmd_label='cmd-3-min-factorization',
+            output_file='out-agree.txt')
+
+        # Intron prediction
+        logging.info("STEP  4:  Predicting introns...")
+
+        exec_system_command(
+            command="ulimit -t " + str(options.max_intron_agreement_time * 60) + " && " +
+            exes["intron-agreement"],
+            error_comment="Could not compute the factorizations",
+            logfile=options.plogfile,
+            cmd_label='cmd-4-intron-agreement',
+            output_file='out-after-intron-agree.txt')
+
+        # The computation of the full-length isoforms should not be avoided
+        # if options.step1:
+        #     sys.exit(0)
+
+        # Transform compositions into exons
+        logging.info("STEP  5:  Computing the final transcript alignments...")
+
+        exec_system_command(
+            command=exes["compact-compositions"] + " < out-after-intron-agree.txt > build-ests.txt",
+            error_comment="Could not transform factorizations into exons",
+            logfile=options.plogfile,
+            cmd_label='cmd-5-compact-compositions',
+            output_file='build-ests.txt')
 
     # Compute maximal transcripts
     logging.info("STEP  6:  Computing the final full-length isoforms...")
 
     exec_system_command(
-        command=exes["maximal-transcripts"] + " < build-ests.txt",
+        command=exes["maximal-transcripts"] +
+        (" --dag-paths" if options.dag_paths else "") +
+        (" --max-isoforms=" + str(options.max_isoforms) if options.max_isoforms > 0 else "") +
+        " < build-ests.txt",
         error_comment="Could not compute maximal transcripts",
         logfile=options.plogfile,
         cmd_label='cmd-6a-maximal-transcripts',
@@ -964,8 +1048,9 @@ def pintron_pipeline(options):
 
     if options.compress:
         exec_system_command("gzip -q9 " + " ".join([options.output_filename,
-                                                    options.plogfile,
-                                                    options.glogfile]),
+                                                    options.plogfile] +
+                                                   ([] if options.batch_manifest
+                                                    else [options.glogfile])),
                             error_comment="Could not compress final files",
                             logfile="/dev/null",
                             cmd_label='cmd-10-compress',
@@ -983,6 +1068,115 @@ def pintron_pipeline(options):
         subprocess.call("rm -f " + " ".join(tempfiles), shell=True)
 
 
+def read_batch_manifest(manifest_filename):
+    """Read the loci listed in the manifest.
+
+    Each non-empty line (except comments, starting with '#') contains the
+    locus ID, the genomic file, the EST file and, optionally, the gene symbol.
+    """
+
+    loci = []
+    with open(manifest_filename, mode='r', encoding='utf-8') as fd:
+        for lineno, line in enumerate(fd, start=1):
+            fields = line.split()
+            if not fields or fields[0].startswith('#'):
+                continue
+            if len(fields) not in (3, 4):
+                raise PIntronIOError(manifest_filename,
+                                     'Line {} is not a valid locus!'.format(lineno))
+            for filename in fields[1:3]:
+                if not os.path.isfile(filename) or not os.access(filename, os.R_OK):
+                    raise PIntronIOError(filename,
+                                         'Could not read file "' + filename + '"!')
+            loci.append({'id': fields[0],
+                         'dir': os.path.abspath(fields[0]),
+                         'genomic': os.path.abspath(fields[1]),
+                         'ests': os.path.abspath(fields[2]),
+                         'gene': fields[3] if len(fields) == 4 else fields[0]})
+    return loci
+
+
+def compute_locus_gene_structure(options, exes, locus):
+    """Executes the steps following the compaction of the compositions (STEP 5)
+    on a locus of the batch (in its own directory).
+
+    Returns the error message (None if the locus has been successfully processed).
+    """
+
+    os.chdir(locus['dir'])
+    locus_options = copy.copy(options)
+    locus_options.gene = locus['gene']
+    locus_options.genome_filename = 'genomic.txt'
+    try:
+        compute_gene_structure(locus_options, exes, core_done=True)
+    except Exception as err:
+        logging.exception("*** Error during the processing of locus %s! ***", locus['id'])
+        return str(err)
+    return None
+
+
+def pintron_batch_pipeline(options):
+    """Executes the pipeline on all the loci of the batch manifest.
+
+    Steps 2-5 (factorization, exon agreement, intron agreement and compaction
+    of the compositions) of all the loci are computed by a single run of
+    pintron-core, then the other steps are executed on options.threads loci
+    at a time.
+    The outputs of each locus are stored in a directory named after the locus.
+    """
+
+    logging.info("PIntron%s", pintron_version)
+    logging.info("Running: " + " ".join(sys.argv))
+
+    logging.info("STEP  1:  Checking executables and preparing input data...")
+    exes = check_executables(options.bindir, ["pintron-core",
+                                             "maximal-transcripts",
+                                             "cds-annotation"
+                                             ])
+    loci = read_batch_manifest(options.batch_manifest)
+    logging.info("Read %d loci from file '%s'.", len(loci), options.batch_manifest)
+
+    # The later steps read the genomic sequence from the current directory
+    core_manifest = "pintron-core-manifest.txt"
+    with open(core_manifest, mode='w', encoding='utf-8') as fd:
+        for locus in loci:
+            os.makedirs(locus['id'], exist_ok=True)
+            genomic_link = os.path.join(locus['id'], 'genomic.txt')
+            if os.path.lexists(genomic_link):
+                os.remove(genomic_link)
+            os.symlink(locus['genomic'], genomic_link)
+            fd.write("{}\t{}\t{}\n".format(locus['id'], locus['genomic'], locus['ests']))
+
+    logging.info("STEPS 2-5:  Pre-aligning transcript data, predicting introns and "
+                 "computing the final transcript alignments of %d loci...", len(loci))
+    exec_system_command(
+        command="ulimit -t " + str((options.max_factorization_time * 60 * options.threads +
+                                    (options.max_exon_agreement_time +
+                                     options.max_intron_agreement_time) * 60) * len(loci)) +
+        " && ulimit -v " + str(options.max_factorization_memory * 1024 * options.threads) + " && " +
+        exes["pintron-core"] + " --threads=" + str(options.threads) +
+        " --genomic-index-type=" + options.genomic_index_type +
+        " --max-exon-agreement-time=" + str(exon_agreement_search_time(options)) +
+        " --batch-manifest=" + core_manifest,
+        error_comment="Could not compute the factorizations",
+        logfile=options.plogfile,
+        cmd_label='cmd-2-pintron-core',
+        output_file='build-ests.txt')
+
+    logging.info("STEPS 6-10: Processing %d loci with %d workers...", len(loci), options.threads)
+    with multiprocessing.Pool(processes=options.threads) as pool:
+        errors = pool.starmap(compute_locus_gene_structure,
+                              [(options, exes, locus) for locus in loci])
+
+    failed = [locus['id'] for (locus, err) in zip(loci, errors) if err is not None]
+    if not options.no_clean:
+        subprocess.call("rm -f " + " ".join([core_manifest, "config-dump.ini", "info-pid-*.log"]),
+                        shell=True)
+    if failed:
+        raise PIntronError("Could not process the loci: " + ", ".join(failed))
+    logging.info("All the %d loci have been processed.", len(loci))
+
+
 def prepare_loggers(options):
     """Prepare loggers.
 
@@ -1014,7 +1208,10 @@ if __name__ == '__main__':
         else:
             options.version = pintron_version
         prepare_loggers(options)
-        pintron_pipeline(options)
+        if options.batch_manifest:
+            pintron_batch_pipeline(options)
+        else:
+            pintron_pipeline(options)
     except PIntronError as err:
         logging.exception("*** Fatal error caught during the execution of the pipeline! ***\n"
                           "%s", err)
@@ -39,25 +39,38 @@
 #define _AGREE_INTRONS_H_
 
 #include "types.h"
+#include "genomic-intron-registry.h"
 
 
 /*
- * Try the agreement of a intron to some intron inside the list
+ * Maximum distance (excluded) between the sites of an intron and the sites
+ * of the intron it is agreed to (on both sites or on a single site)
  */
+#define AGREEMENT_RANGE 12
+#define SINGLE_SITE_AGREEMENT_RANGE 16
 
-bool try_agreement_to_intron_list(char *, pintron, plist, int);
-bool try_agreement_to_intron_list_on_single_site(char *, pintron, plist, plist);
+/*
+ * Try the agreement of a intron to some intron inside the (indexed) list
+ */
+
+bool try_agreement_to_intron_list(char *, pintron, pgenomic_intron_index, int);
+bool try_agreement_to_intron_list_on_single_site(char *, pintron, pgenomic_intron_index, pgenomic_intron_registry);
 
 bool try_agreement(char *, pintron, pgenomic_intron, int);
 
-bool try_agreement_on_single_site(char *, pintron, pgenomic_intron, plist);
+/*
+ * Agree an intron to a genomic intron (the agreement must be admissible, see try_agreement)
+ */
+void agree_to_genomic_intron(char *, pintron, pgenomic_intron);
+
+bool try_agreement_on_single_site(char *, pintron, pgenomic_intron, pgenomic_intron_registry);
 
-bool try_agreement_on_donor_site(char *, pintron, pgenomic_intron, plist);
-bool try_agreement_on_acceptor_site(char *, pintron, pgenomic_intron, plist);
+bool try_agreement_on_donor_site(char *, pintron, pgenomic_intron, pgenomic_intron_registry);
+bool try_agreement_on_acceptor_site(char *, pintron, pgenomic_intron, pgenomic_intron_registry);
 
-bool find_better_intron(char *, pintron, plist);
+bool find_better_intron(char *, pintron, pgenomic_intron_registry);
 
-bool try_agreement_to_a_burset_frequency_list(char *, pintron, plist, plist, unsigned int);
+bool try_agreement_to_a_burset_frequency_list(char *, pintron, plist, pgenomic_intron_registry, unsigned int);
 
 /*
  * Set the two agree flags: (1) if the intron can be agreed and (2) what type of EST
@@ -68,14 +81,15 @@ pintron set_agree_flags(pintron);
 plist get_exon_composition_from_an_intron_composition(plist);
 
 /*
- * Returns a pintron list from a pfactor list and update the gen_intron_list
+ * Returns a pintron list from a pfactor list and update the registry of the genomic introns
  */
-plist get_intron_composition_from_an_exon_composition(pEST_info, int, char *, plist, plist, bool);
+plist get_intron_composition_from_an_exon_composition(pEST_info, int, char *, plist, pgenomic_intron_registry, bool);
 
 /*
- * Adds a genomic intron to a list e returns the updated list.
+ * Adds a genomic intron to the registry (or increments the number of its supporting ESTs
+ * if it is already present) and returns it.
  */
-plist add_genomic_intron(char *, plist, int, int, pgenomic_intron *);
+pgenomic_intron add_genomic_intron(char *, pgenomic_intron_registry, int, int);
 
 /*
  * Returns the error that the agreement (to an intron) would produce, but it does not perform any agreement
@@ -0,0 +1,111 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010,2012  Yuri Pirola, Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+/**
+ *
+ * @file arena.h
+ *
+ * Allocatore a regioni (arena) per oggetti transitori.
+ *
+ * Gli oggetti vengono allocati in blocchi contigui tramite un semplice
+ * incremento di puntatore e non vengono mai liberati singolarmente:
+ * tutta la memoria dell'arena viene rilasciata in un'unica operazione
+ * (arena_release o arena_destroy).
+ * E' usato per gli oggetti creati durante un singolo tentativo di
+ * fattorizzazione di un EST (pairing del MEG, nodi delle liste, embedding).
+ *
+ **/
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "util.h"
+
+#define ARENA_ALIGNMENT 8
+#define ARENA_MIN_CHUNK_SIZE (64*1024)
+#define ARENA_MAX_CHUNK_SIZE (16*1024*1024)
+
+typedef struct _arena_chunk* parena_chunk;
+
+struct _arena_chunk {
+  parena_chunk next;
+  size_t size;
+  char* data;
+};
+
+typedef struct _arena* parena;
+
+struct _arena {
+// Blocco corrente (in testa alla lista dei blocchi)
+  parena_chunk chunks;
+// Prima posizione libera e fine del blocco corrente
+  char* free;
+  char* end;
+// Dimensione del prossimo blocco da allocare
+  size_t next_chunk_size;
+// Byte allocati dall'ultimo rilascio
+  size_t allocated;
+};
+
+parena arena_create(void);
+
+/**
+ * Rilascia tutti gli oggetti allocati nell'arena.
+ * Il blocco piu' recente viene mantenuto per le allocazioni successive.
+ **/
+void arena_release(parena a);
+
+void arena_destroy(parena a);
+
+void* arena_alloc_slow(parena a, const size_t size);
+
+static inline
+void* arena_alloc(parena a, size_t size) {
+  my_assert(a!=NULL);
+  size= (size + (ARENA_ALIGNMENT-1)) & ~((size_t)ARENA_ALIGNMENT-1);
+  if ((size_t)(a->end - a->free) < size)
+	 return arena_alloc_slow(a, size);
+  void* p= a->free;
+  a->free+= size;
+  a->allocated+= size;
+  return p;
+}
+
+#define ARENA_PALLOC( a, type ) (type*)arena_alloc((a), sizeof(type))
+
+static inline
+size_t arena_size(const parena a) {
+  my_assert(a!=NULL);
+  return a->allocated;
+}
+
+#endif
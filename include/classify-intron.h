@@ -58,9 +58,37 @@
 
 #define _intron_type_str( c ) (((c)==_intron_U12)?"U12":(((c)==_intron_U2)?"U2":"ND"))
 
+/*
+ * Scoring engine of the classifier.
+ * The 10 PWMs (see LoadPWMMatrices for the indices) are loaded once and
+ * shared read-only by all the threads. For each motif the C vector is
+ * folded into the weights and the denominator (the max score) is
+ * precomputed, so that a window is scored in place on the genomic sequence
+ * with one table lookup and one addition per position.
+ */
+#define _PWM_NUMBER (10)
+
+typedef struct _pwm_model {
+	int length;
+	double *weight;	/* 4*length, weight[c*length+i]=CVector[i]*pwm[c*length+i] */
+	double den;		/* sum of CVector[i]*MAXVector[i] */
+} pwm_model;
+
+typedef struct _pwm_scorer* ppwm_scorer;
+
+struct _pwm_scorer {
+	double **pwm_matx;
+	double **CVector;
+	double **MAXVector;
+	pwm_model models[_PWM_NUMBER];
+};
+
+/*Returns the (never freed) scoring engine, building it at the first call*/
+const struct _pwm_scorer *get_pwm_scorer(void);
+
 plist classify_genomic_intron_list(char *, plist);
 pgenomic_intron classify_genomic_intron(char *, pgenomic_intron);
-char classify_genomic_intron_start_end(const char * const, int, int, double *, double *, int *, double *, double **, double **, double **);
+char classify_genomic_intron_start_end(const char * const, int, int, double *, double *, int *, double *);
 
 /*Compute the score of the 14-long input sequence wrt to 5' ss of type GT-AG (U12)
 ==> 3nt inside exon and 11nt inside intron*/
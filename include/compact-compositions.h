@@ -0,0 +1,51 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010  Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+#ifndef _COMPACT_COMPOSITIONS_H_
+#define _COMPACT_COMPOSITIONS_H_
+
+#include <stdio.h>
+
+/*
+ * Compact the exon compositions of the transcripts read from
+ * fcompositions (in the format of out-after-intron-agree.txt) and write
+ * the result in fout (in the format of build-ests.txt).
+ * The coordinates of the genomic region are read from the header of
+ * the genomic sequence in fgen, while the exons of the RefSeq
+ * transcripts are written in fccds (in the format of
+ * genomic-exonforCCDS.txt).
+ * The compositions are visited in lexicographic order of their keys,
+ * thus the output is the same of the script compact-compositions-perl.
+ * The files are left to the caller.
+ */
+void
+compact_compositions(FILE* fgen, FILE* fcompositions,
+							FILE* fout, FILE* fccds);
+
+#endif
@@ -36,15 +36,17 @@
 
 #include "types.h"
 #include "my_time.h"
+#include "io-multifasta.h"
 #include "configuration.h"
 
 #include "aug_suffix_tree.h"
+#include "gen-index.h"
 
 
 pEST
 compute_est_fact(pEST_info gen,
 					  pEST_info est,
-					  LST_STree* tree,
+					  const pgen_index idx,
 					  ppreproc_gen pg,
 					  FILE* floginfoext,
 					  FILE* fmeg, FILE* fpmeg, FILE* ftmeg,
@@ -52,5 +54,95 @@ compute_est_fact(pEST_info gen,
 					  pmytime pt_alg, pmytime pt_comp, pmytime pt_io,
 					  pconfiguration shared_config);
 
+/*
+ * Factorize a transcript. If no valid factorization is found and the strand
+ * is not fixed, then the reverse and complement rev_est (if not NULL) is
+ * factorized.
+ * Valid factorizations are written on f_multif_out and the factorized
+ * sequence on est_multif_out.
+ * If fact_ests (fact_infos) is not NULL, the same factorizations (factorized
+ * sequence) are also added to it, as they would be read back from
+ * f_multif_out (est_multif_out); see add_multifasta_output.
+ */
+void
+compute_transcript_fact(pEST_info gen,
+								pEST_info est,
+								pEST_info rev_est,
+								const pgen_index idx,
+								ppreproc_gen pg,
+								FILE* floginfoext,
+								FILE* fmeg, FILE* fpmeg, FILE* ftmeg,
+								FILE* fintronic,
+								FILE* f_multif_out, FILE* est_multif_out,
+								plist fact_ests, plist fact_infos,
+								pmytime pt_alg, pmytime pt_comp, pmytime pt_io,
+								pconfiguration shared_config);
+
+
+// Number of transcripts read for each thread before a parallel factorization
+#define TRANSCRIPTS_PER_THREAD_BATCH (256)
+
+pEST_info copy_and_reverse(pEST_info est);
+
+/*
+ * Read the next transcript and prepare it (and its reverse and complement,
+ * if its strand is not fixed) for the factorization.
+ * Return false at the end of the file.
+ */
+bool
+read_next_transcript(pmultifasta_reader reader, pEST_info gen, pmytime pt_io,
+							pEST_info* pest, pEST_info* prev_est);
+
+/*
+ * Map the genomic index from index_file (if given and valid), otherwise
+ * build it (and save it, if a file is given).
+ */
+pgen_index
+get_genomic_index(const ppreproc_gen pg, pconfiguration config,
+						const char* const index_file,
+						FILE* floginfo, pmytime pt_st, pmytime pt_alg);
+
+
+/*
+ * The input and output files of a locus (see option batch-manifest).
+ */
+struct _locus {
+// Directory of the output files (NULL for the current directory)
+  char* out_dir;
+  char* gen_file;
+  char* ests_file;
+// File of the genomic index (NULL if the index is not stored)
+  char* index_file;
+};
+
+/*
+ * Path of the file name in the directory dir (the current directory if
+ * dir is NULL).
+ */
+char*
+locus_path(const char* const dir, const char* const name);
+
+/*
+ * Create the output directory of the locus (if needed).
+ */
+void
+create_locus_dir(const struct _locus* const locus);
+
+/*
+ * Open the output file name of the locus.
+ */
+FILE*
+open_locus_output(const struct _locus* const locus, const char* const name);
+
+/*
+ * Read the loci listed in the manifest filename (see option batch-manifest).
+ * The number of loci is stored in *pn_loci.
+ */
+struct _locus*
+read_batch_manifest(const char* const filename, size_t* const pn_loci);
+
+void
+batch_manifest_destroy(struct _locus* loci, const size_t n_loci);
+
 
 #endif
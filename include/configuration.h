@@ -36,6 +36,12 @@
 
 #include <stdbool.h>
 
+// The representations of the index of the genomic sequence
+typedef enum {
+  GENOMIC_INDEX_SUFFIX_TREE= 0,
+  GENOMIC_INDEX_SUFFIX_ARRAY= 1
+} genomic_index_type;
+
 struct _configuration {
 
 // Minimum lenght of a factor (l)
@@ -132,6 +138,35 @@ struct _configuration {
   //has a dust score greater than this value, then the exon is "low complex".
   //Suggested value: 20.0 (see ASPicDB)
   double complexity_threshold;
+
+  //The number of threads used for factorizing the transcripts
+  //and for the intron agreement.
+  //The value 1 disables the parallel computation.
+  unsigned int num_threads;
+
+  //The file storing the preprocessed index of the genomic sequence.
+  //If NULL, the index is built in memory and not saved.
+  char* genomic_index_file;
+
+  //If true, the genomic index is built and saved, but the transcripts
+  //are not factorized.
+  bool build_genomic_index_only;
+
+  //The representation of the genomic index.
+  //The suffix array requires much less memory than the suffix tree.
+  genomic_index_type genomic_index_type;
+
+  //The file listing the loci to factorize in batch mode.
+  //If NULL, the (single) locus in the current directory is factorized.
+  char* batch_manifest_file;
+
+  //If true, pintron-core also writes the intermediate files of the
+  //separate programs of the pipeline.
+  bool dump_intermediate_files;
+
+  //The time limit (in seconds) of the search of the minimum factorization
+  //in the exon agreement (0 means no limit).
+  unsigned int max_exon_agreement_time;
 };
 
 typedef struct _configuration* pconfiguration;
@@ -43,13 +43,14 @@
 #include "int_list.h"
 #include "configuration.h"
 #include "my_time.h"
+#include "meg-csr.h"
 
 //Include
 
 //Computa per data una EST tutte le fattorizzazioni ammissibili a partire
-//dal grafo degli embedding massimali (pext_array)
+//dal grafo degli embedding massimali (insieme dei vertici e archi)
 //pEST get_EST_factorizations(pconfiguration, pEST_info, pext_array);
-pEST get_EST_factorizations(pEST_info, pext_array, pconfiguration, pEST_info,
+pEST get_EST_factorizations(pEST_info, pext_array, const pcsr_meg, pconfiguration, pEST_info,
 									 pmytime_timeout);
 
 void print_split_string_on_stderr(const int, char*);
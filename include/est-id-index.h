@@ -0,0 +1,115 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010,2012  Yuri Pirola, Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+/**
+ *
+ * @file est-id-index.h
+ *
+ * Hash index of objects (usually pEST_info) on their identifiers (usually
+ * the EST ids).
+ *
+ * The identifiers are not copied, so they must not change or be freed
+ * while the index is used.
+ * More objects can have the same identifier: they are kept in insertion
+ * order, est_id_index_find returns the first one and est_id_index_take
+ * returns each of them once, in insertion order.
+ *
+ **/
+
+#ifndef _EST_ID_INDEX_H_
+#define _EST_ID_INDEX_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+struct _est_id_index_entry {
+  const char* id;
+  void* value;
+  size_t hash;
+// Next entry in the same bucket (only for the first entry of each identifier)
+  size_t next;
+// Next entry with the same identifier
+  size_t next_duplicate;
+// Last entry and first entry not yet taken with the same identifier
+// (only for the first entry of each identifier)
+  size_t last_duplicate;
+  size_t first_not_taken;
+};
+
+struct _est_id_index {
+  size_t n_entries;
+  size_t n_ids;
+  size_t capacity;
+  struct _est_id_index_entry* entries;
+  size_t n_buckets;
+// First entry of each bucket
+  size_t* buckets;
+};
+
+typedef struct _est_id_index* pest_id_index;
+
+pest_id_index
+est_id_index_create(void);
+
+void
+est_id_index_destroy(pest_id_index idx);
+
+/**
+ *
+ * Add the object @p value with identifier @p id to the index.
+ * Return false if another object with the same identifier was already
+ * present.
+ *
+ **/
+bool
+est_id_index_add(pest_id_index idx, const char* const id, void* const value);
+
+/**
+ *
+ * Return the first object with identifier @p id (NULL if there is none).
+ *
+ **/
+void*
+est_id_index_find(pest_id_index idx, const char* const id);
+
+/**
+ *
+ * Return the first object with identifier @p id not returned by a
+ * previous call (NULL if there is none).
+ *
+ **/
+void*
+est_id_index_take(pest_id_index idx, const char* const id);
+
+static inline size_t
+est_id_index_size(const pest_id_index idx) {
+  return idx->n_entries;
+}
+
+#endif /* _EST_ID_INDEX_H_ */
@@ -0,0 +1,118 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010,2012  Yuri Pirola, Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+/**
+ *
+ * @file gen-index-esa.h
+ *
+ * Enhanced suffix array representation of the genomic index
+ * (see gen-index.h).
+ *
+ * The index of a text of n characters (terminated by '\0') stores the
+ * suffix array of the n+1 suffixes, the LCP array and the child table of
+ * Abouelhoda, Kurtz and Ohlebusch (Replacing suffix trees with enhanced
+ * suffix arrays, J. of Discrete Algorithms 2, 2004), which allows to
+ * navigate the lcp-intervals as the nodes of the suffix tree.
+ * About 11 bytes per character are required.
+ *
+ * Internal to gen-index.c: use the functions of gen-index.h.
+ *
+ **/
+
+#ifndef _GEN_INDEX_ESA_H_
+#define _GEN_INDEX_ESA_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gen-index.h"
+
+/*
+ * Construction
+ */
+
+// Build the suffix array of the n suffixes of text (text[n-1] must be the
+// unique smallest character) with the SA-IS algorithm of Nong, Zhang and
+// Chan (2009).
+void
+esa_build_suffix_array(const char* const text, const uint32_t n,
+							  uint32_t* const sa);
+
+// Build the LCP array of the n suffixes (Kasai et al., 2001).
+// The values that do not fit in lcp are returned as a (sorted) array of
+// *n_exc pairs (index, value).
+uint32_t*
+esa_build_lcp(const char* const text, const uint32_t n,
+				  const uint32_t* const sa,
+				  uint8_t* const lcp, uint32_t* const n_exc);
+
+// Build the child table and the single chars of the intervals.
+// The text, the suffix array and the LCP array of idx must be already set.
+void
+esa_build_child_table(const pgen_index idx, uint32_t* const cld);
+
+void
+esa_build_single_chars(const pgen_index idx, char* const sc);
+
+/*
+ * Navigation (see gen-index.h)
+ */
+
+gen_node
+esa_root(const pgen_index idx);
+
+size_t
+esa_depth(const pgen_index idx, const gen_node v);
+
+size_t
+esa_parent_depth(const pgen_index idx, const gen_node v);
+
+gen_node
+esa_parent(const pgen_index idx, const gen_node v);
+
+bool
+esa_find_kid(const pgen_index idx, const gen_node v, const size_t depth,
+				 const char c, gen_node* const kid);
+
+char
+esa_single_char(const pgen_index idx, const gen_node v);
+
+gen_node
+esa_suffix_link(const pgen_index idx, const gen_node v, const size_t depth);
+
+void
+esa_for_each_occurrence(const pgen_index idx,
+								const gen_node v,
+								const gen_node* const block,
+								const size_t skip_k,
+								gen_occurrence_function f,
+								void* data);
+
+#endif /* _GEN_INDEX_ESA_H_ */
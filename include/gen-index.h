@@ -0,0 +1,289 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010,2012  Yuri Pirola, Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+/**
+ *
+ * @file gen-index.h
+ *
+ * Index of the genomic sequence used to build the vertex set of the MEGs.
+ *
+ * Two representations are available:
+ *  - GENOMIC_INDEX_SUFFIX_TREE: a pointer-free copy of the preprocessed
+ *    suffix tree.  The nodes are numbered in breadth-first order (the root
+ *    is node 0), so that the children of a node are stored contiguously.
+ *  - GENOMIC_INDEX_SUFFIX_ARRAY: an enhanced suffix array (suffix array,
+ *    LCP array and child table).  The nodes of the (implicit) suffix tree
+ *    are the lcp-intervals [lb, rb] of the suffix array.
+ *
+ * The whole index is kept in a single buffer whose layout is the same of
+ * the binary file, hence a saved index can be memory-mapped and used
+ * without any further processing.
+ *
+ * When the index is neither saved nor loaded, the preprocessed libstree
+ * suffix tree is used directly (see gen_index_create_on_stree), so that
+ * the tree and its flat copy are never allocated at the same time.
+ *
+ * The nodes are accessed only through the gen_index_* functions, which
+ * hide the representation.
+ *
+ **/
+
+#ifndef _GEN_INDEX_H_
+#define _GEN_INDEX_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "aug_suffix_tree.h"
+#include "configuration.h"
+
+// The root of the suffix tree representation
+#define GEN_INDEX_ROOT 0
+#define GEN_INDEX_NONE ((uint32_t)UINT32_MAX)
+
+// Incrementare ad ogni modifica del formato del file
+#define GEN_INDEX_VERSION 2
+
+// LCP values greater or equal to GEN_INDEX_LCP_ESCAPE are stored apart
+#define GEN_INDEX_LCP_ESCAPE 255
+
+struct _gen_index_node {
+// The parent of the node (GEN_INDEX_NONE for the root)
+  uint32_t parent;
+// The suffix link (GEN_INDEX_NONE if the node does not have one)
+  uint32_t suffix_link;
+// The children are first_kid, ..., first_kid+n_kids-1
+  uint32_t first_kid;
+  uint32_t n_kids;
+// The label of the edge entering the node is
+// text[edge_start], ..., text[edge_start+edge_len-1]
+  uint32_t edge_start;
+  uint32_t edge_len;
+  uint32_t string_depth;
+// The slices of the node are slices[slices], ..., slices[slices+2*alph_size-1]
+// (GEN_INDEX_NONE if string_depth < min_string_depth)
+  uint32_t slices;
+// The first character of the edge label ('\0' for the terminator)
+  char first_char;
+// See LST_Node
+  char single_char;
+};
+
+struct _gen_index {
+  genomic_index_type type;
+  uint32_t gen_len;
+  uint32_t alph_size;
+// The genomic sequence ('\0'-terminated)
+  const char* text;
+
+// Suffix tree representation
+  uint32_t n_nodes;
+// Only the nodes whose string depth is at least min_string_depth have the slices
+  uint32_t min_string_depth;
+  const struct _gen_index_node* nodes;
+  const uint32_t* slices;
+  const uint32_t* occs;
+
+// Suffix array representation.
+// The suffixes are gen_len+1 (the last one is the terminator only).
+// The key (see get_key) of each symbol
+  const uint32_t* keys;
+  const uint32_t* sa;
+// lcp[i] is the length of the longest common prefix of the suffixes
+// sa[i-1] and sa[i] (or GEN_INDEX_LCP_ESCAPE, see lcp_exc)
+  const uint8_t* lcp;
+// Pairs (i, lcp of i) sorted by i for the LCP values that do not fit in lcp
+  uint32_t n_lcp_exc;
+  const uint32_t* lcp_exc;
+// Child table (up, down and next l-index values stored in a single array)
+  const uint32_t* cld;
+// For each internal lcp-interval, the single_char (see LST_Node)
+// stored at the position of its first l-index
+  const char* sc;
+
+// The libstree suffix tree (and its string set) used directly as the index
+// (NULL if the index is stored in the buffer)
+  LST_STree* tree;
+  LST_StringSet* tree_strings;
+
+// The buffer (allocated or memory-mapped) that stores the index
+  void* buffer;
+  size_t buffer_size;
+  bool mapped;
+};
+
+typedef struct _gen_index* pgen_index;
+
+// A node of the index: the node id (lb) for the suffix tree representation,
+// the lcp-interval [lb, rb] for the suffix array representation, the
+// address of the LST_Node (split in lb and rb) for the libstree tree.
+typedef struct _gen_node {
+  uint32_t lb;
+  uint32_t rb;
+} gen_node;
+
+/**
+ *
+ * Build the suffix tree representation of the index from the suffix tree
+ * @p tree of the genomic sequence.
+ * The tree must have been already preprocessed by stree_preprocess (with
+ * the same @p pg and @p config) and it can be destroyed afterwards.
+ *
+ **/
+pgen_index
+gen_index_create_from_stree(LST_STree* tree,
+									 const ppreproc_gen pg,
+									 const pconfiguration config);
+
+/**
+ *
+ * Use the suffix tree @p tree of the genomic sequence as the index,
+ * without flattening it.
+ * The tree must have been already preprocessed by stree_preprocess (with
+ * the same @p pg and @p config).  The index takes the ownership of the tree
+ * and of its string set @p set, which are destroyed by gen_index_destroy.
+ * The genomic sequence of @p pg must not be freed before the index.
+ * The index cannot be saved.
+ *
+ **/
+pgen_index
+gen_index_create_on_stree(LST_STree* tree,
+								  LST_StringSet* set,
+								  const ppreproc_gen pg,
+								  const pconfiguration config);
+
+/**
+ *
+ * Build the suffix array representation of the index of the genomic
+ * sequence of @p pg (the suffix tree is not needed).
+ *
+ **/
+pgen_index
+gen_index_create_suffix_array(const ppreproc_gen pg);
+
+/**
+ *
+ * Save the index to file @p filename.
+ * The file is written to a temporary file which is then renamed, so that
+ * concurrent processes never map a partially written index.
+ *
+ * @return true if the index has been saved (false if the index is the
+ * libstree tree).
+ *
+ **/
+bool
+gen_index_save(const pgen_index idx, const char* const filename);
+
+/**
+ *
+ * Memory-map the index stored in file @p filename.
+ *
+ * @return the index or NULL if the file does not exist, it has been
+ * written by an incompatible version, or it has not been built from the
+ * genomic sequence of @p pg with the representation (and, for suffix
+ * trees, the minimum factor length) of @p config.
+ *
+ **/
+pgen_index
+gen_index_load(const char* const filename,
+					const ppreproc_gen pg,
+					const pconfiguration config);
+
+void
+gen_index_destroy(pgen_index idx);
+
+
+/*
+ * Navigation of the (possibly implicit) suffix tree.
+ */
+
+gen_node
+gen_index_root(const pgen_index idx);
+
+bool
+gen_index_is_root(const pgen_index idx, const gen_node v);
+
+// The string depth of node v
+size_t
+gen_index_depth(const pgen_index idx, const gen_node v);
+
+// The string depth of the parent of node v (0 for the root)
+size_t
+gen_index_parent_depth(const pgen_index idx, const gen_node v);
+
+gen_node
+gen_index_parent(const pgen_index idx, const gen_node v);
+
+// The child of node v (whose string depth is depth) whose edge label
+// starts with c.
+// Return false if such a child does not exist.
+bool
+gen_index_find_kid(const pgen_index idx, const gen_node v, const size_t depth,
+						 const char c, gen_node* const kid);
+
+// The symbol that precedes all the occurrences of the subtree of v
+// ('\0' if there are more symbols or if the subtree contains the first suffix).
+char
+gen_index_single_char(const pgen_index idx, const gen_node v);
+
+// The label of the edge entering node v (whose parent has string depth
+// parent_depth).
+const char*
+gen_index_edge_label(const pgen_index idx, const gen_node v,
+							const size_t parent_depth);
+
+// The node reached by the suffix link of the ancestor of v (or v itself)
+// whose string depth is depth (> 0).
+gen_node
+gen_index_suffix_link(const pgen_index idx, const gen_node v,
+							 const size_t depth);
+
+typedef void (*gen_occurrence_function)(void* data,
+													 const uint32_t t,
+													 const size_t k,
+													 const bool before_block);
+
+// Call f on each occurrence t of the subtree of node v, except the
+// occurrences of the subtree of block (if not NULL), with the key k of
+// the preceding symbol.  Occurrences preceded by the symbol of key skip_k
+// are not reported.
+// The first suffix (t=0) is reported once for each key.
+// The occurrences that precede the block (in the order of the index) are
+// marked by before_block.  If the block does not contain occurrences with
+// key k, all the occurrences with key k are marked as before_block.
+void
+gen_index_for_each_occurrence(const pgen_index idx,
+										const gen_node v,
+										const gen_node* const block,
+										const size_t skip_k,
+										gen_occurrence_function f,
+										void* data);
+
+#endif /* _GEN_INDEX_H_ */
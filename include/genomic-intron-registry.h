@@ -0,0 +1,197 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010,2012  Yuri Pirola, Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+/**
+ *
+ * @file genomic-intron-registry.h
+ *
+ * Registry of the genomic introns induced by the transcripts.
+ *
+ * The introns are kept in a list (the most recently inserted first, as the
+ * list of genomic introns previously used by the intron agreement), in a
+ * hash table keyed by (start, end) and in an array sorted by (start, end)
+ * for range queries. The array is sorted again only when needed, i.e. when
+ * it is requested after some insertions.
+ * The coordinates of the introns must not change after their insertion.
+ *
+ **/
+
+#ifndef _GENOMIC_INTRON_REGISTRY_H_
+#define _GENOMIC_INTRON_REGISTRY_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "types.h"
+#include "list.h"
+
+struct _genomic_intron_registry {
+// Length of the genomic sequence
+  size_t gen_length;
+// The genomic introns, the most recently inserted first
+  plist introns;
+  size_t n_introns;
+// Hash table (open addressing) on (start, end)
+  pgenomic_intron* table;
+  size_t table_size;
+// The genomic introns sorted by (start, end) (if is_sorted)
+  pgenomic_intron* sorted;
+  size_t sorted_capacity;
+  bool is_sorted;
+};
+
+typedef struct _genomic_intron_registry* pgenomic_intron_registry;
+
+pgenomic_intron_registry
+genomic_intron_registry_create(const size_t gen_length);
+
+/**
+ *
+ * Destroy the registry and the genomic introns it contains.
+ *
+ **/
+void
+genomic_intron_registry_destroy(pgenomic_intron_registry reg);
+
+/**
+ *
+ * Return the genomic intron from @p start to @p end (NULL if it does not
+ * exist).
+ *
+ **/
+pgenomic_intron
+genomic_intron_registry_find(pgenomic_intron_registry reg,
+									  const int start, const int end);
+
+/**
+ *
+ * Add the genomic intron @p gen_intron (which must not be already present)
+ * to the registry.
+ *
+ **/
+void
+genomic_intron_registry_insert(pgenomic_intron_registry reg,
+										 pgenomic_intron gen_intron);
+
+/**
+ *
+ * Return the array of the genomic introns sorted by (start, end).
+ * The array is valid until the next insertion.
+ *
+ **/
+pgenomic_intron*
+genomic_intron_registry_sorted(pgenomic_intron_registry reg);
+
+/**
+ *
+ * Return the position in the sorted array of the first genomic intron
+ * not lower than (@p start, @p end) (the number of introns if no such
+ * intron exists).
+ *
+ **/
+size_t
+genomic_intron_registry_lower_bound(pgenomic_intron_registry reg,
+												const int start, const int end);
+
+static inline size_t
+genomic_intron_registry_size(const pgenomic_intron_registry reg) {
+  return reg->n_introns;
+}
+
+/**
+ *
+ * Index of a list of genomic introns (a list of ppointer to pgenomic_intron)
+ * that allows to retrieve the introns whose start and/or end are close to
+ * given positions, in the same order they appear in the list.
+ *
+ **/
+
+struct _genomic_intron_index_entry {
+  pgenomic_intron intron;
+// Position of the intron in the indexed list
+  size_t rank;
+};
+
+struct _genomic_intron_index {
+  size_t n_introns;
+// The entries sorted by (start, rank) and by (end, rank)
+  struct _genomic_intron_index_entry* by_start;
+  struct _genomic_intron_index_entry* by_end;
+// The result of the last query
+  struct _genomic_intron_index_entry* candidates;
+  size_t n_candidates;
+};
+
+typedef struct _genomic_intron_index* pgenomic_intron_index;
+
+pgenomic_intron_index
+genomic_intron_index_create(plist gen_intron_pointer_list);
+
+void
+genomic_intron_index_destroy(pgenomic_intron_index idx);
+
+/**
+ *
+ * Find the indexed introns such that both (if @p on_both_sites) or at least
+ * one (otherwise) of the distances |intron->start - @p start| and
+ * |intron->end - @p end| are lower than @p range.
+ * The candidates are sorted as in the indexed list and they can be accessed
+ * with genomic_intron_index_candidate until the next query.
+ * Return the number of candidates.
+ *
+ **/
+size_t
+genomic_intron_index_query(pgenomic_intron_index idx,
+									const int start, const int end,
+									const int range, const bool on_both_sites);
+
+/**
+ *
+ * Same as genomic_intron_index_query, but the candidates are stored in
+ * @p candidates (which must have room for all the indexed introns), so that
+ * the index can be queried by more threads at the same time.
+ *
+ **/
+size_t
+genomic_intron_index_query_into(const pgenomic_intron_index idx,
+										  const int start, const int end,
+										  const int range, const bool on_both_sites,
+										  struct _genomic_intron_index_entry* const candidates);
+
+static inline size_t
+genomic_intron_index_n_introns(const pgenomic_intron_index idx) {
+  return idx->n_introns;
+}
+
+static inline pgenomic_intron
+genomic_intron_index_candidate(const pgenomic_intron_index idx, const size_t i) {
+  return idx->candidates[i].intron;
+}
+
+#endif /* _GENOMIC_INTRON_REGISTRY_H_ */
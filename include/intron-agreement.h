@@ -0,0 +1,60 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010  Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+#ifndef _INTRON_AGREEMENT_H_
+#define _INTRON_AGREEMENT_H_
+
+#include <stdio.h>
+
+#include "types.h"
+#include "list.h"
+#include "my_time.h"
+
+/*
+ * Compute the agreement of the introns induced by the factorizations in
+ * est_with_intron_list (a list of pEST, as read by read_factorizations)
+ * on the genomic sequence gen (not N-trimmed).
+ * estinfo_list is the list of the pEST_info of the transcripts (as read by
+ * read_multifasta).
+ * The agreed factorizations are written in f_multif_out and the predicted
+ * introns in gtf_out.
+ * Both the lists are consumed, while gen and the files are left to the caller.
+ * The introns are classified and agreed using n_threads threads (the result
+ * does not depend on n_threads).
+ */
+void
+compute_intron_agreement(pEST_info gen,
+								 plist estinfo_list,
+								 plist est_with_intron_list,
+								 FILE* f_multif_out, FILE* gtf_out,
+								 FILE* floginfo,
+								 pmytime pt_pre, pmytime pt_alg, pmytime pt_io,
+								 const unsigned int n_threads);
+
+#endif
@@ -31,7 +31,11 @@
 #include "ext_array.h"
 #include "list.h"
 #include "types.h"
+#include "meg-csr.h"
 
 pext_array meg_read(FILE *);
 
 void meg_write(FILE*, pext_array );
+
+// Scrive nello stesso formato di meg_write il MEG compatto
+void meg_write_csr(FILE*, const pcsr_meg );
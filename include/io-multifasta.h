@@ -28,6 +28,8 @@
  *
  **/
 //Header file for IO-MULTIFASTA.c
+#ifndef _IO_MULTIFASTA_H_
+#define _IO_MULTIFASTA_H_
 
 #include <stdio.h>
 #include "list.h"
@@ -40,6 +42,38 @@
 */
 plist read_multifasta(FILE* );
 
+/*
+  Streaming reader of files in MULTIFASTA format.
+  The file is read in blocks and each call to multifasta_reader_next
+  returns the next record as views on the internal buffer (the id is the
+  header without '>', the sequence is the concatenation of its lines).
+  The views are valid until the next call, and the memory used is bounded
+  by the length of the longest record.
+*/
+typedef struct _multifasta_reader* pmultifasta_reader;
+
+typedef struct _multifasta_record* pmultifasta_record;
+
+struct _multifasta_record {
+  const char* id;
+  size_t id_len;
+  const char* seq;
+  size_t seq_len;
+};
+
+pmultifasta_reader multifasta_reader_create(FILE* );
+
+bool multifasta_reader_next(pmultifasta_reader, pmultifasta_record);
+
+/*
+  Returns a new pEST_info with the next record (NULL at the end of the file).
+  The sequence is copied once: original_EST_seq shares the memory of
+  EST_seq until the latter is modified (polyA/T substitution, N tails removal).
+*/
+pEST_info multifasta_reader_next_EST_info(pmultifasta_reader);
+
+void multifasta_reader_destroy(pmultifasta_reader);
+
 /*
   Receives a plist and a file opened in write mode and prints
   data contained in the plist
@@ -57,6 +91,26 @@ void write_multifasta(plist , FILE* );
 */
 void write_multifasta_output(pEST_info, pEST , FILE* , char);
 
+/*
+  Same as write_multifasta_output, but the factorizations are added to the
+  list of pEST as read_factorizations would read them from the file
+  (1-based coordinates, consecutive factorizations of the same EST grouped
+  in a single pEST).
+*/
+void add_multifasta_output(pEST_info, pEST, plist, char);
+
+/*
+  Move the pEST of the second list (built by add_multifasta_output) to the
+  tail of the first one, grouping the factorizations of the same EST.
+*/
+void append_factorized_ESTs(plist, plist);
+
+/*
+  Returns a copy of the pEST_info as read_multifasta would read it from
+  the output of write_single_EST_info.
+*/
+pEST_info copy_EST_info_as_read(pEST_info);
+
 pEST_info read_single_EST_info(FILE*);
 
 void write_single_EST_info(FILE*, pEST_info);
@@ -83,3 +137,4 @@ void polyAT_substitution(pEST_info);
 
 void Ntails_removal(pEST_info);
 
+#endif
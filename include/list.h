@@ -33,12 +33,19 @@
  *
  * A data structure that represents a linked list of generic items.
  *
+ * The nodes of the heap-allocated lists and the heap iterators are
+ * recycled through a per-thread pool of at most LIST_POOL_SIZE objects
+ * (define LIST_POOL_SIZE to 0 to disable the pool).
+ * The *_stack iterator functions do not allocate at all and should be
+ * preferred in new code.
+ *
  **/
 
 #ifndef _LIST_H_
 #define _LIST_H_
 
 #include "generic.h"
+#include "arena.h"
 #include <stdbool.h>
 #include <stddef.h>
 
@@ -48,6 +55,13 @@ typedef struct _listit* plistit;
 
 plist list_create(void);
 
+/*
+ * Crea una lista la cui struttura e i cui nodi sono allocati nell'arena @p a.
+ * I nodi non vengono mai deallocati singolarmente: la memoria viene
+ * recuperata solo al rilascio dell'arena.
+ */
+plist list_create_in_arena(parena a);
+
 void list_destroy(plist, delete_function);
 
 void list_add_to_head(plist, item);
@@ -152,6 +166,12 @@ int relaxed_list_contained(plist, plist, relaxed_comparator, int);
  */
 int relaxed_list_compare(plist, plist, relaxed_comparator, int);
 
+/*
+ * Releases the nodes and the iterators kept in the pool of the calling thread.
+ * It should be called by a thread before terminating.
+ */
+void list_pool_trim(void);
+
 /**
  * List iterator definitions
  **/
@@ -167,10 +187,16 @@ void list_first_reuse(plist const l, plistit* pli);
 
 plistit list_last(plist l);
 
+static inline
+void list_last_stack(plist const l, plistit pli);
+
 void list_last_reuse(plist const l, plistit* pli);
 
 plistit listit_copy(plistit li);
 
+static inline
+void listit_copy_stack(const plistit const li, plistit pli);
+
 void listit_copy_reuse(plistit const li, plistit* prli);
 
 static inline
@@ -204,6 +230,8 @@ struct _node {
 struct _list {
   _pnode sentinel;
   size_t size;
+// Arena da cui provengono i nodi (NULL se allocati sullo heap)
+  parena arena;
 };
 
 struct _listit {
@@ -213,6 +241,11 @@ struct _listit {
   struct _list* l;
 };
 
+// Allocazione e deallocazione (tramite il pool) degli iteratori sullo heap
+plistit _listit_alloc(void);
+
+void _listit_free(plistit li);
+
 static inline
 size_t list_size(plist l) {
   NOT_NULL(l);
@@ -222,7 +255,7 @@ size_t list_size(plist l) {
 static inline
 plistit list_first(const plist const l) {
   my_assert(l!=NULL);
-  plistit li= PALLOC(struct _listit);
+  plistit li= _listit_alloc();
   li->l= l;
   const _pnode const sentinel= l->sentinel;
   li->next= sentinel->next;
@@ -245,7 +278,7 @@ void list_first_reuse(plist l, plistit* pli) {
   my_assert(l!=NULL);
   plistit li= NULL;
   if (*pli == NULL) {
-	 li= PALLOC(struct _listit);
+	 li= _listit_alloc();
 	 *pli= li;
   } else {
 	 li= *pli;
@@ -256,10 +289,26 @@ void list_first_reuse(plist l, plistit* pli) {
   li->sentinel= l->sentinel;
 }
 
+static inline
+void list_last_stack(plist const l, plistit pli) {
+  my_assert(l!=NULL);
+  pli->l= l;
+  const _pnode const sentinel= l->sentinel;
+  pli->next= sentinel;
+  pli->prev= sentinel->prev;
+  pli->sentinel= sentinel;
+}
+
+static inline
+void listit_copy_stack(const plistit const li, plistit pli) {
+  my_assert(li!=NULL);
+  *pli= *li;
+}
+
 static inline
 void listit_destroy(plistit li) {
   if (li!=NULL)
-	 pfree(li);
+	 _listit_free(li);
 }
 
 static inline
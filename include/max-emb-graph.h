@@ -40,6 +40,9 @@
 #include "configuration.h"
 #include "ext_array.h"
 #include "aug_suffix_tree.h"
+#include "gen-index.h"
+#include "arena.h"
+#include "meg-csr.h"
 
 #define PAIRING( P ) P->p, P->t, P->l
 
@@ -47,13 +50,38 @@
 int
 compute_gl(pconfiguration config);
 
+/**
+ * Costruisce l'insieme dei vertici del MEG.
+ * I pairing e le liste Vi sono allocati nell'arena @p arena, che deve
+ * essere rilasciata solo dopo la distruzione del MEG.
+ **/
 pext_array
 build_vertex_set(pEST_info pattern,
-					  LST_STree* tree,
+					  const pgen_index idx,
 					  const ppreproc_gen const pg,
-					  pconfiguration config);
+					  pconfiguration config,
+					  parena arena);
 
-void
+/**
+ * Restituisce una copia (allocata in @p arena) dell'insieme dei vertici
+ * @p V0 con i soli pairing lunghi almeno @p min_factor_len.
+ * Se @p V0 e' stato costruito da build_vertex_set con un min-factor-len
+ * non superiore, il risultato coincide con quello di build_vertex_set
+ * invocata con @p min_factor_len (le rimozioni dei pairing a bassa
+ * complessita' sono sempre causate da pairing non piu' corti), ma non
+ * richiede nuove interrogazioni dell'indice.
+ **/
+pext_array
+filter_vertex_set(const pext_array V0,
+						const size_t min_factor_len,
+						parena arena);
+
+/**
+ * Costruisce l'insieme degli archi del MEG con insieme dei vertici @p V.
+ * Gli archi sono memorizzati soltanto nella rappresentazione compatta
+ * restituita (con i pairing nell'ordine del MEG).
+ **/
+pcsr_meg
 build_edge_set(pext_array V,
 					pconfiguration config
 					)
@@ -63,7 +91,7 @@ build_edge_set(pext_array V,
   ;
 
 void
-add_intronic_edges_to_file(FILE* f, pext_array V);
+add_intronic_edges_to_file(FILE* f, pext_array V, const pcsr_meg meg);
 
 // Funzione per la creazione del sorgente dot di un MEG.
 // Abilitata solo se LOG_GRAPHS e' definito, altrimenti non compie nulla.
@@ -71,10 +99,10 @@ add_intronic_edges_to_file(FILE* f, pext_array V);
 // Vedere file .c per parametri di formattazione
 
 void
-save_meg_to_filename(pext_array V, const char* const filename);
+save_meg_to_filename(pext_array V, const pcsr_meg meg, const char* const filename);
 
 void
-print_meg(pext_array V, FILE* f);
+print_meg(pext_array V, const pcsr_meg meg, FILE* f);
 
 
 #endif /* _MAX-EMB-GRAPH_H_ */
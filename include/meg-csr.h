@@ -0,0 +1,178 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010,2012  Yuri Pirola, Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+/**
+ *
+ * @file meg-csr.h
+ *
+ * Compact (CSR-like) representation of a MEG.
+ *
+ * The pairings are stored in a flat array (in the order of the MEG, i.e.
+ * by position on the EST) and the adjacencies and the incidences of all
+ * the pairings are stored as indices in two contiguous arrays.
+ * It is the only representation of the edges of a MEG: the vertex set is
+ * still given by the lists V[i] of pairings, while the pairings of the MEG
+ * have no lists of adjacents and incidents.
+ *
+ * The edges of a pairing can be added and removed (preserving the order of
+ * the others). When the block of a pairing is full, it is moved to the end
+ * of the array, hence the arrays may contain unused slots until
+ * csr_meg_pack is called.
+ *
+ **/
+
+#ifndef _MEG_CSR_H_
+#define _MEG_CSR_H_
+
+#include <stddef.h>
+
+#include "types.h"
+#include "ext_array.h"
+
+// The edges of the pairing i are edges[first[i]], ..., edges[first[i]+size[i]-1]
+// and the block of i has room for capacity[i] edges.
+struct _csr_edges {
+  unsigned int* first;
+  unsigned int* size;
+  unsigned int* capacity;
+  unsigned int* edges;
+// Used and allocated length of edges
+  size_t len;
+  size_t alloc;
+};
+
+struct _csr_meg {
+  size_t n_pairings;
+  size_t n_edges;
+// The pairings. It holds pairings[i]->id == i
+  ppairing* pairings;
+  size_t alloc_pairings;
+// The adjacents of each pairing
+  struct _csr_edges adj;
+// The incidents of each pairing
+  struct _csr_edges inc;
+};
+
+typedef struct _csr_meg* pcsr_meg;
+
+/**
+ *
+ * Build the compact representation of the vertex set @p V, without edges.
+ *
+ * Remark: It modifies the field id of the pairings.
+ *
+ * @param V The vertex set of the MEG.
+ * @return The compact representation of @p V.
+ *
+ **/
+pcsr_meg
+csr_meg_create(pext_array V);
+
+void
+csr_meg_destroy(pcsr_meg meg);
+
+/**
+ *
+ * Add the pairing @p p (without edges) to @p meg.
+ * It does not add @p p to the vertex set.
+ *
+ * @return The id of @p p.
+ *
+ **/
+unsigned int
+csr_meg_add_pairing(pcsr_meg meg, ppairing p);
+
+/**
+ *
+ * Add the edge (@p i, @p j), i.e. @p j to the tail of the adjacents of @p i
+ * and @p i to the tail of the incidents of @p j.
+ *
+ **/
+void
+csr_meg_add_edge(pcsr_meg meg, const unsigned int i, const unsigned int j);
+
+/**
+ *
+ * Remove the edge from @p i to its @p k-th adjacent.
+ *
+ **/
+void
+csr_meg_remove_adj(pcsr_meg meg, const unsigned int i, const unsigned int k);
+
+/**
+ *
+ * Remove all the edges incident to or from @p i.
+ *
+ **/
+void
+csr_meg_isolate_pairing(pcsr_meg meg, const unsigned int i);
+
+/**
+ *
+ * Remove all the edges of @p meg.
+ *
+ **/
+void
+csr_meg_clear_edges(pcsr_meg meg);
+
+/**
+ *
+ * Renumber the pairings in the order of the vertex set @p V, discarding
+ * those that are not in @p V (which must not have edges), and store the
+ * edges of each pairing contiguously and in order.
+ * If @p V is NULL, the pairings and their order are kept.
+ *
+ * Remark: It modifies the field id of the pairings.
+ *
+ **/
+void
+csr_meg_pack(pcsr_meg meg, pext_array V);
+
+
+static inline size_t
+csr_meg_n_adjs(const pcsr_meg meg, const unsigned int i) {
+  return meg->adj.size[i];
+}
+
+static inline unsigned int
+csr_meg_adj(const pcsr_meg meg, const unsigned int i, const unsigned int k) {
+  return meg->adj.edges[meg->adj.first[i] + k];
+}
+
+static inline size_t
+csr_meg_n_incs(const pcsr_meg meg, const unsigned int i) {
+  return meg->inc.size[i];
+}
+
+static inline unsigned int
+csr_meg_inc(const pcsr_meg meg, const unsigned int i, const unsigned int k) {
+  return meg->inc.edges[meg->inc.first[i] + k];
+}
+
+#endif /* _MEG_CSR_H_ */
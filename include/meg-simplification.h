@@ -44,114 +44,103 @@
 
 #include "ext_array.h"
 #include "configuration.h"
+#include "arena.h"
+#include "meg-csr.h"
 
 /**
  * This file contains procedures that simplifies the CMEG graph by removing unnecessary
  * edges (w.r.t. the spliced alignment problem).
+ *
+ * The CMEG is given by its vertex set @p V and its (compact) edge set @p meg.
+ * Every procedure leaves the pairings of @p meg in the order of @p V.
  ***/
 
-typedef pext_array pgraph;
-
 
 /**
  *
- * Return the number of vertexes and edges of the CMEG @p V.
+ * Return the number of vertexes and edges of the CMEG @p meg.
  *
- * @param V The CMEG to analyse.
+ * @param meg The CMEG to analyse.
  * @param tot_pairings (output) the number of vertexes
  * @param tot_edges (output) the number of edges
  *
  **/
-void MEG_stats(pext_array V, size_t* tot_pairings, size_t* tot_edges);
+void MEG_stats(const pcsr_meg meg, size_t* tot_pairings, size_t* tot_edges);
 
 /**
  *
- * Decide if the CMEG @p V is too complex to perform the compact short edges.
+ * Decide if the CMEG @p meg is too complex to perform the compact short edges.
  *
- * @param V The CMEG to analyse.
+ * @param meg The CMEG to analyse.
  * @param config The configuration structure
  *
  **/
 bool
-is_too_complex_for_compaction(pext_array V, pconfiguration config);
+is_too_complex_for_compaction(const pcsr_meg meg, pconfiguration config);
 
 /**
  *
- * Decide if the CMEG @p V is too complex.
+ * Decide if the CMEG (@p V, @p meg) is too complex.
  *
- * @param V The CMEG to analyse.
+ * @param V The vertex set of the CMEG to analyse.
+ * @param meg The CMEG to analyse.
  * @param config The configuration structure
  *
  **/
 bool
-is_too_complex(pext_array V, pconfiguration config);
+is_too_complex(pext_array V, const pcsr_meg meg, pconfiguration config);
 
 /**
  *
- * Remove edges and vertices from the CMEG @p V that cannot be reached from the
- * source or that cannot reach the sink.
+ * Remove edges and vertices from the CMEG (@p V, @p meg) that cannot be
+ * reached from the source or that cannot reach the sink.
  *
- * @param V The CMEG to simplify.
+ * @param V The vertex set of the CMEG to simplify.
+ * @param meg The CMEG to simplify.
  *
  **/
 void
-remove_other_sources_and_sinks(pext_array V);
+remove_other_sources_and_sinks(pext_array V, pcsr_meg meg);
 
 /**
  *
- * Remove edges from the CMEG @p V that cannot corresponds to mutations nor introns
+ * Remove edges from the CMEG (@p V, @p meg) that cannot corresponds to mutations nor introns
  * because of their length.
  *
- * @param V The CMEG to simplify.
+ * @param V The vertex set of the CMEG to simplify.
+ * @param meg The CMEG to simplify.
  * @param config The configuration structure
  *
  **/
 void
-remove_useless_edges(pext_array V, pconfiguration config);
+remove_useless_edges(pext_array V, pcsr_meg meg, pconfiguration config);
 
 
-void
-compact_short_edges(pext_array V, pconfiguration config);
-
 /**
  *
- * Apply simplification procedures of the CMEG @p V.
- *
- * @param V The CMEG to simplify.
- * @param config The configuration structure
+ * Replace the edges of the CMEG (@p V, @p meg) with small gaps by new
+ * pairings, which are allocated in @p arena.
  *
  **/
 void
-simplify_meg(pext_array V, pconfiguration config);
+compact_short_edges(pext_array V, pcsr_meg meg, pconfiguration config, parena arena);
 
 /**
  *
- * Transforms the (C)MEG @p meg into a "normal" graph intended as an extendible array
- * of ppairing.
- * It enforces arr[i]->id= i
+ * Apply simplification procedures of the CMEG (@p V, @p meg).
  *
- * @param meg The (C)MEG to transform.
- * @return An extendible array containing the vertex set of the MEG graph.
- *
- **/
-pgraph
-meg2graph(pext_array meg);
-
-/**
- *
- * Destroy the graph @p graph without freeing the memory of vertices, adjacencies, and
- * incidencies lists.
- * @param graph the graph to destroy.
+ * @param V The vertex set of the CMEG to simplify.
+ * @param meg The CMEG to simplify.
+ * @param config The configuration structure
  *
  **/
 void
-graph_destroy(pgraph graph);
+simplify_meg(pext_array V, pcsr_meg meg, pconfiguration config);
 
 /**
  *
  * Perform a DFS visit of the graph @p G.
  *
- * Remark: It may modify the field id of the pairings.
  * Note: Outbound array parameters are automatically allocated if NULLs.
  *
  * @param G The graph to visit.
@@ -163,33 +152,34 @@ graph_destroy(pgraph graph);
  *
  **/
 void
-dfs_visit(pgraph G, int** out_dtime, int** out_ftime, int** out_topological_ids, bool* out_is_acyclic);
+dfs_visit(const pcsr_meg G, int** out_dtime, int** out_ftime, int** out_topological_ids, bool* out_is_acyclic);
 
 /**
  *
  * Perform a topological sort of the graph @p G.
- * The result is stored in the field id of the ppairing.
+ * The result is stored in the array @p out_order (allocated by the
+ * procedure): (*out_order)[k] is the id of the k-th vertex.
  *
  * @param G The graph to sort.
+ * @param out_order The vertices in topological order (out).
  * @param out_is_acyclic The flag that indicates if the graph is acyclic (out). The
  * sorting process is not valid if @p out_is_acyclic is false.
  *
  **/
 void
-topological_sort(pgraph G, bool* out_is_acyclic);
+topological_sort(const pcsr_meg G, unsigned int** out_order, bool* out_is_acyclic);
 
 /**
  *
  * Perform a transitive reduction of the acyclic graph @p G.
+ * The adjacents of each vertex are left in topological order.
  *
  * Remark: The digraph @p G must be acyclic, otherwise it fails.
  *
- * @param G The graph to sort.
- * @param out_is_acyclic The flag that indicates if the graph is acyclic (out). The
- * sorting process is not valid if @p out_is_acyclic is false.
+ * @param G The graph to reduce.
  *
  **/
 void
-transitive_reduction(pgraph G);
+transitive_reduction(pcsr_meg G);
 
 #endif /* !__MEG_SIMPLIFICATION_H__ */
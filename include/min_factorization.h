@@ -40,8 +40,43 @@
 
 void print_factorizations_result(pbit_vect,plist,plist,psimpl);
 
+/*
+ * Same as print_factorizations_result, but the chosen factorizations are
+ * returned as a new list of pEST (as read_factorizations would read them
+ * from the printed output).
+ */
+plist get_factorizations_result(pbit_vect,plist,plist,psimpl);
+
+/*
+ * Build the colored matrix of the factorizations of the list of pEST,
+ * simplify it and compute the minimum set of factors.
+ * The unique factors and the simplification are returned in the
+ * parameters; the result (NULL if no search was needed) must be passed to
+ * print_factorizations_result or get_factorizations_result.
+ * The last parameter is the time limit of the search (see min_fact_anytime).
+ */
+pbit_vect compute_min_factorization(plist, plist*, psimpl*, const unsigned int);
+
+/*
+ * Execute the whole exon agreement on the list of pEST (compute_min_factorization
+ * and get_factorizations_result). The input list is not destroyed.
+ */
+plist min_factorization_agreement(plist, const unsigned int);
+
+/*
+ * Compute a minimum set of factors such that every EST of the (simplified)
+ * colored matrix has a factorization using only those factors.
+ * The result is the same of the exhaustive search of create_combinations.
+ */
 pbit_vect min_fact(plist);
 
+/*
+ * Same as min_fact, but if max_search_time (in seconds) is positive and the
+ * search does not terminate in time, a (not necessarily minimum) solution
+ * computed greedily is returned.
+ */
+pbit_vect min_fact_anytime(plist, const unsigned int);
+
 plist color_matrix_simplified_create(plist, psimpl);
 
 void color_matrix_simplified_destroy(plist);
@@ -81,6 +81,10 @@ MYTIME_start_parallel(pmytime pt);
 void
 MYTIME_reset(pmytime pt);
 
+// Add the time elapsed on timer src to timer pt
+void
+MYTIME_add(pmytime pt, pmytime src);
+
 void
 MYTIME_stop(pmytime pt);
 
@@ -0,0 +1,181 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010,2012  Yuri Pirola, Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+/**
+ *
+ * @file nucleotide-codes.h
+ *
+ * Constant tables shared by the modules that inspect the nucleotides:
+ * numeric codes, complements, dinucleotide codes and Burset frequencies
+ * of the intron patterns.
+ *
+ * The codes are 1+the 2-bit code of A, C, G and T (case insensitive),
+ * NT_N for 'N' and 'n', and NT_OTHER (0) for the other symbols.
+ *
+ * It also defines the packed representation of a (genomic) sequence, that
+ * stores the 2-bit codes of the nucleotides, the runs of N and the runs of
+ * lowercase symbols (the N mask and the case mask), and the positions of
+ * the other symbols.
+ * Since the masks are stored as runs, a sequence takes about 2 bits per
+ * symbol (4 times less than the string).
+ *
+ **/
+
+#ifndef _NUCLEOTIDE_CODES_H_
+#define _NUCLEOTIDE_CODES_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define NT_OTHER 0
+#define NT_A 1
+#define NT_C 2
+#define NT_G 3
+#define NT_T 4
+#define NT_N 5
+
+// The dinucleotides of A, C, G and T are coded by 0, ..., 15 (AA, AC, ..., TT)
+// and all the others by NT_DINUCLEOTIDE_OTHER
+#define NT_DINUCLEOTIDES 16
+#define NT_DINUCLEOTIDE_OTHER NT_DINUCLEOTIDES
+
+extern const unsigned char nt_code_table[256];
+
+// The complement of each IUPAC symbol, preserving the case (0 for the
+// symbols that are their own complement)
+extern const char nt_complement_table[256];
+
+// Burset frequency of the introns with donor and acceptor dinucleotides
+// (0 for the patterns never observed)
+extern const int burset_frequency_table[NT_DINUCLEOTIDES][NT_DINUCLEOTIDES];
+
+static inline unsigned int
+nt_code(const char c) {
+  return nt_code_table[(unsigned char)c];
+}
+
+static inline bool
+nt_is_acgt(const unsigned int code) {
+  return (code-NT_A) < 4;
+}
+
+static inline bool
+nt_is_N(const char c) {
+  return nt_code(c) == NT_N;
+}
+
+static inline char
+nt_complement(const char c) {
+  const char comp= nt_complement_table[(unsigned char)c];
+  return (comp != 0) ? comp : c;
+}
+
+static inline unsigned int
+dinucleotide_code(const char c1, const char c2) {
+  const unsigned int x1= nt_code(c1);
+  const unsigned int x2= nt_code(c2);
+  if (!nt_is_acgt(x1) || !nt_is_acgt(x2))
+	 return NT_DINUCLEOTIDE_OTHER;
+  return ((x1-NT_A) << 2) | (x2-NT_A);
+}
+
+/**
+ *
+ * Burset frequency of the intron whose donor (resp. acceptor) dinucleotide
+ * is @p donor (resp. @p acceptor); only the first two symbols are read.
+ *
+ **/
+static inline int
+burset_frequency(const char* const donor, const char* const acceptor) {
+  const unsigned int d= dinucleotide_code(donor[0], (donor[0] != '\0') ? donor[1] : '\0');
+  const unsigned int a= dinucleotide_code(acceptor[0], (acceptor[0] != '\0') ? acceptor[1] : '\0');
+  if ((d == NT_DINUCLEOTIDE_OTHER) || (a == NT_DINUCLEOTIDE_OTHER))
+	 return 0;
+  return burset_frequency_table[d][a];
+}
+
+/*
+ * Packed sequences
+ */
+
+// Run [start, end) of symbols
+struct _nt_run {
+  size_t start;
+  size_t end;
+};
+
+// Symbol (not A, C, G, T or N) in position pos
+struct _nt_exception {
+  size_t pos;
+  char symbol;
+};
+
+struct _packed_seq {
+  size_t length;
+// 2-bit codes of the symbols, 32 for each word (0 for N and the exceptions)
+  uint64_t* codes;
+// N mask
+  struct _nt_run* N_runs;
+  size_t n_N_runs;
+// Case mask
+  struct _nt_run* lower_runs;
+  size_t n_lower_runs;
+// Symbols that are not nucleotides (or N), with their case
+  struct _nt_exception* exceptions;
+  size_t n_exceptions;
+};
+
+typedef struct _packed_seq* ppacked_seq;
+
+ppacked_seq
+packed_seq_create(const char* const seq);
+
+void
+packed_seq_destroy(ppacked_seq pseq);
+
+// Memory (in bytes) occupied by the packed sequence
+size_t
+packed_seq_size(const ppacked_seq pseq);
+
+// Symbol in position pos (with its case)
+char
+packed_seq_get(const ppacked_seq pseq, const size_t pos);
+
+// Copy the len symbols starting from position start in dest (which must hold
+// len+1 characters, since it is terminated by '\0')
+void
+packed_seq_unpack_range(const ppacked_seq pseq, const size_t start,
+								const size_t len, char* const dest);
+
+// The sequence as a newly allocated string
+char*
+packed_seq_unpack(const ppacked_seq pseq);
+
+#endif /* _NUCLEOTIDE_CODES_H_ */
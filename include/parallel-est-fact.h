@@ -0,0 +1,79 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010,2012  Yuri Pirola, Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+/**
+ *
+ * @file parallel-est-fact.h
+ *
+ * Multi-threaded factorization of a set of transcripts.
+ *
+ **/
+
+#ifndef _PARALLEL_EST_FACT_H_
+#define _PARALLEL_EST_FACT_H_
+
+#include <stdio.h>
+
+#include "types.h"
+#include "list.h"
+#include "my_time.h"
+#include "configuration.h"
+
+#include "aug_suffix_tree.h"
+#include "gen-index.h"
+
+
+/*
+ * Factorize the transcripts of est_list using config->num_threads threads.
+ *
+ * est_list must contain each transcript immediately followed by its reverse
+ * and complement if (and only if) its strand is not fixed.
+ * Transcripts are distributed among the threads, each owning a double-ended
+ * queue of jobs; an idle thread steals jobs from the back of the queue of
+ * another thread.
+ * The output of each transcript is buffered and written in the input order,
+ * hence the output files are the same produced by the sequential procedure
+ * (compute_transcript_fact).
+ * The in-memory factorizations (if fact_ests and fact_infos are not NULL)
+ * are collected in the same order.
+ */
+void
+compute_transcripts_fact_parallel(pEST_info gen,
+											 plist est_list,
+											 const pgen_index idx,
+											 ppreproc_gen pg,
+											 FILE* floginfoext,
+											 FILE* fmeg, FILE* fpmeg, FILE* ftmeg,
+											 FILE* fintronic,
+											 FILE* f_multif_out, FILE* est_multif_out,
+											 plist fact_ests, plist fact_infos,
+											 pmytime pt_alg, pmytime pt_comp, pmytime pt_io,
+											 pconfiguration config);
+
+#endif
@@ -0,0 +1,109 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010,2012  Yuri Pirola, Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+/**
+ *
+ * @file parallel-intron-agreement.h
+ *
+ * Multi-threaded classification and agreement of the introns.
+ *
+ * The genomic introns are classified independently by a pool of threads.
+ * The agreement to a list of genomic introns (a pass) is performed in two
+ * phases: first the threads compute the agreement errors of each intron
+ * to its candidates, then the agreements are committed sequentially in the
+ * order of the list using the precomputed errors.
+ * The errors of an intron are used only if its factors (donor and
+ * acceptor) have not been modified by the agreement of another intron of
+ * the same transcript since they were computed, otherwise they are
+ * computed again. Hence the result is the same of the sequential
+ * procedure.
+ *
+ **/
+
+#ifndef _PARALLEL_INTRON_AGREEMENT_H_
+#define _PARALLEL_INTRON_AGREEMENT_H_
+
+#include <stdbool.h>
+
+#include "types.h"
+#include "list.h"
+#include "genomic-intron-registry.h"
+
+typedef struct _agreement_pool* pagreement_pool;
+
+/*
+ * Create a pool of n_threads threads (the calling thread included).
+ */
+pagreement_pool
+agreement_pool_create(const unsigned int n_threads);
+
+void
+agreement_pool_destroy(pagreement_pool pool);
+
+/*
+ * Classify the genomic introns of the list (as classify_genomic_intron_list).
+ */
+void
+classify_genomic_intron_list_parallel(pagreement_pool pool,
+												  char* genomic_sequence,
+												  plist gen_intron_list);
+
+typedef struct _agreement_pass* pagreement_pass;
+
+/*
+ * Compute the errors of the agreement (on both sites, see try_agreement) of
+ * the introns of intron_list (a list of ppointer to pintron) to the genomic
+ * introns of target.
+ * If only_supported is true, only the genomic introns supported by some EST
+ * are considered; if only_better is true, only the genomic introns with a
+ * greater Burset frequency than the intron to be agreed are considered.
+ * The introns already agreed are skipped.
+ */
+pagreement_pass
+agreement_pass_create(pagreement_pool pool,
+							 char* genomic_sequence,
+							 plist intron_list,
+							 pgenomic_intron_index target,
+							 const int allowed_error,
+							 const bool only_supported,
+							 const bool only_better);
+
+/*
+ * Try to agree the i-th intron of the list of the pass to the first
+ * admissible genomic intron of the target. Return true if the intron has
+ * been agreed.
+ * The introns must be tried in the order of the list.
+ */
+bool
+agreement_pass_try(pagreement_pass pass, const size_t i);
+
+void
+agreement_pass_destroy(pagreement_pass pass);
+
+#endif
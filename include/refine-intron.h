@@ -53,14 +53,14 @@ int Check_Burset_patterns(char *, int, int);
 int getBursetFrequency_adaptor(const char* const t,
 										 const size_t cut1, const size_t cut2);
 
-int getBursetFrequency(char *, char *);
+int getBursetFrequency(const char *, const char *);
 
 //Returns a list of gap alignments
 plist compute_gap_alignment(char *, char *, bool, int, int, int);
 
-void ComputeGapAlignMatrix(char *, char *, char **, char **, char **, char *, bool);
+void ComputeGapAlignMatrix(const char *, const char *, const size_t, const size_t, char *, char *);
 
-void TracebackGapAlignment(size_t, pgap_alignment, char *, char *, char **, char **, char **, int, int, char);
+void TracebackGapAlignment(size_t, pgap_alignment, char *, char *, const char *, int, int, char);
 
 void Find_AG_after_on_the_right(pgap_alignment, int, int *, int *, int *);
 
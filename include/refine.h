@@ -81,6 +81,29 @@ unsigned int*
 edit_distance(const char* const s1, const size_t ls1,
 				  const char* const s2, const size_t ls2);
 
+/**
+ * Compute the edit distance between s1 and s2 (same costs of
+ * edit_distance) without building the matrix, using a bit-parallel
+ * algorithm. The result is equal to the last cell of the matrix
+ * returned by edit_distance.
+ **/
+unsigned int
+bp_edit_distance(const char* const s1, const size_t ls1,
+					  const char* const s2, const size_t ls2);
+
+/**
+ * Find a longest common factor of s1 and s2 with a bit-parallel algorithm.
+ * If n_always_match is true, 'n' and 'N' match any symbol.
+ * The occurrence returned is the same of the quadratic dynamic programming
+ * (the one ending first on s1 and then on s2).
+ **/
+void
+bp_longest_common_factor(const char* const s1, const size_t l1,
+								 const char* const s2, const size_t l2,
+								 const bool n_always_match,
+								 size_t* const pocc1, size_t* const pocc2,
+								 size_t* const plen);
+
 
 
 #endif /* !_REFINE_H_ */
@@ -189,9 +189,10 @@ struct _pairing {
   int p;
   int t;
   int l;
-  plist adjs; //Lista degli adiacenti
-  plist incs; //Lista degli incidenti
+  plist adjs; //Lista degli adiacenti (NULL nei pairing dei MEG, vedi meg-csr.h)
+  plist incs; //Lista degli incidenti (NULL nei pairing dei MEG, vedi meg-csr.h)
   bool visited;
+  bool arena_allocated; //Allocato in un'arena (non va deallocato singolarmente)
   int number_of_visits;
 };
 
@@ -317,6 +318,7 @@ plist embedding_create(void);
 void embedding_destroy(plist embedding);
 
 ppairing pairing_create(void);
+ppairing pairing_create_in_arena(parena a);
 void pairing_destroy(ppairing p);
 void pairing_destroy_2(ppairing p);
 
@@ -0,0 +1,53 @@
+#!/bin/bash
+#
+# Compare the output of compact-compositions with the one of the
+# reference Perl script compact-compositions-perl.
+#
+# Usage: compare-compact-compositions.sh BINDIR [TESTDIR...]
+#
+# Each TESTDIR must contain genomic.txt and out-after-intron-agree.txt
+# (as left by the regression tests, that run pintron with -k).
+# If no TESTDIR is given, all the directories of regressionTest that
+# contain such files are checked.
+
+if [ $# -lt 1 ]; then
+    echo "Usage: $0 BINDIR [TESTDIR...]" >&2
+    exit 2
+fi
+
+BINDIR=`cd "$1" && pwd`
+shift
+
+if [ $# -eq 0 ]; then
+    set -- `dirname "$0"`/*/
+fi
+
+TMPDIR=`mktemp -d`
+trap 'rm -rf "$TMPDIR"' EXIT
+
+STATUS=0
+for TESTDIR in "$@"; do
+    if [ ! -f "$TESTDIR/genomic.txt" ] || [ ! -f "$TESTDIR/out-after-intron-agree.txt" ]; then
+        continue
+    fi
+    NAME=`basename "$TESTDIR"`
+    for IMPL in perl c; do
+        mkdir -p "$TMPDIR/$IMPL"
+        cp "$TESTDIR/genomic.txt" "$TMPDIR/$IMPL/"
+    done
+    ( cd "$TMPDIR/perl" && \
+        "$BINDIR/compact-compositions-perl" < "$TESTDIR/out-after-intron-agree.txt" > build-ests.txt 2> /dev/null )
+    ( cd "$TMPDIR/c" && \
+        "$BINDIR/compact-compositions" < "$TESTDIR/out-after-intron-agree.txt" > build-ests.txt 2> /dev/null )
+    RESULT="OK"
+    for FILE in build-ests.txt genomic-exonforCCDS.txt; do
+        if ! cmp -s "$TMPDIR/perl/$FILE" "$TMPDIR/c/$FILE"; then
+            RESULT="DIFFERENT ($FILE)"
+            STATUS=1
+        fi
+    done
+    echo "$NAME: $RESULT"
+    rm -rf "$TMPDIR/perl" "$TMPDIR/c"
+done
+
+exit $STATUS
@@ -114,6 +114,9 @@ char* returnInfoNextToPattern(char *f1,char *str,int num){
 }
 
 int compareJson(char f1[],char f2[]){
+	//reference output in the current format (with file_format_version): the files must be equal
+	if(returnInfoNextToPattern(f1,"file_format_version",1)[0]!='E')
+		return compare(f1,f2);
 	int c1=!strcmp(returnInfoNextToPattern(f1,"sequence_id",1),returnInfoNextToPattern(f2,"sequence_id",1));
 	int c2=!strcmp(returnInfoNextToPattern(f1,"strand",1),returnInfoNextToPattern(f2,"strand",1));
 	int c6=!strcmp(returnInfoNextToPattern(f1,"acceptor alignment average error",1),returnInfoNextToPattern(f2,"acceptor_alignment_error",1));
@@ -34,6 +34,7 @@
 #include "my_time.h"
 #include "log.h"
 #include "util.h"
+#include "est-id-index.h"
 #include "log-build-info.h"
 
 #define MAX_NLD 50000           //Massimo numero di nucleotidi gestibili in una sequenza
@@ -201,6 +202,8 @@ int number_of_introns;
 
 int number_of_cds;
 struct annotated_cds *a_cds;
+//Indice delle annotazioni sull'ID del RefSeq
+pest_id_index cds_index=NULL;
 
 char strand;
 
@@ -267,6 +270,7 @@ static char getContext(int ATG_start, char *tr_seq);
 
 static void GetCDSAnnotations(char *fileName);
 
+static int FindCDSAnnotation(const char *RefSeq);
 static char GetCDSAnnotationForRefSeq_2(int i);
 static void CheckStartEndWRTref(int ref, int i);
 
@@ -1003,6 +1007,19 @@ void GetCDSAnnotations(char *fileName){
   }
 
   fclose(in);
+
+  cds_index=est_id_index_create();
+  for(int c=0; c<counter; c++){
+	 est_id_index_add(cds_index, a_cds[c].RefSeq, &a_cds[c]);
+  }
+}
+
+//Ritorna l'indice della (prima) annotazione del RefSeq (-1 se non esiste)
+int FindCDSAnnotation(const char *RefSeq){
+  if(cds_index == NULL)
+	 return -1;
+  struct annotated_cds *cds=(struct annotated_cds *)est_id_index_find(cds_index, RefSeq);
+  return (cds == NULL)?(-1):((int)(cds-a_cds));
 }
 
 void CheckStartEndWRTref(int ref, int i){
@@ -1047,14 +1064,7 @@ char GetCDSAnnotationForRefSeq_2(int i){
   if(trs[i].type != 0)
          return 0;
 
-  while(j < number_of_cds && !stop){
-         if(!strcmp(a_cds[j].RefSeq, trs[i].RefSeq))
-                stop=1;
-         else
-                j++;
-  }
-
-  if(!stop)
+  if(FindCDSAnnotation(trs[i].RefSeq) == -1)
          return 0;
 
   trs[i].ORF_start=-1;
@@ -1092,15 +1102,8 @@ char GetCDSAnnotationForRefSeq_2(int i){
 //Effettuare il controllo sul multiplo di 3, altrimenti return 0
 
 //Trovo il refseq nel file delle annotazioni
-  r_index=0;
-  stop=0;
-  while(r_index < number_of_cds && !stop){
-         if(!strcmp(a_cds[r_index].RefSeq, trs[i].RefSeq))
-                stop=1;
-         else
-                r_index++;
-  }
-  if(!stop)
+  r_index=FindCDSAnnotation(trs[i].RefSeq);
+  if(r_index == -1)
          return 0;
 
  //Trovo l'ORF sul trascritto in questione che sia uguale a quello annotato
@@ -37,6 +37,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <ctype.h>
 #include "my_time.h"
@@ -49,13 +50,12 @@
 //31ott07 Modifica per sperimentazione trascritti
 #define STRONG_FIRST_LAST_MATCH
 
-#define MAX_EXONS 500           //Massimo numero di esoni gestibili per un trascritto
-
 //07ott05
 #define MAX_POLYA_END 20                //Massimo numero di terminazioni polyA gestibili per un trascritto
 
-#define MAX_TRANSCRIPTS 5000    //Massimo numero di trascritti gestibili (sia per l'input r che per l'output)
-#define MAX_NLD 300000          //Massimo numero di nucleotidi gestibili in una sequenza
+//Le liste dei trascritti (in input e dei percorsi) e le liste degli esoni sono
+//ridimensionate in base ai dati: questa e' solo la capacita' iniziale
+#define INITIAL_TRANSCRIPTS 64
 
 #define EXT_EDIT 2              //Distanza di edit per la sostituzione degli esterni
 
@@ -124,12 +124,22 @@
 
 /*STRUTTURE DATI*/
 
+/*Lista degli indici degli esoni interni di un trascritto. Le liste non vengono
+  mai modificate dopo la costruzione e sono condivise (con conteggio dei riferimenti)
+  tra i trascritti che le copiano*/
+struct exon_list{
+  int refs;
+  int length;
+  int exons[];
+};
+
 /*Struttura identificante un trascritto come sequenza degli indici interi dei suoi esoni*/
 struct transcript{
 
   int exons;            /*Numero di esoni che compongono il trascritto*/
-  int exon_list[MAX_EXONS];     /*Lista degli indici interi degli esoni interni che compongono il trascritto in
-                                                                                  numero pari a (exons-2)*/
+  int *exon_list;       /*Lista degli indici interi degli esoni interni che compongono il trascritto in
+                                                                                  numero pari a (exons-2), ovvero il campo exons di una
+                                                                                  struct exon_list (NULL se non ancora assegnata)*/
   int left_ext;                 /*Esone esterno sinistro*/
   int right_ext;                        /*Esone esterno destro*/
 
@@ -139,7 +149,7 @@ struct transcript{
 //07ott05
 #ifdef MERGE_POLYA
   int number_of_polya;
-  int polya_end[MAX_EXONS];
+  int polya_end[MAX_POLYA_END];
 #endif
 
   int ESTs;
@@ -165,8 +175,26 @@ struct path{
   struct transcript tr; /*Trascritto corrispondente*/
   int L;                        /*Limite per l'estensione*/
   char visit;                   /*TRUE se il path e' da prendere in considerazione, FALSE altrimenti*/
+
+  unsigned int nodes_hash;      /*Hash (incrementale) della sequenza dei nodi*/
+  unsigned int tr_hash;         /*Hash della sequenza degli esoni di tr (calcolato all'inserimento in coda)*/
+  struct path *same_hash_next;  /*Percorso successivo nella lista di trabocco della tabella dei percorsi in coda*/
+};
+
+/*Stato di un percorso nella visita in profondita' (--dag-paths): due percorsi con lo stesso nodo finale, lo stesso
+  limite di estensione e lo stesso trascritto hanno le stesse estensioni*/
+struct dag_state{
+  int end;
+  int L;
+  struct transcript tr;
+  unsigned int hash;
+  struct dag_state *next;       /*Stato successivo nella lista di trabocco*/
 };
 
+/*Valori iniziale e moltiplicatore degli hash (FNV-1a) sulle sequenze di indici*/
+#define PATH_HASH_SEED 2166136261u
+#define PATH_HASH_PRIME 16777619u
+
 /*Struttura identificante un nodo del grafo (trascritto)*/
 struct node{
 
@@ -183,15 +211,51 @@ struct queue{
   struct path *tail;
 };
 
+/*Arco del grafo delle estensioni verso (o da) il nodo node*/
+struct arc{
+  int node;
+  int L;                        /*Estensione (0 se l'arco e' stato rimosso)*/
+};
+
+/*Lista di adiacenza di un nodo, ordinata per indice di nodo*/
+struct arc_list{
+  int size;
+  int capacity;
+  struct arc *arcs;
+};
+
+/*Occorrenza di una coordinata (sinistra o destra) di un esone di un trascritto*/
+struct coord_occurrence{
+  int coord;
+  int transcript;
+};
+
 
 /*PROTOTIPI*/
 
 /*Costruisce e riempie la transcript_list leggendo un file passato come argomento*/
 static void Get_Transcripts_from_File();
 
-/*Costruisce la matrice di estensione (o di adiacenza). Le struttura transcript_list deve essere gia' stata riempita. I
-  valori di overlapping sono rispetto al primo esone del trascritto e non rispetto al primo esone interno*/
-static void Build_Extension_Matrix();
+/*Costruisce il grafo delle estensioni (liste di adiacenza). Le struttura transcript_list deve essere gia' stata riempita. I
+  valori di overlapping sono rispetto al primo esone del trascritto e non rispetto al primo esone interno.
+  Extends viene calcolata solo sulle coppie di trascritti in cui il primo esone di uno dei due ha un estremo
+  a distanza al piu' 2 da quello di un esone dell'altro (condizione necessaria per Check_L_suffix)*/
+static void Build_Extension_Graph();
+
+/*Restituisce l'estensione dell'arco (i,j) del grafo, 0 se l'arco non esiste*/
+static int Get_extension(int i, int j);
+
+/*Rimuove l'arco (i,j) dal grafo*/
+static void Remove_extension(int i, int j);
+
+/*Aggiunge in coda alla lista un arco verso node*/
+static void Add_arc(struct arc_list *list, int node, int L);
+
+/*Aggiunge alle coppie candidate le coppie (i,j) con j in occurrences con coordinata in [coord-2,coord+2]*/
+static void Add_candidate_pairs(struct arc_list *candidates, struct coord_occurrence *occurrences, int n_occurrences, int coord, int i);
+
+static int Compare_coord_occurrences(const void *a, const void *b);
+static int Compare_arcs(const void *a, const void *b);
 
 /*...*/
 //08giu05
@@ -251,6 +315,35 @@ static void Enqueue(struct path **path);
 /*Estrae un elemento dalla coda*/
 static struct path *Dequeue();
 
+/*Hash della sequenza degli esoni del trascritto*/
+static unsigned int Transcript_hash(struct transcript *t);
+
+/*Inserisce (o rimuove) un percorso nella tabella hash dei percorsi in coda. Ogni lista di trabocco mantiene
+  l'ordine di inserimento, quindi il primo percorso con un dato trascritto e' anche il primo in coda*/
+static void Queue_table_insert(struct path *path);
+static void Queue_table_remove(struct path *path);
+
+/*Calcola con la programmazione dinamica sul DAG delle estensioni il numero dei percorsi massimali
+  (da una sorgente ad un pozzo) senza enumerarli. Il conteggio satura a PATH_COUNT_LIMIT*/
+static double Count_Maximal_Paths();
+
+/*Conta in profondita' i trascritti massimali distinti della sorgente source_index (modalita' --dag-paths): in
+  memoria ci sono il percorso corrente e gli stati gia' visitati, non tutta la frontiera della visita in ampiezza.
+  Un percorso che raggiunge uno stato gia' visitato non viene esteso. La potatura e' esatta, mentre l'euristica
+  PRUNE_EXON_COMP di Set_Paths_for_Source dipende dal contenuto della coda: per questo i trascritti in output sono
+  sempre quelli della visita in ampiezza e il conteggio e' solo riportato nel log*/
+static double Count_Isoforms_for_Source_DAG(int source_index);
+
+/*Registra lo stato (end, L, tr) della visita in profondita'. Restituisce FALSE se lo stato e' gia' stato
+  raggiunto, TRUE altrimenti. Con end=-1 registra il trascritto di un percorso massimale*/
+static char Dag_state_visit(int end, int L, struct transcript *tr);
+
+/*Svuota la tabella degli stati della visita in profondita'*/
+static void Dag_states_clear();
+
+/*TRUE se e' stato raggiunto il limite sul numero dei percorsi massimali (--max-isoforms)*/
+static char Isoform_cap_reached();
+
 /*Restituisce l'indirizzo del path in coda che ha lo stesso trascritto di arg_path*/
 static struct path *Get_path_with_the_same_exons(struct path *arg_path);
 
@@ -267,6 +360,21 @@ static void Build_extension(struct transcript t1, struct transcript t2, int L, s
   gia' stata allocata; la funzione alloca solo exon_list).
   La liberazione della memoria di copy deve essere gestita completamente al di fuori*/
 static void Copy_transcript(struct transcript t, struct transcript *copy);
+/*Alloca una nuova lista di length esoni (con un riferimento)*/
+static int *New_exon_list(int length);
+/*Aggiunge (Retain) o rilascia (Release) un riferimento alla lista di esoni.
+  La lista viene liberata quando non ha piu' riferimenti*/
+static int *Retain_exon_list(int *exon_list);
+static void Release_exon_list(int *exon_list);
+/*Libera un percorso (nodi e lista di esoni del trascritto)*/
+static void Free_Path(struct path *path);
+/*Garantisce che le liste dei trascritti dei percorsi abbiano almeno size elementi*/
+static void Ensure_path_transcripts_capacity(struct transcript **list, struct path ***paths, int *capacity, int size);
+/*Legge dallo standard input la prossima stringa senza spazi (come scanf("%s\n", ...)),
+  ridimensionando il buffer se necessario*/
+static void Read_string(char **buffer, size_t *size);
+/*Accoda string al buffer (di lunghezza *length), ridimensionandolo se necessario*/
+static void Append_string(char **buffer, size_t *size, size_t *length, const char *string);
 
 /*Determina il trascritto massimale a partire da un percorso sul grafo dei trascritti e lo memorizza in return_transcript
   (gia' allocato; la funzione alloca solo exon_list)*/
@@ -329,15 +437,13 @@ static char *To_lower(char *str);
 //27giu05
 int count_del;
 
-/*Matrice quadrata di dimensioni pari al numero dei trascritti. La posizione (i,j) fornisce l'estensione "e" del trascritto
-  j-esimo rispetto al trascritto i-esimo: e=0 se j non estende i o esiste una relazione di inclusione,
+/*Grafo dei trascritti come liste di adiacenza di dimensioni pari al numero dei trascritti. out_arcs[i] contiene gli
+  archi (i,j), con L pari all'estensione "e" del trascritto j-esimo rispetto al trascritto i-esimo:
   e>0 e' la posizione dell'esone (che non puo' essere il primo) di i da cui incomincia l'estensione di j.
-  Tale matrice e' in sostanza la matrice di adiacenza del grafo dei trascritti. Puo' essere inizializzata a -1. Se trovo che j
-  estende i allora settero' un valore positivo in (i,j) e uno zero in (j,i): c'e' un arco che va da i a j*/
-int **extension_matrix;
-
-//27giu05
-char **remove_extension_matrix;
+  in_arcs[j] contiene gli stessi archi (i,j) visti da j. Un arco rimosso dalla riduzione del grafo resta nelle liste
+  con L=0 (come lo 0 della vecchia matrice di estensione)*/
+struct arc_list *out_arcs;
+struct arc_list *in_arcs;
 
 /*Vettore: in posizione i e' TRUE se il trascritto i (nodo) e' una sorgente,
   ovvero un nodo senza archi entranti*/
@@ -348,7 +454,7 @@ char *give_path;
 
 /*Vettore di dimensioni pari al numero dei trascritti: in posizione i e' memorizzata l'informazione relativa al trascritto i*/
 //struct transcript *transcript_list;
-struct transcript transcript_list[MAX_TRANSCRIPTS];
+struct transcript *transcript_list=NULL;
 
 /*Numero dei trascritti presenti in transcript_list*/
 int number_of_transcripts;
@@ -366,6 +472,26 @@ int number_of_sources;
 /*Coda di nodi*/
 struct queue q;
 
+/*Tabella hash dei percorsi in coda (dimensione potenza di 2)*/
+struct path **queue_table=NULL;
+int queue_table_size=0;
+int queue_table_count=0;
+
+/*Opzioni: enumerazione in profondita' dei percorsi e limite sul numero dei percorsi massimali
+  (0 se non c'e' limite)*/
+char dag_paths=0;
+int max_isoforms=0;
+
+/*Numero dei percorsi massimali enumerati*/
+int emitted_paths=0;
+
+/*Tabella hash degli stati della visita in profondita' (dimensione potenza di 2)*/
+struct dag_state **dag_state_table=NULL;
+int dag_state_table_size=0;
+int dag_state_count=0;
+
+#define PATH_COUNT_LIMIT 1e15
+
 /*Puntatore per le aggiunte di un nodo ad un percorso*/
 struct node *add=NULL;
 
@@ -377,13 +503,15 @@ int source_total_paths;
 
 /*Vettore che memorizza i trascritti determinati sui percorsi trovati*/
 //struct transcript *path_transcript_list;
-struct transcript path_transcript_list[MAX_TRANSCRIPTS];
-struct path *transcript_list_of_paths[MAX_TRANSCRIPTS];
+struct transcript *path_transcript_list=NULL;
+struct path **transcript_list_of_paths=NULL;
+int path_transcripts_capacity=0;
 
 /*Vettore che memorizza i trascritti determinati sui percorsi trovati per una sorgente*/
 //struct transcript *source_path_transcript_list;
-struct transcript source_path_transcript_list[MAX_TRANSCRIPTS];
-struct path *source_list_of_paths[MAX_TRANSCRIPTS];
+struct transcript *source_path_transcript_list=NULL;
+struct path **source_list_of_paths=NULL;
+int source_path_transcripts_capacity=0;
 
 /*In posizione i e' TRUE se il trascritto i in path_transcript_list e' stato filtrato*/
 char *filtered;
@@ -411,8 +539,10 @@ char **exists_list;
 //22mar07
 //char init_reading[100000];
 //char init_reading2[100000];
-char init_reading[200000];
-char init_reading2[200000];
+char *init_reading=NULL;
+size_t init_reading_size=0, init_reading_length=0;
+char *init_reading2=NULL;
+size_t init_reading2_size=0, init_reading2_length=0;
 
 int number_of_exons;    /*Numero degli esoni nella lista totale*/
 
@@ -445,11 +575,13 @@ int boundary;
 #endif
 
 int
-main(){
+main(int argc, char *argv[]){
   INFO("BUILD-FULL-LENGTHS");
   PRINT_LICENSE_INFORMATION;
   PRINT_SYSTEM_INFORMATION;
   int i=0, j=0, k=0, p=0;
+  double maximal_paths=0;
+  double dag_isoforms=0;
   char stop=0;
   //char temp_string[MAX_NLD];
   char temp_string2[50];
@@ -477,6 +609,24 @@ main(){
 
   MYTIME_start(pt_tot);
 
+//Opzioni (facoltative)
+  for(i=1; i<argc; i++){
+         if(!strcmp(argv[i], "--dag-paths")){
+                dag_paths=1;
+         }
+         else if(!strncmp(argv[i], "--max-isoforms=", strlen("--max-isoforms="))){
+                max_isoforms=atoi(argv[i]+strlen("--max-isoforms="));
+         }
+         else{
+                fprintf(stderr, "Usage: %s [--dag-paths] [--max-isoforms=N] < build-ests.txt\n", argv[0]);
+#ifdef HALT_EXIT_MODE
+                exit(1);
+#else
+                exit(EXIT_FAILURE);
+#endif
+         }
+  }
+
   vect_actual_path_number=(int *)malloc((SECOND_MIN_EXONS_ACCEPTED_OUTPUT-FIRST_MIN_EXONS_ACCEPTED_OUTPUT+1)*sizeof(int));
   if(vect_actual_path_number == NULL){
          fprintf(stderr, "Problem1 in allocating vect_actual_path_number!\n");
@@ -592,7 +742,7 @@ main(){
 //19gen05
   First_Filtering();
 
-  Build_Extension_Matrix();
+  Build_Extension_Graph();
 
  //27giu05
 #ifdef MYERS_PRUNING
@@ -614,7 +764,7 @@ main(){
 
   source_list=(int *)malloc(number_of_sources*sizeof(int));
   if(source_list== NULL){
-         fprintf(stderr, "Problem4 of memory allocation in Build_Extension_Matrix!\n");
+         fprintf(stderr, "Problem4 of memory allocation in Build_Extension_Graph!\n");
 #ifdef HALT_EXIT_MODE
          exit(1);
 #else
@@ -677,6 +827,18 @@ main(){
         exit(0);*/
 /******************************/
 
+  maximal_paths=Count_Maximal_Paths();
+  INFO("Maximal paths in the extension graph: %.0f%s", maximal_paths, (maximal_paths >= PATH_COUNT_LIMIT)?("+"):(""));
+  if(max_isoforms > 0 && maximal_paths > max_isoforms)
+         WARN("Only the first %d maximal paths will be considered.", max_isoforms);
+
+  if(dag_paths){
+         dag_isoforms=0;
+         for(i=0; i<number_of_sources; i++)
+                dag_isoforms+=Count_Isoforms_for_Source_DAG(i);
+         INFO("Distinct maximal transcripts (depth-first count): %.0f", dag_isoforms);
+  }
+
   Set_Paths();
 
 //27giu05
@@ -758,31 +920,31 @@ exit(0);*/
   for(i=0; i<number_of_exons; i++){
          sprintf(temp_string2, "%d:%d", list_of_exon_left[i], list_of_exon_right[i]);
 #ifndef MULTI_FASTA_FORMAT
-         strcat(init_reading, temp_string2);
+         Append_string(&init_reading, &init_reading_size, &init_reading_length, temp_string2);
 #endif
-         strcat(init_reading2, temp_string2);
+         Append_string(&init_reading2, &init_reading2_size, &init_reading2_length, temp_string2);
 
 //10mag05
 #ifdef PRINT_POLYA
          sprintf(temp_string2, ":%d", polya[i]);
 #ifndef MULTI_FASTA_FORMAT
-         strcat(init_reading, temp_string2);
+         Append_string(&init_reading, &init_reading_size, &init_reading_length, temp_string2);
 #endif
 #endif
 
          sprintf(temp_string2, ";%d:%d", list_of_old_exon_left[i], list_of_old_exon_right[i]);
-         strcat(init_reading2, temp_string2);
+         Append_string(&init_reading2, &init_reading2_size, &init_reading2_length, temp_string2);
 
 //10mag05
 #ifdef PRINT_POLYA
          sprintf(temp_string2, ":%d", polya[i]);
-         strcat(init_reading2, temp_string2);
+         Append_string(&init_reading2, &init_reading2_size, &init_reading2_length, temp_string2);
 #endif
 
 #ifndef MULTI_FASTA_FORMAT
-         strcat(init_reading, "\n");
+         Append_string(&init_reading, &init_reading_size, &init_reading_length, "\n");
 #endif
-         strcat(init_reading2, "\n");
+         Append_string(&init_reading2, &init_reading2_size, &init_reading2_length, "\n");
   }
 
 /*strcpy(file_name, "F_TEMP_COMPOSITION_TRANS");
@@ -1219,6 +1381,9 @@ exit(EXIT_FAILURE);
          fclose(tr_out[i-FIRST_MIN_EXONS_ACCEPTED_OUTPUT]);
   }
 
+  free(init_reading);
+  free(init_reading2);
+
   MYTIME_stop(pt_tot);
   MYTIME_LOG(INFO, pt_tot);
 
@@ -1231,9 +1396,10 @@ exit(EXIT_FAILURE);
 /*FUNZIONI*/
 
 void Get_Transcripts_from_File(){
-  char temp_string[MAX_NLD];
-  char temp_exon[7];
-  char temp_conf[7];
+  char *temp_string=NULL;
+  size_t temp_string_size=0;
+  char temp_exon[12];
+  char temp_conf[12];
 
 //19dic06
 //  char temp_type[7];
@@ -1244,7 +1410,9 @@ void Get_Transcripts_from_File(){
   int i=0, j=0, k=0, p=0;
   int exons1=0, exons2=0;
   int counter=0;
-  int temp_exon_list[MAX_EXONS];
+  int *temp_exon_list=NULL;
+  int temp_exon_list_size=0;
+  int transcript_list_size=0;
   char stop=0, stop2=0;
   int count_exons=0;
   int coord_counter=0;
@@ -1256,23 +1424,25 @@ void Get_Transcripts_from_File(){
 //  int max_lgth=0, lgth=0;
 
 #ifdef READ_ABS_COORD
-  scanf("%s\n", temp_string);
+  Read_string(&temp_string, &temp_string_size);
   gen_start=atoi(temp_string);
-  scanf("%s\n", temp_string);
+  Read_string(&temp_string, &temp_string_size);
   gen_end=atoi(temp_string);
-  scanf("%s\n", temp_string);
+  Read_string(&temp_string, &temp_string_size);
   strand=atoi(temp_string);
-  scanf("%s\n", temp_string);
+  Read_string(&temp_string, &temp_string_size);
   boundary=atoi(temp_string);
 #endif
 
 //22mar07
-  strcpy(init_reading, "");
-  strcpy(init_reading2, "");
+  init_reading_length=0;
+  Append_string(&init_reading, &init_reading_size, &init_reading_length, "");
+  init_reading2_length=0;
+  Append_string(&init_reading2, &init_reading2_size, &init_reading2_length, "");
 
 //Lettura delle prime tre righe
   for(i=0; i<3; i++){
-         scanf("%s\n", temp_string);
+         Read_string(&temp_string, &temp_string_size);
 
          if(i==1){
                 number_of_exons=atoi(temp_string);
@@ -1282,13 +1452,13 @@ void Get_Transcripts_from_File(){
 #ifdef MULTI_FASTA_FORMAT
                 if(i == 2){
 #endif
-                  strcat(init_reading, temp_string);
-                  strcat(init_reading, "\n");
+                  Append_string(&init_reading, &init_reading_size, &init_reading_length, temp_string);
+                  Append_string(&init_reading, &init_reading_size, &init_reading_length, "\n");
 #ifdef MULTI_FASTA_FORMAT
                 }
 #endif
-                strcat(init_reading2, temp_string);
-                strcat(init_reading2, "\n");
+                Append_string(&init_reading2, &init_reading2_size, &init_reading2_length, temp_string);
+                Append_string(&init_reading2, &init_reading2_size, &init_reading2_length, "\n");
          }
   }
 
@@ -1464,7 +1634,7 @@ void Get_Transcripts_from_File(){
 
 //Lettura e scrittura della lista iniziale degli esoni
   while(!stop){
-         scanf("%s\n", temp_string);
+         Read_string(&temp_string, &temp_string_size);
          if(temp_string[0] == '.'){
                 stop=1;
          }
@@ -1556,13 +1726,19 @@ void Get_Transcripts_from_File(){
          exons1=0;
          exons2=0;
 
-         if(counter > MAX_TRANSCRIPTS-1){
-                fprintf(stderr, "Too many transcripts in input!\n");
+         if(counter >= transcript_list_size){
+                transcript_list_size=(transcript_list_size == 0)?(INITIAL_TRANSCRIPTS):(2*transcript_list_size);
+                transcript_list=(struct transcript *)realloc(transcript_list, transcript_list_size*sizeof(struct transcript));
+                if(transcript_list == NULL){
+                  fprintf(stderr, "Problem6 of memory allocation in Get_Transcripts_from_File!\n");
 #ifdef HALT_EXIT_MODE
-                exit(1);
+                  exit(1);
 #else
-                exit(EXIT_FAILURE);
+                  exit(EXIT_FAILURE);
 #endif
+                }
+                for(k=counter; k<transcript_list_size; k++)
+                  transcript_list[k].exon_list=NULL;
          }
 
          i=1;
@@ -1598,7 +1774,7 @@ void Get_Transcripts_from_File(){
          strcpy(temp_refseq, "");
 #endif
 
-         scanf("%s\n", temp_string);
+         Read_string(&temp_string, &temp_string_size);
 
          i=0;
 
@@ -1612,6 +1788,18 @@ void Get_Transcripts_from_File(){
                 temp_exon[j]='\0';
                 if(j > 0){
                   exon_index=atoi(temp_exon);
+                  if(exons1 >= temp_exon_list_size){
+                         temp_exon_list_size=(temp_exon_list_size == 0)?(64):(2*temp_exon_list_size);
+                         temp_exon_list=(int *)realloc(temp_exon_list, temp_exon_list_size*sizeof(int));
+                         if(temp_exon_list == NULL){
+                                fprintf(stderr, "Problem7 of memory allocation in Get_Transcripts_from_File!\n");
+#ifdef HALT_EXIT_MODE
+                                exit(1);
+#else
+                                exit(EXIT_FAILURE);
+#endif
+                         }
+                  }
                   temp_exon_list[exons1]=exon_index;
                   exons1++;
                 }
@@ -1619,12 +1807,12 @@ void Get_Transcripts_from_File(){
          }
 
          while(!stop2){
-                scanf("%s\n", temp_string);
+                Read_string(&temp_string, &temp_string_size);
                 if(temp_string[0] == '.' || temp_string[0] == '#')
                   stop2=1;
                 else{
-                  if(exons2 > MAX_EXONS-1){
-                         fprintf(stderr, "Too many exons in input transcript number %d!\n", (counter+1));
+                  if(exons2 > exons1-1){
+                         fprintf(stderr, "Invalid transcript in input file (%d)!\n", (counter+1));
 #ifdef HALT_EXIT_MODE
                          exit(1);
 #else
@@ -1680,6 +1868,8 @@ void Get_Transcripts_from_File(){
                 strcpy(transcript_list[counter].RefSeq, temp_refseq);
 
                 transcript_list[counter].left_ext=temp_exon_list[0];
+                Release_exon_list(transcript_list[counter].exon_list);
+                transcript_list[counter].exon_list=New_exon_list(exons1-2);
 
 //16feb06
                 if(polya[transcript_list[counter].left_ext] == 1){
@@ -1751,17 +1941,52 @@ void Get_Transcripts_from_File(){
   }
 
   number_of_transcripts=counter;
+
+  free(temp_exon_list);
+  free(temp_string);
 }
 
-void Build_Extension_Matrix(){
+void Read_string(char **buffer, size_t *size){
+  size_t length=0;
+  int c=0;
 
-  int i=0, j=0;
-  int extension_limit=0;
-  char exists_extension=0;
+  if(*buffer == NULL || *size == 0){
+         *size=1024;
+         *buffer=(char *)malloc(*size*sizeof(char));
+         if(*buffer == NULL){
+                fprintf(stderr, "Problem1 of memory allocation in Read_string!\n");
+#ifdef HALT_EXIT_MODE
+                exit(1);
+#else
+                exit(EXIT_FAILURE);
+#endif
+         }
+  }
 
-  extension_matrix=(int **)malloc(number_of_transcripts*sizeof(int *));
-  if(extension_matrix == NULL){
-         fprintf(stderr, "Problem1 of memory allocation in Build_Extension_Matrix!\n");
+  do{
+         c=getchar();
+  }while(c != EOF && isspace(c));
+
+  while(c != EOF && !isspace(c)){
+         if(length+1 >= *size){
+                *size*=2;
+                *buffer=(char *)realloc(*buffer, *size*sizeof(char));
+                if(*buffer == NULL){
+                  fprintf(stderr, "Problem2 of memory allocation in Read_string!\n");
+#ifdef HALT_EXIT_MODE
+                  exit(1);
+#else
+                  exit(EXIT_FAILURE);
+#endif
+                }
+         }
+         (*buffer)[length++]=(char)c;
+         c=getchar();
+  }
+  (*buffer)[length]='\0';
+
+  if(length == 0){
+         fprintf(stderr, "Unexpected end of input file!\n");
 #ifdef HALT_EXIT_MODE
          exit(1);
 #else
@@ -1769,10 +1994,24 @@ void Build_Extension_Matrix(){
 #endif
   }
 
-  for(i=0; i<number_of_transcripts; i++){
-         extension_matrix[i]=(int *)malloc(number_of_transcripts*sizeof(int));
-         if(extension_matrix[i] == NULL){
-                fprintf(stderr, "Problem2 of memory allocation in Build_Extension_Matrix!\n");
+//Come scanf("%s\n", ...) consuma gli spazi che seguono la stringa
+  while(c != EOF && isspace(c))
+         c=getchar();
+  if(c != EOF)
+         ungetc(c, stdin);
+}
+
+void Append_string(char **buffer, size_t *size, size_t *length, const char *string){
+  size_t string_length=strlen(string);
+
+  if(*buffer == NULL || *length+string_length+1 > *size){
+         if(*size == 0)
+                *size=1024;
+         while(*length+string_length+1 > *size)
+                *size*=2;
+         *buffer=(char *)realloc(*buffer, *size*sizeof(char));
+         if(*buffer == NULL){
+                fprintf(stderr, "Problem of memory allocation in Append_string!\n");
 #ifdef HALT_EXIT_MODE
                 exit(1);
 #else
@@ -1781,10 +2020,30 @@ void Build_Extension_Matrix(){
          }
   }
 
-//27giu05
-  remove_extension_matrix=(char **)malloc(number_of_transcripts*sizeof(char *));
-  if(remove_extension_matrix == NULL){
-         fprintf(stderr, "Problem11 of memory allocation in Build_Extension_Matrix!\n");
+  memcpy(*buffer+*length, string, string_length+1);
+  *length+=string_length;
+}
+
+
+
+void Build_Extension_Graph(){
+
+  int i=0, j=0, k=0;
+  int extension_limit=0;
+  char exists_extension=0;
+  int exon=0;
+  int n_occurrences=0;
+  struct coord_occurrence *left_occurrences=NULL;
+  struct coord_occurrence *right_occurrences=NULL;
+  struct arc_list *candidates=NULL;
+
+//Almeno una lista, in modo che calloc non restituisca NULL senza trascritti
+  const size_t n_arc_lists=(number_of_transcripts > 0)? (size_t)number_of_transcripts : 1;
+  out_arcs=(struct arc_list *)calloc(n_arc_lists, sizeof(struct arc_list));
+  in_arcs=(struct arc_list *)calloc(n_arc_lists, sizeof(struct arc_list));
+  candidates=(struct arc_list *)calloc(n_arc_lists, sizeof(struct arc_list));
+  if(out_arcs == NULL || in_arcs == NULL || candidates == NULL){
+         fprintf(stderr, "Problem1 of memory allocation in Build_Extension_Graph!\n");
 #ifdef HALT_EXIT_MODE
          exit(1);
 #else
@@ -1792,22 +2051,48 @@ void Build_Extension_Matrix(){
 #endif
   }
 
-//27giu05
-  for(i=0; i<number_of_transcripts; i++){
-         remove_extension_matrix[i]=(char *)malloc(number_of_transcripts*sizeof(char));
-         if(remove_extension_matrix[i] == NULL){
-                fprintf(stderr, "Problem2 of memory allocation in Build_Extension_Matrix!\n");
+//Occorrenze delle coordinate degli esoni di tutti i trascritti, ordinate per coordinata
+  for(i=0; i<number_of_transcripts; i++)
+         n_occurrences+=transcript_list[i].exons;
+
+  left_occurrences=(struct coord_occurrence *)malloc((n_occurrences+1)*sizeof(struct coord_occurrence));
+  right_occurrences=(struct coord_occurrence *)malloc((n_occurrences+1)*sizeof(struct coord_occurrence));
+  if(left_occurrences == NULL || right_occurrences == NULL){
+         fprintf(stderr, "Problem2 of memory allocation in Build_Extension_Graph!\n");
 #ifdef HALT_EXIT_MODE
-                exit(1);
+         exit(1);
 #else
-                exit(EXIT_FAILURE);
+         exit(EXIT_FAILURE);
 #endif
+  }
+
+  n_occurrences=0;
+  for(i=0; i<number_of_transcripts; i++){
+         for(k=0; k<transcript_list[i].exons; k++){
+                exon=(k == 0)?(transcript_list[i].left_ext):((k == transcript_list[i].exons-1)?(transcript_list[i].right_ext):(transcript_list[i].exon_list[k-1]));
+                left_occurrences[n_occurrences].coord=list_of_exon_left[exon];
+                left_occurrences[n_occurrences].transcript=i;
+                right_occurrences[n_occurrences].coord=list_of_exon_right[exon];
+                right_occurrences[n_occurrences].transcript=i;
+                n_occurrences++;
          }
   }
+  qsort(left_occurrences, n_occurrences, sizeof(struct coord_occurrence), Compare_coord_occurrences);
+  qsort(right_occurrences, n_occurrences, sizeof(struct coord_occurrence), Compare_coord_occurrences);
+
+//Coppie candidate (i,j), i<j: il primo esone di i o di j ha un estremo vicino a quello di un esone dell'altro
+  for(i=0; i<number_of_transcripts; i++){
+         exon=transcript_list[i].left_ext;
+         Add_candidate_pairs(candidates, left_occurrences, n_occurrences, list_of_exon_left[exon], i);
+         Add_candidate_pairs(candidates, right_occurrences, n_occurrences, list_of_exon_right[exon], i);
+  }
+
+  free(left_occurrences);
+  free(right_occurrences);
 
   is_source=(char *)malloc(number_of_transcripts*sizeof(char));
   if(is_source == NULL){
-         fprintf(stderr, "Problem3 of memory allocation in Build_Extension_Matrix!\n");
+         fprintf(stderr, "Problem3 of memory allocation in Build_Extension_Graph!\n");
 #ifdef HALT_EXIT_MODE
          exit(1);
 #else
@@ -1815,24 +2100,13 @@ void Build_Extension_Matrix(){
 #endif
   }
 
-  for(i=0; i<number_of_transcripts; i++)
-         for(j=0; j<number_of_transcripts; j++){
-//27giu05
-                remove_extension_matrix[i][j]=0;
-
-                if(i == j)
-                  extension_matrix[i][j]=0;
-                else
-                  extension_matrix[i][j]=-1;
-         }
-
   for(i=0; i<number_of_transcripts; i++)
          is_source[i]=1;
 
   in_degree=(int *)malloc(number_of_transcripts*sizeof(int));
   out_degree=(int *)malloc(number_of_transcripts*sizeof(int));
   if(in_degree == NULL || out_degree == NULL){
-         fprintf(stderr, "Problem30 of memory allocation in Build_Extension_Matrix!\n");
+         fprintf(stderr, "Problem30 of memory allocation in Build_Extension_Graph!\n");
 #ifdef HALT_EXIT_MODE
          exit(1);
 #else
@@ -1847,7 +2121,7 @@ void Build_Extension_Matrix(){
 
   give_path=(char *)malloc(number_of_transcripts*sizeof(char));
   if(give_path == NULL){
-         fprintf(stderr, "Problem31 of memory allocation in Build_Extension_Matrix!\n");
+         fprintf(stderr, "Problem31 of memory allocation in Build_Extension_Graph!\n");
 #ifdef HALT_EXIT_MODE
          exit(1);
 #else
@@ -1858,9 +2132,13 @@ void Build_Extension_Matrix(){
   for(i=0; i<number_of_transcripts; i++)
          give_path[i]=0;
 
+//Le coppie sono considerate nello stesso ordine della matrice (i crescente, poi j crescente) in modo che
+//le liste di adiacenza risultino ordinate
   for(i=0; i<number_of_transcripts; i++){
-         for(j=i+1; j<number_of_transcripts; j++)
-                if(extension_matrix[i][j] == -1){
+         qsort(candidates[i].arcs, candidates[i].size, sizeof(struct arc), Compare_arcs);
+         for(k=0; k<candidates[i].size; k++)
+                if(k == 0 || candidates[i].arcs[k].node != candidates[i].arcs[k-1].node){
+                  j=candidates[i].arcs[k].node;
 /*if(i==19 && j==32){
   fprintf(stdout, "******************************************* %d %d\n", i, j);
   fprintf(stdout, "HERE prima 38 %d %d\n", list_of_exon_left[38], list_of_exon_right[38]);
@@ -1908,24 +2186,26 @@ void Build_Extension_Matrix(){
   fprintf(stderr, "EXT %d\n", exists_extension);
   fprintf(stderr, "*******************************************\n");
   }*/
-                  extension_matrix[i][j]=0;
-                  extension_matrix[j][i]=0;
                   if(exists_extension == 1 || exists_extension == -1){
                          if(exists_extension == 1){
-                                extension_matrix[i][j]=extension_limit;
+                                Add_arc(&out_arcs[i], j, extension_limit);
+                                Add_arc(&in_arcs[j], i, extension_limit);
 //is_source[j]=0;
                                 out_degree[i]=out_degree[i]+1;
                                 in_degree[j]=in_degree[j]+1;
                          }
                          else{
-                                extension_matrix[j][i]=extension_limit;
+                                Add_arc(&out_arcs[j], i, extension_limit);
+                                Add_arc(&in_arcs[i], j, extension_limit);
                                 out_degree[j]=out_degree[j]+1;
                                 in_degree[i]=in_degree[i]+1;
 //is_source[i]=0;
                          }
                   }
                 }
+         free(candidates[i].arcs);
   }
+  free(candidates);
 
 /*      //Conteggio delle sorgenti
         number_of_sources=0;
@@ -1936,7 +2216,7 @@ void Build_Extension_Matrix(){
 
         source_list=(int *)malloc(number_of_sources*sizeof(int));
         if(source_list== NULL){
-        fprintf(stderr, "Problem4 of memory allocation in Build_Extension_Matrix!\n");
+        fprintf(stderr, "Problem4 of memory allocation in Build_Extension_Graph!\n");
         #ifdef HALT_EXIT_MODE
         exit(1);
         #else
@@ -1953,6 +2233,94 @@ void Build_Extension_Matrix(){
         }*/
 }
 
+void Add_candidate_pairs(struct arc_list *candidates, struct coord_occurrence *occurrences, int n_occurrences, int coord, int i){
+  int low=0, high=n_occurrences, mid=0;
+  int j=0;
+
+//Prima occorrenza con coordinata >= coord-2
+  while(low < high){
+         mid=(low+high)/2;
+         if(occurrences[mid].coord < coord-2)
+                low=mid+1;
+         else
+                high=mid;
+  }
+
+  for(; low<n_occurrences && occurrences[low].coord <= coord+2; low++){
+         j=occurrences[low].transcript;
+         if(j < i)
+                Add_arc(&candidates[j], i, 0);
+         if(j > i)
+                Add_arc(&candidates[i], j, 0);
+  }
+}
+
+int Compare_coord_occurrences(const void *a, const void *b){
+  const struct coord_occurrence *o1=(const struct coord_occurrence *)a;
+  const struct coord_occurrence *o2=(const struct coord_occurrence *)b;
+
+  if(o1->coord != o2->coord)
+         return (o1->coord < o2->coord)?(-1):(1);
+  return o1->transcript-o2->transcript;
+}
+
+int Compare_arcs(const void *a, const void *b){
+  return ((const struct arc *)a)->node-((const struct arc *)b)->node;
+}
+
+void Add_arc(struct arc_list *list, int node, int L){
+  if(list->size == list->capacity){
+         list->capacity=(list->capacity == 0)?(4):(2*list->capacity);
+         list->arcs=(struct arc *)realloc(list->arcs, list->capacity*sizeof(struct arc));
+         if(list->arcs == NULL){
+                fprintf(stderr, "Problem1 of memory allocation in Add_arc!\n");
+#ifdef HALT_EXIT_MODE
+                exit(1);
+#else
+                exit(EXIT_FAILURE);
+#endif
+         }
+  }
+
+  list->arcs[list->size].node=node;
+  list->arcs[list->size].L=L;
+  list->size++;
+}
+
+//Ricerca binaria di node nella lista (ordinata) degli archi
+static struct arc *Find_arc(struct arc_list *list, int node){
+  int low=0, high=list->size-1, mid=0;
+
+  while(low <= high){
+         mid=(low+high)/2;
+         if(list->arcs[mid].node == node)
+                return &list->arcs[mid];
+         if(list->arcs[mid].node < node)
+                low=mid+1;
+         else
+                high=mid-1;
+  }
+
+  return NULL;
+}
+
+int Get_extension(int i, int j){
+  struct arc *arc=Find_arc(&out_arcs[i], j);
+
+  return (arc == NULL)?(0):(arc->L);
+}
+
+void Remove_extension(int i, int j){
+  struct arc *arc=Find_arc(&out_arcs[i], j);
+
+  if(arc != NULL)
+         arc->L=0;
+
+  arc=Find_arc(&in_arcs[j], i);
+  if(arc != NULL)
+         arc->L=0;
+}
+
 //CONTROLLARE
 struct path *Copy_of_Path(struct path *path){
   struct path *copy_path=NULL;
@@ -1971,6 +2339,8 @@ struct path *Copy_of_Path(struct path *path){
   copy_path->next=NULL;
   copy_path->n=NULL;
   copy_path->tail=NULL;
+  copy_path->tr.exon_list=NULL;
+  copy_path->nodes_hash=PATH_HASH_SEED;
 
   head=path->n;
 
@@ -2042,13 +2412,15 @@ void Add_Node(struct path **path, int node, char upd_tr){
   }
 
   if(upd_tr && !first_node){
-         (*path)->L+=extension_matrix[(*path)->end][node];
+         (*path)->L+=Get_extension((*path)->end, node);
          Build_extension((*path)->tr, transcript_list[node], (*path)->L, &extension);
          Copy_transcript(extension, &((*path)->tr));
+         Release_exon_list(extension.exon_list);
   }
 
   (*path)->tail=add;
   (*path)->end=node;
+  (*path)->nodes_hash=((*path)->nodes_hash^(unsigned int)node)*PATH_HASH_PRIME;
 }
 
 void Set_Paths(){
@@ -2056,6 +2428,8 @@ void Set_Paths(){
 
   total_paths=0;
 
+  emitted_paths=0;
+
   for(i=0; i<number_of_sources; i++){
          Set_Paths_for_Source(i);
          total_paths=total_paths+source_total_paths;
@@ -2075,16 +2449,252 @@ void Set_Paths(){
          filtered[i]=0;
 }
 
-void Set_Paths_for_Source(int source_index){
+char Isoform_cap_reached(){
+  static char warned=0;
+
+  if(max_isoforms <= 0 || emitted_paths < max_isoforms)
+         return 0;
+
+  if(!warned){
+         WARN("Reached the limit of %d maximal paths.", max_isoforms);
+         warned=1;
+  }
+  return 1;
+}
+
+double Count_Maximal_Paths(){
+  int *order=NULL;
+  int *residual_in_degree=NULL;
+  double *paths=NULL;
+  double total=0;
+  int i=0, k=0, first=0, last=0, node=0;
+
+  order=(int *)malloc((number_of_transcripts+1)*sizeof(int));
+  residual_in_degree=(int *)malloc((number_of_transcripts+1)*sizeof(int));
+  paths=(double *)malloc((number_of_transcripts+1)*sizeof(double));
+  if(order == NULL || residual_in_degree == NULL || paths == NULL){
+         fprintf(stderr, "Problem1 of memory allocation in Count_Maximal_Paths!\n");
+#ifdef HALT_EXIT_MODE
+         exit(1);
+#else
+         exit(EXIT_FAILURE);
+#endif
+  }
+
+//Ordinamento topologico (sugli archi non rimossi dalla riduzione del grafo)
+  for(i=0; i<number_of_transcripts; i++){
+         residual_in_degree[i]=in_degree[i];
+         if(in_degree[i] == 0)
+                order[last++]=i;
+  }
+  while(first < last){
+         node=order[first++];
+         for(k=0; k<out_arcs[node].size; k++){
+                if(out_arcs[node].arcs[k].L != 0){
+                  residual_in_degree[out_arcs[node].arcs[k].node]--;
+                  if(residual_in_degree[out_arcs[node].arcs[k].node] == 0)
+                         order[last++]=out_arcs[node].arcs[k].node;
+                }
+         }
+  }
+  if(last != number_of_transcripts){
+         fprintf(stderr, "Cycle detected!\n");
+#ifdef HALT_EXIT_MODE
+         exit(1);
+#else
+         exit(EXIT_FAILURE);
+#endif
+  }
+
+//paths[v]: numero dei percorsi da v ad un pozzo
+  for(i=number_of_transcripts-1; i>=0; i--){
+         node=order[i];
+         paths[node]=0;
+         for(k=0; k<out_arcs[node].size; k++){
+                if(out_arcs[node].arcs[k].L != 0)
+                  paths[node]+=paths[out_arcs[node].arcs[k].node];
+         }
+         if(paths[node] == 0)
+                paths[node]=1;
+         if(paths[node] > PATH_COUNT_LIMIT)
+                paths[node]=PATH_COUNT_LIMIT;
+  }
+
+  for(i=0; i<number_of_transcripts; i++){
+         if(in_degree[i] == 0)
+                total+=paths[i];
+  }
+  if(total > PATH_COUNT_LIMIT)
+         total=PATH_COUNT_LIMIT;
+
+  free(order);
+  free(residual_in_degree);
+  free(paths);
+
+  return total;
+}
+
+double Count_Isoforms_for_Source_DAG(int source_index){
+  struct path **stack=NULL;
+  int *next_arc=NULL;
+  char *has_edge=NULL;
+  struct path *top=NULL;
+  struct path *copy=NULL;
+  double isoforms=0;
+  int depth=0, node=0, k=0;
+
+  Dag_states_clear();
+
+  stack=(struct path **)malloc((number_of_transcripts+1)*sizeof(struct path *));
+  next_arc=(int *)malloc((number_of_transcripts+1)*sizeof(int));
+  has_edge=(char *)malloc((number_of_transcripts+1)*sizeof(char));
+  if(stack == NULL || next_arc == NULL || has_edge == NULL){
+         fprintf(stderr, "Problem1 of memory allocation in Count_Isoforms_for_Source_DAG!\n");
+#ifdef HALT_EXIT_MODE
+         exit(1);
+#else
+         exit(EXIT_FAILURE);
+#endif
+  }
+
+  stack[0]=Create_Source_Path(source_list[source_index]);
+  next_arc[0]=0;
+  has_edge[0]=0;
+  depth=1;
+
+  while(depth > 0){
+         top=stack[depth-1];
+         node=top->end;
+
+//Prossimo arco (non rimosso) uscente dal nodo finale del percorso corrente
+         k=next_arc[depth-1];
+         while(k < out_arcs[node].size && out_arcs[node].arcs[k].L == 0)
+                k++;
+
+         if(k < out_arcs[node].size){
+                next_arc[depth-1]=k+1;
+                has_edge[depth-1]=1;
+
+                copy=Copy_of_Path(top);
+                Add_Node(&copy, out_arcs[node].arcs[k].node, 1);
+
+//Le estensioni di uno stato gia' visitato sono gia' state contate
+                if(Dag_state_visit(copy->end, copy->L, &copy->tr)){
+                  stack[depth]=copy;
+                  next_arc[depth]=0;
+                  has_edge[depth]=0;
+                  depth++;
+                }
+                else
+                  Free_Path(copy);
+         }
+         else{
+//Se non ci sono archi uscenti, il percorso e' massimale (e lo conto se il suo trascritto non e' gia' stato contato)
+                if(!has_edge[depth-1] && Dag_state_visit(-1, 0, &top->tr))
+                  isoforms++;
+                Free_Path(top);
+                depth--;
+         }
+  }
+
+  Dag_states_clear();
+
+  free(stack);
+  free(next_arc);
+  free(has_edge);
+
+  return isoforms;
+}
+
+char Dag_state_visit(int end, int L, struct transcript *tr){
+  struct dag_state **old_table=dag_state_table;
+  int old_size=dag_state_table_size;
+  struct dag_state *head=NULL, *help=NULL;
+  unsigned int hash=Transcript_hash(tr);
+  int i=0;
+
+  hash=(hash^(unsigned int)end)*PATH_HASH_PRIME;
+  hash=(hash^(unsigned int)L)*PATH_HASH_PRIME;
+
+  if(dag_state_table_size > 0){
+         head=dag_state_table[hash&(dag_state_table_size-1)];
+         while(head != NULL){
+                if(head->hash == hash && head->end == end && head->L == L && Equals_transcripts(head->tr, *tr))
+                  return 0;
+                head=head->next;
+         }
+  }
+
+//Raddoppio la tabella
+  if(dag_state_count >= dag_state_table_size){
+         dag_state_table_size=(old_size == 0)?(256):(2*old_size);
+         dag_state_table=(struct dag_state **)calloc(dag_state_table_size, sizeof(struct dag_state *));
+         if(dag_state_table == NULL){
+                fprintf(stderr, "Problem1 of memory allocation in Dag_state_visit!\n");
+#ifdef HALT_EXIT_MODE
+                exit(1);
+#else
+                exit(EXIT_FAILURE);
+#endif
+         }
+         for(i=0; i<old_size; i++){
+                head=old_table[i];
+                while(head != NULL){
+                  help=head->next;
+                  head->next=dag_state_table[head->hash&(dag_state_table_size-1)];
+                  dag_state_table[head->hash&(dag_state_table_size-1)]=head;
+                  head=help;
+                }
+         }
+         free(old_table);
+  }
+
+  head=(struct dag_state *)malloc(sizeof(struct dag_state));
+  if(head == NULL){
+         fprintf(stderr, "Problem2 of memory allocation in Dag_state_visit!\n");
+#ifdef HALT_EXIT_MODE
+         exit(1);
+#else
+         exit(EXIT_FAILURE);
+#endif
+  }
+  head->end=end;
+  head->L=L;
+  head->tr.exon_list=NULL;
+  Copy_transcript(*tr, &head->tr);
+  head->hash=hash;
+  i=hash&(dag_state_table_size-1);
+  head->next=dag_state_table[i];
+  dag_state_table[i]=head;
+  dag_state_count++;
+
+  return 1;
+}
+
+void Dag_states_clear(){
+  struct dag_state *head=NULL, *help=NULL;
   int i=0;
+
+  for(i=0; i<dag_state_table_size; i++){
+         head=dag_state_table[i];
+         while(head != NULL){
+                help=head->next;
+                Release_exon_list(head->tr.exon_list);
+                free(head);
+                head=help;
+         }
+         dag_state_table[i]=NULL;
+  }
+  dag_state_count=0;
+}
+
+void Set_Paths_for_Source(int source_index){
+  int i=0, k=0;
   struct path *enq_path=NULL;
   struct path *source_p=NULL;
   struct path *copy=NULL;
   char no_edge=0;
 
-  struct node *p_free=NULL;
-  struct node *help_p_free=NULL;
-
 //  struct node *head=NULL;
 //27giu05
 #ifdef PRUNE_EXON_COMP
@@ -2109,6 +2719,12 @@ void Set_Paths_for_Source(int source_index){
   while(!Queue_Is_Empty()){
          enq_path=Dequeue();
 
+//Raggiunto il limite sul numero dei percorsi: svuoto la coda
+         if(Isoform_cap_reached()){
+                Free_Path(enq_path);
+                continue;
+         }
+
 /*head=enq_path->n;
   fprintf(stdout, "Path********************************\n");
   while(head != NULL){
@@ -2126,9 +2742,10 @@ void Set_Paths_for_Source(int source_index){
          if(enq_path->visit == 1){
 #endif
 
-                for(i=0; i<number_of_transcripts; i++){
+                for(k=0; k<out_arcs[enq_path->end].size; k++){
+                  i=out_arcs[enq_path->end].arcs[k].node;
 //Esiste un arco da u a i
-                  if(extension_matrix[enq_path->end][i] != 0){
+                  if(out_arcs[enq_path->end].arcs[k].L != 0){
 //27giu05
 #ifdef PRUNE_EXON_COMP
                          same_exons_path=NULL;
@@ -2150,6 +2767,8 @@ void Set_Paths_for_Source(int source_index){
                                   same_exons_path->visit=0;
                                   Enqueue(&copy);
                                 }
+                                else
+                                  Free_Path(copy);
                          }
                          else{
 #endif
@@ -2164,6 +2783,7 @@ void Set_Paths_for_Source(int source_index){
 //Se non ci sono archi uscenti dal nodo enq_path->end, enq_path e' terminato
                 if(no_edge){
                   Set_Path_Transcripts_for_Source(enq_path);
+                  emitted_paths++;
 
 /*head=enq_path->n;
   fprintf(stdout, "\nPath number %d********************************\n", source_total_paths);
@@ -2189,19 +2809,28 @@ void Set_Paths_for_Source(int source_index){
 #endif
 
 //Libero la memoria di enq_path
-         p_free=enq_path->n;
-         while(p_free != NULL){
-                help_p_free=p_free->next;
-                free(p_free);
-                p_free=help_p_free;
-         }
-         free(enq_path);
+         Free_Path(enq_path);
+  }
+}
+
+void Free_Path(struct path *path){
+  struct node *p_free=NULL;
+  struct node *help_p_free=NULL;
+
+  p_free=path->n;
+  while(p_free != NULL){
+         help_p_free=p_free->next;
+         free(p_free);
+         p_free=help_p_free;
   }
+  Release_exon_list(path->tr.exon_list);
+  free(path);
 }
 
 void InitializeQueue(){
   struct path *head=q.head;
   struct path *help=NULL;
+  int i=0;
 
   while(head != NULL){
          help=head->next;
@@ -2210,6 +2839,10 @@ void InitializeQueue(){
 
   q.head=NULL;
   q.tail=NULL;
+
+  for(i=0; i<queue_table_size; i++)
+         queue_table[i]=NULL;
+  queue_table_count=0;
 }
 
 char Queue_Is_Empty(){
@@ -2224,6 +2857,9 @@ void Enqueue(struct path **path){
          q.tail->next=*path;
 
   q.tail=*path;
+
+  (*path)->tr_hash=Transcript_hash(&((*path)->tr));
+  Queue_table_insert(*path);
 }
 
 struct path *Dequeue(){
@@ -2237,20 +2873,100 @@ struct path *Dequeue(){
 
          if(q.head == NULL)
                 q.tail=NULL;
+
+         Queue_table_remove(value);
   }
 
   return value;
 }
 
+unsigned int Transcript_hash(struct transcript *t){
+  unsigned int hash=PATH_HASH_SEED;
+  int k=0;
+
+  hash=(hash^(unsigned int)t->left_ext)*PATH_HASH_PRIME;
+  for(k=0; k<t->exons-2; k++)
+         hash=(hash^(unsigned int)t->exon_list[k])*PATH_HASH_PRIME;
+  hash=(hash^(unsigned int)t->right_ext)*PATH_HASH_PRIME;
+
+  return hash;
+}
+
+void Queue_table_insert(struct path *path){
+  struct path **old_table=queue_table;
+  int old_size=queue_table_size;
+  struct path *head=NULL, *help=NULL;
+  int i=0;
+
+//Raddoppio la tabella (mantenendo l'ordine nelle liste di trabocco)
+  if(queue_table_count >= queue_table_size){
+         queue_table_size=(old_size == 0)?(256):(2*old_size);
+         queue_table=(struct path **)calloc(queue_table_size, sizeof(struct path *));
+         if(queue_table == NULL){
+                fprintf(stderr, "Problem1 of memory allocation in Queue_table_insert!\n");
+#ifdef HALT_EXIT_MODE
+                exit(1);
+#else
+                exit(EXIT_FAILURE);
+#endif
+         }
+         queue_table_count=0;
+         for(i=0; i<old_size; i++){
+                head=old_table[i];
+                while(head != NULL){
+                  help=head->same_hash_next;
+                  Queue_table_insert(head);
+                  head=help;
+                }
+         }
+         free(old_table);
+  }
+
+  path->same_hash_next=NULL;
+
+  i=path->tr_hash&(queue_table_size-1);
+  if(queue_table[i] == NULL)
+         queue_table[i]=path;
+  else{
+         head=queue_table[i];
+         while(head->same_hash_next != NULL)
+                head=head->same_hash_next;
+         head->same_hash_next=path;
+  }
+  queue_table_count++;
+}
+
+void Queue_table_remove(struct path *path){
+  struct path **head=NULL;
+
+  if(queue_table_size == 0)
+         return;
+
+  head=&queue_table[path->tr_hash&(queue_table_size-1)];
+  while(*head != NULL && *head != path)
+         head=&((*head)->same_hash_next);
+
+  if(*head != NULL){
+         *head=path->same_hash_next;
+         path->same_hash_next=NULL;
+         queue_table_count--;
+  }
+}
+
 struct path *Get_path_with_the_same_exons(struct path *arg_path){
-  struct path *head=q.head;
+  struct path *head=NULL;
   char found=0;
+  unsigned int hash=Transcript_hash(&arg_path->tr);
 
+  if(queue_table_size == 0)
+         return NULL;
+
+  head=queue_table[hash&(queue_table_size-1)];
   while(head != NULL && !found){
-         if(Equals_transcripts(arg_path->tr, head->tr))
+         if(head->tr_hash == hash && Equals_transcripts(arg_path->tr, head->tr))
                 found=1;
          else
-                head=head->next;
+                head=head->same_hash_next;
   }
 
   return head;
@@ -2266,6 +2982,10 @@ char Equals_transcripts(struct transcript t1, struct transcript t2){
   if(t1.left_ext != t2.left_ext || t1.right_ext != t2.right_ext)
          return 0;
 
+//Liste di esoni condivise
+  if(t1.exon_list == t2.exon_list)
+         return 1;
+
   while(k < t1.exons-2 && !stop){
          if(t1.exon_list[k] == t2.exon_list[k])
                 k++;
@@ -2284,15 +3004,7 @@ void Build_extension(struct transcript t1, struct transcript t2, int L, struct t
 //  int k=0;
 
   extension->exons=t2.exons+L;
-
-  if(extension->exons > MAX_EXONS){
-         fprintf(stderr, "Too many exons in Extension!\n");
-#ifdef HALT_EXIT_MODE
-         exit(1);
-#else
-         exit(EXIT_FAILURE);
-#endif
-  }
+  extension->exon_list=New_exon_list(extension->exons-2);
 
 /*fprintf(stdout, "\n\nBUILD1 L %d:\n", L);
   for(k=0; k<t1.exons; k++){
@@ -2362,7 +3074,7 @@ void Build_extension(struct transcript t1, struct transcript t2, int L, struct t
 }
 
 void Copy_transcript(struct transcript t, struct transcript *copy){
-  int i=0;
+  int *old_exon_list=copy->exon_list;
 
   copy->exons=t.exons;
 
@@ -2372,14 +3084,53 @@ void Copy_transcript(struct transcript t, struct transcript *copy){
   copy->type=t.type;
   strcpy(copy->RefSeq, t.RefSeq);
 
-//Riempio, con gli elementi di t i gli elementi di copy
-  for(i=0; i<t.exons-2; i++){
-         copy->exon_list[i]=t.exon_list[i];
-  }
+//La lista degli esoni di t non viene copiata ma condivisa
+  copy->exon_list=Retain_exon_list(t.exon_list);
+  Release_exon_list(old_exon_list);
 
   copy->right_ext=t.right_ext;
 }
 
+int *New_exon_list(int length){
+  struct exon_list *list=NULL;
+
+  if(length < 0)
+         length=0;
+
+  list=(struct exon_list *)malloc(sizeof(struct exon_list)+length*sizeof(int));
+  if(list == NULL){
+         fprintf(stderr, "Problem1 of memory allocation in New_exon_list!\n");
+#ifdef HALT_EXIT_MODE
+         exit(1);
+#else
+         exit(EXIT_FAILURE);
+#endif
+  }
+  list->refs=1;
+  list->length=length;
+
+  return list->exons;
+}
+
+int *Retain_exon_list(int *exon_list){
+  if(exon_list != NULL)
+         ((struct exon_list *)((char *)exon_list-offsetof(struct exon_list, exons)))->refs++;
+
+  return exon_list;
+}
+
+void Release_exon_list(int *exon_list){
+  struct exon_list *list=NULL;
+
+  if(exon_list == NULL)
+         return;
+
+  list=(struct exon_list *)((char *)exon_list-offsetof(struct exon_list, exons));
+  list->refs--;
+  if(list->refs == 0)
+         free(list);
+}
+
 /* //MODIFICA: fare in modo da non usarla piu' */
 /* void Get_Transcript_From_Path(struct path *tr_path, struct transcript *return_transcript){ */
 /*   struct node *head=tr_path->n; */
@@ -2669,14 +3420,7 @@ void Set_Path_Transcripts_for_Source(struct path *path){
   }
 
   if(!stop){
-         if(source_total_paths > MAX_TRANSCRIPTS-1){
-                fprintf(stderr, "Too many path in source transcript graph!\n");
-#ifdef HALT_EXIT_MODE
-                exit(1);
-#else
-                exit(EXIT_FAILURE);
-#endif
-         }
+         Ensure_path_transcripts_capacity(&source_path_transcript_list, &source_list_of_paths, &source_path_transcripts_capacity, source_total_paths+1);
 //MODIFICA
 //Copy_transcript(return_transcript, &source_path_transcript_list[source_total_paths]);
          Copy_transcript(path->tr, &source_path_transcript_list[source_total_paths]);
@@ -2689,14 +3433,7 @@ void Set_Path_Transcripts_for_Source(struct path *path){
 void Set_Path_Transcripts(){
   int i=0;
 
-  if(total_paths > MAX_TRANSCRIPTS){
-         fprintf(stderr, "Too many path in transcript graph!\n");
-#ifdef HALT_EXIT_MODE
-         exit(1);
-#else
-         exit(EXIT_FAILURE);
-#endif
-  }
+  Ensure_path_transcripts_capacity(&path_transcript_list, &transcript_list_of_paths, &path_transcripts_capacity, total_paths);
 
   for(i=0; i<source_total_paths; i++){
          Copy_transcript(source_path_transcript_list[i], &path_transcript_list[transcript_counter]);
@@ -2715,6 +3452,34 @@ void Set_Path_Transcripts(){
   }
 }
 
+void Ensure_path_transcripts_capacity(struct transcript **list, struct path ***paths, int *capacity, int size){
+  int i=0;
+  int new_capacity=*capacity;
+
+  if(size <= *capacity)
+         return;
+
+  while(new_capacity < size)
+         new_capacity=(new_capacity == 0)?(INITIAL_TRANSCRIPTS):(2*new_capacity);
+
+  *list=(struct transcript *)realloc(*list, new_capacity*sizeof(struct transcript));
+  *paths=(struct path **)realloc(*paths, new_capacity*sizeof(struct path *));
+  if(*list == NULL || *paths == NULL){
+         fprintf(stderr, "Problem1 of memory allocation in Ensure_path_transcripts_capacity!\n");
+#ifdef HALT_EXIT_MODE
+         exit(1);
+#else
+         exit(EXIT_FAILURE);
+#endif
+  }
+
+  for(i=*capacity; i<new_capacity; i++){
+         (*list)[i].exon_list=NULL;
+         (*paths)[i]=NULL;
+  }
+  *capacity=new_capacity;
+}
+
 void Filter_Path_Transcripts(){
   int i=0, j=0, k=0;
   char included=0;
@@ -3446,6 +4211,8 @@ struct path *Create_Source_Path(int index){
   path->next=NULL;
   path->n=NULL;
   path->tail=NULL;
+  path->tr.exon_list=NULL;
+  path->nodes_hash=PATH_HASH_SEED;
 
   Add_Node(&path, index, 1);
 
@@ -4824,8 +5591,11 @@ void Add_Path(struct path **path_list, struct path **path){
                 head=head->next;
   }
 
-  if(head != NULL)
+  if(head != NULL){
+         Free_Path(path_to_be_added);
+         path_to_be_added=NULL;
          return;
+  }
 
   path_to_be_added->next=NULL;
 
@@ -4847,7 +5617,7 @@ void Empty_Source_List_of_Paths(){
          head=source_list_of_paths[i];
          while(head != NULL){
                 help=head->next;
-                free(head);
+                Free_Path(head);
                 head=help;
          }
          source_list_of_paths[i]=NULL;
@@ -4858,7 +5628,7 @@ char Equal_Paths(struct path *path1, struct path *path2){
   char stop=0;
   struct node *nodes1=NULL, *nodes2=NULL;
 
-  if(path1->end != path2->end)
+  if(path1->end != path2->end || path1->nodes_hash != path2->nodes_hash)
          return 0;
 
   nodes1=path1->n;
@@ -4884,12 +5654,12 @@ char Equal_Paths(struct path *path1, struct path *path2){
 }
 
 void Graph_reduction(){
-  int i=0, j=0;
+  int i=0, k=0;
 
   for(i=0; i<number_of_transcripts; i++){
-         for(j=0; j<number_of_transcripts; j++){
-                if(extension_matrix[i][j] != 0)
-                  Partial_Graph_reduction_for_arc(i, j);
+         for(k=0; k<out_arcs[i].size; k++){
+                if(out_arcs[i].arcs[k].L != 0)
+                  Partial_Graph_reduction_for_arc(i, out_arcs[i].arcs[k].node);
          }
   }
 }
@@ -5005,19 +5775,20 @@ void Graph_reduction(){
 //ricerca
 int Get_Opposite_Node_Index(int a_index, int b_index, int initial_index){
   char stop=0;
-  int c_index=-1, i=0;
+  int c_index=-1, i=0, k=0;
 
-  if(extension_matrix[a_index][b_index] == 0)
+  if(Get_extension(a_index, b_index) == 0)
          return c_index;
 
-  i=initial_index;
-  while(i < number_of_transcripts && !stop){
-         if(extension_matrix[a_index][i] != 0 && extension_matrix[i][b_index] != 0){
+  k=0;
+  while(k < out_arcs[a_index].size && !stop){
+         i=out_arcs[a_index].arcs[k].node;
+         if(i >= initial_index && out_arcs[a_index].arcs[k].L != 0 && Get_extension(i, b_index) != 0){
                 stop=1;
                 c_index=i;
          }
          else
-                i++;
+                k++;
   }
 
   return c_index;
@@ -5043,27 +5814,25 @@ void Partial_Graph_reduction_for_node(int a_index, int b_index, int c_index){
   struct node *node_list=NULL, *out_node_list=NULL;
   struct node *head=NULL, *help_head=NULL, *help=NULL, *out_head=NULL;
   struct node *help_node_list=NULL;
-  int i=0;
+  int i=0, k=0;
   char changed=1, stop=0;
   char no_outcoming=1, attached=1;;
 
 //c non ha archi uscenti?
-  i=0;
-  while(i < number_of_transcripts){
-         if(extension_matrix[c_index][i] != 0 && i != b_index){
+  for(k=0; k<out_arcs[c_index].size; k++){
+         i=out_arcs[c_index].arcs[k].node;
+         if(out_arcs[c_index].arcs[k].L != 0 && i != b_index){
                 no_outcoming=0;
                 Add_Node_to_a_node_list(&out_node_list, i);
          }
-         i++;
   }
 
 //Considero tutti i nodi che entrano in quello relativo a c_index (eccetto il nodo a_index)
-  i=0;
-  while(i < number_of_transcripts){
-         if(extension_matrix[i][c_index] != 0 && i != a_index){
+  for(k=0; k<in_arcs[c_index].size; k++){
+         i=in_arcs[c_index].arcs[k].node;
+         if(in_arcs[c_index].arcs[k].L != 0 && i != a_index){
                 Add_Node_to_a_node_list(&node_list, i);
          }
-         i++;
   }
 
 //Per tutti gli n in node list tale che esiste l'arco (n,a) o (n,b), cancello l'arco (n,c)
@@ -5072,17 +5841,17 @@ void Partial_Graph_reduction_for_node(int a_index, int b_index, int c_index){
 //09mar07
          help=head->next;
 
-         if(extension_matrix[head->index][a_index] != 0){
-                extension_matrix[head->index][c_index]=0;
+         if(Get_extension(head->index, a_index) != 0){
+                Remove_extension(head->index, c_index);
                 out_degree[head->index]=out_degree[head->index]-1;
                 in_degree[c_index]=in_degree[c_index]-1;
                 Add_Node_to_a_node_list(&help_node_list, head->index);
                 Remove_Node_from_a_node_list(&node_list, head->index);
          }
          else{
-                if(extension_matrix[head->index][b_index] != 0){
+                if(Get_extension(head->index, b_index) != 0){
                   if(no_outcoming){
-                         extension_matrix[head->index][c_index]=0;
+                         Remove_extension(head->index, c_index);
                          out_degree[head->index]=out_degree[head->index]-1;
                          in_degree[c_index]=in_degree[c_index]-1;
                          Add_Node_to_a_node_list(&help_node_list, head->index);
@@ -5092,13 +5861,13 @@ void Partial_Graph_reduction_for_node(int a_index, int b_index, int c_index){
                          attached=1;
                          out_head=out_node_list;
                          while(out_head != NULL && attached){
-                                if(extension_matrix[head->index][out_head->index] == 0)
+                                if(Get_extension(head->index, out_head->index) == 0)
                                   attached=0;
 
                                 out_head=out_head->next;
                          }
                          if(attached){
-                                extension_matrix[head->index][c_index]=0;
+                                Remove_extension(head->index, c_index);
                                 out_degree[head->index]=out_degree[head->index]-1;
                                 in_degree[c_index]=in_degree[c_index]-1;
                                 Add_Node_to_a_node_list(&help_node_list, head->index);
@@ -5119,10 +5888,10 @@ void Partial_Graph_reduction_for_node(int a_index, int b_index, int c_index){
                 stop=0;
                 help_head=help_node_list;
                 while(help_head != NULL && !stop){
-                  if(extension_matrix[head->index][help_head->index] != 0){
+                  if(Get_extension(head->index, help_head->index) != 0){
                          stop=1;
                          changed=1;
-                         extension_matrix[head->index][c_index]=0;
+                         Remove_extension(head->index, c_index);
                          out_degree[head->index]=out_degree[head->index]-1;
                          in_degree[c_index]=in_degree[c_index]-1;
                          Add_Node_to_a_node_list(&help_node_list, head->index);
@@ -5140,7 +5909,7 @@ void Partial_Graph_reduction_for_node(int a_index, int b_index, int c_index){
 
 //Rimuovo anche l'arco (c,b)
   if(node_list == NULL){
-         extension_matrix[c_index][b_index]=0;
+         Remove_extension(c_index, b_index);
          out_degree[c_index]=out_degree[c_index]-1;
          in_degree[b_index]=in_degree[b_index]-1;
   }
@@ -5494,8 +6263,10 @@ void First_Filtering(){
          }
 			else if (pos!=0) {
                 transcript_list[i+pos].left_ext=transcript_list[i].left_ext;
-                for(j=0; j<transcript_list[i].exons-2; j++)
-                  transcript_list[i+pos].exon_list[j]=transcript_list[i].exon_list[j];
+//La lista degli esoni viene spostata (non copiata)
+                Release_exon_list(transcript_list[i+pos].exon_list);
+                transcript_list[i+pos].exon_list=transcript_list[i].exon_list;
+                transcript_list[i].exon_list=NULL;
                 transcript_list[i+pos].right_ext=transcript_list[i].right_ext;
                 transcript_list[i+pos].exons=transcript_list[i].exons;
                 transcript_list[i+pos].ESTs=transcript_list[i].ESTs;
@@ -36,13 +36,14 @@
 #include "refine.h"
 #include "refine-intron.h"
 #include "classify-intron.h"
+#include "nucleotide-codes.h"
 
 #include "log.h"
 
 //#define LOG_THRESHOLD LOG_LEVEL_TRACE
 
-bool try_agreement_to_intron_list(char *genomic_sequence, pintron intron_from, plist genomic_intron_list, int allowed_error){
-	my_assert(genomic_intron_list != NULL);
+bool try_agreement_to_intron_list(char *genomic_sequence, pintron intron_from, pgenomic_intron_index genomic_intron_index, int allowed_error){
+	my_assert(genomic_intron_index != NULL);
 	my_assert(genomic_sequence != NULL);
 	my_assert(intron_from->isReal == true);
 	my_assert(intron_from->agree_type != 0);
@@ -51,21 +52,20 @@ bool try_agreement_to_intron_list(char *genomic_sequence, pintron intron_from, p
 	my_assert(intron_from->donor != NULL && intron_from->acceptor != NULL);
 	my_assert(intron_from->gen_intron != NULL);
 
+	//Only the introns close on both sites can be agreed (see try_agreement)
 	bool agree_ok=false;
-	plistit agree_it=list_first(genomic_intron_list);
-	while(agree_ok == false && listit_has_next(agree_it)){
- 		ppointer pp=(ppointer)listit_next(agree_it);
-		pgenomic_intron gen_intron_to=(pgenomic_intron)pp->pointer;
+	const size_t n_candidates=genomic_intron_index_query(genomic_intron_index, intron_from->gen_intron->start, intron_from->gen_intron->end, AGREEMENT_RANGE, true);
+	for(size_t i=0; agree_ok == false && i < n_candidates; ++i){
+		pgenomic_intron gen_intron_to=genomic_intron_index_candidate(genomic_intron_index, i);
 		if(gen_intron_to->supportingESTs > 0)
 			agree_ok=try_agreement(genomic_sequence, intron_from, gen_intron_to, allowed_error);
 	}
-	listit_destroy(agree_it);
 
 	return agree_ok;
 }
 
-bool try_agreement_to_intron_list_on_single_site(char *genomic_sequence, pintron intron_from, plist gen_intron_list_to, plist gen_intron_list){
-	my_assert(gen_intron_list_to != NULL);
+bool try_agreement_to_intron_list_on_single_site(char *genomic_sequence, pintron intron_from, pgenomic_intron_index gen_intron_index_to, pgenomic_intron_registry gen_introns){
+	my_assert(gen_intron_index_to != NULL);
 	my_assert(genomic_sequence != NULL);
 	my_assert(intron_from->isReal == true);
 	my_assert(intron_from->agree_type != 0);
@@ -74,15 +74,14 @@ bool try_agreement_to_intron_list_on_single_site(char *genomic_sequence, pintron
 	my_assert(intron_from->donor != NULL && intron_from->acceptor != NULL);
 	my_assert(intron_from->gen_intron != NULL);
 
+	//Only the introns close on at least one site can be agreed (see try_agreement_on_single_site)
 	bool agree_ok=false;
-	plistit agree_it=list_first(gen_intron_list_to);
-	while(agree_ok == false && listit_has_next(agree_it)){
- 		ppointer pp=(ppointer)listit_next(agree_it);
-		pgenomic_intron gen_intron_to=(pgenomic_intron)pp->pointer;
+	const size_t n_candidates=genomic_intron_index_query(gen_intron_index_to, intron_from->gen_intron->start, intron_from->gen_intron->end, SINGLE_SITE_AGREEMENT_RANGE, false);
+	for(size_t i=0; agree_ok == false && i < n_candidates; ++i){
+		pgenomic_intron gen_intron_to=genomic_intron_index_candidate(gen_intron_index_to, i);
 		if(gen_intron_to->supportingESTs > 0)
-			agree_ok=try_agreement_on_single_site(genomic_sequence, intron_from, gen_intron_to, gen_intron_list);
+			agree_ok=try_agreement_on_single_site(genomic_sequence, intron_from, gen_intron_to, gen_introns);
 	}
-	listit_destroy(agree_it);
 
 	return agree_ok;
 }
@@ -96,7 +95,7 @@ bool try_agreement(char *genomic_sequence, pintron intron_from, pgenomic_intron
 	my_assert(intron_from->gen_intron != NULL);
 	my_assert(gen_intron_to != NULL);
 
-	int reducing_range=12; //From ASPIC parameters
+	int reducing_range=AGREEMENT_RANGE; //From ASPIC parameters
 
 	DEBUG("...to %d-%d (agree type %d)", gen_intron_to->start, gen_intron_to->end, gen_intron_to->agree_type);
 	int start_diff=intron_from->gen_intron->start-gen_intron_to->start;
@@ -111,13 +110,7 @@ bool try_agreement(char *genomic_sequence, pintron intron_from, pgenomic_intron
 			//XXX
 			if((int)error <= allowed_error){ //ASPIC parameters ==> 2
 				agree_ok=true;
-				intron_from->agreed=true;
-				intron_from->gen_intron->supportingESTs-=1;
-				intron_from->gen_intron=gen_intron_to;
-				intron_from->gen_intron->supportingESTs+=1;
-				intron_from->donor->GEN_end=intron_from->gen_intron->start-1;
-				intron_from->acceptor->GEN_start=intron_from->gen_intron->end+1;
-				Correct_est_alignment(genomic_sequence, intron_from);
+				agree_to_genomic_intron(genomic_sequence, intron_from, gen_intron_to);
 			}
 		}
 	}
@@ -128,7 +121,20 @@ bool try_agreement(char *genomic_sequence, pintron intron_from, pgenomic_intron
 	 return agree_ok;
 }
 
-bool try_agreement_on_single_site(char *genomic_sequence, pintron intron_from, pgenomic_intron gen_intron_to, plist gen_intron_list){
+void agree_to_genomic_intron(char *genomic_sequence, pintron intron_from, pgenomic_intron gen_intron_to){
+	my_assert(intron_from->agreed == false);
+	my_assert(gen_intron_to != NULL);
+
+	intron_from->agreed=true;
+	intron_from->gen_intron->supportingESTs-=1;
+	intron_from->gen_intron=gen_intron_to;
+	intron_from->gen_intron->supportingESTs+=1;
+	intron_from->donor->GEN_end=intron_from->gen_intron->start-1;
+	intron_from->acceptor->GEN_start=intron_from->gen_intron->end+1;
+	Correct_est_alignment(genomic_sequence, intron_from);
+}
+
+bool try_agreement_on_single_site(char *genomic_sequence, pintron intron_from, pgenomic_intron gen_intron_to, pgenomic_intron_registry gen_introns){
 	my_assert(intron_from->isReal == true);
 	my_assert(intron_from->agree_type == 2);
 	my_assert(intron_from->try_agree == true);
@@ -144,27 +150,27 @@ bool try_agreement_on_single_site(char *genomic_sequence, pintron intron_from, p
 	start_diff=(start_diff >= 0)?(start_diff):(-start_diff);
 	end_diff=(end_diff >= 0)?(end_diff):(-end_diff);
 
-	int reducing_range=16; //ASPIC parameter: 12
+	int reducing_range=SINGLE_SITE_AGREEMENT_RANGE; //ASPIC parameter: 12
 
 	bool agree_ok=false;
 
 	if(start_diff < reducing_range){
 		DEBUG("...try agreement on donor site");
-		agree_ok=try_agreement_on_donor_site(genomic_sequence, intron_from, gen_intron_to, gen_intron_list);
+		agree_ok=try_agreement_on_donor_site(genomic_sequence, intron_from, gen_intron_to, gen_introns);
 	}
 
 	if(agree_ok == false && end_diff < reducing_range){
 		DEBUG("...try agreement on acceptor site");
-		agree_ok=try_agreement_on_acceptor_site(genomic_sequence, intron_from, gen_intron_to, gen_intron_list);
+		agree_ok=try_agreement_on_acceptor_site(genomic_sequence, intron_from, gen_intron_to, gen_introns);
 	}
 
 	return agree_ok;
 }
 
-bool try_agreement_on_donor_site(char *genomic_sequence, pintron intron_from, pgenomic_intron gen_intron_to, plist gen_intron_list){
+bool try_agreement_on_donor_site(char *genomic_sequence, pintron intron_from, pgenomic_intron gen_intron_to, pgenomic_intron_registry gen_introns){
 	my_assert(genomic_sequence != NULL);
 	my_assert(intron_from != NULL);
-	my_assert(gen_intron_list != NULL);
+	my_assert(gen_introns != NULL);
 	my_assert(gen_intron_to != NULL);
 
 	plist candidate_burset_list=list_create();
@@ -201,17 +207,17 @@ bool try_agreement_on_donor_site(char *genomic_sequence, pintron intron_from, pg
 
 	list_sort(candidate_burset_list, (comparator)burset_frequency_compare);
 
-	bool agree_ok=try_agreement_to_a_burset_frequency_list(genomic_sequence, intron_from, candidate_burset_list, gen_intron_list, 2);
+	bool agree_ok=try_agreement_to_a_burset_frequency_list(genomic_sequence, intron_from, candidate_burset_list, gen_introns, 2);
 
 	list_destroy(candidate_burset_list, (delete_function)burset_frequency_destroy);
 
 	return agree_ok;
 }
 
-bool try_agreement_on_acceptor_site(char *genomic_sequence, pintron intron_from, pgenomic_intron gen_intron_to, plist gen_intron_list){
+bool try_agreement_on_acceptor_site(char *genomic_sequence, pintron intron_from, pgenomic_intron gen_intron_to, pgenomic_intron_registry gen_introns){
 	my_assert(genomic_sequence != NULL);
 	my_assert(intron_from != NULL);
-	my_assert(gen_intron_list != NULL);
+	my_assert(gen_introns != NULL);
 	my_assert(gen_intron_to != NULL);
 
 	plist candidate_burset_list=list_create();
@@ -248,16 +254,16 @@ bool try_agreement_on_acceptor_site(char *genomic_sequence, pintron intron_from,
 
 	list_sort(candidate_burset_list, (comparator)burset_frequency_compare);
 
-	bool agree_ok=try_agreement_to_a_burset_frequency_list(genomic_sequence, intron_from, candidate_burset_list, gen_intron_list, 2);
+	bool agree_ok=try_agreement_to_a_burset_frequency_list(genomic_sequence, intron_from, candidate_burset_list, gen_introns, 2);
 
 	list_destroy(candidate_burset_list, (delete_function)burset_frequency_destroy);
 
 	return agree_ok;
 }
 
-bool find_better_intron(char *genomic_sequence, pintron intron_from, plist gen_intron_list){
+bool find_better_intron(char *genomic_sequence, pintron intron_from, pgenomic_intron_registry gen_introns){
 	my_assert(intron_from != NULL);
-	my_assert(gen_intron_list != NULL);
+	my_assert(gen_introns != NULL);
 	my_assert(genomic_sequence != NULL);
 
 	plist candidate_burset_list=list_create();
@@ -302,7 +308,7 @@ bool find_better_intron(char *genomic_sequence, pintron intron_from, plist gen_i
 
 	list_sort(candidate_burset_list, (comparator)burset_frequency_compare);
 
-	bool agree_ok=try_agreement_to_a_burset_frequency_list(genomic_sequence, intron_from, candidate_burset_list, gen_intron_list, 0);
+	bool agree_ok=try_agreement_to_a_burset_frequency_list(genomic_sequence, intron_from, candidate_burset_list, gen_introns, 0);
 
 	list_destroy(candidate_burset_list, (delete_function)burset_frequency_destroy);
 
@@ -312,7 +318,7 @@ bool find_better_intron(char *genomic_sequence, pintron intron_from, plist gen_i
 /*
  * allowed_error is the max error for canonical pt (for other pt must be 0)
  */
-bool try_agreement_to_a_burset_frequency_list(char *genomic_sequence, pintron intron_from, plist burset_frequency_list, plist gen_intron_list, unsigned int allowed_error){
+bool try_agreement_to_a_burset_frequency_list(char *genomic_sequence, pintron intron_from, plist burset_frequency_list, pgenomic_intron_registry gen_introns, unsigned int allowed_error){
 
 	bool agree_ok=false;
 	plistit burset_it=list_first(burset_frequency_list);
@@ -346,8 +352,7 @@ bool try_agreement_to_a_burset_frequency_list(char *genomic_sequence, pintron in
 			if(error <= max_error){ //ASPIC parameters ==> 2
 				agree_ok=true;
 				intron_from->agreed=true;
-				pgenomic_intron new_gen_intron;
-				gen_intron_list=add_genomic_intron(genomic_sequence, gen_intron_list, pbf->start, pbf->end, &new_gen_intron);
+				pgenomic_intron new_gen_intron=add_genomic_intron(genomic_sequence, gen_introns, pbf->start, pbf->end);
 				if(new_gen_intron->classified == false)
 					new_gen_intron=classify_genomic_intron(genomic_sequence, new_gen_intron);
 				intron_from->gen_intron->supportingESTs-=1;
@@ -433,14 +438,14 @@ plist get_exon_composition_from_an_intron_composition(plist intron_composition){
 	return exon_composition;
 }
 
-plist get_intron_composition_from_an_exon_composition(pEST_info info, int gen_length, char *genomic_sequence, plist exon_composition, plist gen_intron_list, bool exon_ends_from_one){
+plist get_intron_composition_from_an_exon_composition(pEST_info info, int gen_length, char *genomic_sequence, plist exon_composition, pgenomic_intron_registry gen_introns, bool exon_ends_from_one){
 
 	my_assert(genomic_sequence != NULL);
 	my_assert(info != NULL);
 	my_assert(info->EST_seq != NULL);
 	my_assert(exon_composition != NULL);
 	my_assert(list_size(exon_composition) >= 1);
-	my_assert(gen_intron_list != NULL);
+	my_assert(gen_introns != NULL);
 
 	plist intron_composition=list_create();
 
@@ -471,7 +476,7 @@ plist get_intron_composition_from_an_exon_composition(pEST_info info, int gen_le
 		pgenomic_intron p=NULL;
 		if(start >= 0 && end < (int)gen_length){
 			TRACE("\tTRUE!");
-			gen_intron_list=add_genomic_intron(genomic_sequence, gen_intron_list, start, end, &p);
+			p=add_genomic_intron(genomic_sequence, gen_introns, start, end);
 			intron->isReal=true;
 			my_assert(p != NULL);
 		  }
@@ -542,30 +547,20 @@ plist get_intron_composition_from_an_exon_composition(pEST_info info, int gen_le
 	  return intron_composition;
 }
 
-plist add_genomic_intron(char *genomic_sequence, plist gen_intron_list, int start, int end, pgenomic_intron *p){
+pgenomic_intron add_genomic_intron(char *genomic_sequence, pgenomic_intron_registry gen_introns, int start, int end){
 
-	my_assert(gen_intron_list != NULL);
+	my_assert(gen_introns != NULL);
 
 	my_assert(genomic_sequence != NULL);
-	size_t gen_length=strlen(genomic_sequence);
+	my_assert(start >= 0 && start < (int)gen_introns->gen_length);
+	my_assert(end >= 0 && end < (int)gen_introns->gen_length);
 
-	my_assert(start >= 0 && start < (int)gen_length);
-	my_assert(end >= 0 && end < (int)gen_length);
-
-	plistit list_it_for_gen_intron=list_first(gen_intron_list);
-	bool found=false;
-	while(found == false && listit_has_next(list_it_for_gen_intron)){
-		 pgenomic_intron current_gen_intron=(pgenomic_intron)listit_next(list_it_for_gen_intron);
-		 if(current_gen_intron->start == start && current_gen_intron->end == end){
-			 found=true;
-			 current_gen_intron->supportingESTs=current_gen_intron->supportingESTs+1;
-			 *p=current_gen_intron;
-		 }
+	pgenomic_intron gen_intron=genomic_intron_registry_find(gen_introns, start, end);
+	if(gen_intron != NULL){
+		gen_intron->supportingESTs=gen_intron->supportingESTs+1;
 	}
-	listit_destroy(list_it_for_gen_intron);
-
-	if(found == false){
-		pgenomic_intron gen_intron=genomic_intron_create(start, end);
+	else{
+		gen_intron=genomic_intron_create(start, end);
 
 		TRACE("\tNEW!");
 		TRACE("\tfrom %d to %d", gen_intron->start, gen_intron->end);
@@ -579,11 +574,10 @@ plist add_genomic_intron(char *genomic_sequence, plist gen_intron_list, int star
 
 		gen_intron->supportingESTs=1;
 
-		list_add_to_head(gen_intron_list, gen_intron);
-		*p=gen_intron;
+		genomic_intron_registry_insert(gen_introns, gen_intron);
 	}
 
-	return gen_intron_list;
+	return gen_intron;
 }
 
 unsigned int get_agreement_error(char *genomic_sequence, pintron intron_from, pgenomic_intron gen_intron_to){
@@ -759,10 +753,7 @@ unsigned int get_agreement_error_start_end(char *genomic_sequence, pintron intro
 	size_t l1=strlen(seq_reduced);
 	size_t l2=strlen(seq_reducing);
 
-	unsigned int* M=edit_distance(seq_reduced, l1, seq_reducing, l2);
-
-	unsigned int error=M[(l1+1)*(l2+1)-1];
-	pfree(M);
+	unsigned int error=bp_edit_distance(seq_reduced, l1, seq_reducing, l2);
 	return error;
 }
 
@@ -873,17 +864,13 @@ pgenomic_intron set_intron_Burset_frequency(pgenomic_intron gen_intron){
 
 int get_intron_Burset_frequency_start_end(char *genomic_sequence, int start, int end){
 	my_assert(genomic_sequence != NULL);
+#ifndef NDEBUG
 	size_t gen_length=strlen(genomic_sequence);
 	my_assert(start >= 0 && end < (int)gen_length);
+#endif
 
-	char *donor_pt=real_substring(start, 2, genomic_sequence);
-	char *acceptor_pt=real_substring(end-1, 2, genomic_sequence);
-	my_assert(donor_pt != NULL && acceptor_pt != NULL);
-
-	int frequency=getBursetFrequency(donor_pt, acceptor_pt);
-
-	pfree(donor_pt);
-	pfree(acceptor_pt);
+	if(end < 1)
+		return 0;
 
-	return frequency;
+	return burset_frequency(genomic_sequence+start, genomic_sequence+end-1);
 }
@@ -0,0 +1,110 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010,2012  Yuri Pirola, Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+#include "arena.h"
+
+#include "log.h"
+#include "util.h"
+#include <stdlib.h>
+
+static parena_chunk
+arena_chunk_create(const size_t size) {
+  parena_chunk c= (parena_chunk)palloc(sizeof(struct _arena_chunk)+size);
+  c->next= NULL;
+  c->size= size;
+  c->data= (char*)(c+1);
+  return c;
+}
+
+parena arena_create(void) {
+  parena a= PALLOC(struct _arena);
+  a->chunks= NULL;
+  a->free= a->end= NULL;
+  a->next_chunk_size= ARENA_MIN_CHUNK_SIZE;
+  a->allocated= 0;
+  return a;
+}
+
+void* arena_alloc_slow(parena a, const size_t size) {
+  my_assert(a!=NULL);
+  parena_chunk c;
+  if (size > a->next_chunk_size/2) {
+// Oggetto grande: blocco dedicato, inserito dopo quello corrente
+// in modo da non sprecare lo spazio residuo
+	 c= arena_chunk_create(size);
+	 if (a->chunks == NULL) {
+		a->chunks= c;
+		a->free= a->end= c->data + size;
+	 } else {
+		c->next= a->chunks->next;
+		a->chunks->next= c;
+	 }
+	 a->allocated+= size;
+	 return c->data;
+  }
+  c= arena_chunk_create(a->next_chunk_size);
+  FINETRACE("Allocating a new arena chunk of %zu bytes.", c->size);
+  c->next= a->chunks;
+  a->chunks= c;
+  a->free= c->data + size;
+  a->end= c->data + c->size;
+  if (a->next_chunk_size < ARENA_MAX_CHUNK_SIZE)
+	 a->next_chunk_size*= 2;
+  a->allocated+= size;
+  return c->data;
+}
+
+void arena_release(parena a) {
+  my_assert(a!=NULL);
+  FINETRACE("Releasing an arena of %zu bytes.", a->allocated);
+  if (a->chunks != NULL) {
+	 parena_chunk c= a->chunks->next;
+	 while (c != NULL) {
+		parena_chunk tmp= c->next;
+		pfree(c);
+		c= tmp;
+	 }
+	 a->chunks->next= NULL;
+	 a->free= a->chunks->data;
+	 a->end= a->chunks->data + a->chunks->size;
+  }
+  a->allocated= 0;
+}
+
+void arena_destroy(parena a) {
+  if (a == NULL)
+	 return;
+  parena_chunk c= a->chunks;
+  while (c != NULL) {
+	 parena_chunk tmp= c->next;
+	 pfree(c);
+	 c= tmp;
+  }
+  pfree(a);
+}
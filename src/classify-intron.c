@@ -29,6 +29,7 @@
  **/
 #include <ctype.h>
 #include <math.h>
+#include <pthread.h>
 
 #include "est-factorizations.h"
 #include "classify-intron.h"
@@ -39,20 +40,149 @@
 
 //#define LOG_THRESHOLD LOG_LEVEL_TRACE
 
+//Codifica dei nucleotidi per le PWM (1+indice di riga; 0 per i simboli non validi)
+static const char nt_pwm_code[256]={
+	['A']=1, ['a']=1, ['N']=1, ['n']=1,
+	['C']=2, ['c']=2,
+	['G']=3, ['g']=3,
+	['T']=4, ['t']=4
+};
+
+static const int pwm_lengths[_PWM_NUMBER]={ 12, 12, 14, 14, 13, 14, 18, 17, 17, 18 };
+
+static struct _pwm_scorer pwm_scorer;
+static pthread_once_t pwm_scorer_once=PTHREAD_ONCE_INIT;
+
+static void build_pwm_scorer(void){
+	pwm_scorer.pwm_matx=LoadPWMMatrices();
+	pwm_scorer.CVector=LoadCVPWMMatrices(pwm_scorer.pwm_matx);
+	pwm_scorer.MAXVector=LoadMAXPWMMatrices(pwm_scorer.pwm_matx);
+	int k;
+	for(k=0; k<_PWM_NUMBER; k++){
+		const int length=pwm_lengths[k];
+		const double *pwm=pwm_scorer.pwm_matx[k];
+		const double *CVector=pwm_scorer.CVector[k];
+		const double *MAXVector=pwm_scorer.MAXVector[k];
+		pwm_model *model=&pwm_scorer.models[k];
+		model->length=length;
+		model->weight=NPALLOC(double, 4*length);
+		model->den=0.0f;
+		int i, c;
+		//Stesso ordine delle operazioni di GetMatInspectorScoreOfaMotif
+		for(i=0; i<length; i++){
+			for(c=0; c<4; c++)
+				model->weight[c*length+i]=CVector[i]*pwm[c*length+i];
+			model->den+=CVector[i]*MAXVector[i];
+		}
+	}
+}
+
+const struct _pwm_scorer *get_pwm_scorer(void){
+	pthread_once(&pwm_scorer_once, build_pwm_scorer);
+	return &pwm_scorer;
+}
+
+//Score della PWM k sulla finestra di genomic_sequence che inizia in w_start.
+//Le finestre che escono dalla sequenza vengono valutate come in precedenza
+//(sulla sottostringa troncata).
+static double score_window(const struct _pwm_scorer *sc, int k, const char * const genomic_sequence, int w_start){
+	const pwm_model *model=&sc->models[k];
+	const int length=model->length;
+	if(w_start >= 0){
+		const char *w=genomic_sequence+w_start;
+		double num=0.0f;
+		int i;
+		for(i=0; i<length && w[i] != '\0'; i++){
+			const int code=nt_pwm_code[(unsigned char)w[i]]-1;
+			my_assert(code != -1);
+			num+=model->weight[code*length+i];
+		}
+		if(i == length)
+			return num/model->den;
+	}
+	char *w=real_substring(w_start, length, genomic_sequence);
+	double score=GetMatInspectorScoreOfaMotif(w, sc->pwm_matx[k], sc->CVector[k], sc->MAXVector[k], length);
+	pfree(w);
+	return score;
+}
+
+//Come SearchBPSinIntronSequenceWithMathInspector, ma sull'introne
+//[start, start+length) della sequenza genomica
+static int search_bps(const struct _pwm_scorer *sc, int k, const char * const genomic_sequence, int start, int length, double *score, int range_start, int range_end){
+	*score=0.0f;
+
+	if(length < range_start){
+		return -1;
+	}
+
+	int start_w=length-range_end;
+	int end_w=length-range_start;
+
+	if(start_w < 0)
+		start_w=0;
+
+	int start_bps=-1;
+	int i;
+	bool firsttime=true;
+
+	for(i=start_w; i <= end_w; i++){
+		double score_bps=score_window(sc, k, genomic_sequence, start+i);
+
+		if(firsttime == true || score_bps >= *score){
+			*score=score_bps;
+			start_bps=i;
+			firsttime=false;
+		}
+	}
+
+	return start_bps;
+}
+
+//Come ExistsGoodBPSinIntronSequenceWithMathInspector
+static int exists_good_bps(const struct _pwm_scorer *sc, const char * const genomic_sequence, int start, int length, double *score, int range_start, int range_end){
+	*score=0.0f;
+
+	if(range_end > length){
+		return -1;
+	}
+
+	double score_9=0.0f;
+	double score_10=0.0f;
+	int bps_9=search_bps(sc, 0, genomic_sequence, start, length, &score_9, range_start, range_end);
+	int bps_10=search_bps(sc, 1, genomic_sequence, start, length, &score_10, range_start, range_end);
+
+	int bps_pos=-1;
+
+	if(score_9 > score_10){
+		if(score_9 > 0.75f){
+			*score=score_9;
+			bps_pos=bps_9;
+		}
+	}
+	else{
+		if(score_10 > 0.75f){
+			*score=score_10;
+			bps_pos=bps_10;
+		}
+	}
+
+	return bps_pos;
+}
+
+static inline bool has_dinucleotide(const char * const s, const char * const lower, const char * const upper){
+	return (s[0] == lower[0] && s[1] == lower[1]) || (s[0] == upper[0] && s[1] == upper[1]);
+}
+
 plist classify_genomic_intron_list(char *genomic_sequence, plist gen_intron_list){
 	my_assert(genomic_sequence != NULL);
 	my_assert(gen_intron_list != NULL);
 
-	double **pwm_matx=LoadPWMMatrices();
-	double **CVector=LoadCVPWMMatrices(pwm_matx);
-	double **MAXVector=LoadMAXPWMMatrices(pwm_matx);
-
 	plistit list_it_for_gen_intron=list_first(gen_intron_list);
 	while(listit_has_next(list_it_for_gen_intron)){
 		 pgenomic_intron current_gen_intron=(pgenomic_intron)listit_next(list_it_for_gen_intron);
 		 double score5, score3, BPS_score;
 		 int BPS_position;
-		 current_gen_intron->type=classify_genomic_intron_start_end(genomic_sequence, current_gen_intron->start, current_gen_intron->end, &score5, &score3, &BPS_position, &BPS_score, pwm_matx, CVector, MAXVector);
+		 current_gen_intron->type=classify_genomic_intron_start_end(genomic_sequence, current_gen_intron->start, current_gen_intron->end, &score5, &score3, &BPS_position, &BPS_score);
 		 current_gen_intron->score5=score5;
 		 current_gen_intron->score3=score3;
 		 current_gen_intron->BPS_position=BPS_position;
@@ -61,10 +191,6 @@ plist classify_genomic_intron_list(char *genomic_sequence, plist gen_intron_list
 	}
 	listit_destroy(list_it_for_gen_intron);
 
-	FreePWMMatrices(pwm_matx);
-	FreeCVPWMMatrices(CVector);
-	FreeMAXPWMMatrices(MAXVector);
-
 	return gen_intron_list;
 }
 
@@ -72,27 +198,24 @@ pgenomic_intron classify_genomic_intron(char *genomic_sequence, pgenomic_intron
 	my_assert(genomic_sequence != NULL);
 	my_assert(gen_intron != NULL);
 
-	double **pwm_matx=LoadPWMMatrices();
-	double **CVector=LoadCVPWMMatrices(pwm_matx);
-	double **MAXVector=LoadMAXPWMMatrices(pwm_matx);
-
 	 double score5, score3, BPS_score;
 	 int BPS_position;
-	 gen_intron->type=classify_genomic_intron_start_end(genomic_sequence, gen_intron->start, gen_intron->end, &score5, &score3, &BPS_position, &BPS_score, pwm_matx, CVector, MAXVector);
+	 gen_intron->type=classify_genomic_intron_start_end(genomic_sequence, gen_intron->start, gen_intron->end, &score5, &score3, &BPS_position, &BPS_score);
 	 gen_intron->score5=score5;
 	 gen_intron->score3=score3;
 	 gen_intron->BPS_position=BPS_position;
 	 gen_intron->BPS_score=BPS_score;
 	 gen_intron->classified=true;
 
-	FreePWMMatrices(pwm_matx);
-	FreeCVPWMMatrices(CVector);
-	FreeMAXPWMMatrices(MAXVector);
-
 	return gen_intron;
 }
 
-char classify_genomic_intron_start_end(const char * const genomic_sequence, int start, int end, double *score5, double *score3, int *BPS_position, double *BPS_score, double **pwm_matx, double **CVector, double **MAXVector){
+//Le finestre delle PWM sono relative ai siti di splicing:
+//5' da splice5-3, 3' da splice3-14+1 (vedi le funzioni GetScoreOf*BySS)
+#define _SCORE5( k ) score_window(sc, (k), genomic_sequence, start-3)
+#define _SCORE3( k ) score_window(sc, (k), genomic_sequence, end-14+1)
+
+char classify_genomic_intron_start_end(const char * const genomic_sequence, int start, int end, double *score5, double *score3, int *BPS_position, double *BPS_score){
 #ifndef NDEBUG
 	my_assert(genomic_sequence != NULL);
 	size_t gen_length=strlen(genomic_sequence);
@@ -104,17 +227,18 @@ char classify_genomic_intron_start_end(const char * const genomic_sequence, int
 	my_assert(score3 != NULL);
 	my_assert(BPS_position != NULL);
 	my_assert(BPS_score != NULL);
-	my_assert(pwm_matx != NULL);
-	my_assert(CVector != NULL);
-	my_assert(MAXVector != NULL);
 #endif
 
+	const struct _pwm_scorer *sc=get_pwm_scorer();
+	const int intron_length=end-start+1;
+
 	//BPS is searched inside a window from the 14th to 30th nucleotide before the intron 3' site
-	char *intronSequence=real_substring(start, end-start+1, genomic_sequence);
-	*BPS_position=ExistsGoodBPSinIntronSequenceWithMathInspector(intronSequence, pwm_matx[0], pwm_matx[1], CVector[0], CVector[1], MAXVector[0], MAXVector[1], BPS_score, 14, 30);
+	*BPS_position=exists_good_bps(sc, genomic_sequence, start, intron_length, BPS_score, 14, 30);
 
-	char *pt_5=real_substring(0, 2, intronSequence);
-	char *pt_3=real_substring(strlen(intronSequence)-2, 2, intronSequence);
+	//Dinucleotidi agli estremi dell'introne (letti sul posto)
+	const char *pt_5=genomic_sequence+start;
+	const char *pt_3=genomic_sequence+end-1;
+	const bool pt_5_valid=(intron_length >= 2);
 
 	double scoreU12_3=0.0f, scoreU2_3=0.0f;
 	double scoreU12_3_2=0.0f, scoreU2_3_2=0.0f;
@@ -123,65 +247,65 @@ char classify_genomic_intron_start_end(const char * const genomic_sequence, int
 
 	char pt_type=1;	/*0=gt-ag or gc-ag; 1=altro*/
 
-	if((!strcmp(pt_5, "gt") || !strcmp(pt_5, "GT")) && (!strcmp(pt_3, "ag") || !strcmp(pt_3, "AG"))){
+	if(pt_5_valid && has_dinucleotide(pt_5, "gt", "GT") && has_dinucleotide(pt_3, "ag", "AG")){
 		pt_type=0;
-		scoreU12_5=GetScoreOf5PrimeGTAGU12BySS(genomic_sequence, start, pwm_matx[2], CVector[2], MAXVector[2]);
-		scoreU2_5=GetScoreOf5PrimeGTAGU2BySS(genomic_sequence, start, pwm_matx[4], CVector[4], MAXVector[4]);
+		scoreU12_5=_SCORE5(2);
+		scoreU2_5=_SCORE5(4);
 
-		scoreU12_3=GetScoreOf3PrimeGTAGU12BySS(genomic_sequence, end, pwm_matx[6], CVector[6], MAXVector[6]);
-		scoreU2_3=GetScoreOf3PrimeGTAGU2BySS(genomic_sequence, end, pwm_matx[8], CVector[8], MAXVector[8]);
+		scoreU12_3=_SCORE3(6);
+		scoreU2_3=_SCORE3(8);
 	}
 	else{
-		if((!strcmp(pt_5, "gc") || !strcmp(pt_5, "GC")) && (!strcmp(pt_3, "ag") || !strcmp(pt_3, "AG"))){
+		if(pt_5_valid && has_dinucleotide(pt_5, "gc", "GC") && has_dinucleotide(pt_3, "ag", "AG")){
 			pt_type=0;
 
-			scoreU2_5=GetScoreOf5PrimeGCAGU2BySS(genomic_sequence, start, pwm_matx[5], CVector[5], MAXVector[5]);
-			scoreU2_3=GetScoreOf3PrimeGCAGU2BySS(genomic_sequence, end, pwm_matx[9], CVector[9], MAXVector[9]);
-			scoreU12_5=GetScoreOf5PrimeGTAGU12BySS(genomic_sequence, start, pwm_matx[2], CVector[2], MAXVector[2]);
+			scoreU2_5=_SCORE5(5);
+			scoreU2_3=_SCORE3(9);
+			scoreU12_5=_SCORE5(2);
 
-			scoreU12_5_2=GetScoreOf5PrimeATACU12BySS(genomic_sequence, start, pwm_matx[3], CVector[3], MAXVector[3]);
+			scoreU12_5_2=_SCORE5(3);
 			if(scoreU12_5_2 > scoreU12_5)
 				scoreU12_5=scoreU12_5_2;
 
-			scoreU12_3=GetScoreOf3PrimeGTAGU12BySS(genomic_sequence, end, pwm_matx[6], CVector[6], MAXVector[6]);
+			scoreU12_3=_SCORE3(6);
 
-			scoreU12_3_2=GetScoreOf3PrimeATACU12BySS(genomic_sequence, end, pwm_matx[7], CVector[7], MAXVector[7]);
+			scoreU12_3_2=_SCORE3(7);
 			if(scoreU12_3_2 > scoreU12_3)
 				scoreU12_3=scoreU12_3_2;
 		}
 		else{
-			if((!strcmp(pt_5, "at") || !strcmp(pt_5, "AT")) && (!strcmp(pt_3, "ac") || !strcmp(pt_3, "AC"))){
-				scoreU12_5=GetScoreOf5PrimeATACU12BySS(genomic_sequence, start, pwm_matx[3], CVector[3], MAXVector[3]);
-				scoreU12_3=GetScoreOf3PrimeATACU12BySS(genomic_sequence, end, pwm_matx[7], CVector[7], MAXVector[7]);
+			if(pt_5_valid && has_dinucleotide(pt_5, "at", "AT") && has_dinucleotide(pt_3, "ac", "AC")){
+				scoreU12_5=_SCORE5(3);
+				scoreU12_3=_SCORE3(7);
 
-				scoreU2_5=GetScoreOf5PrimeGTAGU2BySS(genomic_sequence, start, pwm_matx[4], CVector[4], MAXVector[4]);
-				scoreU2_5_2=GetScoreOf5PrimeGCAGU2BySS(genomic_sequence, start, pwm_matx[5], CVector[5], MAXVector[5]);
+				scoreU2_5=_SCORE5(4);
+				scoreU2_5_2=_SCORE5(5);
 				if(scoreU2_5_2 > scoreU2_5)
 					scoreU2_5=scoreU2_5_2;
 
-				scoreU2_3=GetScoreOf3PrimeGTAGU2BySS(genomic_sequence, end, pwm_matx[8], CVector[8], MAXVector[8]);
-				scoreU2_3_2=GetScoreOf3PrimeGCAGU2BySS(genomic_sequence, end, pwm_matx[9], CVector[9], MAXVector[9]);
+				scoreU2_3=_SCORE3(8);
+				scoreU2_3_2=_SCORE3(9);
 				if(scoreU2_3_2 > scoreU2_3)
 					scoreU2_3=scoreU2_3_2;
 			}
 			else{
-				scoreU12_5=GetScoreOf5PrimeGTAGU12BySS(genomic_sequence, start, pwm_matx[2], CVector[2], MAXVector[2]);
-				scoreU12_5_2=GetScoreOf5PrimeATACU12BySS(genomic_sequence, start, pwm_matx[3], CVector[3], MAXVector[3]);
+				scoreU12_5=_SCORE5(2);
+				scoreU12_5_2=_SCORE5(3);
 				if(scoreU12_5_2 > scoreU12_5)
 					scoreU12_5=scoreU12_5_2;
 
-				scoreU2_5=GetScoreOf5PrimeGTAGU2BySS(genomic_sequence, start, pwm_matx[4], CVector[4], MAXVector[4]);
-				scoreU2_5_2=GetScoreOf5PrimeGCAGU2BySS(genomic_sequence, start, pwm_matx[5], CVector[5], MAXVector[5]);
+				scoreU2_5=_SCORE5(4);
+				scoreU2_5_2=_SCORE5(5);
 				if(scoreU2_5_2 > scoreU2_5)
 					scoreU2_5=scoreU2_5_2;
 
-				scoreU12_3=GetScoreOf3PrimeGTAGU12BySS(genomic_sequence, end, pwm_matx[6], CVector[6], MAXVector[6]);
-				scoreU12_3_2=GetScoreOf3PrimeATACU12BySS(genomic_sequence, end, pwm_matx[7], CVector[7], MAXVector[7]);
+				scoreU12_3=_SCORE3(6);
+				scoreU12_3_2=_SCORE3(7);
 				if(scoreU12_3_2 > scoreU12_3)
 					scoreU12_3=scoreU12_3_2;
 
-				scoreU2_3=GetScoreOf3PrimeGTAGU2BySS(genomic_sequence, end, pwm_matx[8], CVector[8], MAXVector[8]);
-				scoreU2_3_2=GetScoreOf3PrimeGCAGU2BySS(genomic_sequence, end, pwm_matx[9], CVector[9], MAXVector[9]);
+				scoreU2_3=_SCORE3(8);
+				scoreU2_3_2=_SCORE3(9);
 				if(scoreU2_3_2 > scoreU2_3)
 					scoreU2_3=scoreU2_3_2;
 			}
@@ -199,12 +323,12 @@ char classify_genomic_intron_start_end(const char * const genomic_sequence, int
 		//Se e' gt-ag o gc-ag
 		if(pt_type == 0){
 			type=1;
-			*BPS_position=ExistsGoodBPSinIntronSequenceWithMathInspector(intronSequence, pwm_matx[0], pwm_matx[1], CVector[0], CVector[1], MAXVector[0], MAXVector[1], BPS_score, 30, 200);
+			*BPS_position=exists_good_bps(sc, genomic_sequence, start, intron_length, BPS_score, 30, 200);
 		}
 		else{
 			if(scoreU12_5-scoreU2_5 > 0.25 && scoreU12_5 >= 0.75){
 				type=0;
-				*BPS_position=ExistsGoodBPSinIntronSequenceWithMathInspector(intronSequence, pwm_matx[0], pwm_matx[1], CVector[0], CVector[1], MAXVector[0], MAXVector[1], BPS_score, 30, 200);
+				*BPS_position=exists_good_bps(sc, genomic_sequence, start, intron_length, BPS_score, 30, 200);
 			}
 		}
 	}
@@ -221,13 +345,12 @@ char classify_genomic_intron_start_end(const char * const genomic_sequence, int
 		*score3=scoreU2_3;
 	}
 
-	pfree(pt_5);
-	pfree(pt_3);
-	pfree(intronSequence);
-
 	return type;
 }
 
+#undef _SCORE5
+#undef _SCORE3
+
 double GetScoreOf5PrimeGTAGU12BySS(const char * const genomic_sequence, int splice5, double *pwm_5PrimeGTAGU12, double *CV_pwm_5PrimeGTAGU12, double *MAXV_pwm_5PrimeGTAGU12){
 
 	my_assert(splice5 >= 0);
@@ -633,24 +756,7 @@ double GetMatInspectorScoreOfaMotif(char *sequence, double *pwm, double *CVector
 	double den=0.0f;
 	double num=0.0f;
 	for(i=0; i<motif_length; i++){
-		int index=-1;
-
-		if(sequence[i] == 'N' || sequence[i] == 'n'){
-			index=0;
-		}
-
-		if(sequence[i] == 'A' || sequence[i] == 'a'){
-			index=0;
-		}
-		if(sequence[i] == 'C' || sequence[i] == 'c'){
-			index=1;
-		}
-		if(sequence[i] == 'G' || sequence[i] == 'g'){
-			index=2;
-		}
-		if(sequence[i] == 'T' || sequence[i] == 't'){
-			index=3;
-		}
+		const int index=nt_pwm_code[(unsigned char)sequence[i]]-1;
 		my_assert(index != -1);
 
 		num+=CVector[i]*pwm[index*motif_length+i];
@@ -1682,8 +1788,14 @@ pgenomic_intron set_pattern(char *genomic_sequence, pgenomic_intron gen_intron){
 	my_assert(gen_intron->end >= 0 && gen_intron->end < (int)gen_length);
 #endif
 
+	//I pattern sono memorizzati in maiuscolo
 	gen_intron->donor_pt=real_substring(gen_intron->start, 2, genomic_sequence);
 	gen_intron->acceptor_pt=real_substring(gen_intron->end-1, 2, genomic_sequence);
+	int i;
+	for(i=0; gen_intron->donor_pt[i] != '\0'; i++)
+		gen_intron->donor_pt[i]=toupper(gen_intron->donor_pt[i]);
+	for(i=0; gen_intron->acceptor_pt[i] != '\0'; i++)
+		gen_intron->acceptor_pt[i]=toupper(gen_intron->acceptor_pt[i]);
 
 	return gen_intron;
 }
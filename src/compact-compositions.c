@@ -0,0 +1,916 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010  Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+/**
+ *
+ * @file compact-compositions.c
+ *
+ * Compattazione delle composizioni esoniche dei trascritti
+ * (step "compact-compositions" della pipeline).
+ * E' la traduzione dello script compact-compositions-perl: gli hash
+ * dello script sono sostituiti da tabelle hash indicizzate da stringhe
+ * e le composizioni sono visitate nello stesso ordine (lessicografico
+ * delle chiavi), quindi l'output e' identico.
+ *
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+#include "util.h"
+#include "arena.h"
+#include "io-multifasta.h"
+#include "compact-compositions.h"
+
+#include "log.h"
+
+#define CC_FAILURE( n )								\
+  do {													\
+	 FATAL("Failure " n "! Terminating");		\
+	 fail();												\
+  } while (0)
+
+/*
+  Tabella hash (con liste di trabocco) indicizzata da stringhe.
+  Chiavi ed elementi sono allocati nell'arena, che contiene anche i
+  valori associati.
+*/
+
+typedef struct _cc_map_entry* pcc_map_entry;
+
+struct _cc_map_entry {
+  const char* key;
+  void* value;
+  pcc_map_entry next;
+};
+
+typedef struct _cc_map* pcc_map;
+
+struct _cc_map {
+  parena a;
+  size_t size;
+  size_t n_buckets;
+  pcc_map_entry* buckets;
+};
+
+static char*
+cc_strndup(parena a, const char* const s, const size_t len) {
+  char* r= (char*)arena_alloc(a, len+1);
+  memcpy(r, s, len);
+  r[len]= '\0';
+  return r;
+}
+
+static size_t
+cc_hash(const char* s) {
+// FNV-1a
+  uint64_t h= 14695981039346656037ULL;
+  for (; *s != '\0'; ++s) {
+	 h^= (unsigned char)*s;
+	 h*= 1099511628211ULL;
+  }
+  return (size_t)h;
+}
+
+static pcc_map
+cc_map_create(parena a) {
+  pcc_map m= ARENA_PALLOC(a, struct _cc_map);
+  m->a= a;
+  m->size= 0;
+  m->n_buckets= 64;
+  m->buckets= NPALLOC(pcc_map_entry, m->n_buckets);
+  for (size_t i= 0; i<m->n_buckets; ++i)
+	 m->buckets[i]= NULL;
+  return m;
+}
+
+static void
+cc_map_destroy(pcc_map m) {
+  pfree(m->buckets);
+}
+
+static pcc_map_entry
+cc_map_find(pcc_map m, const char* const key) {
+  pcc_map_entry e= m->buckets[cc_hash(key) & (m->n_buckets-1)];
+  while ((e != NULL) && (strcmp(e->key, key) != 0))
+	 e= e->next;
+  return e;
+}
+
+static void
+cc_map_grow(pcc_map m) {
+  const size_t n_buckets= 2*m->n_buckets;
+  pcc_map_entry* buckets= NPALLOC(pcc_map_entry, n_buckets);
+  for (size_t i= 0; i<n_buckets; ++i)
+	 buckets[i]= NULL;
+  for (size_t i= 0; i<m->n_buckets; ++i) {
+	 pcc_map_entry e= m->buckets[i];
+	 while (e != NULL) {
+		pcc_map_entry next= e->next;
+		const size_t h= cc_hash(e->key) & (n_buckets-1);
+		e->next= buckets[h];
+		buckets[h]= e;
+		e= next;
+	 }
+  }
+  pfree(m->buckets);
+  m->buckets= buckets;
+  m->n_buckets= n_buckets;
+}
+
+// Restituisce l'elemento con chiave key, creandolo (con valore NULL)
+// se non esiste
+static pcc_map_entry
+cc_map_get(pcc_map m, const char* const key) {
+  pcc_map_entry e= cc_map_find(m, key);
+  if (e != NULL)
+	 return e;
+  if (m->size >= m->n_buckets)
+	 cc_map_grow(m);
+  e= ARENA_PALLOC(m->a, struct _cc_map_entry);
+  e->key= cc_strndup(m->a, key, strlen(key));
+  e->value= NULL;
+  const size_t h= cc_hash(key) & (m->n_buckets-1);
+  e->next= m->buckets[h];
+  m->buckets[h]= e;
+  ++m->size;
+  return e;
+}
+
+static int
+cc_map_entry_compare(const void* p1, const void* p2) {
+  return strcmp((*(const pcc_map_entry*)p1)->key,
+					 (*(const pcc_map_entry*)p2)->key);
+}
+
+// Elementi della tabella in ordine lessicografico di chiave
+// (come 'sort keys' in Perl)
+static pcc_map_entry*
+cc_map_sorted_entries(pcc_map m) {
+  pcc_map_entry* v= NPALLOC(pcc_map_entry, m->size+1);
+  size_t n= 0;
+  for (size_t i= 0; i<m->n_buckets; ++i)
+	 for (pcc_map_entry e= m->buckets[i]; e != NULL; e= e->next)
+		v[n++]= e;
+  my_assert(n == m->size);
+  qsort(v, n, sizeof(pcc_map_entry), cc_map_entry_compare);
+  return v;
+}
+
+
+/*
+  Composizioni
+*/
+
+struct _cc_exon {
+  int left;
+  int right;
+  const char* est_seq;
+  const char* gen_seq;
+};
+
+// Composizione associata a un GB id
+// (composition_hash e polya_hash dello script)
+typedef struct _cc_composition* pcc_composition;
+
+struct _cc_composition {
+  const char* gb;
+  bool is_RefSeq;
+  int n_ESTs;
+  int polya;
+  size_t n_exons;
+  struct _cc_exon* exons;
+};
+
+// Lista dei GB id delle composizioni con la stessa sequenza di esoni
+// interni (compact_composition dello script)
+typedef struct _cc_id* pcc_id;
+
+struct _cc_id {
+  pcc_composition c;
+  pcc_id next;
+};
+
+struct _cc_id_list {
+  pcc_id head;
+  pcc_id tail;
+};
+
+// Occorrenza di un esone in una composizione
+// (left_exon_hash e right_exon_hash dello script)
+struct _cc_occurrence {
+  int left;
+  int right;
+  size_t order;
+  pcc_composition c;
+};
+
+// Esone di output
+struct _cc_printed_exon {
+  int left;
+  int right;
+  int polya;
+  size_t index;
+  const char* seq;
+};
+
+// Composizione di output
+struct _cc_printed_composition {
+  int n_ESTs;
+  const char* gb;
+  size_t n_exons;
+  size_t* indexes;
+};
+
+static bool
+is_RefSeq_id(const char* const gb) {
+  return (strncmp(gb, "NM_", 3) == 0) || (strncmp(gb, "NR_", 3) == 0);
+}
+
+static void
+check_exon_length(const struct _cc_exon* const e, const char* const failure) {
+  if ((size_t)(e->right - e->left + 1) != strlen(e->gen_seq)) {
+	 FATAL("Failure %s! Terminating", failure);
+	 fail();
+  }
+}
+
+static void
+set_int_value(parena a, pcc_map_entry e, const int value) {
+  if (e->value == NULL)
+	 e->value= ARENA_PALLOC(a, int);
+  *(int*)e->value= value;
+}
+
+static pcc_composition
+get_composition(parena a, pcc_map compositions, const char* const gb) {
+  pcc_map_entry e= cc_map_get(compositions, gb);
+  if (e->value == NULL) {
+	 pcc_composition c= ARENA_PALLOC(a, struct _cc_composition);
+	 c->gb= e->key;
+	 c->is_RefSeq= is_RefSeq_id(gb);
+	 c->n_ESTs= 0;
+	 c->polya= 0;
+	 c->n_exons= 0;
+	 c->exons= NULL;
+	 e->value= c;
+  }
+  return (pcc_composition)e->value;
+}
+
+static void
+add_id(parena a, struct _cc_id_list* ids, pcc_composition c) {
+  pcc_id id= ARENA_PALLOC(a, struct _cc_id);
+  id->c= c;
+  id->next= NULL;
+  if (ids->tail == NULL)
+	 ids->head= id;
+  else
+	 ids->tail->next= id;
+  ids->tail= id;
+}
+
+/*
+  Aggiunge la composizione di un trascritto: se esiste gia' una
+  composizione (non RefSeq) con gli stessi esoni interni e con esoni
+  esterni compatibili (rispetto al segnale di polyA), gli esoni esterni
+  di quest'ultima vengono estesi e viene incrementato il numero di EST
+*/
+static void
+add_composition(parena a, pcc_map compositions, pcc_map compact,
+					 const char* const gb, struct _cc_exon* exons,
+					 const size_t n_exons, const int polya) {
+  const bool is_RefSeq= is_RefSeq_id(gb);
+  char* key= NULL;
+  if (n_exons > 1) {
+	 key= NPALLOC(char, 24*n_exons + strlen(gb) + 1);
+	 size_t len= sprintf(key, "%d-", exons[0].right);
+	 for (size_t i= 1; i+1<n_exons; ++i)
+		len+= sprintf(key+len, "%d-%d-", exons[i].left, exons[i].right);
+	 len+= sprintf(key+len, "%d-", exons[n_exons-1].left);
+	 if (is_RefSeq)
+		strcpy(key+len, gb);
+  }
+
+  pcc_map_entry ek= (key != NULL) ? cc_map_find(compact, key) : NULL;
+  if (ek != NULL) {
+	 if (is_RefSeq)
+		CC_FAILURE("1");
+	 struct _cc_id_list* ids= (struct _cc_id_list*)ek->value;
+	 for (pcc_id id= ids->head; id != NULL; id= id->next) {
+		pcc_composition c= id->c;
+		if (c->n_exons != n_exons)
+		  CC_FAILURE("4");
+		struct _cc_exon* first= &c->exons[0];
+		struct _cc_exon* last= &c->exons[n_exons-1];
+		const struct _cc_exon* add_first= &exons[0];
+		const struct _cc_exon* add_last= &exons[n_exons-1];
+		if ((first->right != add_first->right) || (last->left != add_last->left))
+		  CC_FAILURE("5");
+// L'ultimo esone puo' essere esteso solo se non termina con un polyA
+		const struct _cc_exon* new_last= NULL;
+		if (polya == 1) {
+		  if (c->polya == 1) {
+			 if (last->right == add_last->right)
+				new_last= last;
+		  } else {
+			 if (last->right <= add_last->right)
+				new_last= add_last;
+		  }
+		} else {
+		  if (c->polya == 1) {
+			 if (last->right >= add_last->right)
+				new_last= last;
+		  } else {
+			 new_last= (last->right >= add_last->right) ? last : add_last;
+		  }
+		}
+		if (new_last != NULL) {
+		  if (first->left > add_first->left) {
+			 first->left= add_first->left;
+			 first->est_seq= add_first->est_seq;
+			 first->gen_seq= add_first->gen_seq;
+		  }
+		  if (c->polya == 0)
+			 c->polya= polya;
+		  check_exon_length(first, "13");
+		  if (new_last != last) {
+			 last->right= new_last->right;
+			 last->est_seq= new_last->est_seq;
+			 last->gen_seq= new_last->gen_seq;
+		  }
+		  check_exon_length(last, "13");
+		  ++c->n_ESTs;
+		  pfree(key);
+		  return;
+		}
+	 }
+	 add_id(a, ids, get_composition(a, compositions, gb));
+  } else {
+	 if (key != NULL) {
+		struct _cc_id_list* ids= ARENA_PALLOC(a, struct _cc_id_list);
+		ids->head= ids->tail= NULL;
+		cc_map_get(compact, key)->value= ids;
+		if (cc_map_find(compositions, gb) != NULL)
+		  CC_FAILURE("2");
+		add_id(a, ids, get_composition(a, compositions, gb));
+	 }
+  }
+  pcc_composition c= get_composition(a, compositions, gb);
+  c->n_ESTs= 1;
+  c->polya= polya;
+  c->n_exons= n_exons;
+  c->exons= exons;
+  if (key != NULL)
+	 pfree(key);
+}
+
+// Il GB id e' la prima sequenza (non vuota) di caratteri alfanumerici
+// che segue "/gb="
+static const char*
+find_GB_id(const char* const header, size_t* plen) {
+  const char* p= strstr(header, "/gb=");
+  while (p != NULL) {
+	 size_t len= 0;
+	 while (isalnum((unsigned char)p[4+len]) || (p[4+len] == '_'))
+		++len;
+	 if (len > 0) {
+		*plen= len;
+		return p+4;
+	 }
+	 p= strstr(p+1, "/gb=");
+  }
+  return NULL;
+}
+
+static const char*
+parse_number(const char* p, int* n) {
+  if (!isdigit((unsigned char)*p))
+	 return NULL;
+  char* end;
+  *n= (int)strtol(p, &end, 10);
+  return end;
+}
+
+static const char*
+parse_word(const char* p, const char** w, size_t* len) {
+  *w= p;
+  while (isalnum((unsigned char)*p) || (*p == '_'))
+	 ++p;
+  *len= p - *w;
+  return (*len > 0) ? p : NULL;
+}
+
+static const char*
+skip_spaces(const char* p, const bool at_least_one) {
+  if (at_least_one && !isspace((unsigned char)*p))
+	 return NULL;
+  while (isspace((unsigned char)*p))
+	 ++p;
+  return p;
+}
+
+// Legge una riga "est_left est_right gen_left gen_right est_seq gen_seq"
+static bool
+parse_exon_row(parena a, const char* p, struct _cc_exon* e) {
+  int n;
+  p= skip_spaces(p, false);
+  for (int i= 0; i<4; ++i) {
+	 if (i > 0 && (p= skip_spaces(p, true)) == NULL)
+		return false;
+	 if ((p= parse_number(p, &n)) == NULL)
+		return false;
+	 if (i == 2)
+		e->left= n;
+	 else if (i == 3)
+		e->right= n;
+  }
+  const char* w;
+  size_t len;
+  if ((p= skip_spaces(p, true)) == NULL || (p= parse_word(p, &w, &len)) == NULL)
+	 return false;
+  e->est_seq= cc_strndup(a, w, len);
+  if ((p= skip_spaces(p, true)) == NULL || (p= parse_word(p, &w, &len)) == NULL)
+	 return false;
+  e->gen_seq= cc_strndup(a, w, len);
+  return true;
+}
+
+static void
+read_compositions(parena a, FILE* fcompositions, FILE* fccds,
+						pcc_map compositions, pcc_map compact) {
+  size_t n_bytes= 1024;
+  char* line= c_palloc(n_bytes);
+  ssize_t len;
+  size_t max_exons= 16;
+  struct _cc_exon* exons= NPALLOC(struct _cc_exon, max_exons);
+  size_t n_exons= 0;
+  int polya= 0;
+  char* gb= NULL;
+
+  while (true) {
+	 len= custom_getline(&line, &n_bytes, fcompositions);
+	 if ((len < 0) || (line[0] == '>')) {
+// Fine della composizione corrente
+		if (gb != NULL) {
+		  if (is_RefSeq_id(gb)) {
+			 for (size_t i= 0; i<n_exons; ++i)
+				fprintf(fccds, "%d %d %s\n",
+						  exons[i].left, exons[i].right, exons[i].est_seq);
+		  }
+		  struct _cc_exon* cexons=
+			 (struct _cc_exon*)arena_alloc(a, (n_exons+1)*sizeof(struct _cc_exon));
+		  memcpy(cexons, exons, n_exons*sizeof(struct _cc_exon));
+		  add_composition(a, compositions, compact, gb, cexons, n_exons, polya);
+		}
+		if (len < 0)
+		  break;
+		if ((len > 0) && (line[len-1] == '\n'))
+		  line[--len]= '\0';
+		size_t gb_len;
+		const char* p= find_GB_id(line+1, &gb_len);
+		if (p == NULL) {
+		  FATAL("No GB ID found for %s! Terminating", line+1);
+		  fail();
+		}
+		gb= cc_strndup(a, p, gb_len);
+		n_exons= 0;
+		polya= 0;
+	 } else {
+		if ((len > 0) && (line[len-1] == '\n'))
+		  line[--len]= '\0';
+		if (gb == NULL) {
+		  FATAL("No GB ID found for %s! Terminating", line);
+		  fail();
+		}
+		if (len == 0)
+		  continue;
+		if (line[0] == '#') {
+		  if ((strncmp(line, "#polya=", 7) == 0) && isdigit((unsigned char)line[7]))
+			 polya= (int)strtol(line+7, NULL, 10);
+		} else {
+		  if (n_exons == max_exons) {
+			 max_exons*= 2;
+			 exons= (struct _cc_exon*)realloc(exons, max_exons*sizeof(struct _cc_exon));
+			 if (exons == NULL) {
+				FATAL("Allocation memory error. Trying to allocate %zu exons.", max_exons);
+				fail();
+			 }
+		  }
+		  if (!parse_exon_row(a, line, &exons[n_exons])) {
+			 FATAL("Wrong format file! Terminating");
+			 fail();
+		  }
+		  ++n_exons;
+		}
+	 }
+  }
+  pfree(exons);
+  pfree(line);
+}
+
+// Riconosce gli header ">chrNN:start:end:strand"
+static bool
+parse_region_header(const char* const h,
+						  const char** p1, size_t* l1,
+						  const char** p2, size_t* l2,
+						  const char** ps, size_t* ls) {
+  if (strncasecmp(h, "chr", 3) != 0)
+	 return false;
+  const char* p= h+3;
+  const char* q= p;
+  while (isdigit((unsigned char)*q) || (strchr("xXyY", *q) != NULL && *q != '\0'))
+	 ++q;
+  if ((q == p) || (*q != ':'))
+	 return false;
+  *p1= p= q+1;
+  while (isdigit((unsigned char)*p))
+	 ++p;
+  *l1= p - *p1;
+  if ((*l1 == 0) || (*p != ':'))
+	 return false;
+  *p2= ++p;
+  while (isdigit((unsigned char)*p))
+	 ++p;
+  *l2= p - *p2;
+  if ((*l2 == 0) || (*p != ':'))
+	 return false;
+  *ps= ++p;
+  if ((*p == '+') || (*p == '-'))
+	 ++p;
+  if (*p != '1')
+	 return false;
+  *ls= p + 1 - *ps;
+  return true;
+}
+
+static void
+write_genomic_region(parena a, FILE* fgen, FILE* fout) {
+  pmultifasta_reader reader= multifasta_reader_create(fgen);
+  struct _multifasta_record rec;
+  if (!multifasta_reader_next(reader, &rec)) {
+	 FATAL("Cannot read the genomic sequence! Terminating");
+	 fail();
+  }
+  const char* header= cc_strndup(a, rec.id, rec.id_len);
+  const char *p1, *p2, *ps;
+  size_t l1, l2, ls;
+  if (parse_region_header(header, &p1, &l1, &p2, &l2, &ps, &ls)) {
+	 if (strtoll(p1, NULL, 10) < strtoll(p2, NULL, 10)) {
+		fprintf(fout, "%.*s\n%.*s\n", (int)l1, p1, (int)l2, p2);
+	 } else {
+		fprintf(fout, "%.*s\n%.*s\n", (int)l2, p2, (int)l1, p1);
+	 }
+	 fprintf(fout, "%.*s\n", (int)ls, ps);
+  } else {
+// La regione e' l'intera sequenza genomica
+	 fprintf(fout, "1\n%zu\n+1\n", rec.seq_len);
+  }
+  fprintf(fout, "0\n");
+  multifasta_reader_destroy(reader);
+}
+
+static int
+occurrence_by_right_compare(const void* p1, const void* p2) {
+  const struct _cc_occurrence* o1= (const struct _cc_occurrence*)p1;
+  const struct _cc_occurrence* o2= (const struct _cc_occurrence*)p2;
+  if (o1->right != o2->right) return (o1->right < o2->right) ? -1 : 1;
+  if (o1->left != o2->left) return (o1->left < o2->left) ? -1 : 1;
+  return (o1->order < o2->order) ? -1 : (o1->order > o2->order);
+}
+
+static int
+occurrence_by_left_compare(const void* p1, const void* p2) {
+  const struct _cc_occurrence* o1= (const struct _cc_occurrence*)p1;
+  const struct _cc_occurrence* o2= (const struct _cc_occurrence*)p2;
+  if (o1->left != o2->left) return (o1->left < o2->left) ? -1 : 1;
+  if (o1->right != o2->right) return (o1->right < o2->right) ? -1 : 1;
+  return (o1->order < o2->order) ? -1 : (o1->order > o2->order);
+}
+
+static int
+printed_exon_compare(const void* p1, const void* p2) {
+  const struct _cc_printed_exon* e1= (const struct _cc_printed_exon*)p1;
+  const struct _cc_printed_exon* e2= (const struct _cc_printed_exon*)p2;
+  if (e1->left != e2->left) return (e1->left < e2->left) ? -1 : 1;
+  if (e1->right != e2->right) return (e1->right < e2->right) ? -1 : 1;
+  return (e1->index < e2->index) ? -1 : (e1->index > e2->index);
+}
+
+// Intervallo [*pb, *pe) delle occorrenze con coordinata (destra se
+// by_right, sinistra altrimenti) uguale a coord
+static void
+find_occurrences(const struct _cc_occurrence* const occs, const size_t n,
+					  const bool by_right, const int coord,
+					  size_t* pb, size_t* pe) {
+  size_t lo= 0, hi= n;
+  while (lo < hi) {
+	 const size_t mid= lo + (hi-lo)/2;
+	 if ((by_right ? occs[mid].right : occs[mid].left) < coord)
+		lo= mid+1;
+	 else
+		hi= mid;
+  }
+  *pb= lo;
+  hi= n;
+  while (lo < hi) {
+	 const size_t mid= lo + (hi-lo)/2;
+	 if ((by_right ? occs[mid].right : occs[mid].left) <= coord)
+		lo= mid+1;
+	 else
+		hi= mid;
+  }
+  *pe= lo;
+}
+
+/*
+  Il primo esone viene sostituito dall'esone interno (di un'altra
+  composizione) con la stessa estremita' destra e l'estremita' sinistra
+  minima.
+*/
+static void
+reduce_first_exon(const struct _cc_occurrence* const by_right, const size_t n,
+						struct _cc_exon* first) {
+  size_t b, e;
+  find_occurrences(by_right, n, true, first->right, &b, &e);
+  if (b == e)
+	 CC_FAILURE("7");
+  size_t i= b;
+  while ((i < e) && (by_right[i].left != first->left))
+	 ++i;
+  if (i == e)
+	 CC_FAILURE("8");
+  bool stop= false;
+  i= b;
+  while ((i < e) && !stop) {
+	 const int left= by_right[i].left;
+	 size_t group_end= i;
+	 while ((group_end < e) && (by_right[group_end].left == left))
+		++group_end;
+	 if (left == first->left) {
+		stop= true;
+	 } else {
+		for (size_t j= i; (j < group_end) && !stop; ++j) {
+		  const pcc_composition oc= by_right[j].c;
+		  for (size_t k= 0; (k+1 < oc->n_exons) && !stop; ++k) {
+			 if ((oc->exons[k].left == left) && (oc->exons[k].right == first->right)) {
+				*first= oc->exons[k];
+				check_exon_length(first, "13");
+				stop= true;
+			 }
+		  }
+		}
+	 }
+	 i= group_end;
+  }
+}
+
+/*
+  Come reduce_first_exon, ma per l'ultimo esone (di una composizione
+  senza polyA), che viene sostituito dall'esone con la stessa estremita'
+  sinistra e l'estremita' destra massima.
+*/
+static void
+reduce_last_exon(const struct _cc_occurrence* const by_left, const size_t n,
+					  pcc_composition c, struct _cc_exon* last) {
+  size_t b, e;
+  find_occurrences(by_left, n, false, last->left, &b, &e);
+  if (b == e)
+	 CC_FAILURE("9");
+  size_t i= b;
+  while ((i < e) && (by_left[i].right != last->right))
+	 ++i;
+  if (i == e)
+	 CC_FAILURE("10");
+  bool stop= false;
+  i= e;
+  while ((i > b) && !stop) {
+	 const int right= by_left[i-1].right;
+	 size_t group_begin= i;
+	 while ((group_begin > b) && (by_left[group_begin-1].right == right))
+		--group_begin;
+	 if (right == last->right) {
+		stop= true;
+	 } else {
+		for (size_t j= group_begin; (j < i) && !stop; ++j) {
+		  const pcc_composition oc= by_left[j].c;
+		  for (size_t k= 1; (k < oc->n_exons) && !stop; ++k) {
+			 if ((oc->exons[k].left == last->left) && (oc->exons[k].right == right)) {
+				*last= oc->exons[k];
+				check_exon_length(last, "14");
+				c->polya= oc->polya;
+				stop= true;
+			 }
+		  }
+		}
+	 }
+	 i= group_begin;
+  }
+}
+
+void
+compact_compositions(FILE* fgen, FILE* fcompositions,
+							FILE* fout, FILE* fccds) {
+  my_assert(fgen != NULL);
+  my_assert(fcompositions != NULL);
+  my_assert(fout != NULL);
+  my_assert(fccds != NULL);
+
+  parena a= arena_create();
+
+  DEBUG("Reading the genomic region");
+  write_genomic_region(a, fgen, fout);
+
+  DEBUG("Reading the exon compositions");
+// GB id -> pcc_composition
+  pcc_map compositions= cc_map_create(a);
+// Esoni interni -> struct _cc_id_list
+  pcc_map compact= cc_map_create(a);
+  read_compositions(a, fcompositions, fccds, compositions, compact);
+  cc_map_destroy(compact);
+
+  pcc_map_entry* sorted= cc_map_sorted_entries(compositions);
+  const size_t n_compositions= compositions->size;
+  size_t n_occs= 0;
+  for (size_t i= 0; i<n_compositions; ++i)
+	 n_occs+= ((pcc_composition)sorted[i]->value)->n_exons;
+  DEBUG("Read %zu compositions with %zu exons", n_compositions, n_occs);
+
+// Segnale di polyA degli esoni ("left-right" -> int) e occorrenze
+  char buf[64];
+  pcc_map polya_exons= cc_map_create(a);
+  struct _cc_occurrence* by_right= NPALLOC(struct _cc_occurrence, n_occs+1);
+  size_t n= 0;
+  for (size_t i= 0; i<n_compositions; ++i) {
+	 const pcc_composition c= (pcc_composition)sorted[i]->value;
+	 for (size_t j= 0; j<c->n_exons; ++j) {
+		const struct _cc_exon* ex= &c->exons[j];
+		sprintf(buf, "%d-%d", ex->left, ex->right);
+		pcc_map_entry e= cc_map_get(polya_exons, buf);
+		if (j+1 == c->n_exons) {
+		  if ((e->value == NULL) || (*(int*)e->value == 0))
+			 set_int_value(a, e, c->polya);
+		} else {
+		  set_int_value(a, e, 0);
+		}
+		by_right[n].left= ex->left;
+		by_right[n].right= ex->right;
+		by_right[n].order= n;
+		by_right[n].c= c;
+		++n;
+	 }
+  }
+  struct _cc_occurrence* by_left= NPALLOC(struct _cc_occurrence, n_occs+1);
+  memcpy(by_left, by_right, n_occs*sizeof(struct _cc_occurrence));
+  qsort(by_right, n_occs, sizeof(struct _cc_occurrence), occurrence_by_right_compare);
+  qsort(by_left, n_occs, sizeof(struct _cc_occurrence), occurrence_by_left_compare);
+
+  DEBUG("Reducing the external exons");
+  for (size_t i= 0; i<n_compositions; ++i) {
+	 const pcc_composition c= (pcc_composition)sorted[i]->value;
+	 if (c->is_RefSeq || (c->n_exons < 2))
+		continue;
+	 struct _cc_exon first= c->exons[0];
+	 struct _cc_exon last= c->exons[c->n_exons-1];
+	 reduce_first_exon(by_right, n_occs, &first);
+	 if (c->polya == 0)
+		reduce_last_exon(by_left, n_occs, c, &last);
+	 c->exons[0]= first;
+	 c->exons[c->n_exons-1]= last;
+  }
+  pfree(by_right);
+  pfree(by_left);
+
+  DEBUG("Building the output compositions");
+// "left-right" (":GB id" per le RefSeq) -> size_t
+  pcc_map printed_index= cc_map_create(a);
+// Indici degli esoni -> struct _cc_printed_composition
+  pcc_map printed_compositions= cc_map_create(a);
+  struct _cc_printed_exon* printed= NPALLOC(struct _cc_printed_exon, n_occs+1);
+  size_t n_printed= 0;
+  int max_right= 0;
+  size_t str_size= 64;
+  char* str= c_palloc(str_size);
+  for (size_t i= 0; i<n_compositions; ++i) {
+	 const pcc_composition c= (pcc_composition)sorted[i]->value;
+	 size_t* indexes= (size_t*)arena_alloc(a, (c->n_exons+1)*sizeof(size_t));
+	 const size_t max_len= 24 + strlen(c->gb);
+	 if (str_size < max_len + 21*c->n_exons + 1) {
+		str_size= max_len + 21*c->n_exons + 1;
+		pfree(str);
+		str= c_palloc(str_size);
+	 }
+	 char* key= str;
+	 char* comp_str= str + max_len;
+	 size_t comp_len= 0;
+	 comp_str[0]= '\0';
+	 for (size_t j= 0; j<c->n_exons; ++j) {
+		const struct _cc_exon* ex= &c->exons[j];
+		if (max_right < ex->right)
+		  max_right= ex->right;
+		int len= sprintf(key, "%d-%d", ex->left, ex->right);
+		pcc_map_entry ep= cc_map_find(polya_exons, key);
+		my_assert(ep != NULL);
+		if (c->is_RefSeq)
+		  sprintf(key+len, ":%s", c->gb);
+		pcc_map_entry e= cc_map_get(printed_index, key);
+		if (e->value == NULL) {
+		  e->value= ARENA_PALLOC(a, size_t);
+		  *(size_t*)e->value= n_printed;
+		  printed[n_printed].left= ex->left;
+		  printed[n_printed].right= ex->right;
+		  printed[n_printed].polya= *(int*)ep->value;
+		  printed[n_printed].index= n_printed;
+		  printed[n_printed].seq= c->is_RefSeq ? ex->est_seq : ex->gen_seq;
+		  ++n_printed;
+		}
+		indexes[j]= *(size_t*)e->value;
+		comp_len+= sprintf(comp_str+comp_len, (j == 0) ? "%zu" : ".%zu", indexes[j]);
+	 }
+	 pcc_map_entry e= cc_map_get(printed_compositions, comp_str);
+	 if (e->value != NULL) {
+		if (c->is_RefSeq)
+		  CC_FAILURE("12(1)");
+		((struct _cc_printed_composition*)e->value)->n_ESTs+= c->n_ESTs;
+	 } else {
+		struct _cc_printed_composition* pc=
+		  ARENA_PALLOC(a, struct _cc_printed_composition);
+		pc->n_ESTs= c->n_ESTs;
+		pc->gb= c->is_RefSeq ? c->gb : NULL;
+		pc->n_exons= c->n_exons;
+		pc->indexes= indexes;
+		e->value= pc;
+	 }
+  }
+  pfree(str);
+  pfree(sorted);
+
+  DEBUG("Writing %zu compositions with %zu exons",
+		  printed_compositions->size, n_printed);
+  fprintf(fout, "%zu\n%zu\n%d\n", printed_compositions->size, n_printed, max_right);
+
+// Gli esoni sono scritti ordinati per coordinate
+  qsort(printed, n_printed, sizeof(struct _cc_printed_exon), printed_exon_compare);
+  size_t* ordered= NPALLOC(size_t, n_printed+1);
+  for (size_t i= 0; i<n_printed; ++i) {
+	 ordered[printed[i].index]= i;
+	 fprintf(fout, "%d:%d:%d\n", printed[i].left, printed[i].right, printed[i].polya);
+  }
+
+  sorted= cc_map_sorted_entries(printed_compositions);
+  for (size_t i= 0; i<printed_compositions->size; ++i) {
+	 const struct _cc_printed_composition* pc=
+		(const struct _cc_printed_composition*)sorted[i]->value;
+	 fprintf(fout, ".%d", pc->n_ESTs);
+	 if (pc->gb != NULL)
+		fprintf(fout, ".%s", pc->gb);
+	 fputc('\n', fout);
+	 for (size_t j= 0; j<pc->n_exons; ++j)
+		fprintf(fout, (j == 0) ? "%zu" : ".%zu", ordered[pc->indexes[j]]);
+	 fputc('\n', fout);
+	 for (size_t j= 0; j<pc->n_exons; ++j) {
+		fputs(printed[ordered[pc->indexes[j]]].seq, fout);
+		fputc('\n', fout);
+	 }
+  }
+  fprintf(fout, "#\n*\n");
+
+  pfree(sorted);
+  pfree(ordered);
+  pfree(printed);
+  cc_map_destroy(printed_compositions);
+  cc_map_destroy(printed_index);
+  cc_map_destroy(polya_exons);
+  cc_map_destroy(compositions);
+  arena_destroy(a);
+}
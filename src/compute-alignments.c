@@ -30,6 +30,7 @@
 
 #include "compute-alignments.h"
 #include "types.h"
+#include "nucleotide-codes.h"
 #include <string.h>
 
 #include "log.h"
@@ -107,7 +108,7 @@ ComputeAlignMatrix(const char * const EST_seq,
 
 	for(i=1; i<n+1; i++) {
 	  const char est= EST_seq[i-1];
-	  const bool is_est_a_N= ((est == 'n') || (est == 'N'));
+	  const bool is_est_a_N= nt_is_N(est);
 	  M2[0]= i;
 	  unsigned int left= i;
 	  for(j=1; j<m+1; j++) {
@@ -115,8 +116,7 @@ ComputeAlignMatrix(const char * const EST_seq,
 		 char current_dir= (char)0; //0 per allineamento caratteri in i-1 e j-1
 		 if ((est == genomic_seq[j-1]) ||
 			  is_est_a_N ||
-			  (genomic_seq[j-1] == 'n') ||
-			  (genomic_seq[j-1] == 'N')) {
+			  nt_is_N(genomic_seq[j-1])) {
 			//Costo match a 0
 		 } else {
 			current += 1; //Costo mismatch a +1
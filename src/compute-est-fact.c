@@ -29,6 +29,11 @@
  **/
 
 #include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/types.h>
 
 #include "util.h"
 #include "list.h"
@@ -49,7 +54,7 @@
 #include "compute-est-fact.h"
 
 static void
-log_meg(pext_array V) {
+log_meg(pext_array V, const pcsr_meg meg) {
   DEBUG("Start MEG");
   DEBUG("(   p,    t,    l)");
   for (unsigned int i= 0; i< EA_size(V); ++i) {
@@ -58,12 +63,10 @@ log_meg(pext_array V) {
 	 while (listit_has_next(lit)) {
 		ppairing p= listit_next(lit);
 		DEBUG("(%4d, %4d, %4d)", PAIRING(p));
-		plistit ait= list_first(p->adjs);
-		while (listit_has_next(ait)) {
-		  ppairing a= listit_next(ait);
+		for (unsigned int k= 0; k<csr_meg_n_adjs(meg, p->id); ++k) {
+		  ppairing a= meg->pairings[csr_meg_adj(meg, p->id, k)];
 		  DEBUG("     -> (%4d, %4d, %4d)", PAIRING(a));
 		}
-		listit_destroy(ait);
 	 }
 	 listit_destroy(lit);
   }
@@ -72,30 +75,34 @@ log_meg(pext_array V) {
 
 static void
 report_meg(pEST_info est, pmytime pt_io,
-			  FILE* fmeg, pext_array V) {
+			  FILE* fmeg, pext_array V, const pcsr_meg meg) {
   MYTIME_START_PARALLEL(pt_io);
-  log_meg(V);
+  log_meg(V, meg);
 #ifndef NDEBUG
-  print_meg(V, stdout);
+  print_meg(V, meg, stdout);
   fflush(stdout);
 #endif
   DEBUG("Appending MEG to the MEGs file..");
   fprintf(fmeg, "\n\n***********\n\n");
   write_single_EST_info(fmeg, est);
-  meg_write(fmeg, V);
+  meg_write_csr(fmeg, meg);
   fflush(fmeg);
   MYTIME_STOP_PARALLEL(pt_io);
 }
 
 static void
 build_meg(pEST_info est,
-			 LST_STree* tree,
+			 const pgen_index idx,
 			 ppreproc_gen pg,
 			 FILE* floginfoext,
 			 pmytime pt_alg, pmytime pt_meg,
 			 pconfiguration shared_config,
 			 size_t* pt_inc_pairing_len,
-			 pext_array* pV) {
+			 parena occ_arena,
+			 pext_array* pocc_V,
+			 parena arena,
+			 pext_array* pV,
+			 pcsr_meg* pmeg) {
 
 // Create a local copy of configuration parameters
   pconfiguration config= config_clone(shared_config);
@@ -109,32 +116,37 @@ build_meg(pEST_info est,
 	 DEBUG("Building the MEG vertex set");
 
 	 config->min_factor_len += *pt_inc_pairing_len;
-	 *pV= build_vertex_set(est, tree, pg, config);
+// L'insieme delle occorrenze viene calcolato una sola volta per EST.
+// I tentativi successivi (con min-factor-len maggiore) lo filtrano soltanto.
+	 if (*pocc_V == NULL) {
+		*pocc_V= build_vertex_set(est, idx, pg, config, occ_arena);
+	 }
+	 *pV= filter_vertex_set(*pocc_V, config->min_factor_len, arena);
 	 MYTIME_reset(pt_meg);
 	 MYTIME_start(pt_meg);
 	 DEBUG("Building the MEG edge set");
-	 build_edge_set(*pV, config);
-	 save_meg_to_filename(*pV, "meg-1-untouched.dot");
-	 simplify_meg(*pV, config);
-	 save_meg_to_filename(*pV, "meg-2-after-basic-simplification.dot");
+	 *pmeg= build_edge_set(*pV, config);
+	 save_meg_to_filename(*pV, *pmeg, "meg-1-untouched.dot");
+	 simplify_meg(*pV, *pmeg, config);
+	 save_meg_to_filename(*pV, *pmeg, "meg-2-after-basic-simplification.dot");
 	 if (config->trans_red) {
-		pgraph g= meg2graph(*pV);
-		transitive_reduction(g);
-		graph_destroy(g);
-		save_meg_to_filename(*pV, "meg-3-after-transitive-reduction.dot");
+		transitive_reduction(*pmeg);
+		save_meg_to_filename(*pV, *pmeg, "meg-3-after-transitive-reduction.dot");
 	 }
-	 too_complex= is_too_complex_for_compaction(*pV, config);
+	 too_complex= is_too_complex_for_compaction(*pmeg, config);
 	 if (!too_complex && config->short_edge_comp) {
-		compact_short_edges(*pV, config);
-		save_meg_to_filename(*pV, "meg-4-after-short-edge-contraction.dot");
+		compact_short_edges(*pV, *pmeg, config, arena);
+		save_meg_to_filename(*pV, *pmeg, "meg-4-after-short-edge-contraction.dot");
 	 }
 	 DEBUG("Analyzing complexity of the MEG vertex set");
-	 too_complex= too_complex || is_too_complex(*pV, config);
+	 too_complex= too_complex || is_too_complex(*pV, *pmeg, config);
 	 config->min_factor_len -= *pt_inc_pairing_len;
 	 if (too_complex) {
            if (config->min_factor_len+(*pt_inc_pairing_len)+1+2 < EA_size(*pV)) {
              ++(*pt_inc_pairing_len);
+             csr_meg_destroy(*pmeg);
              EA_destroy(*pV, (delete_function)vi_destroy);
+             arena_release(arena);
              INFO("MEG too much complex. Re-trying with min-factor-len= %zd.",
                   config->min_factor_len+(*pt_inc_pairing_len));
            } else {
@@ -158,6 +170,7 @@ internal_get_EST_factorizations(pEST_info gen,
 										  pmytime pt_comp, pmytime pt_ccomp,
 										  pconfiguration shared_config,
 										  pext_array V,
+										  const pcsr_meg meg,
 										  pEST * pfactorized_est,
 										  bool* is_timeout_expired) {
 
@@ -167,7 +180,7 @@ internal_get_EST_factorizations(pEST_info gen,
   MYTIME_START_PARALLEL(pt_comp);
   MYTIME_reset(pt_ccomp);
   MYTIME_start(pt_ccomp);
-  *pfactorized_est= get_EST_factorizations(est, V, shared_config, gen, pt_fact_timeout);
+  *pfactorized_est= get_EST_factorizations(est, V, meg, shared_config, gen, pt_fact_timeout);
   *is_timeout_expired= MYTIME_timeout_expired(pt_fact_timeout);
   if (*pfactorized_est != NULL) {
 	 DEBUG("Computed %zu factorizations.", list_size((*pfactorized_est)->factorizations));
@@ -192,7 +205,7 @@ internal_get_EST_factorizations(pEST_info gen,
 pEST
 compute_est_fact(pEST_info gen,
 					  pEST_info est,
-					  LST_STree* tree,
+					  const pgen_index idx,
 					  ppreproc_gen pg,
 					  FILE* floginfoext,
 					  FILE* fmeg, FILE* fpmeg, FILE* ftmeg,
@@ -207,6 +220,13 @@ compute_est_fact(pEST_info gen,
 
   size_t inc_pairing_len= 0;
   pext_array V= NULL;
+  pcsr_meg meg= NULL;
+// Arena for the MEG pairings, released after each attempt
+  parena arena= arena_create();
+// Occurrence set computed with the smallest min-factor-len, kept for all the
+// attempts of this EST
+  pext_array occ_V= NULL;
+  parena occ_arena= arena_create();
 
   bool is_timeout_expired= false;
 
@@ -217,10 +237,10 @@ compute_est_fact(pEST_info gen,
 	 bool same_MEG_as_before= false;
 	 do {
 		same_MEG_as_before= false;
-		build_meg(est, tree, pg, floginfoext, pt_alg, pt_meg, shared_config,
-					 &inc_pairing_len, &V);
+		build_meg(est, idx, pg, floginfoext, pt_alg, pt_meg, shared_config,
+					 &inc_pairing_len, occ_arena, &occ_V, arena, &V, &meg);
 
-		MEG_stats(V, &tot_pairings, &tot_edges);
+		MEG_stats(meg, &tot_pairings, &tot_edges);
 		same_MEG_as_before= prev_tot_pairings > 2 &&
 		  prev_tot_edges > 0 &&
 		  (prev_tot_pairings <= tot_pairings || prev_tot_edges <= tot_edges);
@@ -231,7 +251,9 @@ compute_est_fact(pEST_info gen,
 		  ++inc_pairing_len;
 		  DEBUG("Destroying the MEG and the occurrence set");
 		  MYTIME_START_PARALLEL(pt_alg);
+		  csr_meg_destroy(meg);
 		  EA_destroy(V, (delete_function)vi_destroy);
+		  arena_release(arena);
 		  MYTIME_STOP_PARALLEL(pt_alg);
 		}
 	 } while (same_MEG_as_before);
@@ -242,7 +264,7 @@ compute_est_fact(pEST_info gen,
 
 	 is_timeout_expired= false;
 	 internal_get_EST_factorizations(gen, est, floginfoext, pt_comp, pt_ccomp, shared_config,
-												V, &factorized_est, &is_timeout_expired);
+												V, meg, &factorized_est, &is_timeout_expired);
 
 	 DEBUG("Timeout expired?        %s", (is_timeout_expired)?"YES":"no");
 	 DEBUG("Factorization returned? %s", (factorized_est!=NULL &&
@@ -251,7 +273,7 @@ compute_est_fact(pEST_info gen,
 		  (factorized_est!=NULL && !list_is_empty(factorized_est->factorizations))) {
 		DEBUG("EST factorization procedure correctly terminated "
 				"(possibly without factorizations).");
-		report_meg(est, pt_io, fmeg, V);
+		report_meg(est, pt_io, fmeg, V, meg);
 	 }
 
 	 if (factorized_est!=NULL && !list_is_empty(factorized_est->factorizations)) {
@@ -259,9 +281,9 @@ compute_est_fact(pEST_info gen,
 		is_timeout_expired= false; // Reset timeout expiration
 											// since we computed some factorizations
 		fprintf(fintronic, ">%s\n", est->EST_id);
-		add_intronic_edges_to_file(fintronic, V);
+		add_intronic_edges_to_file(fintronic, V, meg);
 		write_single_EST_info(fpmeg, est);
-		meg_write(fpmeg, V);
+		meg_write_csr(fpmeg, meg);
 		fprintf(ftmeg, "%llu %llu %zu\n",
 				  MYTIME_getinterval(pt_meg),
 				  MYTIME_getinterval(pt_ccomp),
@@ -280,14 +302,329 @@ compute_est_fact(pEST_info gen,
 
 	 DEBUG("Destroying the MEG and the occurrence set");
 	 MYTIME_START_PARALLEL(pt_alg);
+	 csr_meg_destroy(meg);
 	 EA_destroy(V, (delete_function)vi_destroy);
+	 arena_release(arena);
 	 MYTIME_STOP_PARALLEL(pt_alg);
 
   } while (is_timeout_expired);
 
+  if (occ_V != NULL)
+	 EA_destroy(occ_V, (delete_function)vi_destroy);
+  arena_destroy(occ_arena);
+  arena_destroy(arena);
+
 // Destroy local timers
   MYTIME_destroy(pt_meg);
   MYTIME_destroy(pt_ccomp);
 
   return factorized_est;
 }
+
+void
+compute_transcript_fact(pEST_info gen,
+								pEST_info est,
+								pEST_info rev_est,
+								const pgen_index idx,
+								ppreproc_gen pg,
+								FILE* floginfoext,
+								FILE* fmeg, FILE* fpmeg, FILE* ftmeg,
+								FILE* fintronic,
+								FILE* f_multif_out, FILE* est_multif_out,
+								plist fact_ests, plist fact_infos,
+								pmytime pt_alg, pmytime pt_comp, pmytime pt_io,
+								pconfiguration shared_config) {
+  my_assert(est!=NULL);
+  my_assert(rev_est==NULL || !est->fixed_strand);
+  bool reversed= false;
+  pEST_info curr= est;
+  while (curr!=NULL) {
+	 pEST factorized_est=
+		compute_est_fact(gen, curr, idx, pg,
+							  floginfoext, fmeg, fpmeg, ftmeg,
+							  fintronic,
+							  pt_alg, pt_comp, pt_io, shared_config);
+	 pEST_info next= NULL;
+	 if (!list_is_empty(factorized_est->factorizations)) {
+// Found valid factorizations
+		INFO("Found valid factorization(s) for EST %s on the %s strand of the genomic.",
+			  curr->EST_gb,
+			  ((curr->EST_strand==1)?"same":"opposite"));
+		MYTIME_START_PARALLEL(pt_io);
+		write_multifasta_output(gen, factorized_est, f_multif_out, shared_config->retain_externals);
+		write_single_EST_info(est_multif_out, factorized_est->info);
+		if (fact_ests != NULL)
+		  add_multifasta_output(gen, factorized_est, fact_ests, shared_config->retain_externals);
+		if (fact_infos != NULL)
+		  list_add_to_tail(fact_infos, copy_EST_info_as_read(factorized_est->info));
+		MYTIME_STOP_PARALLEL(pt_io);
+	 } else if (reversed || rev_est==NULL) {
+// It is already the rev&compl sequence or it cannot be rev&complement
+		INFO("...the EST %s has no alignment! (Fixed strand? %s)",
+			  curr->EST_gb, (curr->fixed_strand ? "true" : "false"));
+	 } else {
+// Try again with the reverse and complement
+		INFO("...the strand from the input file may be wrong (read: '%s')!", curr->EST_strand_as_read);
+		reversed= true;
+		next= rev_est;
+	 }
+
+	 EST_destroy_just_factorizations(factorized_est);
+
+	 log_info(floginfoext, "est-processing-end");
+
+	 curr= next;
+  }
+}
+
+
+static char*
+create_and_copy(const char const* src) {
+  if (src==NULL)
+	 return NULL;
+  char* dest= alloc_and_copy(src);
+  return dest;
+}
+
+pEST_info copy_and_reverse(pEST_info est) {
+  pEST_info rev_est= EST_info_create();
+  rev_est->EST_seq= create_and_copy(est->EST_seq);
+  rev_est->original_EST_seq= (est->original_EST_seq==est->EST_seq) ?
+	 rev_est->EST_seq : create_and_copy(est->original_EST_seq);
+  reverse_and_complement(rev_est);
+  rev_est->EST_id= create_and_copy(est->EST_id);
+  rev_est->EST_gb= create_and_copy(est->EST_gb);
+  rev_est->EST_chr= create_and_copy(est->EST_chr);
+  rev_est->EST_strand_as_read=
+	 create_and_copy(est->EST_strand_as_read);
+  rev_est->EST_strand= - est->EST_strand;
+  rev_est->fixed_strand= est->fixed_strand;
+  rev_est->pref_polyA_length= est->suff_polyT_length;
+  rev_est->suff_polyA_length= est->pref_polyT_length;
+  rev_est->pref_polyT_length= est->suff_polyA_length;
+  rev_est->suff_polyT_length= est->pref_polyA_length;
+  return rev_est;
+}
+
+bool
+read_next_transcript(pmultifasta_reader reader, pEST_info gen, pmytime pt_io,
+							pEST_info* pest, pEST_info* prev_est) {
+  MYTIME_start(pt_io);
+  pEST_info est= multifasta_reader_next_EST_info(reader);
+  MYTIME_stop(pt_io);
+  *pest= est;
+  *prev_est= NULL;
+  if (est == NULL)
+	 return false;
+  INFO("EST: %s", est->EST_id);
+
+  DEBUG("Set the GB id from the fasta header");
+  set_EST_GB_identification(est);
+
+  DEBUG("Set the EST strand and RC");
+  set_EST_Strand_and_RC(est, gen);
+
+  DEBUG("Replace polyA/T with fake characters");
+  polyAT_substitution(est);
+
+  if (!est->fixed_strand) {
+	 DEBUG("Strand is not fixed. Adding also its reverse and complement.");
+	 *prev_est= copy_and_reverse(est);
+	 polyAT_substitution(*prev_est);
+  }
+  return true;
+}
+
+// libstree numbers the strings with a global counter, hence the suffix
+// trees of different loci are not built concurrently
+static pthread_mutex_t stree_construction_lock= PTHREAD_MUTEX_INITIALIZER;
+
+// Build the suffix tree representation of the genomic index.
+// The tree is flattened only if the index has to be saved, otherwise it is
+// used directly (and destroyed with the index)
+static pgen_index
+build_genomic_index_from_stree(const ppreproc_gen pg, pconfiguration config,
+										 const bool flatten,
+										 FILE* floginfo, pmytime pt_st, pmytime pt_alg) {
+  INFO("Creating the suffix tree");
+
+// Log resource utilization
+  log_info(floginfo, "gst-construction-begin");
+
+  MYTIME_start(pt_st);
+  pthread_mutex_lock(&stree_construction_lock);
+  LST_StringSet *set= lst_stringset_new();
+  LST_String * lst= PALLOC(LST_String);
+  lst_string_init(lst, pg->gen->EST_seq, sizeof(char),
+						strlen(pg->gen->EST_seq));
+  lst_stringset_add(set, lst);
+  LST_STree* tree = lst_stree_new(set);
+  pthread_mutex_unlock(&stree_construction_lock);
+  MYTIME_stop(pt_st);
+
+// Log resource utilization
+  log_info(floginfo, "gst-preprocessing-begin");
+
+  DEBUG("Preprocessing the GST");
+  MYTIME_start(pt_alg);
+  stree_preprocess(tree, pg, config);
+  if (!flatten) {
+	 MYTIME_stop(pt_alg);
+// Log resource utilization
+	 log_info(floginfo, "gst-preprocessing-end");
+	 return gen_index_create_on_stree(tree, set, pg, config);
+  }
+  pgen_index idx= gen_index_create_from_stree(tree, pg, config);
+  DEBUG("Destroying the GST additional informations");
+  stree_info_destroy(tree);
+  MYTIME_stop(pt_alg);
+
+// Log resource utilization
+  log_info(floginfo, "gst-preprocessing-end");
+
+  DEBUG("Destroying the GST");
+  MYTIME_start(pt_st);
+  lst_stree_free(tree);
+  pfree(set);
+  MYTIME_stop(pt_st);
+  return idx;
+}
+
+pgen_index
+get_genomic_index(const ppreproc_gen pg, pconfiguration config,
+						const char* const index_file,
+						FILE* floginfo, pmytime pt_st, pmytime pt_alg) {
+  if ((index_file != NULL) &&
+		!config->build_genomic_index_only) {
+	 INFO("Loading the genomic index");
+	 MYTIME_start(pt_st);
+	 pgen_index idx= gen_index_load(index_file, pg, config);
+	 MYTIME_stop(pt_st);
+	 if (idx != NULL)
+		return idx;
+  }
+
+  pgen_index idx= NULL;
+  if (config->genomic_index_type == GENOMIC_INDEX_SUFFIX_ARRAY) {
+	 INFO("Creating the enhanced suffix array");
+// Log resource utilization
+	 log_info(floginfo, "gst-construction-begin");
+	 MYTIME_start(pt_st);
+	 idx= gen_index_create_suffix_array(pg);
+	 MYTIME_stop(pt_st);
+// Log resource utilization
+	 log_info(floginfo, "gst-preprocessing-end");
+  } else {
+	 idx= build_genomic_index_from_stree(pg, config, index_file != NULL,
+													 floginfo, pt_st, pt_alg);
+  }
+
+  if (index_file != NULL) {
+	 const bool saved= gen_index_save(idx, index_file);
+	 if (!saved && config->build_genomic_index_only) {
+		FATAL("Cannot save the genomic index to file %s! Terminating",
+				index_file);
+		fail();
+	 }
+  }
+  return idx;
+}
+
+
+char*
+locus_path(const char* const dir, const char* const name) {
+  if (dir == NULL)
+	 return alloc_and_copy(name);
+  const size_t ldir= strlen(dir);
+  char* path= NPALLOC(char, ldir+strlen(name)+2);
+  strcpy(path, dir);
+  path[ldir]= '/';
+  strcpy(path+ldir+1, name);
+  return path;
+}
+
+FILE*
+open_locus_output(const struct _locus* const locus, const char* const name) {
+  char* path= locus_path(locus->out_dir, name);
+  FILE* f= fopen(path, "w");
+  if (!f) {
+	 FATAL("Cannot create file %s! Terminating", path);
+	 fail();
+  }
+  pfree(path);
+  return f;
+}
+
+void
+create_locus_dir(const struct _locus* const locus) {
+  if ((locus->out_dir != NULL) &&
+		(mkdir(locus->out_dir, 0777) != 0) && (errno != EEXIST)) {
+	 FATAL("Cannot create directory %s! Terminating", locus->out_dir);
+	 fail();
+  }
+}
+
+struct _locus*
+read_batch_manifest(const char* const filename, size_t* const pn_loci) {
+  FILE* fman= fopen(filename, "r");
+  if (!fman) {
+	 FATAL("File %s not found! Terminating", filename);
+	 fail();
+  }
+  size_t n_loci= 0;
+  size_t max_loci= 16;
+  struct _locus* loci= NPALLOC(struct _locus, max_loci);
+  char* line= NULL;
+  size_t bsize= 0;
+  size_t lineno= 0;
+  while (my_getline(&line, &bsize, fman) >= 0) {
+	 ++lineno;
+	 char* saveptr= NULL;
+	 char* fields[5];
+	 size_t n_fields= 0;
+	 for (char* tok= strtok_r(line, " \t", &saveptr);
+			(tok != NULL) && (n_fields < 5);
+			tok= strtok_r(NULL, " \t", &saveptr)) {
+		fields[n_fields++]= tok;
+	 }
+	 if ((n_fields == 0) || (fields[0][0] == '#'))
+		continue;
+	 if ((n_fields == 2) || (n_fields > 4)) {
+		FATAL("Line %zu of file %s is not a valid locus! Terminating",
+				lineno, filename);
+		fail();
+	 }
+	 if (n_loci == max_loci) {
+		max_loci*= 2;
+		loci= (struct _locus*)realloc(loci, max_loci*sizeof(struct _locus));
+		if (loci == NULL) {
+		  FATAL("Allocation of the loci failed! Terminating");
+		  fail();
+		}
+	 }
+	 struct _locus* locus= loci + n_loci;
+	 locus->out_dir= alloc_and_copy(fields[0]);
+	 locus->gen_file= (n_fields > 1) ?
+		alloc_and_copy(fields[1]) : locus_path(fields[0], "genomic.txt");
+	 locus->ests_file= (n_fields > 2) ?
+		alloc_and_copy(fields[2]) : locus_path(fields[0], "ests.txt");
+	 locus->index_file= (n_fields > 3) ? alloc_and_copy(fields[3]) : NULL;
+	 ++n_loci;
+  }
+  free(line);
+  fclose(fman);
+  *pn_loci= n_loci;
+  return loci;
+}
+
+void
+batch_manifest_destroy(struct _locus* loci, const size_t n_loci) {
+  for (size_t i= 0; i < n_loci; ++i) {
+	 pfree(loci[i].out_dir);
+	 pfree(loci[i].gen_file);
+	 pfree(loci[i].ests_file);
+	 if (loci[i].index_file != NULL)
+		pfree(loci[i].index_file);
+  }
+  free(loci);
+}
@@ -170,6 +170,57 @@ check_and_copy(struct gengetopt_args_info* args) {
   INFO("CONFIG: Maximum time for computing a factorization of a single transcript: %u.",
 		 config->max_single_factorization_time);
 
+  fail_if(args->threads_arg<1);
+  config->num_threads= args->threads_arg;
+  INFO("CONFIG: Number of threads used for computing the factorizations "
+		 "and the intron agreement: %u.",
+		 config->num_threads);
+
+  config->genomic_index_file= NULL;
+  if (args->genomic_index_given) {
+	 config->genomic_index_file= alloc_and_copy(args->genomic_index_arg);
+	 INFO("CONFIG: The genomic index is stored in file '%s'.",
+			config->genomic_index_file);
+  }
+
+  config->build_genomic_index_only= args->build_genomic_index_only_flag;
+  if (config->build_genomic_index_only && (config->genomic_index_file == NULL) &&
+		!args->batch_manifest_given) {
+	 FATAL("Option build-genomic-index-only requires option genomic-index.");
+	 fail();
+  }
+  INFO("CONFIG: Only build the genomic index? %s.",
+		 config->build_genomic_index_only?"yes":"no");
+
+  config->genomic_index_type=
+	 (args->genomic_index_type_arg == genomic_index_type_arg_array) ?
+	 GENOMIC_INDEX_SUFFIX_ARRAY : GENOMIC_INDEX_SUFFIX_TREE;
+  INFO("CONFIG: Representation of the genomic index: %s.",
+		 (config->genomic_index_type == GENOMIC_INDEX_SUFFIX_ARRAY) ?
+		 "suffix array" : "suffix tree");
+
+  config->batch_manifest_file= NULL;
+  if (args->batch_manifest_given) {
+	 config->batch_manifest_file= alloc_and_copy(args->batch_manifest_arg);
+	 INFO("CONFIG: Batch mode. The loci are listed in file '%s'.",
+			config->batch_manifest_file);
+	 if (config->genomic_index_file != NULL) {
+		WARN("Option genomic-index is ignored in batch mode. "
+			  "The genomic index of each locus is given in the manifest.");
+		pfree(config->genomic_index_file);
+		config->genomic_index_file= NULL;
+	 }
+  }
+
+  config->dump_intermediate_files= args->dump_intermediate_files_flag;
+  INFO("CONFIG: Write the intermediate files? %s.",
+		 config->dump_intermediate_files?"yes":"no");
+
+  fail_if(args->max_exon_agreement_time_arg<0);
+  config->max_exon_agreement_time= args->max_exon_agreement_time_arg;
+  INFO("CONFIG: Time limit of the search of the minimum factorization: %us.",
+		 config->max_exon_agreement_time);
+
   return config;
 }
 
@@ -238,6 +289,15 @@ config_clone(pconfiguration src) {
   config->short_edge_comp= src->short_edge_comp;
   config->max_single_factorization_time= src->max_single_factorization_time;
   config->complexity_threshold= src->complexity_threshold;
+  config->num_threads= src->num_threads;
+  config->genomic_index_file= (src->genomic_index_file == NULL) ?
+	 NULL : alloc_and_copy(src->genomic_index_file);
+  config->build_genomic_index_only= src->build_genomic_index_only;
+  config->genomic_index_type= src->genomic_index_type;
+  config->batch_manifest_file= (src->batch_manifest_file == NULL) ?
+	 NULL : alloc_and_copy(src->batch_manifest_file);
+  config->dump_intermediate_files= src->dump_intermediate_files;
+  config->max_exon_agreement_time= src->max_exon_agreement_time;
 
   return config;
 }
@@ -246,6 +306,10 @@ config_clone(pconfiguration src) {
 void config_destroy(pconfiguration config) {
   DEBUG("Destroying the struct for the configuration parameters.");
   my_assert(config!=NULL);
+  if (config->genomic_index_file != NULL)
+	 pfree(config->genomic_index_file);
+  if (config->batch_manifest_file != NULL)
+	 pfree(config->batch_manifest_file);
   pfree(config);
 }
 
@@ -306,12 +370,19 @@ pconfiguration config_create(int argc, char** argv) {
   COPY_long_VALUE(max_single_factorization_time);
 //  COPY_int_VALUE(max_seq_in_gst);
   COPY_double_VALUE(complexity_threshold);
+  COPY_int_VALUE(threads);
+  COPY_long_VALUE(max_exon_agreement_time);
 
   args_info.retain_externals_orig=
 	 alloc_and_copy((args_info.retain_externals_arg==retain_externals_arg_true) ?
 						 "true": "false");
   args_info.retain_externals_given= 1;
 
+  args_info.genomic_index_type_orig=
+	 alloc_and_copy((args_info.genomic_index_type_arg==genomic_index_type_arg_array) ?
+						 "array": "tree");
+  args_info.genomic_index_type_given= 1;
+
   pconfiguration config= check_and_copy(&args_info);
 
   if (cmdline_parser_file_save(__SAVE_CONFIG_FILE__, &args_info)!=0) {
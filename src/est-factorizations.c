@@ -47,12 +47,18 @@
 #include "max-emb-graph.h"
 
 #include "factorization-util.h"
+#include "meg-csr.h"
 
 
 //Computa per un dato subtree
 //di un grafo degli embedding (GEM) gli embeddings e restituisce una lista di ppairing
+//Gli adiacenti sono letti dalla rappresentazione compatta meg del grafo e
+//gli embeddings gia' calcolati sono memorizzati in computed_sub_e (indicizzato per id del pairing)
+//Gli embeddings (liste e pairing) sono allocati nell'arena a
 static plist get_subtree_embeddings(const int counter, ppairing root, pconfiguration config,
-												pmytime_timeout ptt, const char* const GEN_seq);
+												pmytime_timeout ptt, const char* const GEN_seq,
+												const pcsr_meg meg, plist* const computed_sub_e,
+												parena a);
 
 //Prende in input una lista di embeddings (lista di liste di ppairing) e fornisce in output una
 //lista di fattorizzazioni (eliminando eventualmente embedding non buoni)
@@ -60,19 +66,18 @@ static plist get_factorizations_from_embeddings(plist, pconfiguration, pEST_info
 
 //Aggiorna l'embedding con il nuovo nodo (solo se e' compatibile)
 static plist update_embedding(plist embedding, ppairing node,
-										const char* const GEN_seq, pconfiguration config);
+										const char* const GEN_seq, pconfiguration config,
+										parena a);
 
 static pfactor create_and_set_factor(int donor_EST_start, int donor_EST_end, int donor_GEN_start, int donor_GEN_end);
 
-///Create a new subtree embeddings object and set its parameter
-static psubtree_embeddings create_and_set_subtree_embeddings(ppairing, plist);
-static plist get_computed_subtree_embeddings(ppairing);
-
 //Funzione per copiare liste di pfactor
 //static pfactor copy_pfactor(pfactor);
 
 //Funzione per copiare liste di pfactor
-static ppairing copy_ppairing(ppairing);
+static ppairing copy_ppairing(parena, ppairing);
+
+static plist copy_embedding_in_arena(parena, plist);
 
 
 //Funzione di stampa di una lista di embeddings
@@ -119,11 +124,10 @@ static char maximality_relation(plist, plist);
 
 static bool check_gap_errors(plist, char*, char *, pconfiguration);
 
-plist list_of_subtree_embeddings;
-
 //Computa per una data EST tutte le fattorizzazioni ammissibili a partire
-//dal grafo degli embedding massimali (pext_array)
-pEST get_EST_factorizations(pEST_info pest_info, pext_array pext, pconfiguration config,
+//dal grafo degli embedding massimali (insieme dei vertici pext e archi meg)
+pEST get_EST_factorizations(pEST_info pest_info, pext_array pext, const pcsr_meg meg,
+									 pconfiguration config,
 									 pEST_info gen_info, pmytime_timeout ptt)
 {
   unsigned int i, pext_size;
@@ -138,6 +142,7 @@ pEST get_EST_factorizations(pEST_info pest_info, pext_array pext, pconfiguration
 
   my_assert(pest_info != NULL);
   my_assert(pext != NULL);
+  my_assert(meg != NULL);
 
   est = EST_create();
   est->info = pest_info;
@@ -150,21 +155,17 @@ pEST get_EST_factorizations(pEST_info pest_info, pext_array pext, pconfiguration
 //Creazione della lista delle fattorizzazioni ammissibili vuota
   factorization_list=list_create();
 
+//Gli id dei pairing (in meg) indicizzano gli embeddings gia' calcolati
 //Settaggio dei campi visited e number_of_visits nei pairing del MEG
-  for(i=0; i<pext_size; i++){
-//Puntatore alla lista di pairings in posizione i
-	 pgem =(plist)EA_get(pext, i);
-	 pgem_iter=list_first(pgem);
-	 while(listit_has_next(pgem_iter)){
-		next_pairing=(ppairing) listit_next(pgem_iter);
-		next_pairing->number_of_visits=0;
-		next_pairing->visited=false;
-	 }
-	 listit_destroy(pgem_iter);
+  plist* computed_sub_e= NPALLOC(plist, meg->n_pairings+1);
+//Arena per gli embeddings, rilasciata in blocco al termine
+  parena embedding_arena= arena_create();
+  for(i=0; i<meg->n_pairings; i++){
+	 meg->pairings[i]->number_of_visits=0;
+	 meg->pairings[i]->visited=false;
+	 computed_sub_e[i]= NULL;
   }
 
-  list_of_subtree_embeddings=list_create();
-
   for(i=0; i<pext_size; i++){
 //Puntatore alla lista di pairings in posizione i
 	 pgem =(plist)EA_get(pext, i);
@@ -186,9 +187,12 @@ pEST get_EST_factorizations(pEST_info pest_info, pext_array pext, pconfiguration
 		  DEBUG("\t\t%d) Path rooted in pairing (%d, %d, %d)",
 				  counter, next_pairing->p, next_pairing->t, next_pairing->l);
 
-		  subtree_embedding_list= get_subtree_embeddings(counter, next_pairing, config, ptt, gen_info->EST_seq);
+		  subtree_embedding_list= get_subtree_embeddings(counter, next_pairing, config, ptt, gen_info->EST_seq,
+																		  meg, computed_sub_e, embedding_arena);
 
 		  if (subtree_embedding_list == NULL) {
+			 pfree(computed_sub_e);
+			 arena_destroy(embedding_arena);
 			 return NULL;
 		  }
 
@@ -197,7 +201,7 @@ pEST get_EST_factorizations(pEST_info pest_info, pext_array pext, pconfiguration
 
 		  subtree_fact_list=get_factorizations_from_embeddings(subtree_embedding_list, config, est->info, pext_size-2);
 
-// DISTRUGGERE subtree_embedding_list QUI
+// subtree_embedding_list (nell'arena) e' deallocata insieme a embedding_arena
 
 		  //printf("...ALL THE FACTORIZATIONS FOR THE PATH ARE OBTAINED %zu!\n", list_size(subtree_fact_list));
 
@@ -266,6 +270,9 @@ pEST get_EST_factorizations(pEST_info pest_info, pext_array pext, pconfiguration
 	 }
 	 listit_destroy(pgem_iter);
   }
+  pfree(computed_sub_e);
+  DEBUG("Releasing %zu bytes of embeddings.", arena_size(embedding_arena));
+  arena_destroy(embedding_arena);
 
   plistit plist_add_factorization;
 
@@ -595,15 +602,16 @@ pEST get_EST_factorizations(pEST_info pest_info, pext_array pext, pconfiguration
 
 //Computa per un dato subtree tutti gli embedding e restituisce una lista di liste di ppairing
 static plist get_subtree_embeddings(const int counter, ppairing root, pconfiguration config,
-												pmytime_timeout ptt, const char* const GEN_seq)
+												pmytime_timeout ptt, const char* const GEN_seq,
+												const pcsr_meg meg, plist* const computed_sub_e,
+												parena a)
 {
   plist embedding_list; 	//Lista degli embedding
   plist updated_embedding_list;
   plist subtree_embedding_list; 	//Lista degli embedding relativi ad un subtree
   plist embedding; 	//Embedding: lista di ppairing
   plist next_embedding;
-  plist adj_list;
-  plistit adj_list_iter, subtree_embedding_iter;
+  plistit subtree_embedding_iter;
   ppairing pair;
   ppairing next_adj_pairing;
 
@@ -612,13 +620,13 @@ static plist get_subtree_embeddings(const int counter, ppairing root, pconfigura
   DEBUG("\t\t%.*s->%d) Pairing node (%d, %d, %d)", counter, SPACE_STRING, counter,
 		  root->p, root->t, root->l);
 
-  plist computed_sub_e=get_computed_subtree_embeddings(root);
-  if(computed_sub_e != NULL){
+  my_assert(root->id < meg->n_pairings && meg->pairings[root->id] == root);
+  if(computed_sub_e[root->id] != NULL){
 	 DEBUG("\t\tThe subtree embeddings are retrieved!");
 
-	 print_embeddings(computed_sub_e);
+	 print_embeddings(computed_sub_e[root->id]);
 
-	 return computed_sub_e;
+	 return computed_sub_e[root->id];
   }
   DEBUG("\t\t  %.*sThe subtree embeddings are to be computed!",
 		  counter, SPACE_STRING);
@@ -628,28 +636,24 @@ static plist get_subtree_embeddings(const int counter, ppairing root, pconfigura
 	 return NULL;
   }
 
-//Recupero la lista di adiacenza del nodo in input
-  adj_list=root->adjs;
+//Recupero il numero di adiacenti del nodo in input
+  const size_t n_adjs= csr_meg_n_adjs(meg, root->id);
 
 //Creazione della lista delle fattorizzazioni vuota
-  embedding_list=embedding_create();
+  embedding_list=list_create_in_arena(a);
 
   root->visited=true;
   root->number_of_visits++;
 
 //Se il nodo root e' una foglia
-  if(list_is_empty(adj_list)){
+  if(n_adjs == 0){
 	 DEBUG("\t\t\t%.*s...IS A LEAF!", counter, SPACE_STRING);
 
 //Creazione dell'embedding (lista di ppairing vuota)
-	 embedding=list_create();
+	 embedding=list_create_in_arena(a);
 
 //Creazione del pairing
-	 pair=pairing_create();
-
-	 pair->p=root->p;
-	 pair->t=root->t;
-	 pair->l=root->l;
+	 pair=copy_ppairing(a, root);
 
 //Aggiunta del pairing all'embedding
 	 list_add_to_head(embedding, pair);
@@ -658,13 +662,12 @@ static plist get_subtree_embeddings(const int counter, ppairing root, pconfigura
 	 list_add_to_head(embedding_list, embedding);
   }
   else{
-	 adj_list_iter=list_first(adj_list);
-
-//Scansione dei pairings della lista
-	 while(listit_has_next(adj_list_iter)){
-		next_adj_pairing=(ppairing) listit_next(adj_list_iter);
+//Scansione degli adiacenti
+	 for(unsigned int k=0; k<n_adjs; k++){
+		next_adj_pairing=meg->pairings[csr_meg_adj(meg, root->id, k)];
 
-		subtree_embedding_list= get_subtree_embeddings(counter+1, next_adj_pairing, config, ptt, GEN_seq);
+		subtree_embedding_list= get_subtree_embeddings(counter+1, next_adj_pairing, config, ptt, GEN_seq,
+																	  meg, computed_sub_e, a);
 		if (subtree_embedding_list == NULL) {
 		  return NULL;
 		}
@@ -693,7 +696,7 @@ static plist get_subtree_embeddings(const int counter, ppairing root, pconfigura
 		  print_embedding(next_embedding);
 
 //Adds the root node; ritorna una lista di embedding (attualmente uno solo)
-		  updated_embedding_list=update_embedding(next_embedding, root, GEN_seq, config);
+		  updated_embedding_list=update_embedding(next_embedding, root, GEN_seq, config, a);
 
 		  DEBUG("\t\t\t\t%.*s...node added!", counter, SPACE_STRING);
 		  print_embeddings(updated_embedding_list);
@@ -725,14 +728,14 @@ static plist get_subtree_embeddings(const int counter, ppairing root, pconfigura
 				  is_maximal=maximality_relation(add_emb, cmp_emb);
 
 				  if(is_maximal == 2){
-					 list_remove_at_iterator(&cmp_it, (delete_function)pairing_destroy_2);
+					 list_remove_at_iterator(&cmp_it, (delete_function)noop_free);
 				  }
 				}
 
 				if(is_maximal >= 1)
 				  list_add_to_tail(embedding_list, add_emb);
 				else{
-				  list_remove_at_iterator(&add_it, (delete_function)pairing_destroy_2);
+				  list_remove_at_iterator(&add_it, (delete_function)noop_free);
 				}
 			 }
 
@@ -749,21 +752,21 @@ static plist get_subtree_embeddings(const int counter, ppairing root, pconfigura
 
 		listit_destroy(subtree_embedding_iter);
 	 }
-	 listit_destroy(adj_list_iter);
 
 	 DEBUG("\t\t\t%.*s...node (%d, %d, %d) added to all the embeddings of all its adjacent nodes!",
 			 counter, SPACE_STRING, root->p, root->t, root->l);
 	 print_embeddings(embedding_list);
   }
 
-  list_add_to_tail(list_of_subtree_embeddings, create_and_set_subtree_embeddings(root, embedding_list));
+  computed_sub_e[root->id]= embedding_list;
 
   return embedding_list;
 }
 
 //Aggiorna l'embedding con il nuovo nodo (solo se e' compatibile)
 static plist update_embedding(plist embedding, ppairing node,
-										const char* const GEN_seq, pconfiguration config){
+										const char* const GEN_seq, pconfiguration config,
+										parena a){
   plist copy_embedding;
   plist sink_embedding;
   int node_copy_l;
@@ -772,12 +775,12 @@ static plist update_embedding(plist embedding, ppairing node,
   my_assert(!list_is_empty(embedding));
 
   ppairing head=(ppairing)list_head(embedding);
-  plist return_embedding_list=list_create();
+  plist return_embedding_list=list_create_in_arena(a);
 
   if(head->p == SINK_PAIRING_START){
 	 if(node->p >= 0){
-		sink_embedding=list_create();
-		ppairing node_copy=pairing_simple_copy(node);
+		sink_embedding=list_create_in_arena(a);
+		ppairing node_copy=copy_ppairing(a, node);
 		list_add_to_head(sink_embedding, node_copy);
 		list_add_to_head(return_embedding_list, sink_embedding);
 	 }
@@ -785,7 +788,7 @@ static plist update_embedding(plist embedding, ppairing node,
   }
 
   if(node->p < 0){
-	 copy_embedding=list_copy(embedding, (copy_item) copy_ppairing);
+	 copy_embedding=copy_embedding_in_arena(a, embedding);
 	 list_add_to_head(return_embedding_list, copy_embedding);
 
 	 return return_embedding_list;
@@ -897,13 +900,13 @@ static plist update_embedding(plist embedding, ppairing node,
 // Se ( ho un piccolo gap "netto" su T  OR ho un introne di lunghezza >= al minimo )
 //  --> aggiungo
 		  if((gap_length_on_t <= fl) || is_intron_on_t ) {
-			 copy_embedding=list_copy(embedding, (copy_item) copy_ppairing);
+			 copy_embedding=copy_embedding_in_arena(a, embedding);
 			 ppairing head_copy=(ppairing)list_head(copy_embedding);
 			 head_copy->p=head_copy_p;
 			 head_copy->t=head_copy_t;
 			 head_copy->l=head_copy_l;
 
-			 ppairing node_copy=pairing_simple_copy(node);
+			 ppairing node_copy=copy_ppairing(a, node);
 			 node_copy->l=node_copy_l;
 
 			 list_add_to_head(copy_embedding, node_copy);
@@ -933,42 +936,6 @@ static pfactor create_and_set_factor(int donor_EST_start, int donor_EST_end, int
 }
 
 
-//Create a new subtree embeddings object and set its parameter
-static psubtree_embeddings create_and_set_subtree_embeddings(ppairing root, plist embeddings)
-{
-  psubtree_embeddings new_sub_e;
-
-  new_sub_e=subtree_embeddings_create();
-
-  new_sub_e->root=root;
-  new_sub_e->embeddings=embeddings;
-
-  return new_sub_e;
-}
-
-static plist get_computed_subtree_embeddings(ppairing root)
-{
-  plistit list_iter=list_first(list_of_subtree_embeddings);
-  plist ret_e;
-
-  bool found=false;
-  while(listit_has_next(list_iter) && !found){
-	 psubtree_embeddings sub_e=(psubtree_embeddings)listit_next(list_iter);
-
-	 if(root == sub_e->root){
-		found=true;
-		ret_e=sub_e->embeddings;
-	 }
-  }
-
-  listit_destroy(list_iter);
-
-  if(found==true)
-	 return ret_e;
-  else
-	 return NULL;
-}
-
 //UNUSED
 /*
 //Funzione per copiare liste di pfactor
@@ -983,17 +950,31 @@ static pfactor copy_pfactor(pfactor arg)
 }
 */
 
-//Funzione per copiare liste di ppairing
-static ppairing copy_ppairing(ppairing arg)
+//Funzione per copiare (nell'arena) i ppairing degli embedding
+//Le liste di adiacenti e incidenti sono condivise con l'originale
+static ppairing copy_ppairing(parena a, ppairing arg)
 {
-  ppairing copy = PALLOC(struct _pairing);
+  ppairing copy = ARENA_PALLOC(a, struct _pairing);
 
   *copy = *arg;
+  copy->arena_allocated = true;
 
   return copy;
 
 }
 
+//Copia un embedding (lista di ppairing) nell'arena
+static plist copy_embedding_in_arena(parena a, plist embedding)
+{
+  plist copy = list_create_in_arena(a);
+  listit it;
+  list_first_stack(embedding, &it);
+  while(listit_has_next(&it)) {
+	 list_add_to_tail(copy, copy_ppairing(a, (ppairing)listit_next(&it)));
+  }
+  return copy;
+}
+
 static void print_embeddings(plist embedding_list){
   plistit plist_it_id;
 
@@ -1749,9 +1730,7 @@ plist clean_external_exons(plist factorization, char *genomic_sequence, char *es
 			char *est_exon_seq=real_substring(head->EST_start, head->EST_end-head->EST_start+1, est_sequence);
 			size_t l1=strlen(gen_exon_seq);
 			size_t l2=strlen(est_exon_seq);
-			unsigned int* M=edit_distance(gen_exon_seq, l1, est_exon_seq, l2);
-			int error=M[(l1+1)*(l2+1)-1];
-			pfree(M);
+			int error=bp_edit_distance(gen_exon_seq, l1, est_exon_seq, l2);
 			pfree(gen_exon_seq);
 			pfree(est_exon_seq);
 			if(error > 0)
@@ -1805,9 +1784,7 @@ plist clean_external_exons(plist factorization, char *genomic_sequence, char *es
 			char *est_exon_seq=real_substring(tail->EST_start, tail->EST_end-tail->EST_start+1, est_sequence);
 			size_t l1=strlen(gen_exon_seq);
 			size_t l2=strlen(est_exon_seq);
-			unsigned int* M=edit_distance(gen_exon_seq, l1, est_exon_seq, l2);
-			int error=M[(l1+1)*(l2+1)-1];
-			pfree(M);
+			int error=bp_edit_distance(gen_exon_seq, l1, est_exon_seq, l2);
 			pfree(gen_exon_seq);
 			pfree(est_exon_seq);
 			if(error > 0)
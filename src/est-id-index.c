@@ -0,0 +1,177 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010,2012  Yuri Pirola, Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+/**
+ *
+ * @file est-id-index.c
+ *
+ * Hash index of objects on their identifiers.
+ *
+ **/
+
+#include "est-id-index.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "util.h"
+#include "log.h"
+
+#define EST_ID_INDEX_NONE SIZE_MAX
+#define EST_ID_INDEX_INITIAL_SIZE 64
+
+static size_t
+id_hash(const char* s) {
+// FNV-1a
+  uint64_t h= 14695981039346656037ULL;
+  for (; *s != '\0'; ++s) {
+	 h^= (unsigned char)*s;
+	 h*= 1099511628211ULL;
+  }
+  return (size_t)h;
+}
+
+static void
+init_buckets(pest_id_index idx, const size_t n_buckets) {
+  idx->n_buckets= n_buckets;
+  idx->buckets= NPALLOC(size_t, n_buckets);
+  for (size_t i= 0; i<n_buckets; ++i)
+	 idx->buckets[i]= EST_ID_INDEX_NONE;
+}
+
+pest_id_index
+est_id_index_create(void) {
+  pest_id_index idx= PALLOC(struct _est_id_index);
+  idx->n_entries= 0;
+  idx->n_ids= 0;
+  idx->capacity= EST_ID_INDEX_INITIAL_SIZE;
+  idx->entries= NPALLOC(struct _est_id_index_entry, idx->capacity);
+  init_buckets(idx, EST_ID_INDEX_INITIAL_SIZE);
+  return idx;
+}
+
+void
+est_id_index_destroy(pest_id_index idx) {
+  my_assert(idx != NULL);
+  pfree(idx->entries);
+  pfree(idx->buckets);
+  pfree(idx);
+}
+
+// Return the first entry with identifier id (EST_ID_INDEX_NONE if it does
+// not exist)
+static size_t
+find_entry(pest_id_index idx, const char* const id, const size_t h) {
+  size_t e= idx->buckets[h & (idx->n_buckets-1)];
+  while ((e != EST_ID_INDEX_NONE) &&
+			((idx->entries[e].hash != h) || (strcmp(idx->entries[e].id, id) != 0)))
+	 e= idx->entries[e].next;
+  return e;
+}
+
+static void
+add_to_bucket(pest_id_index idx, const size_t e) {
+  const size_t b= idx->entries[e].hash & (idx->n_buckets-1);
+  idx->entries[e].next= idx->buckets[b];
+  idx->buckets[b]= e;
+}
+
+static void
+grow_buckets(pest_id_index idx) {
+  pfree(idx->buckets);
+  init_buckets(idx, 2*idx->n_buckets);
+  for (size_t e= 0; e<idx->n_entries; ++e)
+	 if (idx->entries[e].last_duplicate != EST_ID_INDEX_NONE)
+		add_to_bucket(idx, e);
+}
+
+bool
+est_id_index_add(pest_id_index idx, const char* const id, void* const value) {
+  my_assert(idx != NULL);
+  my_assert(id != NULL);
+  const size_t h= id_hash(id);
+  if (idx->n_entries == idx->capacity) {
+	 idx->capacity*= 2;
+	 struct _est_id_index_entry* entries=
+		NPALLOC(struct _est_id_index_entry, idx->capacity);
+	 memcpy(entries, idx->entries,
+			  idx->n_entries*sizeof(struct _est_id_index_entry));
+	 pfree(idx->entries);
+	 idx->entries= entries;
+  }
+  const size_t first= find_entry(idx, id, h);
+  const size_t e= idx->n_entries++;
+  struct _est_id_index_entry* const entry= idx->entries+e;
+  entry->id= id;
+  entry->value= value;
+  entry->hash= h;
+  entry->next= EST_ID_INDEX_NONE;
+  entry->next_duplicate= EST_ID_INDEX_NONE;
+  entry->last_duplicate= EST_ID_INDEX_NONE;
+  entry->first_not_taken= EST_ID_INDEX_NONE;
+  if (first != EST_ID_INDEX_NONE) {
+	 struct _est_id_index_entry* const first_entry= idx->entries+first;
+	 idx->entries[first_entry->last_duplicate].next_duplicate= e;
+	 first_entry->last_duplicate= e;
+	 if (first_entry->first_not_taken == EST_ID_INDEX_NONE)
+		first_entry->first_not_taken= e;
+	 return false;
+  }
+  entry->last_duplicate= e;
+  entry->first_not_taken= e;
+  ++idx->n_ids;
+  if (idx->n_ids > idx->n_buckets)
+	 grow_buckets(idx);
+  else
+	 add_to_bucket(idx, e);
+  return true;
+}
+
+void*
+est_id_index_find(pest_id_index idx, const char* const id) {
+  my_assert(idx != NULL);
+  my_assert(id != NULL);
+  const size_t e= find_entry(idx, id, id_hash(id));
+  return (e == EST_ID_INDEX_NONE) ? NULL : idx->entries[e].value;
+}
+
+void*
+est_id_index_take(pest_id_index idx, const char* const id) {
+  my_assert(idx != NULL);
+  my_assert(id != NULL);
+  const size_t first= find_entry(idx, id, id_hash(id));
+  if (first == EST_ID_INDEX_NONE)
+	 return NULL;
+  struct _est_id_index_entry* const first_entry= idx->entries+first;
+  const size_t e= first_entry->first_not_taken;
+  if (e == EST_ID_INDEX_NONE)
+	 return NULL;
+  first_entry->first_not_taken= idx->entries[e].next_duplicate;
+  return idx->entries[e].value;
+}
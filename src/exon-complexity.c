@@ -31,101 +31,48 @@
 #include <math.h>
 
 #include "exon-complexity.h"
+#include "nucleotide-codes.h"
 #include "est-factorizations.h"
 
 #include "log.h"
 
-double dustScoreByLeftAndRight(char *genomic_sequence, int start, int end){
-	my_assert(genomic_sequence != NULL);
-	size_t gen_length=strlen(genomic_sequence);
-	my_assert(start >= 0 && end < (int)gen_length);
-
-	char *sequence=real_substring(start, end-start+1, genomic_sequence);
-	double dust=dustScore(sequence);
-
-	pfree(sequence);
-	return dust;
-}
-
-double dustScore(char *sequence){
-	my_assert(sequence != NULL);
-
-	size_t length=strlen(sequence);
-
+//Dust score of sequence[0..length-1]
+static double dust_score(const char * const sequence, const size_t length){
 	if((int)length  <= 2)
 		return 0.0;
 
-	int *dinucleotide_freq=NPALLOC(int, 17);
-	my_assert(dinucleotide_freq != NULL);
-
-	int i;
-	for(i=0; i<17; i++)
-		dinucleotide_freq[i]=0;
+	int dinucleotide_freq[NT_DINUCLEOTIDES+1]={ 0 };
 
 	int running_count=0;
-	for(i=0; i < (int)length-1; i++){
-		int index=getDinucleotideIndex(sequence[i], sequence[i+1]);
+	size_t i;
+	for(i=0; i+1 < length; i++){
+		const unsigned int index=dinucleotide_code(sequence[i], sequence[i+1]);
 		running_count+=dinucleotide_freq[index];
 		dinucleotide_freq[index]++;
 	}
 
 	double dust=(10.0 * (double)running_count)/((double)(length-2));
 
-	pfree(dinucleotide_freq);
-
 	//Dust score wrt to the sequence length
 	return dust/length;
 }
 
-int getDinucleotideIndex(char firstChar, char secondChar){
-
-	if((firstChar == 'a' || firstChar == 'A') && (secondChar == 'a' || secondChar == 'A'))
-		return 0;
-
-	if((firstChar == 'a' || firstChar == 'A') && (secondChar == 'c' || secondChar == 'C'))
-		return 1;
-
-	if((firstChar == 'a' || firstChar == 'A') && (secondChar == 'g' || secondChar == 'G'))
-		return 2;
-
-	if((firstChar == 'a' || firstChar == 'A') && (secondChar == 't' || secondChar == 'T'))
-		return 3;
-
-	if((firstChar == 'c' || firstChar == 'C') && (secondChar == 'a' || secondChar == 'A'))
-		return 4;
-
-	if((firstChar == 'c' || firstChar == 'C') && (secondChar == 'c' || secondChar == 'C'))
-		return 5;
-
-	if((firstChar == 'c' || firstChar == 'C') && (secondChar == 'g' || secondChar == 'G'))
-		return 6;
-
-	if((firstChar == 'c' || firstChar == 'C') && (secondChar == 't' || secondChar == 'T'))
-		return 7;
-
-	if((firstChar == 'g' || firstChar == 'G') && (secondChar == 'a' || secondChar == 'A'))
-		return 8;
-
-	if((firstChar == 'g' || firstChar == 'G') && (secondChar == 'c' || secondChar == 'C'))
-		return 9;
-
-	if((firstChar == 'g' || firstChar == 'G') && (secondChar == 'g' || secondChar == 'G'))
-		return 10;
-
-	if((firstChar == 'g' || firstChar == 'G') && (secondChar == 't' || secondChar == 'T'))
-		return 11;
-
-	if((firstChar == 't' || firstChar == 'T') && (secondChar == 'a' || secondChar == 'A'))
-		return 12;
+double dustScoreByLeftAndRight(char *genomic_sequence, int start, int end){
+	my_assert(genomic_sequence != NULL);
+#ifndef NDEBUG
+	size_t gen_length=strlen(genomic_sequence);
+	my_assert(start >= 0 && end < (int)gen_length);
+#endif
 
-	if((firstChar == 't' || firstChar == 'T') && (secondChar == 'c' || secondChar == 'C'))
-		return 13;
+	return dust_score(genomic_sequence+start, (size_t)(end-start+1));
+}
 
-	if((firstChar == 't' || firstChar == 'T') && (secondChar == 'g' || secondChar == 'G'))
-		return 14;
+double dustScore(char *sequence){
+	my_assert(sequence != NULL);
 
-	if((firstChar == 't' || firstChar == 'T') && (secondChar == 't' || secondChar == 'T'))
-		return 15;
+	return dust_score(sequence, strlen(sequence));
+}
 
-	return 16;
+int getDinucleotideIndex(char firstChar, char secondChar){
+	return (int)dinucleotide_code(firstChar, secondChar);
 }
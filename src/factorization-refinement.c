@@ -256,52 +256,12 @@ find_longest_common_factor_dp(const char* const restrict s1, const size_t l1,
 										const char* const restrict s2, const size_t l2,
 										size_t* const pocc1, size_t* const pocc2,
 										size_t* const plen) {
-  DEBUG("Searching for a longest common factor using a dynamic programming algorithm...");
-  if (l2 > l1) {
-	 find_longest_common_factor_dp(s2, l2, s1, l1, pocc2, pocc1, plen);
-  }
-  size_t* curr= NPALLOC(size_t, l2+1);
-  size_t* prev= NPALLOC(size_t, l2+1);
-  size_t* swap= NULL;
-  *pocc1= 0;
-  *pocc2= 0;
-  *plen= 0;
-
-  for (size_t i2= 0; i2<=l2; ++i2) {
-	 prev[i2]= 0;
-  }
-  for (size_t i1= 0; i1<l1; ++i1) {
-	 curr[0]= 0;
-#ifdef Ns_ALWAYS_MATCH_FOR_LCS
-	 const bool is_s1_i1_a_n= (s1[i1]=='n') || (s1[i1]=='N');
-#endif
-	 for (size_t i2= 0; i2<l2; ++i2) {
+  DEBUG("Searching for a longest common factor using a bit-parallel algorithm...");
 #ifdef Ns_ALWAYS_MATCH_FOR_LCS
-		if (!is_s1_i1_a_n &&
-			 (s2[i2] != 'n') &&
-			 (s2[i2] != 'N') &&
-			 (s1[i1] != s2[i2])) {
-		  curr[i2+1]= 0;
-		} else {
-		  curr[i2+1]= 1 + prev[i2];
-		}
+  bp_longest_common_factor(s1, l1, s2, l2, true, pocc1, pocc2, plen);
 #else
-		if (s1[i1] != s2[i2]) {
-		  curr[i2+1]= 0;
-		} else {
-		  curr[i2+1]= 1 + prev[i2];
-		}
+  bp_longest_common_factor(s1, l1, s2, l2, false, pocc1, pocc2, plen);
 #endif
-		if (*plen < curr[i2+1]) {
-		  *plen= curr[i2+1];
-		  *pocc1= i1+1-*plen;
-		  *pocc2= i2+1-*plen;
-		}
-	 }
-	 swap= curr;
-	 curr= prev;
-	 prev= swap;
-  }
   DEBUG("Found a %zu-long common substring.", *plen);
   DEBUG("S1 (%8zu): %.2s>%.*s<%.2s", *pocc1,
 		  (*pocc1>=2)? s1+*pocc1-2 : "  ",
@@ -311,8 +271,6 @@ find_longest_common_factor_dp(const char* const restrict s1, const size_t l1,
 		  (*pocc2>=2)? s2+*pocc2-2 : "  ",
 		  (int)*plen, s2+*pocc2,
 		  s2+*pocc2+*plen);
-  pfree(curr);
-  pfree(prev);
 }
 
 
@@ -608,23 +566,15 @@ search_small_exon_at_prefix(pfactor * pp1,
 
 
 // A wrapper for 'classify_genomic_intron_start_end'
+// (the PWMs are shared, see get_pwm_scorer)
 static inline
 char _classify_intron(const char* const gen_seq, size_t istart, size_t iend) {
-  // Initialize constant and frequently used matrices as static members (not freed!)
-  static double **pwm_matx= NULL;
-  if (pwm_matx==NULL) pwm_matx= LoadPWMMatrices();
-  static double **CVector= NULL;
-  if (CVector==NULL) CVector= LoadCVPWMMatrices(pwm_matx);
-  static double **MAXVector= NULL;
-  if (MAXVector==NULL) MAXVector= LoadMAXPWMMatrices(pwm_matx);
-// END static initialization
   double score5, score3, BPS_score;
   int BPS_position;
   char type= classify_genomic_intron_start_end(gen_seq,
 															  istart, iend,
 															  &score5, &score3,
-															  &BPS_position, &BPS_score,
-															  pwm_matx, CVector, MAXVector);
+															  &BPS_position, &BPS_score);
   return type;
 }
 
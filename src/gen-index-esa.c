@@ -0,0 +1,591 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010,2012  Yuri Pirola, Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+/**
+ *
+ * @file gen-index-esa.c
+ *
+ * Enhanced suffix array representation of the genomic index.
+ *
+ * Notation: N is the number of suffixes (the length of the genomic
+ * sequence plus the terminator) and L(i) is the length of the longest
+ * common prefix of the suffixes sa[i-1] and sa[i], with L(0)=L(N)=-1.
+ * A node of the suffix tree is an lcp-interval [lb, rb] and its l-indices
+ * are the positions i in (lb, rb] such that L(i) is the string depth of
+ * the node.
+ *
+ * The child table stores in a single array (cld) the three tables of
+ * Abouelhoda et al.:
+ *  - up[i+1] in cld[i], if L(i) > L(i+1);
+ *  - next[i] in cld[i], if defined, otherwise down[i] in cld[i].
+ * The three cases are mutually exclusive and 0 means undefined.
+ *
+ **/
+
+#include "gen-index-esa.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util.h"
+
+#include "log.h"
+
+/*
+ * Suffix array construction (SA-IS)
+ */
+
+#define SAIS_TGET( i ) ((t[(i)>>3] >> ((i)&7)) & 1)
+#define SAIS_TSET( i, b )											\
+  do {																	\
+	 if (b) t[(i)>>3] |= (uint8_t)(1 << ((i)&7));				\
+	 else t[(i)>>3] &= (uint8_t)~(1 << ((i)&7));					\
+  } while (0)
+#define SAIS_CHR( i ) ((cs == sizeof(int32_t)) ?						\
+							  ((const int32_t*)s)[i] :						\
+							  (int32_t)((const unsigned char*)s)[i])
+#define SAIS_IS_LMS( i ) (((i) > 0) && SAIS_TGET(i) && !SAIS_TGET((i)-1))
+
+static void
+sais_get_buckets(const void* const s, int32_t* const bkt,
+					  const int32_t n, const int32_t K, const size_t cs,
+					  const bool end) {
+  memset(bkt, 0, (K+1)*sizeof(int32_t));
+  for (int32_t i= 0; i<n; ++i)
+	 ++bkt[SAIS_CHR(i)];
+  int32_t sum= 0;
+  for (int32_t i= 0; i<=K; ++i) {
+	 sum += bkt[i];
+	 bkt[i]= end ? sum : sum-bkt[i];
+  }
+}
+
+static void
+sais_induce(const uint8_t* const t, int32_t* const SA,
+				const void* const s, int32_t* const bkt,
+				const int32_t n, const int32_t K, const size_t cs) {
+// L-type suffixes
+  sais_get_buckets(s, bkt, n, K, cs, false);
+  for (int32_t i= 0; i<n; ++i) {
+	 const int32_t j= SA[i]-1;
+	 if ((j >= 0) && !SAIS_TGET(j))
+		SA[bkt[SAIS_CHR(j)]++]= j;
+  }
+// S-type suffixes
+  sais_get_buckets(s, bkt, n, K, cs, true);
+  for (int32_t i= n-1; i>=0; --i) {
+	 const int32_t j= SA[i]-1;
+	 if ((j >= 0) && SAIS_TGET(j))
+		SA[--bkt[SAIS_CHR(j)]]= j;
+  }
+}
+
+// s[n-1] must be the unique smallest symbol and the symbols are in [0, K]
+static void
+sais(const void* const s, int32_t* const SA,
+	  const int32_t n, const int32_t K, const size_t cs) {
+  my_assert(n >= 2);
+  uint8_t* t= NPALLOC(uint8_t, n/8+1);
+  memset(t, 0, n/8+1);
+// Classificazione dei suffissi in tipo S (1) e L (0)
+  SAIS_TSET(n-2, 0);
+  SAIS_TSET(n-1, 1);
+  for (int32_t i= n-3; i>=0; --i) {
+	 SAIS_TSET(i, (SAIS_CHR(i) < SAIS_CHR(i+1)) ||
+				  ((SAIS_CHR(i) == SAIS_CHR(i+1)) && SAIS_TGET(i+1)));
+  }
+// Ordinamento delle sottostringhe LMS
+  int32_t* bkt= NPALLOC(int32_t, K+1);
+  sais_get_buckets(s, bkt, n, K, cs, true);
+  for (int32_t i= 0; i<n; ++i)
+	 SA[i]= -1;
+  for (int32_t i= 1; i<n; ++i)
+	 if (SAIS_IS_LMS(i))
+		SA[--bkt[SAIS_CHR(i)]]= i;
+  sais_induce(t, SA, s, bkt, n, K, cs);
+  pfree(bkt);
+
+// Compattazione e assegnamento dei nomi alle sottostringhe LMS
+  int32_t n1= 0;
+  for (int32_t i= 0; i<n; ++i)
+	 if (SAIS_IS_LMS(SA[i]))
+		SA[n1++]= SA[i];
+  for (int32_t i= n1; i<n; ++i)
+	 SA[i]= -1;
+  int32_t name= 0;
+  int32_t prev= -1;
+  for (int32_t i= 0; i<n1; ++i) {
+	 const int32_t pos= SA[i];
+	 bool diff= false;
+	 for (int32_t d= 0; d<n; ++d) {
+		if ((prev == -1) ||
+			 (SAIS_CHR(pos+d) != SAIS_CHR(prev+d)) ||
+			 (SAIS_TGET(pos+d) != SAIS_TGET(prev+d))) {
+		  diff= true;
+		  break;
+		} else if ((d > 0) && (SAIS_IS_LMS(pos+d) || SAIS_IS_LMS(prev+d))) {
+		  break;
+		}
+	 }
+	 if (diff) {
+		++name;
+		prev= pos;
+	 }
+	 SA[n1 + pos/2]= name-1;
+  }
+  for (int32_t i= n-1, j= n-1; i>=n1; --i)
+	 if (SA[i] >= 0)
+		SA[j--]= SA[i];
+
+// Ordinamento del testo ridotto (ricorsivo se i nomi non sono unici)
+  int32_t* const SA1= SA;
+  int32_t* const s1= SA+n-n1;
+  if (name < n1) {
+	 sais(s1, SA1, n1, name-1, sizeof(int32_t));
+  } else {
+	 for (int32_t i= 0; i<n1; ++i)
+		SA1[s1[i]]= i;
+  }
+
+// Induzione del suffix array a partire dai suffissi LMS ordinati
+  bkt= NPALLOC(int32_t, K+1);
+  sais_get_buckets(s, bkt, n, K, cs, true);
+  for (int32_t i= 1, j= 0; i<n; ++i)
+	 if (SAIS_IS_LMS(i))
+		s1[j++]= i;
+  for (int32_t i= 0; i<n1; ++i)
+	 SA1[i]= s1[SA1[i]];
+  for (int32_t i= n1; i<n; ++i)
+	 SA[i]= -1;
+  for (int32_t i= n1-1; i>=0; --i) {
+	 const int32_t j= SA[i];
+	 SA[i]= -1;
+	 SA[--bkt[SAIS_CHR(j)]]= j;
+  }
+  sais_induce(t, SA, s, bkt, n, K, cs);
+  pfree(bkt);
+  pfree(t);
+}
+
+void
+esa_build_suffix_array(const char* const text, const uint32_t n,
+							  uint32_t* const sa) {
+  NOT_NULL(text);
+  NOT_NULL(sa);
+  fail_if((n < 2) || (n > (uint32_t)INT32_MAX));
+  my_assert(text[n-1] == '\0');
+  sais(text, (int32_t*)sa, (int32_t)n, UCHAR_MAX, sizeof(char));
+}
+
+
+/*
+ * LCP array
+ */
+
+struct _lcp_exc {
+  uint32_t* values;
+  size_t size;
+  size_t capacity;
+};
+
+static void
+lcp_exc_add(struct _lcp_exc* const exc, const uint32_t i, const uint32_t value) {
+  if (exc->size+2 > exc->capacity) {
+	 exc->capacity= MAX(2*exc->capacity, 1024);
+	 uint32_t* buff= (uint32_t*)realloc(exc->values, exc->capacity*sizeof(uint32_t));
+	 if (buff == NULL) {
+		FATAL("Allocation memory error. Trying to allocate %zu bytes.",
+				exc->capacity*sizeof(uint32_t));
+		fail();
+	 }
+	 exc->values= buff;
+  }
+  exc->values[exc->size++]= i;
+  exc->values[exc->size++]= value;
+}
+
+static int
+compare_lcp_exc(const void* p1, const void* p2) {
+  const uint32_t i1= *(const uint32_t*)p1;
+  const uint32_t i2= *(const uint32_t*)p2;
+  return (i1 < i2) ? -1 : ((i1 > i2) ? 1 : 0);
+}
+
+uint32_t*
+esa_build_lcp(const char* const text, const uint32_t n,
+				  const uint32_t* const sa,
+				  uint8_t* const lcp, uint32_t* const n_exc) {
+  NOT_NULL(text);
+  NOT_NULL(sa);
+  NOT_NULL(lcp);
+  uint32_t* rank= NPALLOC(uint32_t, n);
+  for (uint32_t i= 0; i<n; ++i)
+	 rank[sa[i]]= i;
+  struct _lcp_exc exc= { NULL, 0, 0 };
+  lcp[0]= 0;
+  uint32_t h= 0;
+  for (uint32_t p= 0; p<n; ++p) {
+	 const uint32_t r= rank[p];
+	 if (r == 0) {
+		h= 0;
+		continue;
+	 }
+	 const uint32_t q= sa[r-1];
+// Il terminatore e' unico, quindi il confronto termina entro il testo
+	 while (text[p+h] == text[q+h])
+		++h;
+	 if (h < GEN_INDEX_LCP_ESCAPE) {
+		lcp[r]= (uint8_t)h;
+	 } else {
+		lcp[r]= GEN_INDEX_LCP_ESCAPE;
+		lcp_exc_add(&exc, r, h);
+	 }
+	 if (h > 0)
+		--h;
+  }
+  pfree(rank);
+  *n_exc= exc.size/2;
+  if (exc.values != NULL)
+	 qsort(exc.values, exc.size/2, 2*sizeof(uint32_t), compare_lcp_exc);
+  return exc.values;
+}
+
+
+/*
+ * Access to the LCP array and to the child table
+ */
+
+// L(i) (-1 for i=0 and i=N)
+static inline int64_t
+L(const pgen_index idx, const uint32_t i) {
+  if ((i == 0) || (i > idx->gen_len))
+	 return -1;
+  const uint8_t v= idx->lcp[i];
+  if (v < GEN_INDEX_LCP_ESCAPE)
+	 return v;
+// Ricerca binaria tra le eccezioni
+  uint32_t lo= 0;
+  uint32_t hi= idx->n_lcp_exc;
+  while (lo < hi) {
+	 const uint32_t mid= lo + (hi-lo)/2;
+	 if (idx->lcp_exc[2*mid] < i)
+		lo= mid+1;
+	 else
+		hi= mid;
+  }
+  my_assert((lo < idx->n_lcp_exc) && (idx->lcp_exc[2*lo] == i));
+  return idx->lcp_exc[2*lo+1];
+}
+
+static inline bool
+is_root(const pgen_index idx, const gen_node v) {
+  return (v.lb == 0) && (v.rb == idx->gen_len);
+}
+
+// The first l-index of the internal interval [lb, rb]
+static inline uint32_t
+first_l_index(const pgen_index idx, const uint32_t lb, const uint32_t rb) {
+  my_assert(lb < rb);
+  return (L(idx, lb) <= L(idx, rb+1)) ? idx->cld[rb] : idx->cld[lb];
+}
+
+// The l-index that follows the l-index x of the interval [., rb] (0 if
+// x is the last one)
+static inline uint32_t
+next_l_index(const pgen_index idx, const uint32_t x, const uint32_t rb) {
+  const uint32_t y= idx->cld[x];
+  if ((x < rb) && (y > x) && (y <= rb) && (L(idx, y) == L(idx, x)))
+	 return y;
+  return 0;
+}
+
+
+/*
+ * Child table and single chars
+ */
+
+// Stack di interi (estendibile)
+struct _u32_stack {
+  uint32_t* values;
+  size_t size;
+  size_t capacity;
+};
+
+static void
+stack_push(struct _u32_stack* const st, const uint32_t v) {
+  if (st->size == st->capacity) {
+	 st->capacity= MAX(2*st->capacity, 1024);
+	 uint32_t* buff= (uint32_t*)realloc(st->values, st->capacity*sizeof(uint32_t));
+	 if (buff == NULL) {
+		FATAL("Allocation memory error. Trying to allocate %zu bytes.",
+				st->capacity*sizeof(uint32_t));
+		fail();
+	 }
+	 st->values= buff;
+  }
+  st->values[st->size++]= v;
+}
+
+#define STACK_TOP( st ) ((st).values[(st).size-1])
+#define STACK_POP( st ) ((st).values[--(st).size])
+
+void
+esa_build_child_table(const pgen_index idx, uint32_t* const cld) {
+  NOT_NULL(idx);
+  NOT_NULL(cld);
+  const uint32_t n= idx->gen_len+1;
+  memset(cld, 0, n*sizeof(uint32_t));
+  struct _u32_stack st= { NULL, 0, 0 };
+
+// next l-index
+  stack_push(&st, 0);
+  for (uint32_t i= 1; i<n; ++i) {
+	 const int64_t li= L(idx, i);
+	 while (li < L(idx, STACK_TOP(st)))
+		--st.size;
+	 if (li == L(idx, STACK_TOP(st))) {
+		cld[STACK_POP(st)]= i;
+	 }
+	 stack_push(&st, i);
+  }
+
+// up and down
+  st.size= 0;
+  uint32_t last= 0;
+  bool last_defined= false;
+  stack_push(&st, 0);
+  for (uint32_t i= 1; i<=n; ++i) {
+	 const int64_t li= L(idx, i);
+	 while (li < L(idx, STACK_TOP(st))) {
+		last= STACK_POP(st);
+		last_defined= true;
+		const uint32_t top= STACK_TOP(st);
+		if ((li <= L(idx, top)) && (L(idx, top) != L(idx, last)) &&
+			 (cld[top] == 0)) {
+// down[top] (solo se next[top] non e' definito)
+		  cld[top]= last;
+		}
+	 }
+	 if (last_defined) {
+// up[i]
+		my_assert(i > 0);
+		cld[i-1]= last;
+		last_defined= false;
+	 }
+	 if (i < n)
+		stack_push(&st, i);
+  }
+  if (st.values != NULL)
+	 free(st.values);
+}
+
+void
+esa_build_single_chars(const pgen_index idx, char* const sc) {
+  NOT_NULL(idx);
+  NOT_NULL(sc);
+  const uint32_t n= idx->gen_len+1;
+  memset(sc, 0, n+1);
+  const char* const text= idx->text;
+  const uint32_t* const sa= idx->sa;
+// Visita bottom-up degli lcp-intervalli (Kasai et al.): gli stack
+// contengono il left bound e la string depth degli intervalli aperti.
+  struct _u32_stack st_lb= { NULL, 0, 0 };
+  struct _u32_stack st_depth= { NULL, 0, 0 };
+  stack_push(&st_lb, 0);
+  stack_push(&st_depth, 0);
+// Inizio della sequenza massimale di posizioni precedute dallo stesso
+// simbolo che termina nella posizione corrente
+  uint32_t run_start= 0;
+  for (uint32_t i= 1; i<=n; ++i) {
+// Aggiornamento di run_start per la posizione i-1
+	 if (i-1 > 0) {
+		const uint32_t p1= sa[i-2];
+		const uint32_t p2= sa[i-1];
+		if ((p1 == 0) || (p2 == 0) || (text[p1-1] != text[p2-1]))
+		  run_start= i-1;
+	 }
+	 const int64_t li= L(idx, i);
+	 uint32_t lb= i-1;
+	 while ((st_depth.size > 0) && (li < (int64_t)STACK_TOP(st_depth))) {
+		--st_depth.size;
+		lb= STACK_POP(st_lb);
+		const uint32_t rb= i-1;
+		my_assert(lb < rb);
+		const uint32_t fl= first_l_index(idx, lb, rb);
+		const bool single= (run_start <= lb) && (sa[lb] != 0);
+		sc[fl]= single ? text[sa[lb]-1] : '\0';
+	 }
+	 if ((i < n) &&
+		  ((st_depth.size == 0) || (li > (int64_t)STACK_TOP(st_depth)))) {
+		stack_push(&st_lb, lb);
+		stack_push(&st_depth, (uint32_t)li);
+	 }
+  }
+  free(st_lb.values);
+  free(st_depth.values);
+}
+
+
+/*
+ * Navigation
+ */
+
+gen_node
+esa_root(const pgen_index idx) {
+  gen_node root= { 0, idx->gen_len };
+  return root;
+}
+
+size_t
+esa_depth(const pgen_index idx, const gen_node v) {
+  if (v.lb == v.rb)
+	 return idx->gen_len+1-idx->sa[v.lb];
+  if (is_root(idx, v))
+	 return 0;
+  return (size_t)L(idx, first_l_index(idx, v.lb, v.rb));
+}
+
+size_t
+esa_parent_depth(const pgen_index idx, const gen_node v) {
+  const int64_t d= MAX(L(idx, v.lb), L(idx, v.rb+1));
+  return (d < 0) ? 0 : (size_t)d;
+}
+
+gen_node
+esa_parent(const pgen_index idx, const gen_node v) {
+  my_assert(!is_root(idx, v));
+  const int64_t pd= (int64_t)esa_parent_depth(idx, v);
+  if (pd == 0)
+	 return esa_root(idx);
+  gen_node p= v;
+  while (L(idx, p.lb) >= pd)
+	 --p.lb;
+  while (L(idx, p.rb+1) >= pd)
+	 ++p.rb;
+  return p;
+}
+
+bool
+esa_find_kid(const pgen_index idx, const gen_node v, const size_t depth,
+				 const char c, gen_node* const kid) {
+  if (v.lb == v.rb)
+	 return false;
+  const char* const text= idx->text;
+  const uint32_t* const sa= idx->sa;
+  uint32_t l= v.lb;
+  uint32_t x= first_l_index(idx, v.lb, v.rb);
+  while (true) {
+	 const unsigned char kc= (unsigned char)text[sa[l]+depth];
+	 if (kc == (unsigned char)c) {
+		kid->lb= l;
+		kid->rb= (x == 0) ? v.rb : x-1;
+		return true;
+	 }
+// I figli sono in ordine lessicografico
+	 if ((kc > (unsigned char)c) || (x == 0))
+		return false;
+	 l= x;
+	 x= next_l_index(idx, x, v.rb);
+  }
+}
+
+char
+esa_single_char(const pgen_index idx, const gen_node v) {
+  if (v.lb == v.rb) {
+	 const uint32_t p= idx->sa[v.lb];
+	 return (p == 0) ? '\0' : idx->text[p-1];
+  }
+  if (is_root(idx, v))
+	 return '\0';
+  return idx->sc[first_l_index(idx, v.lb, v.rb)];
+}
+
+gen_node
+esa_suffix_link(const pgen_index idx, const gen_node v, const size_t depth) {
+  my_assert(depth > 0);
+  const char* const pattern= idx->text + idx->sa[v.lb] + 1;
+  gen_node node= esa_root(idx);
+  size_t node_depth= 0;
+// Discesa dalla radice confrontando solo il primo carattere di ogni arco
+  while (node_depth < depth-1) {
+	 gen_node kid;
+	 fail_if(!esa_find_kid(idx, node, node_depth, pattern[node_depth], &kid));
+	 node= kid;
+	 node_depth= esa_depth(idx, node);
+  }
+  my_assert(node_depth == depth-1);
+  return node;
+}
+
+void
+esa_for_each_occurrence(const pgen_index idx,
+								const gen_node v,
+								const gen_node* const block,
+								const size_t skip_k,
+								gen_occurrence_function f,
+								void* data) {
+  const char* const text= idx->text;
+  const uint32_t* const sa= idx->sa;
+  const uint32_t* const keys= idx->keys;
+  bool in_block[UCHAR_MAX+1];
+  memset(in_block, 0, sizeof(in_block));
+  uint32_t block_lb= v.rb+1;
+  uint32_t block_rb= v.rb;
+  if (block != NULL) {
+	 my_assert((v.lb <= block->lb) && (block->rb <= v.rb));
+	 block_lb= block->lb;
+	 block_rb= block->rb;
+	 for (uint32_t j= block_lb; j<=block_rb; ++j) {
+		const uint32_t t= sa[j];
+		if (t == 0) {
+		  memset(in_block, 1, sizeof(in_block));
+		  break;
+		}
+		in_block[keys[(unsigned char)text[t-1]]]= true;
+	 }
+  }
+  for (uint32_t j= v.lb; j<=v.rb; ++j) {
+	 if (j == block_lb) {
+		j= block_rb;
+		continue;
+	 }
+	 const uint32_t t= sa[j];
+	 if (t == 0) {
+		for (size_t k= 0; k<idx->alph_size; ++k) {
+		  if (k != skip_k)
+			 f(data, 0, k, (j < block_lb) || !in_block[k]);
+		}
+	 } else {
+		const size_t k= keys[(unsigned char)text[t-1]];
+		if (k != skip_k)
+		  f(data, t, k, (j < block_lb) || !in_block[k]);
+	 }
+  }
+}
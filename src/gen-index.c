@@ -0,0 +1,734 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010,2012  Yuri Pirola, Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+/**
+ *
+ * @file gen-index.c
+ *
+ * Index of the genomic sequence: construction, persistence and
+ * navigation of the suffix tree representations (flat and libstree).
+ * The suffix array representation is implemented in gen-index-esa.c.
+ *
+ **/
+
+#include "gen-index.h"
+#include "gen-index-esa.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "ext_array.h"
+#include "util.h"
+
+#include "log.h"
+
+#define GEN_INDEX_MAGIC "PINTRGIX"
+#define GEN_INDEX_BYTE_ORDER ((uint32_t)0x01020304)
+
+// Ogni sezione del buffer inizia ad un offset multiplo di 8
+#define GEN_INDEX_ALIGN( x ) (((x)+7) & ~((size_t)7))
+
+struct _gen_index_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t type;
+  uint32_t node_size;
+  uint32_t min_string_depth;
+  uint32_t gen_len;
+  uint32_t alph_size;
+  uint32_t n_nodes;
+// The number of nodes that have the slices
+  uint32_t n_sliced_nodes;
+// The number of LCP values stored apart
+  uint32_t n_lcp_exc;
+  uint64_t size;
+};
+
+// Offsets of the sections (0 if the section is not present)
+struct _gen_index_layout {
+  size_t nodes;
+  size_t slices;
+  size_t occs;
+  size_t keys;
+  size_t sa;
+  size_t cld;
+  size_t lcp_exc;
+  size_t lcp;
+  size_t sc;
+  size_t text;
+  size_t size;
+};
+
+static void
+compute_layout(const struct _gen_index_header* const h,
+					struct _gen_index_layout* const l) {
+  memset(l, 0, sizeof(struct _gen_index_layout));
+  const size_t n_suffixes= (size_t)h->gen_len+1;
+  size_t next= GEN_INDEX_ALIGN(sizeof(struct _gen_index_header));
+  if (h->type == GENOMIC_INDEX_SUFFIX_TREE) {
+	 l->nodes= next;
+	 l->slices= GEN_INDEX_ALIGN(l->nodes +
+										 (size_t)h->n_nodes*sizeof(struct _gen_index_node));
+	 l->occs= GEN_INDEX_ALIGN(l->slices +
+									  (size_t)h->n_sliced_nodes*2*h->alph_size*sizeof(uint32_t));
+	 next= GEN_INDEX_ALIGN(l->occs +
+								  ((size_t)h->gen_len+h->alph_size)*sizeof(uint32_t));
+  } else {
+	 l->keys= next;
+	 l->sa= GEN_INDEX_ALIGN(l->keys + (UCHAR_MAX+1)*sizeof(uint32_t));
+	 l->cld= GEN_INDEX_ALIGN(l->sa + n_suffixes*sizeof(uint32_t));
+	 l->lcp_exc= GEN_INDEX_ALIGN(l->cld + n_suffixes*sizeof(uint32_t));
+	 l->lcp= GEN_INDEX_ALIGN(l->lcp_exc + (size_t)h->n_lcp_exc*2*sizeof(uint32_t));
+	 l->sc= GEN_INDEX_ALIGN(l->lcp + n_suffixes);
+	 next= GEN_INDEX_ALIGN(l->sc + n_suffixes + 1);
+  }
+  l->text= next;
+  l->size= GEN_INDEX_ALIGN(l->text + h->gen_len + 1);
+}
+
+static pgen_index
+gen_index_from_buffer(void* const buffer, const bool mapped) {
+  const struct _gen_index_header* const h= (const struct _gen_index_header*)buffer;
+  struct _gen_index_layout l;
+  compute_layout(h, &l);
+  char* const b= (char*)buffer;
+  pgen_index idx= PALLOC(struct _gen_index);
+  memset(idx, 0, sizeof(struct _gen_index));
+  idx->type= (genomic_index_type)h->type;
+  idx->gen_len= h->gen_len;
+  idx->alph_size= h->alph_size;
+  idx->text= b + l.text;
+  if (idx->type == GENOMIC_INDEX_SUFFIX_TREE) {
+	 idx->n_nodes= h->n_nodes;
+	 idx->min_string_depth= h->min_string_depth;
+	 idx->nodes= (const struct _gen_index_node*)(b + l.nodes);
+	 idx->slices= (const uint32_t*)(b + l.slices);
+	 idx->occs= (const uint32_t*)(b + l.occs);
+  } else {
+	 idx->keys= (const uint32_t*)(b + l.keys);
+	 idx->sa= (const uint32_t*)(b + l.sa);
+	 idx->cld= (const uint32_t*)(b + l.cld);
+	 idx->n_lcp_exc= h->n_lcp_exc;
+	 idx->lcp_exc= (const uint32_t*)(b + l.lcp_exc);
+	 idx->lcp= (const uint8_t*)(b + l.lcp);
+	 idx->sc= b + l.sc;
+  }
+  idx->buffer= buffer;
+  idx->buffer_size= l.size;
+  idx->mapped= mapped;
+  return idx;
+}
+
+static void
+init_header(struct _gen_index_header* const h,
+				const genomic_index_type type,
+				const ppreproc_gen pg) {
+  memset(h, 0, sizeof(struct _gen_index_header));
+  memcpy(h->magic, GEN_INDEX_MAGIC, sizeof(h->magic));
+  h->version= GEN_INDEX_VERSION;
+  h->byte_order= GEN_INDEX_BYTE_ORDER;
+  h->type= type;
+  h->node_size= sizeof(struct _gen_index_node);
+  h->gen_len= pg->gen_len;
+  h->alph_size= pg->alph_size;
+}
+
+// The buffer is cleared so that the padding bytes saved on file are deterministic
+static char*
+alloc_buffer(struct _gen_index_header* const h,
+				 struct _gen_index_layout* const l) {
+  compute_layout(h, l);
+  h->size= l->size;
+  char* buffer= NPALLOC(char, l->size);
+  memset(buffer, 0, l->size);
+  memcpy(buffer, h, sizeof(struct _gen_index_header));
+  return buffer;
+}
+
+
+struct _node_id {
+  const LST_Node* node;
+  uint32_t id;
+};
+
+static int
+compare_node_ids(const void* p1, const void* p2) {
+  const uintptr_t n1= (uintptr_t)((const struct _node_id*)p1)->node;
+  const uintptr_t n2= (uintptr_t)((const struct _node_id*)p2)->node;
+  return (n1 < n2) ? -1 : ((n1 > n2) ? 1 : 0);
+}
+
+static uint32_t
+get_node_id(const struct _node_id* const ids, const size_t n_nodes,
+				const LST_Node* const node) {
+  if (node == NULL)
+	 return GEN_INDEX_NONE;
+  struct _node_id key= { node, 0 };
+  const struct _node_id* const found=
+	 (const struct _node_id*)bsearch(&key, ids, n_nodes,
+												sizeof(struct _node_id), compare_node_ids);
+  NOT_NULL(found);
+  return found->id;
+}
+
+pgen_index
+gen_index_create_from_stree(LST_STree* tree,
+									 const ppreproc_gen pg,
+									 const pconfiguration config) {
+  NOT_NULL(tree);
+  NOT_NULL(pg);
+  NOT_NULL(config);
+  my_assert(tree->arr_occs != NULL);
+  fail_if(pg->gen_len >= GEN_INDEX_NONE);
+  INFO("Building the genomic index from the suffix tree.");
+
+// Visita in ampiezza dell'albero
+  pext_array order= EA_create();
+  EA_insert(order, tree->root_node);
+  size_t n_sliced_nodes= 0;
+  for (size_t h= 0; h<EA_size(order); ++h) {
+	 LST_Node* node= (LST_Node*)EA_get(order, h);
+	 if (node->slices != NULL)
+		++n_sliced_nodes;
+	 for (LST_Edge* edge= node->kids.lh_first; edge!=NULL;
+			edge= edge->siblings.le_next) {
+		EA_insert(order, edge->dst_node);
+	 }
+  }
+  const size_t n_nodes= EA_size(order);
+  fail_if(n_nodes >= GEN_INDEX_NONE);
+
+  struct _gen_index_header h;
+  init_header(&h, GENOMIC_INDEX_SUFFIX_TREE, pg);
+  h.min_string_depth= config->min_factor_len;
+  h.n_nodes= n_nodes;
+  h.n_sliced_nodes= n_sliced_nodes;
+  struct _gen_index_layout l;
+  char* buffer= alloc_buffer(&h, &l);
+  struct _gen_index_node* const nodes= (struct _gen_index_node*)(buffer + l.nodes);
+  uint32_t* const slices= (uint32_t*)(buffer + l.slices);
+  uint32_t* const occs= (uint32_t*)(buffer + l.occs);
+  char* const text= buffer + l.text;
+
+  memcpy(text, pg->gen->EST_seq, pg->gen_len);
+  text[pg->gen_len]= '\0';
+  for (size_t i= 0; i<pg->gen_len+pg->alph_size; ++i) {
+	 occs[i]= tree->arr_occs[i];
+  }
+
+  struct _node_id* ids= NPALLOC(struct _node_id, n_nodes);
+  for (size_t i= 0; i<n_nodes; ++i) {
+	 ids[i].node= (LST_Node*)EA_get(order, i);
+	 ids[i].id= i;
+  }
+  qsort(ids, n_nodes, sizeof(struct _node_id), compare_node_ids);
+
+  nodes[GEN_INDEX_ROOT].parent= GEN_INDEX_NONE;
+  uint32_t next_kid= 1;
+  uint32_t next_slices= 0;
+  for (size_t i= 0; i<n_nodes; ++i) {
+	 const LST_Node* const node= (LST_Node*)EA_get(order, i);
+	 struct _gen_index_node* const gn= nodes+i;
+	 gn->first_kid= next_kid;
+	 gn->n_kids= 0;
+	 for (LST_Edge* edge= node->kids.lh_first; edge!=NULL;
+			edge= edge->siblings.le_next) {
+		my_assert(EA_get(order, next_kid) == edge->dst_node);
+		nodes[next_kid].parent= i;
+		++next_kid;
+		++gn->n_kids;
+	 }
+	 if (node->up_edge == NULL) {
+		gn->edge_start= pg->gen_len;
+		gn->edge_len= 0;
+	 } else {
+		my_assert(node->up_edge->range.string->num_items == pg->gen_len+1);
+		gn->edge_start= node->up_edge->range.start_index;
+		gn->edge_len= lst_edge_get_length(node->up_edge);
+	 }
+// The terminator is stored as '\0' at position gen_len
+	 gn->first_char= text[gn->edge_start];
+	 gn->single_char= node->single_char;
+	 gn->string_depth= node->string_depth;
+	 gn->suffix_link= get_node_id(ids, n_nodes, node->suffix_link_node);
+	 if (node->slices == NULL) {
+		gn->slices= GEN_INDEX_NONE;
+	 } else {
+		my_assert(node->string_depth >= config->min_factor_len);
+		gn->slices= next_slices;
+		for (size_t k= 0; k<2*pg->alph_size; ++k) {
+		  slices[next_slices+k]= node->slices[k];
+		}
+		next_slices += 2*pg->alph_size;
+	 }
+  }
+  my_assert(next_kid == n_nodes);
+  my_assert(next_slices == 2*pg->alph_size*n_sliced_nodes);
+
+  pfree(ids);
+  EA_destroy(order, (delete_function)noop_free);
+  INFO("Genomic index built: %zu nodes (%zu bytes).", n_nodes, l.size);
+  return gen_index_from_buffer(buffer, false);
+}
+
+
+pgen_index
+gen_index_create_on_stree(LST_STree* tree,
+								  LST_StringSet* set,
+								  const ppreproc_gen pg,
+								  const pconfiguration config) {
+  NOT_NULL(tree);
+  NOT_NULL(set);
+  NOT_NULL(pg);
+  NOT_NULL(config);
+  my_assert(tree->arr_occs != NULL);
+  pgen_index idx= PALLOC(struct _gen_index);
+  memset(idx, 0, sizeof(struct _gen_index));
+  idx->type= GENOMIC_INDEX_SUFFIX_TREE;
+  idx->gen_len= pg->gen_len;
+  idx->alph_size= pg->alph_size;
+  idx->text= pg->gen->EST_seq;
+  idx->min_string_depth= config->min_factor_len;
+  idx->tree= tree;
+  idx->tree_strings= set;
+  return idx;
+}
+
+
+pgen_index
+gen_index_create_suffix_array(const ppreproc_gen pg) {
+  NOT_NULL(pg);
+  fail_if(pg->gen_len >= INT32_MAX);
+  fail_if(pg->alph_size > UCHAR_MAX);
+  INFO("Building the enhanced suffix array of the genomic sequence.");
+  const char* const gen= pg->gen->EST_seq;
+  const uint32_t n_suffixes= pg->gen_len+1;
+  my_assert(gen[pg->gen_len] == '\0');
+
+  uint32_t* sa= NPALLOC(uint32_t, n_suffixes);
+  esa_build_suffix_array(gen, n_suffixes, sa);
+  DEBUG("Suffix array built.");
+  uint8_t* lcp= NPALLOC(uint8_t, n_suffixes);
+  uint32_t n_lcp_exc= 0;
+  uint32_t* lcp_exc= esa_build_lcp(gen, n_suffixes, sa, lcp, &n_lcp_exc);
+  DEBUG("LCP array built (%u long values).", n_lcp_exc);
+
+  struct _gen_index_header h;
+  init_header(&h, GENOMIC_INDEX_SUFFIX_ARRAY, pg);
+  h.n_lcp_exc= n_lcp_exc;
+  struct _gen_index_layout l;
+  char* buffer= alloc_buffer(&h, &l);
+  uint32_t* const keys= (uint32_t*)(buffer + l.keys);
+  for (size_t i= 0; i<=UCHAR_MAX; ++i) {
+	 keys[i]= pg->keys[i];
+  }
+  memcpy(buffer + l.sa, sa, (size_t)n_suffixes*sizeof(uint32_t));
+  pfree(sa);
+  memcpy(buffer + l.lcp, lcp, n_suffixes);
+  pfree(lcp);
+  if (lcp_exc != NULL) {
+	 memcpy(buffer + l.lcp_exc, lcp_exc, (size_t)n_lcp_exc*2*sizeof(uint32_t));
+	 free(lcp_exc);
+  }
+  memcpy(buffer + l.text, gen, pg->gen_len);
+  buffer[l.text + pg->gen_len]= '\0';
+
+  pgen_index idx= gen_index_from_buffer(buffer, false);
+  esa_build_child_table(idx, (uint32_t*)(buffer + l.cld));
+  esa_build_single_chars(idx, buffer + l.sc);
+  INFO("Genomic index built: %u suffixes (%zu bytes).", n_suffixes, l.size);
+  return idx;
+}
+
+
+bool
+gen_index_save(const pgen_index idx, const char* const filename) {
+  NOT_NULL(idx);
+  NOT_NULL(filename);
+  if (idx->tree != NULL) {
+	 WARN("The suffix tree has not been flattened and cannot be saved.");
+	 return false;
+  }
+  INFO("Saving the genomic index to file '%s'.", filename);
+  const size_t tmp_len= strlen(filename)+30;
+  char* tmp_filename= c_palloc(tmp_len);
+  snprintf(tmp_filename, tmp_len, "%s.tmp-%u", filename, (unsigned)getpid());
+  FILE* f= fopen(tmp_filename, "wb");
+  if (f == NULL) {
+	 WARN("Cannot create file '%s' (%s).", tmp_filename, strerror(errno));
+	 pfree(tmp_filename);
+	 return false;
+  }
+  bool ok= (fwrite(idx->buffer, 1, idx->buffer_size, f) == idx->buffer_size);
+  ok= (fclose(f) == 0) && ok;
+  if (ok && (rename(tmp_filename, filename) != 0)) {
+	 WARN("Cannot rename file '%s' to '%s' (%s).",
+			tmp_filename, filename, strerror(errno));
+	 ok= false;
+  }
+  if (!ok) {
+	 WARN("The genomic index has not been saved.");
+	 unlink(tmp_filename);
+  }
+  pfree(tmp_filename);
+  return ok;
+}
+
+
+static bool
+check_header(const struct _gen_index_header* const h,
+				 const size_t file_size,
+				 const ppreproc_gen pg,
+				 const pconfiguration config) {
+  if (memcmp(h->magic, GEN_INDEX_MAGIC, sizeof(h->magic)) != 0) {
+	 WARN("The file is not a genomic index.");
+	 return false;
+  }
+  if ((h->version != GEN_INDEX_VERSION) ||
+		(h->byte_order != GEN_INDEX_BYTE_ORDER) ||
+		(h->node_size != sizeof(struct _gen_index_node))) {
+	 WARN("The genomic index has been built by an incompatible version "
+			"(format %u, current format %u).", h->version, GEN_INDEX_VERSION);
+	 return false;
+  }
+  if (h->type != config->genomic_index_type) {
+	 WARN("The genomic index has been built with a different representation.");
+	 return false;
+  }
+  if ((h->type == GENOMIC_INDEX_SUFFIX_TREE) &&
+		(h->min_string_depth != config->min_factor_len)) {
+	 WARN("The genomic index has been built with minimum factor length %u "
+			"instead of %u.", h->min_string_depth, config->min_factor_len);
+	 return false;
+  }
+  if ((h->gen_len != pg->gen_len) || (h->alph_size != pg->alph_size)) {
+	 WARN("The genomic index has not been built from the current genomic sequence.");
+	 return false;
+  }
+  struct _gen_index_layout l;
+  compute_layout(h, &l);
+  if ((h->size != l.size) || (file_size != l.size)) {
+	 WARN("The genomic index is truncated or corrupted.");
+	 return false;
+  }
+  return true;
+}
+
+pgen_index
+gen_index_load(const char* const filename,
+					const ppreproc_gen pg,
+					const pconfiguration config) {
+  NOT_NULL(filename);
+  NOT_NULL(pg);
+  NOT_NULL(config);
+  const int fd= open(filename, O_RDONLY);
+  if (fd < 0) {
+	 INFO("Genomic index '%s' not available (%s).", filename, strerror(errno));
+	 return NULL;
+  }
+  struct stat st;
+  if ((fstat(fd, &st) != 0) ||
+		((size_t)st.st_size < sizeof(struct _gen_index_header))) {
+	 WARN("Genomic index '%s' is not valid.", filename);
+	 close(fd);
+	 return NULL;
+  }
+  const size_t file_size= st.st_size;
+  void* buffer= mmap(NULL, file_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (buffer == MAP_FAILED) {
+	 WARN("Cannot map genomic index '%s' (%s).", filename, strerror(errno));
+	 return NULL;
+  }
+  if (!check_header((const struct _gen_index_header*)buffer, file_size, pg, config)) {
+	 WARN("Genomic index '%s' ignored.", filename);
+	 munmap(buffer, file_size);
+	 return NULL;
+  }
+  pgen_index idx= gen_index_from_buffer(buffer, true);
+  if (memcmp(idx->text, pg->gen->EST_seq, (size_t)idx->gen_len+1) != 0) {
+	 WARN("The genomic index has not been built from the current genomic sequence.");
+	 WARN("Genomic index '%s' ignored.", filename);
+	 gen_index_destroy(idx);
+	 return NULL;
+  }
+  INFO("Genomic index '%s' loaded (%zu bytes).", filename, idx->buffer_size);
+  return idx;
+}
+
+
+void
+gen_index_destroy(pgen_index idx) {
+  if (idx == NULL)
+	 return;
+  if (idx->tree != NULL) {
+	 stree_info_destroy(idx->tree);
+	 lst_stree_free(idx->tree);
+	 pfree(idx->tree_strings);
+  } else if (idx->mapped) {
+	 munmap(idx->buffer, idx->buffer_size);
+  } else {
+	 pfree(idx->buffer);
+  }
+  pfree(idx);
+}
+
+
+/*
+ * Navigation
+ */
+
+#define IS_ESA( idx ) ((idx)->type == GENOMIC_INDEX_SUFFIX_ARRAY)
+#define IS_LST( idx ) ((idx)->tree != NULL)
+#define NODE( idx, v ) ((idx)->nodes+(v).lb)
+
+// The nodes of the libstree tree are identified by their address
+inline static LST_Node*
+lst_node(const gen_node v) {
+  return (LST_Node*)(uintptr_t)(((uint64_t)v.rb << 32) | v.lb);
+}
+
+inline static gen_node
+lst_gen_node(const LST_Node* const node) {
+  const uint64_t address= (uintptr_t)node;
+  gen_node v= { (uint32_t)address, (uint32_t)(address >> 32) };
+  return v;
+}
+
+gen_node
+gen_index_root(const pgen_index idx) {
+  if (IS_ESA(idx))
+	 return esa_root(idx);
+  if (IS_LST(idx))
+	 return lst_gen_node(idx->tree->root_node);
+  gen_node root= { GEN_INDEX_ROOT, GEN_INDEX_ROOT };
+  return root;
+}
+
+bool
+gen_index_is_root(const pgen_index idx, const gen_node v) {
+  if (IS_ESA(idx))
+	 return (v.lb == 0) && (v.rb == idx->gen_len);
+  if (IS_LST(idx))
+	 return lst_node(v) == idx->tree->root_node;
+  return v.lb == GEN_INDEX_ROOT;
+}
+
+size_t
+gen_index_depth(const pgen_index idx, const gen_node v) {
+  if (IS_ESA(idx))
+	 return esa_depth(idx, v);
+  if (IS_LST(idx))
+	 return lst_node(v)->string_depth;
+  return NODE(idx, v)->string_depth;
+}
+
+size_t
+gen_index_parent_depth(const pgen_index idx, const gen_node v) {
+  if (IS_ESA(idx))
+	 return esa_parent_depth(idx, v);
+  if (IS_LST(idx)) {
+	 const LST_Node* const node= lst_node(v);
+	 return (node->up_edge == NULL) ? 0 : node->up_edge->src_node->string_depth;
+  }
+  return NODE(idx, v)->string_depth - NODE(idx, v)->edge_len;
+}
+
+gen_node
+gen_index_parent(const pgen_index idx, const gen_node v) {
+  if (IS_ESA(idx))
+	 return esa_parent(idx, v);
+  if (IS_LST(idx)) {
+	 my_assert(lst_node(v)->up_edge != NULL);
+	 return lst_gen_node(lst_node(v)->up_edge->src_node);
+  }
+  my_assert(NODE(idx, v)->parent != GEN_INDEX_NONE);
+  gen_node p= { NODE(idx, v)->parent, NODE(idx, v)->parent };
+  return p;
+}
+
+bool
+gen_index_find_kid(const pgen_index idx, const gen_node v, const size_t depth,
+						 const char c, gen_node* const kid) {
+  if (IS_ESA(idx))
+	 return esa_find_kid(idx, v, depth, c, kid);
+  if (IS_LST(idx)) {
+	 for (LST_Edge* edge= lst_node(v)->kids.lh_first; edge!=NULL;
+			edge= edge->siblings.le_next) {
+// The terminator is stored as '\0' at position gen_len
+		if (idx->text[edge->range.start_index] == c) {
+		  *kid= lst_gen_node(edge->dst_node);
+		  return true;
+		}
+	 }
+	 return false;
+  }
+  const struct _gen_index_node* const gn= NODE(idx, v);
+  for (uint32_t k= gn->first_kid; k<gn->first_kid+gn->n_kids; ++k) {
+	 if (idx->nodes[k].first_char == c) {
+		kid->lb= kid->rb= k;
+		return true;
+	 }
+  }
+  return false;
+}
+
+char
+gen_index_single_char(const pgen_index idx, const gen_node v) {
+  if (IS_ESA(idx))
+	 return esa_single_char(idx, v);
+  if (IS_LST(idx))
+	 return lst_node(v)->single_char;
+  return NODE(idx, v)->single_char;
+}
+
+const char*
+gen_index_edge_label(const pgen_index idx, const gen_node v,
+							const size_t parent_depth) {
+  if (IS_ESA(idx))
+	 return idx->text + idx->sa[v.lb] + parent_depth;
+  if (IS_LST(idx))
+	 return idx->text + lst_node(v)->up_edge->range.start_index;
+  return idx->text + NODE(idx, v)->edge_start;
+}
+
+gen_node
+gen_index_suffix_link(const pgen_index idx, const gen_node v,
+							 const size_t depth) {
+  if (IS_ESA(idx))
+	 return esa_suffix_link(idx, v, depth);
+  if (IS_LST(idx)) {
+	 const LST_Node* a= lst_node(v);
+	 while (a->string_depth > depth) {
+		a= a->up_edge->src_node;
+	 }
+	 my_assert(a->string_depth == depth);
+	 NOT_NULL(a->suffix_link_node);
+	 return lst_gen_node(a->suffix_link_node);
+  }
+  uint32_t a= v.lb;
+  while (idx->nodes[a].string_depth > depth) {
+	 a= idx->nodes[a].parent;
+  }
+  my_assert(idx->nodes[a].string_depth == depth);
+  my_assert(idx->nodes[a].suffix_link != GEN_INDEX_NONE);
+  gen_node sl= { idx->nodes[a].suffix_link, idx->nodes[a].suffix_link };
+  return sl;
+}
+
+// As the flat representation, but the slices and the occurrences are the
+// ones computed by stree_preprocess on the libstree tree
+static void
+lst_for_each_occurrence(const pgen_index idx,
+								const gen_node v,
+								const gen_node* const block,
+								const size_t skip_k,
+								gen_occurrence_function f,
+								void* data) {
+  const size_t* const slices= lst_node(v)->slices;
+  NOT_NULL(slices);
+  const size_t* block_slices= NULL;
+  if (block != NULL) {
+	 block_slices= lst_node(*block)->slices;
+	 NOT_NULL(block_slices);
+  }
+  const size_t* const occ= idx->tree->arr_occs;
+  for (size_t k= 0; k<idx->alph_size; ++k) {
+	 if (k == skip_k)
+		continue;
+	 const size_t start= slices[2*k];
+	 const size_t end= slices[2*k+1];
+	 size_t block_start, block_end;
+	 if ((block_slices == NULL) || (block_slices[2*k+1]==0)) {
+		block_start= block_end= end;
+	 } else {
+		block_start= block_slices[2*k];
+		block_end= block_slices[2*k+1];
+	 }
+	 for (size_t i= start; i<block_start; ++i) {
+		f(data, occ[i], k, true);
+	 }
+	 for (size_t i= block_end; i<end; ++i) {
+		f(data, occ[i], k, false);
+	 }
+  }
+}
+
+void
+gen_index_for_each_occurrence(const pgen_index idx,
+										const gen_node v,
+										const gen_node* const block,
+										const size_t skip_k,
+										gen_occurrence_function f,
+										void* data) {
+  if (IS_ESA(idx)) {
+	 esa_for_each_occurrence(idx, v, block, skip_k, f, data);
+	 return;
+  }
+  if (IS_LST(idx)) {
+	 lst_for_each_occurrence(idx, v, block, skip_k, f, data);
+	 return;
+  }
+  my_assert(NODE(idx, v)->slices != GEN_INDEX_NONE);
+  const uint32_t* const slices= idx->slices+NODE(idx, v)->slices;
+  const uint32_t* block_slices= NULL;
+  if (block != NULL) {
+	 my_assert(NODE(idx, *block)->slices != GEN_INDEX_NONE);
+	 block_slices= idx->slices+NODE(idx, *block)->slices;
+  }
+  const uint32_t* const occ= idx->occs;
+  for (size_t k= 0; k<idx->alph_size; ++k) {
+	 if (k == skip_k)
+		continue;
+	 const size_t start= slices[2*k];
+	 const size_t end= slices[2*k+1];
+	 size_t block_start, block_end;
+	 if ((block_slices == NULL) || (block_slices[2*k+1]==0)) {
+		block_start= block_end= end;
+	 } else {
+		block_start= block_slices[2*k];
+		block_end= block_slices[2*k+1];
+	 }
+	 for (size_t i= start; i<block_start; ++i) {
+		f(data, occ[i], k, true);
+	 }
+	 for (size_t i= block_end; i<end; ++i) {
+		f(data, occ[i], k, false);
+	 }
+  }
+}
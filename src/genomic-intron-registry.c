@@ -0,0 +1,297 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010,2012  Yuri Pirola, Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+/**
+ *
+ * @file genomic-intron-registry.c
+ *
+ * Registry of the genomic introns induced by the transcripts and index of
+ * the lists of genomic introns on their coordinates.
+ *
+ **/
+
+#include "genomic-intron-registry.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util.h"
+#include "log.h"
+
+#define REGISTRY_INITIAL_SIZE 64
+
+static inline size_t
+intron_hash(const int start, const int end, const size_t table_size) {
+  uint64_t h= ((uint64_t)(uint32_t)start << 32) | (uint32_t)end;
+  h^= h >> 33;
+  h*= UINT64_C(0xff51afd7ed558ccd);
+  h^= h >> 33;
+  return (size_t)(h & (table_size-1));
+}
+
+// Return the slot of the intron from start to end or the empty slot where it
+// should be inserted
+static inline size_t
+find_slot(pgenomic_intron* const table, const size_t table_size,
+			 const int start, const int end) {
+  size_t i= intron_hash(start, end, table_size);
+  while ((table[i] != NULL) &&
+			((table[i]->start != start) || (table[i]->end != end))) {
+	 i= (i+1) & (table_size-1);
+  }
+  return i;
+}
+
+static void
+grow_table(pgenomic_intron_registry reg) {
+  const size_t new_size= 2*reg->table_size;
+  pgenomic_intron* new_table= NPALLOC(pgenomic_intron, new_size);
+  memset(new_table, 0, new_size*sizeof(pgenomic_intron));
+  for (size_t i= 0; i<reg->table_size; ++i) {
+	 if (reg->table[i] != NULL) {
+		const size_t slot= find_slot(new_table, new_size,
+											  reg->table[i]->start, reg->table[i]->end);
+		new_table[slot]= reg->table[i];
+	 }
+  }
+  pfree(reg->table);
+  reg->table= new_table;
+  reg->table_size= new_size;
+}
+
+pgenomic_intron_registry
+genomic_intron_registry_create(const size_t gen_length) {
+  pgenomic_intron_registry reg= PALLOC(struct _genomic_intron_registry);
+  reg->gen_length= gen_length;
+  reg->introns= list_create();
+  reg->n_introns= 0;
+  reg->table_size= REGISTRY_INITIAL_SIZE;
+  reg->table= NPALLOC(pgenomic_intron, reg->table_size);
+  memset(reg->table, 0, reg->table_size*sizeof(pgenomic_intron));
+  reg->sorted_capacity= REGISTRY_INITIAL_SIZE;
+  reg->sorted= NPALLOC(pgenomic_intron, reg->sorted_capacity);
+  reg->is_sorted= true;
+  return reg;
+}
+
+void
+genomic_intron_registry_destroy(pgenomic_intron_registry reg) {
+  my_assert(reg != NULL);
+  list_destroy(reg->introns, (delete_function)genomic_intron_destroy);
+  pfree(reg->table);
+  pfree(reg->sorted);
+  pfree(reg);
+}
+
+pgenomic_intron
+genomic_intron_registry_find(pgenomic_intron_registry reg,
+									  const int start, const int end) {
+  my_assert(reg != NULL);
+  return reg->table[find_slot(reg->table, reg->table_size, start, end)];
+}
+
+void
+genomic_intron_registry_insert(pgenomic_intron_registry reg,
+										 pgenomic_intron gen_intron) {
+  my_assert(reg != NULL);
+  my_assert(gen_intron != NULL);
+  my_assert(genomic_intron_registry_find(reg, gen_intron->start, gen_intron->end) == NULL);
+// Keep the load factor of the table below 1/2
+  if (2*(reg->n_introns+1) > reg->table_size)
+	 grow_table(reg);
+  const size_t slot= find_slot(reg->table, reg->table_size,
+										 gen_intron->start, gen_intron->end);
+  reg->table[slot]= gen_intron;
+  list_add_to_head(reg->introns, gen_intron);
+  if (reg->n_introns == reg->sorted_capacity) {
+	 reg->sorted_capacity*= 2;
+	 pgenomic_intron* new_sorted= NPALLOC(pgenomic_intron, reg->sorted_capacity);
+	 memcpy(new_sorted, reg->sorted, reg->n_introns*sizeof(pgenomic_intron));
+	 pfree(reg->sorted);
+	 reg->sorted= new_sorted;
+  }
+  if ((reg->n_introns > 0) && reg->is_sorted &&
+		(genomic_intron_compare(&reg->sorted[reg->n_introns-1], &gen_intron) > 0))
+	 reg->is_sorted= false;
+  reg->sorted[reg->n_introns]= gen_intron;
+  ++reg->n_introns;
+}
+
+pgenomic_intron*
+genomic_intron_registry_sorted(pgenomic_intron_registry reg) {
+  my_assert(reg != NULL);
+  if (!reg->is_sorted) {
+	 qsort(reg->sorted, reg->n_introns, sizeof(pgenomic_intron),
+			 (int (*)(const void*, const void*))genomic_intron_compare);
+	 reg->is_sorted= true;
+  }
+  return reg->sorted;
+}
+
+size_t
+genomic_intron_registry_lower_bound(pgenomic_intron_registry reg,
+												const int start, const int end) {
+  pgenomic_intron* const sorted= genomic_intron_registry_sorted(reg);
+  size_t lo= 0, hi= reg->n_introns;
+  while (lo < hi) {
+	 const size_t mid= lo + (hi-lo)/2;
+	 if ((sorted[mid]->start < start) ||
+		  ((sorted[mid]->start == start) && (sorted[mid]->end < end))) {
+		lo= mid+1;
+	 } else {
+		hi= mid;
+	 }
+  }
+  return lo;
+}
+
+
+static int
+entry_start_compare(const struct _genomic_intron_index_entry* e1,
+						  const struct _genomic_intron_index_entry* e2) {
+  if (e1->intron->start != e2->intron->start)
+	 return (e1->intron->start < e2->intron->start) ? -1 : 1;
+  return (e1->rank < e2->rank) ? -1 : ((e1->rank > e2->rank) ? 1 : 0);
+}
+
+static int
+entry_end_compare(const struct _genomic_intron_index_entry* e1,
+						const struct _genomic_intron_index_entry* e2) {
+  if (e1->intron->end != e2->intron->end)
+	 return (e1->intron->end < e2->intron->end) ? -1 : 1;
+  return (e1->rank < e2->rank) ? -1 : ((e1->rank > e2->rank) ? 1 : 0);
+}
+
+static int
+entry_rank_compare(const struct _genomic_intron_index_entry* e1,
+						 const struct _genomic_intron_index_entry* e2) {
+  return (e1->rank < e2->rank) ? -1 : ((e1->rank > e2->rank) ? 1 : 0);
+}
+
+pgenomic_intron_index
+genomic_intron_index_create(plist gen_intron_pointer_list) {
+  my_assert(gen_intron_pointer_list != NULL);
+  pgenomic_intron_index idx= PALLOC(struct _genomic_intron_index);
+  idx->n_introns= list_size(gen_intron_pointer_list);
+// Allocate at least one entry per array
+  const size_t n_alloc= (idx->n_introns > 0) ? idx->n_introns : 1;
+  idx->by_start= NPALLOC(struct _genomic_intron_index_entry, n_alloc);
+  idx->by_end= NPALLOC(struct _genomic_intron_index_entry, n_alloc);
+  idx->candidates= NPALLOC(struct _genomic_intron_index_entry, n_alloc);
+  idx->n_candidates= 0;
+  size_t rank= 0;
+  plistit it= list_first(gen_intron_pointer_list);
+  while (listit_has_next(it)) {
+	 ppointer pp= (ppointer)listit_next(it);
+	 idx->by_start[rank].intron= (pgenomic_intron)pp->pointer;
+	 idx->by_start[rank].rank= rank;
+	 ++rank;
+  }
+  listit_destroy(it);
+  memcpy(idx->by_end, idx->by_start,
+			idx->n_introns*sizeof(struct _genomic_intron_index_entry));
+  qsort(idx->by_start, idx->n_introns, sizeof(struct _genomic_intron_index_entry),
+		  (int (*)(const void*, const void*))entry_start_compare);
+  qsort(idx->by_end, idx->n_introns, sizeof(struct _genomic_intron_index_entry),
+		  (int (*)(const void*, const void*))entry_end_compare);
+  return idx;
+}
+
+void
+genomic_intron_index_destroy(pgenomic_intron_index idx) {
+  my_assert(idx != NULL);
+  pfree(idx->by_start);
+  pfree(idx->by_end);
+  pfree(idx->candidates);
+  pfree(idx);
+}
+
+static inline bool
+is_close(const int p1, const int p2, const int range) {
+  return (p1 > p2 - range) && (p1 < p2 + range);
+}
+
+// Position of the first entry with start (or end) greater than pos-range
+static size_t
+first_in_window(const struct _genomic_intron_index_entry* const entries,
+					 const size_t n, const int pos, const int range,
+					 const bool on_start) {
+  size_t lo= 0, hi= n;
+  while (lo < hi) {
+	 const size_t mid= lo + (hi-lo)/2;
+	 const int p= on_start ? entries[mid].intron->start : entries[mid].intron->end;
+	 if (p <= pos - range) {
+		lo= mid+1;
+	 } else {
+		hi= mid;
+	 }
+  }
+  return lo;
+}
+
+size_t
+genomic_intron_index_query_into(const pgenomic_intron_index idx,
+										  const int start, const int end,
+										  const int range, const bool on_both_sites,
+										  struct _genomic_intron_index_entry* const candidates) {
+  my_assert(idx != NULL);
+  my_assert(candidates != NULL);
+  my_assert(range > 0);
+  size_t n_candidates= 0;
+  for (size_t i= first_in_window(idx->by_start, idx->n_introns, start, range, true);
+		 (i < idx->n_introns) && (idx->by_start[i].intron->start < start + range);
+		 ++i) {
+	 if (!on_both_sites || is_close(idx->by_start[i].intron->end, end, range))
+		candidates[n_candidates++]= idx->by_start[i];
+  }
+  if (!on_both_sites) {
+// Add the introns close only on the end (the others are already candidates)
+	 for (size_t i= first_in_window(idx->by_end, idx->n_introns, end, range, false);
+			(i < idx->n_introns) && (idx->by_end[i].intron->end < end + range);
+			++i) {
+		if (!is_close(idx->by_end[i].intron->start, start, range))
+		  candidates[n_candidates++]= idx->by_end[i];
+	 }
+  }
+  if (n_candidates > 1)
+	 qsort(candidates, n_candidates, sizeof(struct _genomic_intron_index_entry),
+			 (int (*)(const void*, const void*))entry_rank_compare);
+  return n_candidates;
+}
+
+size_t
+genomic_intron_index_query(pgenomic_intron_index idx,
+									const int start, const int end,
+									const int range, const bool on_both_sites) {
+  my_assert(idx != NULL);
+  idx->n_candidates= genomic_intron_index_query_into(idx, start, end, range,
+																	  on_both_sites, idx->candidates);
+  return idx->n_candidates;
+}
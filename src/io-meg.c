@@ -189,5 +189,26 @@ void meg_write(FILE* dest, pext_array graph ) {
 }//end meg_write
 
 
+void meg_write_csr(FILE* dest, const pcsr_meg meg) {
+  my_assert( dest != NULL);
+  my_assert( meg != NULL);
+  DEBUG("Writing the MEG");
+  DEBUG("Vertex-set");
+  for (size_t i= 0; i < meg->n_pairings; ++i) {
+	 fprintf(dest, "(%d,%d,%d)\n",
+				meg->pairings[i]->p,
+				meg->pairings[i]->t,
+				meg->pairings[i]->l);
+  }
+  DEBUG("Edge-set");
+  fprintf(dest,"#adj#\n");
+  for (unsigned int i= 0; i < meg->n_pairings; ++i) {
+	 for (unsigned int k= 0; k < csr_meg_n_adjs(meg, i); ++k) {
+		fprintf(dest,"%u-%u\n", i, csr_meg_adj(meg, i, k));
+	 }
+  }
+}//end meg_write_csr
+
+
 #undef LEN_BUFFER
 
@@ -32,62 +32,19 @@
 #include "io-multifasta.h"
 #include "log.h"
 #include "util.h"
+#include "nucleotide-codes.h"
 #include <string.h>
 #define LEN_BUFFER 10000000
 #define LEN_STRAND_ARRAY 10
 #define LEN_ABSCOORD_ARRAY 100
 
-static char get_Complement(char car){
-  if(car == 'A')
-	 return 'T';
-  if(car == 'a')
-	 return 't';
-  if(car == 'T')
-	 return 'A';
-  if(car == 't')
-	 return 'a';
-  if(car == 'C')
-	 return 'G';
-  if(car == 'c')
-	 return 'g';
-  if(car == 'G')
-	 return 'C';
-  if(car == 'g')
-	 return 'c';
-  if(car == 'R')
-	 return 'Y';
-  if(car == 'r')
-	 return 'y';
-  if(car == 'Y')
-	 return 'R';
-  if(car == 'y')
-	 return 'r';
-  if(car == 'M')
-	 return 'K';
-  if(car == 'm')
-	 return 'k';
-  if(car == 'K')
-	 return 'M';
-  if(car == 'k')
-	 return 'm';
-  if(car == 'B')
-	 return 'V';
-  if(car == 'b')
-	 return 'v';
-  if(car == 'V')
-	 return 'B';
-  if(car == 'v')
-	 return 'b';
-  if(car == 'D')
-	 return 'H';
-  if(car == 'd')
-	 return 'h';
-  if(car == 'H')
-	 return 'D';
-  if(car == 'h')
-	 return 'd';
-
-  return car;
+// EST_seq e original_EST_seq possono condividere la stessa memoria finche'
+// EST_seq non viene modificata: in tal caso viene prima copiata
+static void unshare_EST_seq(pEST_info EST_info){
+  if (EST_info->EST_seq == EST_info->original_EST_seq) {
+	 DEBUG("Copying the sequence before modifying it.");
+	 EST_info->EST_seq= alloc_and_copy(EST_info->original_EST_seq);
+  }
 }
 
 static char* getData(char *buffer, size_t n, FILE *f_in, int* lenght){
@@ -96,73 +53,215 @@ static char* getData(char *buffer, size_t n, FILE *f_in, int* lenght){
   my_assert(f_in != NULL);
   my_assert(lenght != NULL);
 
-  char* res;
-  plist l= list_create();
-  int len= 0;
+// Le righe vengono accodate direttamente nel risultato (ridimensionato
+// se necessario), senza copie intermedie
+  size_t res_size= 1024;
+  char* res= c_palloc(res_size);
+  size_t len= 0;
   int leng= *lenght;
 
   while(buffer[0] != '>' && leng != EOF && strcmp(buffer,"#\\#")){
 	 if (leng>0) {
-		char* readline = alloc_and_copy(buffer);
-		FINETRACE("the read line is |%s|", readline);
+		FINETRACE("the read line is |%s|", buffer);
 		FINETRACE("the length of the read line is %d", leng);
-		list_add_to_tail(l, readline);
+		if (len + leng + 1 > res_size) {
+		  while (len + leng + 1 > res_size)
+			 res_size*= 2;
+		  res= (char*)realloc(res, res_size);
+		  if (res == NULL) {
+			 FATAL("Allocation memory error. Trying to allocate %zu bytes.", res_size);
+			 fail();
+		  }
+		}
+		memcpy(res + len, buffer, leng);
 		len = len + leng;
 	 }
 	 leng = my_getline(&buffer,&n,f_in);
 	 *lenght = leng;
   }//end-While
 
-  plistit li = list_first(l);
-  res= c_palloc(len+1);
-
-  int ind = 0;
-  while(listit_has_next(li)){
-	 char* tmp = (char*) listit_next(li);
-	 memcpy(res + ind, tmp, strlen(tmp));
-	 ind = ind + strlen(tmp);
-  }
-  res[ind] = '\0';
-  list_destroy(l, (delete_function)pfree_function);
-  listit_destroy(li);
+  res[len] = '\0';
   FINETRACE("the concatenated string is |%s|", res);
   return res;
 }//end-getData
 
 
+/*
+  Streaming reader.
+  Il buffer contiene sempre (almeno) il record corrente a partire dalla
+  posizione mark; i byte precedenti possono essere scartati quando si
+  leggono nuovi blocchi. Le righe della sequenza vengono concatenate sul
+  posto (la posizione di scrittura non supera mai quella di lettura).
+*/
+
+#ifndef MULTIFASTA_BLOCK_SIZE
+#define MULTIFASTA_BLOCK_SIZE (4*1024*1024)
+#endif
+
+struct _multifasta_reader {
+  FILE* f;
+  char* buf;
+  size_t size;
+  size_t end;
+  size_t pos;
+  size_t mark;
+  bool eof;
+// Record corrente
+  size_t id_off;
+  size_t id_end;
+  size_t seq_off;
+  size_t wpos;
+};
+
+pmultifasta_reader multifasta_reader_create(FILE* f) {
+  my_assert(f != NULL);
+  pmultifasta_reader r= PALLOC(struct _multifasta_reader);
+  r->f= f;
+  r->size= MULTIFASTA_BLOCK_SIZE;
+  r->buf= c_palloc(r->size);
+  r->end= r->pos= r->mark= 0;
+  r->eof= false;
+  r->id_off= r->id_end= r->seq_off= r->wpos= 0;
+  return r;
+}
+
+void multifasta_reader_destroy(pmultifasta_reader r) {
+  my_assert(r != NULL);
+  pfree(r->buf);
+  pfree(r);
+}
+
+static void
+reader_refill(pmultifasta_reader r) {
+  my_assert(!r->eof);
+// Scarta i byte che precedono mark
+  const size_t delta= r->mark;
+  if (delta > 0) {
+	 memmove(r->buf, r->buf + delta, r->end - delta);
+	 r->end-= delta;
+	 r->pos-= delta;
+	 r->mark= 0;
+	 r->id_off-= MIN(r->id_off, delta);
+	 r->id_end-= MIN(r->id_end, delta);
+	 r->seq_off-= MIN(r->seq_off, delta);
+	 r->wpos-= MIN(r->wpos, delta);
+  }
+// Un byte resta sempre libero per il terminatore della stringa
+  if (r->size - r->end < MULTIFASTA_BLOCK_SIZE/2) {
+	 r->size*= 2;
+	 TRACE("Extending the multifasta buffer to %zu bytes.", r->size);
+	 r->buf= (char*)realloc(r->buf, r->size);
+	 if (r->buf == NULL) {
+		FATAL("Allocation memory error. Trying to allocate %zu bytes.", r->size);
+		fail();
+	 }
+  }
+  const size_t n= fread(r->buf + r->end, 1, r->size - r->end - 1, r->f);
+  r->end+= n;
+  if (n == 0) {
+	 if (ferror(r->f)) {
+		FATAL("Error while reading the multifasta file.");
+		fail();
+	 }
+	 r->eof= true;
+  }
+}
+
+// Legge la prossima riga [*ls, *le), eliminando i caratteri di controllo finali
+// (come my_getline). Ritorna false alla fine del file.
+static bool
+reader_next_line(pmultifasta_reader r, size_t* ls, size_t* le) {
+  while (true) {
+	 char* nl= (char*)memchr(r->buf + r->pos, '\n', r->end - r->pos);
+	 if (nl != NULL) {
+		*ls= r->pos;
+		*le= nl - r->buf;
+		r->pos= *le + 1;
+		break;
+	 }
+	 if (r->eof) {
+		if (r->pos == r->end)
+		  return false;
+		*ls= r->pos;
+		*le= r->end;
+		r->pos= r->end;
+		break;
+	 }
+	 reader_refill(r);
+  }
+  while ((*le > *ls) && (r->buf[*le - 1] < ' '))
+	 --(*le);
+  return true;
+}
+
+bool multifasta_reader_next(pmultifasta_reader r, pmultifasta_record rec) {
+  my_assert(r != NULL);
+  my_assert(rec != NULL);
+  size_t ls, le;
+// Ricerca dell'intestazione (le altre righe vengono ignorate)
+  do {
+	 r->mark= r->pos;
+	 if (!reader_next_line(r, &ls, &le))
+		return false;
+  } while ((le == ls) || (r->buf[ls] != '>'));
+  r->mark= ls;
+  r->id_off= ls + 1;
+  r->id_end= le;
+  r->seq_off= r->wpos= r->pos;
+// Concatenazione delle righe della sequenza
+  while (reader_next_line(r, &ls, &le)) {
+	 if ((le > ls) && (r->buf[ls] == '>')) {
+		r->pos= ls;
+		break;
+	 }
+	 if ((le - ls == 3) && (memcmp(r->buf + ls, "#\\#", 3) == 0))
+		break;
+	 if (r->wpos != ls)
+		memmove(r->buf + r->wpos, r->buf + ls, le - ls);
+	 r->wpos+= le - ls;
+  }
+  r->buf[r->id_end]= '\0';
+  rec->id= r->buf + r->id_off;
+  rec->id_len= r->id_end - r->id_off;
+  rec->seq_len= r->wpos - r->seq_off;
+  if (rec->seq_len > 0) {
+	 r->buf[r->wpos]= '\0';
+	 rec->seq= r->buf + r->seq_off;
+  } else {
+	 rec->seq= "";
+  }
+  return true;
+}
+
+static char*
+copy_view(const char* const src, const size_t len) {
+  char* dest= c_palloc(len+1);
+  memcpy(dest, src, len);
+  dest[len]= '\0';
+  return dest;
+}
+
+pEST_info multifasta_reader_next_EST_info(pmultifasta_reader r) {
+  struct _multifasta_record rec;
+  if (!multifasta_reader_next(r, &rec))
+	 return NULL;
+  pEST_info obj = EST_info_create();
+  obj->EST_id= copy_view(rec.id, strnlen(rec.id, rec.id_len));
+  obj->EST_seq= copy_view(rec.seq, strnlen(rec.seq, rec.seq_len));
+// La sequenza originale e' condivisa finche' EST_seq non viene modificata
+  obj->original_EST_seq= obj->EST_seq;
+  return obj;
+}
+
 plist read_multifasta(FILE* inputFile){
   my_assert(inputFile != NULL);
   plist data_list = list_create();
-  size_t size;
-  int length;
-  size= LEN_BUFFER;
-  char* string = c_palloc(size);
-  char* tmp;
-  length= my_getline(&string, &size, inputFile);
-  while(length>0 && string[length]<32) {
-	 string[length]= '\0';
-	 length--;
-  }
-  while(length != EOF){
-	 if(string[0] == '>'){
-		pEST_info obj = EST_info_create();
-		tmp = substring(1, string);
-		obj->EST_id = tmp;
-		length= my_getline(&string, &size, inputFile);
-		tmp= getData(string, size, inputFile, &length);
-		obj->EST_seq = tmp;
-		char *original_seq=substring(0, obj->EST_seq);
-		obj->original_EST_seq = original_seq;
-		list_add_to_tail(data_list,obj);
-	 } else {
-		length = my_getline(&string, &size, inputFile);
-		while(length>0 && string[length]<32) {
-		  string[length]= '\0';
-		  length--;
-		}
-	 }
-  }//end-while
-  pfree(string);
+  pmultifasta_reader r= multifasta_reader_create(inputFile);
+  pEST_info obj;
+  while ((obj= multifasta_reader_next_EST_info(r)) != NULL) {
+	 list_add_to_tail(data_list,obj);
+  }
+  multifasta_reader_destroy(r);
   return data_list;
 }
 
@@ -240,6 +339,114 @@ void write_multifasta_output(pEST_info gen, pEST est, FILE* output_file, char re
  }
 }
 
+// Return the last EST of ests if its id is EST_id, otherwise a new EST
+// (added to ests) with the given id and no factorizations.
+// Consecutive factorizations of the same EST are grouped as
+// in read_factorizations.
+static pEST
+get_tail_EST(plist ests, const char* const EST_id){
+  if(!list_is_empty(ests)){
+	 pEST tail=(pEST)list_tail(ests);
+	 if(!strcmp(tail->info->EST_id, EST_id))
+		return tail;
+  }
+  pEST dest=EST_create();
+  dest->info=EST_info_create();
+  dest->info->EST_id=alloc_and_copy(EST_id);
+  dest->factorizations=list_create();
+  dest->polyA_signals=boollist_create();
+  dest->polyadenil_signals=boollist_create();
+  list_add_to_tail(ests, dest);
+  return dest;
+}
+
+void add_multifasta_output(pEST_info gen, pEST est, plist ests, char retain_externals){
+  my_assert(est != NULL);
+  my_assert(ests != NULL);
+
+  if(!(est->factorizations == NULL || list_is_empty(est->factorizations))){
+	 plistit f_it=list_first(est->factorizations);
+	 pboollistit polya_it=boollist_first(est->polyA_signals);
+	 pboollistit polyadenil_it=boollist_first(est->polyadenil_signals);
+
+	 while(listit_has_next(f_it)){
+		my_assert(boollistit_has_next(polya_it));
+		my_assert(boollistit_has_next(polyadenil_it));
+
+		plist factorization=(plist)listit_next(f_it);
+		bool polya=(bool) boollistit_next(polya_it);
+		bool polyadenil=(bool) boollistit_next(polyadenil_it);
+
+		if(retain_externals || (list_size(factorization) > 2 || (list_size(factorization) == 2 && est->info->suff_polyA_length != -1))){
+		  pEST dest=get_tail_EST(ests, est->info->EST_id);
+
+		  if(!retain_externals){
+			  polya=0;
+			  polyadenil=0;
+		  }
+		  boollist_add_to_tail(dest->polyA_signals, polya);
+		  boollist_add_to_tail(dest->polyadenil_signals, polyadenil);
+
+		  pfactorization pfact=list_create();
+		  plistit factor_it;
+		  factor_it=list_first(factorization);
+
+		  unsigned int counter=1;
+		  unsigned int l_index=(retain_externals == 0)?(1):(0);
+		  unsigned int r_index=(retain_externals == 0)?((est->info->suff_polyA_length == -1)?(list_size(factorization)):(list_size(factorization)+1)):(list_size(factorization)+1);
+
+		  while(listit_has_next(factor_it)){
+                    pfactor factor=(pfactor)listit_next(factor_it);
+                    if(counter > l_index && counter < r_index){
+                      pfactor copy=factor_create();
+                      copy->EST_start=factor->EST_start + 1;
+                      copy->EST_end=factor->EST_end + 1;
+                      copy->GEN_start=gen->pref_N_length + factor->GEN_start + 1;
+                      copy->GEN_end=gen->pref_N_length + factor->GEN_end + 1;
+                      list_add_to_tail(pfact, copy);
+                    }
+                    counter++;
+		  }
+		  listit_destroy(factor_it);
+		  list_add_to_tail(dest->factorizations, pfact);
+		}
+	 }
+
+	 listit_destroy(f_it);
+	 boollistit_destroy(polya_it);
+	 boollistit_destroy(polyadenil_it);
+ }
+}
+
+void append_factorized_ESTs(plist ests, plist src){
+  my_assert(ests != NULL);
+  my_assert(src != NULL);
+  while(!list_is_empty(src)){
+	 pEST est=(pEST)list_remove_from_head(src);
+	 pEST dest=list_is_empty(ests)?NULL:(pEST)list_tail(ests);
+	 if(dest == NULL || strcmp(dest->info->EST_id, est->info->EST_id)){
+		list_add_to_tail(ests, est);
+	 } else {
+		while(!list_is_empty(est->factorizations)){
+		  list_add_to_tail(dest->factorizations, list_remove_from_head(est->factorizations));
+		  boollist_add_to_tail(dest->polyA_signals, boollist_remove_from_head(est->polyA_signals));
+		  boollist_add_to_tail(dest->polyadenil_signals, boollist_remove_from_head(est->polyadenil_signals));
+		}
+		EST_destroy(est);
+	 }
+  }
+}
+
+pEST_info copy_EST_info_as_read(pEST_info EST_info){
+  my_assert(EST_info != NULL);
+
+  pEST_info copy=EST_info_create();
+  copy->EST_id=alloc_and_copy(EST_info->EST_id);
+  copy->EST_seq=alloc_and_copy(EST_info->original_EST_seq);
+  copy->original_EST_seq=copy->EST_seq;
+  return copy;
+}
+
 pEST_info read_single_EST_info(FILE* source){
 
   my_assert(source != NULL);
@@ -510,8 +717,8 @@ void reverse_and_complement(pEST_info EST_info) {
   size_t left= 0;
 
   while (left<=right) {
-	 char new_right=get_Complement(EST_info->EST_seq[left]);
-	 char new_left=get_Complement(EST_info->EST_seq[right]);
+	 char new_right=nt_complement(EST_info->EST_seq[left]);
+	 char new_left=nt_complement(EST_info->EST_seq[right]);
 	 EST_info->EST_seq[right]= new_right;
 	 EST_info->EST_seq[left]= new_left;
 	 EST_info->original_EST_seq[right]= new_right;
@@ -591,6 +798,7 @@ static void old_polyAT_substitution(pEST_info EST_info) {
 	 char sc= (c=='A')?_POLYA_CHR:_POLYT_CHR;
 	 size_t mlen= ((c=='A')?last_A+1:last_T+1);
 	 INFO("Found a %zubp long initial poly%c.", mlen, c);
+	 unshare_EST_seq(EST_info);
 	 for (i= 0; i<mlen; ++i)
 		EST_info->EST_seq[i]= sc;
 	 if(c=='A'){
@@ -650,6 +858,7 @@ static void old_polyAT_substitution(pEST_info EST_info) {
 	 char sc= (c=='A')?_POLYA_CHR:_POLYT_CHR;
 	 size_t mlen= ((c=='A')?last_A+1:last_T+1);
 	 INFO("Found a %zubp long final poly%c.", mlen, c);
+	 unshare_EST_seq(EST_info);
 	 for (i= 0; i<mlen; ++i)
 		EST_info->EST_seq[est_len-i-1]= sc;
 	 if(c=='A'){
@@ -744,6 +953,7 @@ void polyAT_substitution(pEST_info EST_info) {
 	 char sc= (c=='A')?_POLYA_CHR:_POLYT_CHR;
 	 size_t mlen= ((c=='A')?last_A+1:last_T+1);
 	 INFO("Found a %zubp long initial poly%c.", mlen, c);
+	 unshare_EST_seq(EST_info);
 	 for (i= 0; i<mlen; ++i)
 		EST_info->EST_seq[i]= sc;
 	 if(c=='A'){
@@ -815,6 +1025,7 @@ void polyAT_substitution(pEST_info EST_info) {
 	 char sc= (c=='A')?_POLYA_CHR:_POLYT_CHR;
 	 size_t mlen= ((c=='A')?last_A+1:last_T+1);
 	 INFO("Found a %zubp long final poly%c.", mlen, c);
+	 unshare_EST_seq(EST_info);
 	 for (i= 0; i<mlen; ++i)
 		EST_info->EST_seq[est_len-i-1]= sc;
 	 if(c=='A'){
@@ -840,6 +1051,7 @@ void Ntails_removal(pEST_info EST_info) {
 			++pref) {
 // Do nothing
 	 }
+	 unshare_EST_seq(EST_info);
 	 int i= pref;
 	 int j= 0;
 	 while (i<=est_len) {
@@ -860,7 +1072,10 @@ void Ntails_removal(pEST_info EST_info) {
 	 FATAL("The sequence is only composed by Ns.");
 	 fail();
   }
-  EST_info->EST_seq[est_len-suff]= '\0';
+  if (suff>0) {
+	 unshare_EST_seq(EST_info);
+	 EST_info->EST_seq[est_len-suff]= '\0';
+  }
   EST_info->suff_N_length= suff;
   if (suff>0) {
 	 INFO("Removed a suffix of %d N.", suff);
@@ -32,11 +32,107 @@
 #include "util.h"
 #include <stdlib.h>
 
+#ifndef LIST_POOL_SIZE
+#define LIST_POOL_SIZE 4096
+#endif
+
+#define LIST_POOL_ITERATORS 64
+
+/*
+ * Pool (uno per thread) dei nodi e degli iteratori deallocati, riutilizzati
+ * dalle allocazioni successive senza passare per malloc/free.
+ * I nodi liberi sono collegati tramite il campo next.
+ * Essendo locale al thread, il pool non richiede sincronizzazione.
+ */
+struct _list_pool {
+  _pnode nodes;
+  size_t n_nodes;
+  plistit its[LIST_POOL_ITERATORS];
+  size_t n_its;
+};
+
+static __thread struct _list_pool list_pool;
+
+static inline
+_pnode node_alloc(plist l) {
+  if (l->arena != NULL)
+	 return ARENA_PALLOC(l->arena, struct _node);
+#if LIST_POOL_SIZE > 0
+  if (list_pool.nodes != NULL) {
+	 _pnode n= list_pool.nodes;
+	 list_pool.nodes= n->next;
+	 --list_pool.n_nodes;
+	 return n;
+  }
+#endif
+  return PALLOC(struct _node);
+}
+
+static inline
+void node_free(plist l, _pnode n) {
+  if (l->arena != NULL)
+	 return;
+#if LIST_POOL_SIZE > 0
+  if (list_pool.n_nodes < LIST_POOL_SIZE) {
+	 n->next= list_pool.nodes;
+	 list_pool.nodes= n;
+	 ++list_pool.n_nodes;
+	 return;
+  }
+#endif
+  pfree(n);
+}
+
+plistit _listit_alloc(void) {
+#if LIST_POOL_SIZE > 0
+  if (list_pool.n_its > 0)
+	 return list_pool.its[--list_pool.n_its];
+#endif
+  return PALLOC(struct _listit);
+}
+
+void _listit_free(plistit li) {
+#if LIST_POOL_SIZE > 0
+  if (list_pool.n_its < LIST_POOL_ITERATORS) {
+	 list_pool.its[list_pool.n_its++]= li;
+	 return;
+  }
+#endif
+  pfree(li);
+}
+
+void list_pool_trim(void) {
+  FINETRACE("Releasing %zu pooled nodes and %zu pooled iterators.",
+				list_pool.n_nodes, list_pool.n_its);
+  while (list_pool.nodes != NULL) {
+	 _pnode n= list_pool.nodes;
+	 list_pool.nodes= n->next;
+	 pfree(n);
+  }
+  list_pool.n_nodes= 0;
+  while (list_pool.n_its > 0) {
+	 pfree(list_pool.its[--list_pool.n_its]);
+  }
+}
+
 plist list_create(void) {
   FINETRACE("New list creation");
   plist ris= PALLOC(struct _list);
   ris->size= 0;
-  ris->sentinel= PALLOC(struct _node);
+  ris->arena= NULL;
+  ris->sentinel= node_alloc(ris);
+  ris->sentinel->prev= ris->sentinel->next= ris->sentinel;
+  ris->sentinel->element= NULL;
+  return ris;
+}
+
+plist list_create_in_arena(parena a) {
+  NOT_NULL(a);
+  FINETRACE("New arena list creation");
+  plist ris= ARENA_PALLOC(a, struct _list);
+  ris->size= 0;
+  ris->arena= a;
+  ris->sentinel= node_alloc(ris);
   ris->sentinel->prev= ris->sentinel->next= ris->sentinel;
   ris->sentinel->element= NULL;
   return ris;
@@ -51,17 +147,19 @@ void list_destroy(plist l, delete_function myfree) {
 	 _pnode tmp= n->next->next;
 	 if (myfree!=NULL && n->next->element!=NULL)
 		myfree(n->next->element);
-	 pfree(n->next);
+	 node_free(l, n->next);
 	 n->next= tmp;
   }
-  pfree(l->sentinel);
-  pfree(l);
+  if (l->arena == NULL) {
+	 pfree(l->sentinel);
+	 pfree(l);
+  }
 }
 
 void list_add_to_head(plist l, item p) {
   NOT_NULL(l);
   NOT_NULL(p);
-  _pnode n= PALLOC(struct _node);
+  _pnode n= node_alloc(l);
   n->element= p;
   n->next= l->sentinel->next;
   n->prev= l->sentinel;
@@ -73,7 +171,7 @@ void list_add_to_head(plist l, item p) {
 void list_add_to_tail(plist l, item p) {
   NOT_NULL(l);
   NOT_NULL(p);
-  _pnode n= PALLOC(struct _node);
+  _pnode n= node_alloc(l);
   n->element= p;
   n->prev= l->sentinel->prev;
   n->next= l->sentinel;
@@ -94,7 +192,7 @@ void list_add_before_iterator(plistit it, plist l, item p) {
   if(it->prev->prev == it->l->sentinel) {
 	 list_add_to_head(l, p);
   } else {
-	 _pnode n= PALLOC(struct _node);
+	 _pnode n= node_alloc(l);
 	 n->element= p;
 
 	 n->prev=it->prev->prev;
@@ -115,7 +213,7 @@ item list_remove_from_head(plist l) {
   item p= n->element;
   l->sentinel->next= n->next;
   n->next->prev= l->sentinel;
-  pfree(n);
+  node_free(l, n);
   l->size= l->size-1;
   return p;
 }
@@ -128,7 +226,7 @@ item list_remove_from_tail(plist l) {
   item p= n->element;
   l->sentinel->prev= n->prev;
   n->prev->next= l->sentinel;
-  pfree(n);
+  node_free(l, n);
   l->size= l->size-1;
   return p;
 }
@@ -153,14 +251,14 @@ list_remove_element(plist l, item p, delete_function del) {
   NOT_NULL(l);
   NOT_NULL(p);
   bool removed= false;
-  plistit lit= list_first(l);
-  while (!removed && listit_has_next(lit)) {
-	 if (listit_next(lit)==p) {
-		list_remove_at_iterator(lit, del);
+  listit lit;
+  list_first_stack(l, &lit);
+  while (!removed && listit_has_next(&lit)) {
+	 if (listit_next(&lit)==p) {
+		list_remove_at_iterator(&lit, del);
 		removed= true;
 	 }
   }
-  listit_destroy(lit);
   return removed;
 }
 
@@ -170,12 +268,12 @@ void list_sort(plist l, comparator cmp){
   int size = list_size(l);
   item* base= NPALLOC(item, size);
   int i = 0;
-  plistit it = list_first(l);
-  while(listit_has_next(it)){
-	 base[i] = listit_next(it);
+  listit it;
+  list_first_stack(l, &it);
+  while(listit_has_next(&it)){
+	 base[i] = listit_next(&it);
 	 ++i;
   }
-  listit_destroy(it);
 
   qsort(base, size, sizeof(item), cmp);
 
@@ -192,43 +290,44 @@ void list_sort(plist l, comparator cmp){
 plist list_merge_new(plist l1, plist l2){
   NOT_NULL(l1);
   NOT_NULL(l2);
-  plistit it;
+  listit it;
   plist mergedList = list_create();
-  it = list_first(l1);
-  while(listit_has_next(it)) {
-	 list_add_to_tail(mergedList,listit_next(it));
+  list_first_stack(l1, &it);
+  while(listit_has_next(&it)) {
+	 list_add_to_tail(mergedList,listit_next(&it));
   }
-  listit_destroy(it);
-  it = list_first(l2);
-  while(listit_has_next(it)) {
-	 list_add_to_tail(mergedList,listit_next(it));
+  list_first_stack(l2, &it);
+  while(listit_has_next(&it)) {
+	 list_add_to_tail(mergedList,listit_next(&it));
   }
-  listit_destroy(it);
   return mergedList;
 }
 
 void list_merge(plist l1, plist l2){
   NOT_NULL(l1);
   NOT_NULL(l2);
+// I nodi di l2 passano a l1: devono provenire dallo stesso allocatore
+  my_assert(l1->arena == l2->arena);
   l2->sentinel->next->prev = l1->sentinel->prev;
   l1->sentinel->prev->next = l2->sentinel->next;
   l1->sentinel->prev = l2->sentinel->prev;
   l2->sentinel->prev->next = l1->sentinel;
 
-  pfree(l2->sentinel);
-  pfree(l2);
+  node_free(l2, l2->sentinel);
+  if (l2->arena == NULL)
+	 pfree(l2);
 }
 
 plist list_copy(plist l, copy_item copy){
   NOT_NULL(l);
   NOT_NULL(copy);
   plist res = list_create();
-  plistit it = list_first(l);
+  listit it;
+  list_first_stack(l, &it);
 
-  while(listit_has_next(it)) {
-	 list_add_to_tail(res, copy(listit_next(it)));
+  while(listit_has_next(&it)) {
+	 list_add_to_tail(res, copy(listit_next(&it)));
   }
-  listit_destroy(it);
   return res;
 }
 
@@ -245,7 +344,7 @@ void list_remove_at_iterator(plistit it,
   --it->l->size;
 
   _pnode new_prev= it->prev->prev;
-  pfree(it->prev);
+  node_free(it->l, it->prev);
   it->prev= new_prev;
 }
 
@@ -255,23 +354,23 @@ void list_difference(plist l1, plist l2, comparator cmp, delete_function delete_
   NOT_NULL(l2);
   NOT_NULL(cmp);
   NOT_NULL(delete_node);
-  plistit it1 = list_first(l1);
-  plistit it2 = list_first(l2);
+  listit it1;
+  list_first_stack(l1, &it1);
+  listit it2;
+  list_first_stack(l2, &it2);
 
-  while( (listit_has_next(it1)) && (listit_has_next(it2)) ){
-	 int ris = cmp(&it1->next->element,&it2->next->element);
+  while( (listit_has_next(&it1)) && (listit_has_next(&it2)) ){
+	 int ris = cmp(&it1.next->element,&it2.next->element);
 	 if( ris == 0 ){
-		listit_next(it1);
-		list_remove_at_iterator(it1, delete_node);
+		listit_next(&it1);
+		list_remove_at_iterator(&it1, delete_node);
 	 } else{
 		if( ris > 0 )
-		  listit_next(it2);
+		  listit_next(&it2);
 		else
-		  listit_next(it1);
+		  listit_next(&it1);
 	 }//endelse
   }//endwhile
-  listit_destroy(it1);
-  listit_destroy(it2);
 }//endlistdiff
 
 /****RAFFA****/
@@ -282,22 +381,22 @@ bool list_compare(plist l1, plist l2, comparator cmp){
   if(list_size(l1) != list_size(l2))
 	  return false;
 
-  plistit it1 = list_first(l1);
-  plistit it2 = list_first(l2);
+  listit it1;
+  list_first_stack(l1, &it1);
+  listit it2;
+  list_first_stack(l2, &it2);
 
   stop=false;
 
-  while( (listit_has_next(it1)) && (listit_has_next(it2)) && !stop ){
-	 ris = cmp(&it1->next->element,&it2->next->element);
+  while( (listit_has_next(&it1)) && (listit_has_next(&it2)) && !stop ){
+	 ris = cmp(&it1.next->element,&it2.next->element);
 	 if( ris == 0 ){
-		listit_next(it1);
-		listit_next(it2);
+		listit_next(&it1);
+		listit_next(&it2);
 	 } else{
 		stop=true;
 	 }//endelse
   }//endwhile
-  listit_destroy(it1);
-  listit_destroy(it2);
   if(stop)
 	  return false;
   else
@@ -333,8 +432,10 @@ int relaxed_list_contained(plist l1, plist l2, relaxed_comparator cmp, int allow
 
 	actual_allowed_diff=(allowed_diff == -1)?(0):(allowed_diff);
 
-	plistit it1=list_first(l1);
-	plistit it2=list_first(l2);
+	listit it1;
+	list_first_stack(l1, &it1);
+	listit it2;
+	list_first_stack(l2, &it2);
 	found=false;
 	cfr_type=(allowed_diff == -1)?(0):(-2);
 
@@ -342,16 +443,16 @@ int relaxed_list_contained(plist l1, plist l2, relaxed_comparator cmp, int allow
 
 	if(list_size(l1) > list_size(l2)){
 		//Cerco l'elemento di l1 che matcha con il primo di l2
-		while(listit_has_next(it1) && !found){
-			ris = cmp(&it1->next->element,&it2->next->element, cfr_type, actual_allowed_diff, l1);
+		while(listit_has_next(&it1) && !found){
+			ris = cmp(&it1.next->element,&it2.next->element, cfr_type, actual_allowed_diff, l1);
 			if(ris == 0){
 				found=true;
-				listit_next(it2);
+				listit_next(&it2);
 			}
 			else
 				count_long++;
 
-			listit_next(it1);
+			listit_next(&it1);
 
 			if(cfr_type == -2)
 				cfr_type=2;
@@ -359,16 +460,16 @@ int relaxed_list_contained(plist l1, plist l2, relaxed_comparator cmp, int allow
 	}
 	else{
 		//Cerco l'elemento di l2 che matcha con il primo di l1
-		while(listit_has_next(it2) && !found){
-			ris = cmp(&it2->next->element,&it1->next->element, cfr_type, actual_allowed_diff, l2);
+		while(listit_has_next(&it2) && !found){
+			ris = cmp(&it2.next->element,&it1.next->element, cfr_type, actual_allowed_diff, l2);
 			if(ris == 0){
 				found=true;
-				listit_next(it1);
+				listit_next(&it1);
 			}
 			else
 				count_long++;
 
-			listit_next(it2);
+			listit_next(&it2);
 
 			if(cfr_type == -2)
 				cfr_type=2;
@@ -376,8 +477,6 @@ int relaxed_list_contained(plist l1, plist l2, relaxed_comparator cmp, int allow
 	}
 
 	if(!found){
-		listit_destroy(it1);
-		listit_destroy(it2);
 		return 0;
 	}
 
@@ -386,15 +485,15 @@ int relaxed_list_contained(plist l1, plist l2, relaxed_comparator cmp, int allow
 
 	if(list_size(l1) > list_size(l2)){
 		//Controllo se l2 e' contenuta in l1
-		while( (listit_has_next(it1)) && (listit_has_next(it2)) && !stop ){
+		while( (listit_has_next(&it1)) && (listit_has_next(&it2)) && !stop ){
 
 			cfr_type=(allowed_diff == -1)?(0):((count_factors+1 == list_size(l2))?((count_long+1 == list_size(l1))?(-1):(1)):(0));
 
-			ris = cmp(&it1->next->element,&it2->next->element, cfr_type, actual_allowed_diff, l1);
+			ris = cmp(&it1.next->element,&it2.next->element, cfr_type, actual_allowed_diff, l1);
 
 			if( ris == 0 ){
-				listit_next(it1);
-				listit_next(it2);
+				listit_next(&it1);
+				listit_next(&it2);
 			}else{
 				stop=true;
 			}//endelse
@@ -404,15 +503,15 @@ int relaxed_list_contained(plist l1, plist l2, relaxed_comparator cmp, int allow
 	}
 	else{
 		//Controllo se l1 e' contenuta in l2
-		while( (listit_has_next(it1)) && (listit_has_next(it2)) && !stop ){
+		while( (listit_has_next(&it1)) && (listit_has_next(&it2)) && !stop ){
 
 			cfr_type=(allowed_diff == -1)?(0):((count_factors+1 == list_size(l1))?((count_long+1 == list_size(l2))?(-1):(1)):(0));
 
-			ris = cmp(&it2->next->element,&it1->next->element, cfr_type, actual_allowed_diff, l2);
+			ris = cmp(&it2.next->element,&it1.next->element, cfr_type, actual_allowed_diff, l2);
 
 			if( ris == 0 ){
-				listit_next(it1);
-				listit_next(it2);
+				listit_next(&it1);
+				listit_next(&it2);
 			}else{
 				stop=true;
 			}//endelse
@@ -421,8 +520,6 @@ int relaxed_list_contained(plist l1, plist l2, relaxed_comparator cmp, int allow
 		}//endwhile
 	}
 
-	listit_destroy(it1);
-	listit_destroy(it2);
 
 	if(stop)
 		return 0;
@@ -462,30 +559,30 @@ int relaxed_list_compare(plist l1, plist l2, relaxed_comparator cmp, int allowed
 	if(list_size(l1) != list_size(l2) || list_size(l1) == 1)
 		return 0;
 
-	  plistit it1 = list_first(l1);
-	  plistit it2 = list_first(l2);
+	  listit it1;
+	  list_first_stack(l1, &it1);
+	  listit it2;
+	  list_first_stack(l2, &it2);
 
   stop=false;
   count_factors=1;
 
   actual_allowed_diff=(allowed_diff == -1)?(0):(allowed_diff);
 
-  while( (listit_has_next(it1)) && (listit_has_next(it2)) && !stop ){
+  while( (listit_has_next(&it1)) && (listit_has_next(&it2)) && !stop ){
 
 	 cfr_type=(allowed_diff == -1)?(0):((count_factors == 1)?(-2):((count_factors == (int)list_size(l1))?(-1):(0)));
 
-	 ris = cmp(&it1->next->element,&it2->next->element, cfr_type, actual_allowed_diff, l1);
+	 ris = cmp(&it1.next->element,&it2.next->element, cfr_type, actual_allowed_diff, l1);
 
 	 if( ris == 0 ){
-		listit_next(it1);
-		listit_next(it2);
+		listit_next(&it1);
+		listit_next(&it2);
 	 } else{
 		stop=true;
 	 }//endelse
 	 count_factors++;
   }//endwhile
-  listit_destroy(it1);
-  listit_destroy(it2);
   if(stop)
 	  return 0;
   else
@@ -495,21 +592,20 @@ int relaxed_list_compare(plist l1, plist l2, relaxed_comparator cmp, int allowed
 
 void list_complete_difference(plist l1, plist l2, comparator cmp, delete_function delete_node){
 
-  plistit it1 = list_first(l1);
-  while (listit_has_next(it1)) {
-	 item i1= listit_next(it1);
-	 plistit it2 = list_first(l2);
+  listit it1, it2;
+  list_first_stack(l1, &it1);
+  while (listit_has_next(&it1)) {
+	 item i1= listit_next(&it1);
+	 list_first_stack(l2, &it2);
 	 int ris= 1;
-	 while (ris!=0 && listit_has_next(it2)) {
-		item i2= listit_next(it2);
+	 while (ris!=0 && listit_has_next(&it2)) {
+		item i2= listit_next(&it2);
 		ris = cmp(&i1, &i2);
 	 }
 	 if (ris==0) {
-		list_remove_at_iterator(it1, delete_node);
+		list_remove_at_iterator(&it1, delete_node);
 	 }
-	 listit_destroy(it2);
   }//endwhile
-  listit_destroy(it1);
 }//endlistdiff
 
 
@@ -519,7 +615,7 @@ void list_complete_difference(plist l1, plist l2, comparator cmp, delete_functio
 
 plistit list_last(plist const l) {
   my_assert(l!=NULL);
-  plistit li= PALLOC(struct _listit);
+  plistit li= _listit_alloc();
   li->prev= l->sentinel->prev;
   li->next= l->sentinel;
   li->l= l;
@@ -531,7 +627,7 @@ void list_last_reuse(plist const l, plistit* pli) {
   my_assert(l!=NULL);
   plistit li= NULL;
   if (*pli == NULL) {
-	 li= PALLOC(struct _listit);
+	 li= _listit_alloc();
 	 *pli= li;
   } else {
 	 li= *pli;
@@ -544,7 +640,7 @@ void list_last_reuse(plist const l, plistit* pli) {
 
 plistit listit_copy(plistit li) {
   my_assert(li!=NULL);
-  plistit rli= PALLOC(struct _listit);
+  plistit rli= _listit_alloc();
   rli->prev= li->prev;
   rli->next= li->next;
   rli->l= li->l;
@@ -557,7 +653,7 @@ listit_copy_reuse(plistit const li, plistit* prli) {
   my_assert(li!=NULL);
   plistit rli= NULL;
   if (*prli == NULL) {
-	 rli= PALLOC(struct _listit);
+	 rli= _listit_alloc();
 	 *prli= rli;
   } else {
 	 rli= *prli;
@@ -0,0 +1,82 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010  Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+/**
+ *
+ * @file main-compact-compositions.c
+ *
+ * Compattazione delle composizioni esoniche (step "compact-compositions"
+ * della pipeline).
+ * Legge genomic.txt e le composizioni (out-after-intron-agree.txt) dallo
+ * standard input; scrive build-ests.txt sullo standard output e
+ * genomic-exonforCCDS.txt.
+ *
+ **/
+
+#include <stdio.h>
+
+#include "util.h"
+#include "compact-compositions.h"
+
+#include "my_time.h"
+#include "log.h"
+#include "log-build-info.h"
+
+int main(void) {
+  INFO("COMPACT-COMPOSITIONS v1");
+  PRINT_LICENSE_INFORMATION;
+  PRINT_SYSTEM_INFORMATION;
+  pmytime pt_tot= MYTIME_create_with_name("Total");
+
+  MYTIME_start(pt_tot);
+
+  FILE* fgen= fopen("genomic.txt", "r");
+  if (!fgen) {
+	 FATAL("File genomic.txt not found! Terminating");
+	 fail();
+  }
+  FILE* fccds= fopen("genomic-exonforCCDS.txt", "w");
+  if (!fccds) {
+	 FATAL("Cannot create file genomic-exonforCCDS.txt! Terminating");
+	 fail();
+  }
+
+  compact_compositions(fgen, stdin, stdout, fccds);
+
+  fclose(fgen);
+  fclose(fccds);
+
+  MYTIME_stop(pt_tot);
+  MYTIME_LOG(INFO, pt_tot);
+  MYTIME_destroy(pt_tot);
+
+  INFO("End");
+  resource_usage_log();
+  return 0;
+}
@@ -36,6 +36,8 @@
  **/
 
 #include <stdio.h>
+#include <string.h>
+#include <pthread.h>
 
 #include "types.h"
 #include "util.h"
@@ -44,6 +46,7 @@
 
 #include "max-emb-graph.h"
 #include "aug_suffix_tree.h"
+#include "gen-index.h"
 
 #include "io-multifasta.h"
 #include "io-meg.h"
@@ -57,67 +60,21 @@
 
 #include "factorization-refinement.h"
 #include "compute-est-fact.h"
+#include "parallel-est-fact.h"
 
 
-static char*
-create_and_copy(const char const* src) {
-  if (src==NULL)
-	 return NULL;
-  char* dest= alloc_and_copy(src);
-  return dest;
-}
-
-pEST_info copy_and_reverse(pEST_info est) {
-  pEST_info rev_est= EST_info_create();
-  rev_est->EST_seq= create_and_copy(est->EST_seq);
-  rev_est->original_EST_seq= create_and_copy(est->original_EST_seq);
-  reverse_and_complement(rev_est);
-  rev_est->EST_id= create_and_copy(est->EST_id);
-  rev_est->EST_gb= create_and_copy(est->EST_gb);
-  rev_est->EST_chr= create_and_copy(est->EST_chr);
-  rev_est->EST_strand_as_read=
-	 create_and_copy(est->EST_strand_as_read);
-  rev_est->EST_strand= - est->EST_strand;
-  rev_est->fixed_strand= est->fixed_strand;
-  rev_est->pref_polyA_length= est->suff_polyT_length;
-  rev_est->suff_polyA_length= est->pref_polyT_length;
-  rev_est->pref_polyT_length= est->suff_polyA_length;
-  rev_est->suff_polyT_length= est->pref_polyA_length;
-  return rev_est;
-}
-
-
-int main(int argc, char** argv) {
-  INFO("EST-FACTORIZATION v2");
-  PRINT_LICENSE_INFORMATION;
-  PRINT_SYSTEM_INFORMATION;
-  DEBUG("Initialization");
-  pmytime pt_tot= MYTIME_create_with_name("Total");
-  pmytime pt_st= MYTIME_create_with_name("Suffix Tree");
-  pmytime pt_alg= MYTIME_create_with_name("Algorithm");
-  pmytime pt_comp= MYTIME_create_with_name("Compositions");
-  pmytime pt_io= MYTIME_create_with_name("IO");
-
-  MYTIME_start(pt_tot);
-  pconfiguration config= config_create(argc, argv);
+// Factorize the transcripts of a locus.
+// If parallel is true, the transcripts are factorized by
+// config->num_threads threads.
+static void
+factorize_locus(const struct _locus* const locus, const bool parallel,
+					 pconfiguration config, FILE* floginfo,
+					 pmytime pt_st, pmytime pt_alg, pmytime pt_comp, pmytime pt_io) {
   MYTIME_start(pt_io);
-
-  char buf[1000];
-  snprintf(buf, 1000, "info-pid-%u.log", (unsigned)getpid());
-
-  FILE* floginfo= fopen(buf, "w");
-  if (!floginfo) {
-	 FATAL("Cannot create file info.log! Terminating");
-	 fail();
-  }
-
-// Log resource utilization
-  log_info(floginfo, "start");
-
   DEBUG("Reading genomic sequence");
-  FILE* fgen= fopen("genomic.txt", "r");
+  FILE* fgen= fopen(locus->gen_file, "r");
   if (!fgen) {
-	 FATAL("File genomic.txt not found! Terminating");
+	 FATAL("File %s not found! Terminating", locus->gen_file);
 	 fail();
   }
   plist gen_list= read_multifasta(fgen);
@@ -131,183 +88,107 @@ int main(int argc, char** argv) {
   DEBUG("Removing N tails");
   Ntails_removal(gen);
 
-  DEBUG("Reading EST sequences");
-  FILE* fests= fopen("ests.txt", "r");
-  if (!fests) {
-	 FATAL("File ests.txt not found! Terminating");
-	 fail();
-  }
-  plist est_list= read_multifasta(fests);
-  fclose(fests);
-  DEBUG("EST sequences read");
-
-  FILE* f_multif_out= fopen("raw-multifasta-out.txt", "w");
-  if (!f_multif_out) {
-	 FATAL("Cannot create file raw-multifasta-out.txt! Terminating");
-	 fail();
+  if (config->build_genomic_index_only) {
+	 MYTIME_stop(pt_io);
+	 if (locus->index_file == NULL) {
+		WARN("No genomic index file for the genomic sequence %s. Skipped.",
+			  locus->gen_file);
+	 } else {
+		INFO("Building the genomic index only");
+		ppreproc_gen pg= PGen_create();
+		preprocess_text(gen, pg);
+		gen_index_destroy(get_genomic_index(pg, config, locus->index_file,
+														floginfo, pt_st, pt_alg));
+		pg->gen= NULL;
+		PGen_destroy(pg);
+	 }
+	 EST_info_destroy(gen);
+	 return;
   }
 
-  FILE* fmeg= fopen("megs.txt", "w");
-  if (!fmeg) {
-	 FATAL("Cannot create file megs.txt! Terminating");
-	 fail();
-  }
-
-  FILE* fpmeg= fopen("processed-megs.txt", "w");
-  if (!fpmeg) {
-	 FATAL("Cannot create file processed-megs.txt! Terminating");
-	 fail();
-  }
-
-  FILE* ftmeg= fopen("processed-megs-info.txt", "w");
-  if (!ftmeg) {
-	 FATAL("Cannot create file processed-megs-time.txt! Terminating");
-	 fail();
-  }
+  create_locus_dir(locus);
 
-  FILE* est_multif_out= fopen("processed-ests.txt", "w");
-  if (!est_multif_out) {
-	 FATAL("Cannot create file processed-ests.txt! Terminating");
+  DEBUG("Opening EST sequences");
+  FILE* fests= fopen(locus->ests_file, "r");
+  if (!fests) {
+	 FATAL("File %s not found! Terminating", locus->ests_file);
 	 fail();
   }
+// The transcripts are read (and factorized) one batch at a time
+  pmultifasta_reader est_reader= multifasta_reader_create(fests);
 
-  FILE* fintronic= fopen("meg-edges.txt", "w");
-  if (!fintronic) {
-	 FATAL("Cannot create file meg-edges.txt! Terminating");
-	 fail();
-  }
+  FILE* f_multif_out= open_locus_output(locus, "raw-multifasta-out.txt");
+  FILE* fmeg= open_locus_output(locus, "megs.txt");
+  FILE* fpmeg= open_locus_output(locus, "processed-megs.txt");
+  FILE* ftmeg= open_locus_output(locus, "processed-megs-info.txt");
+  FILE* est_multif_out= open_locus_output(locus, "processed-ests.txt");
+  FILE* fintronic= open_locus_output(locus, "meg-edges.txt");
 
 // Log resource utilization
   log_info(floginfo, "data-io-end");
 
   MYTIME_stop(pt_io);
 
-  const size_t n_est= list_size(est_list);
-
-  INFO("Read %zd sequences.", n_est);
-  plist new_est_list= list_create();
-
-  plistit estit= list_first(est_list);
-  while (listit_has_next(estit)) {
-	 pEST_info est= (pEST_info)listit_next(estit);
-	 INFO("EST: %s", est->EST_id);
-
-	 DEBUG("Set the GB id from the fasta header");
-	 set_EST_GB_identification(est);
-
-	 DEBUG("Set the EST strand and RC");
-	 set_EST_Strand_and_RC(est, gen);
-
-	 list_add_to_tail(new_est_list, est);
-
-	 DEBUG("Replace polyA/T with fake characters");
-	 polyAT_substitution(est);
-
-        if (!est->fixed_strand) {
-          DEBUG("Strand is not fixed. Adding also its reverse and complement.");
-          pEST_info rev_est= copy_and_reverse(est);
-          list_add_to_tail(new_est_list, rev_est);
-          polyAT_substitution(rev_est);
-        }
-  }
-  listit_destroy(estit);
-
-  list_destroy(est_list, (delete_function)noop_free);
-  est_list= new_est_list;
-
-  INFO("Creating the suffix tree");
-
-// Log resource utilization
-  log_info(floginfo, "gst-construction-begin");
-
-  MYTIME_start(pt_st);
-  LST_StringSet *set= lst_stringset_new();
-  LST_String * lst= PALLOC(LST_String);
-  lst_string_init(lst, gen->EST_seq, sizeof(char),
-						strlen(gen->EST_seq));
-  lst_stringset_add(set, lst);
-  LST_STree* tree = lst_stree_new(set);
-  MYTIME_stop(pt_st);
-
-// Log resource utilization
-  log_info(floginfo, "gst-preprocessing-begin");
-
-  DEBUG("Preprocessing the GST");
-  MYTIME_start(pt_alg);
+  DEBUG("Preprocessing the genomic sequence");
   ppreproc_gen pg= PGen_create();
   preprocess_text(gen, pg);
-  stree_preprocess(tree, pg, config);
-  MYTIME_stop(pt_alg);
 
-// Log resource utilization
-  log_info(floginfo, "gst-preprocessing-end");
-
-  size_t id_p= 1;
-  estit= list_first(est_list);
-  bool reversed= false;
-
-  while (listit_has_next(estit)) {
-    pEST_info est= (pEST_info)listit_next(estit);
-    pEST factorized_est=
-      compute_est_fact(gen, est, tree, pg,
-                       floginfo, fmeg, fpmeg, ftmeg,
-                       fintronic,
-                       pt_alg, pt_comp, pt_io, config);
-
-    if (!list_is_empty(factorized_est->factorizations)) {
-      // Found valid factorizations
-      INFO("Found valid factorization(s) for EST %s on the %s strand of the genomic.",
-           est->EST_gb,
-           ((est->EST_strand==1)?"same":"opposite"));
-      MYTIME_start(pt_io);
-      write_multifasta_output(gen, factorized_est, f_multif_out, config->retain_externals);
-      write_single_EST_info(est_multif_out, factorized_est->info);
-      MYTIME_stop(pt_io);
-      // Skip next sequence if it is the reverse of this one
-      if (!est->fixed_strand && !reversed) {
-        listit_next(estit);
-        ++id_p;
+  pgen_index idx= get_genomic_index(pg, config, locus->index_file,
+												floginfo, pt_st, pt_alg);
+
+  size_t n_est= 0;
+  if (parallel) {
+// Each batch is factorized in parallel, then destroyed
+    const size_t batch_size= config->num_threads*TRANSCRIPTS_PER_THREAD_BATCH;
+    bool more= true;
+    while (more) {
+      plist est_list= list_create();
+      size_t n_batch= 0;
+      pEST_info est, rev_est;
+      while (n_batch < batch_size &&
+             (more= read_next_transcript(est_reader, gen, pt_io, &est, &rev_est))) {
+        list_add_to_tail(est_list, est);
+        if (rev_est != NULL)
+          list_add_to_tail(est_list, rev_est);
+        ++n_batch;
       }
-      reversed= false; // Next sequence is "original"
-    } else {
-      // No valid factorization found
-      if (reversed || est->fixed_strand) {
-        // It is already the rev&compl sequence or it cannot be rev&complement
-        INFO("...the EST %s has no alignment! (Fixed strand? %s)",
-             est->EST_gb, (est->fixed_strand ? "true" : "false"));
-        reversed= false; // Next sequence is "original"
-      } else {
-        // !reversed && !fixed_strand
-        INFO("...the strand from the input file may be wrong (read: '%s')!", est->EST_strand_as_read);
-        reversed= true; // Next sequence is reversed
+      if (n_batch > 0) {
+        compute_transcripts_fact_parallel(gen, est_list, idx, pg,
+                                          floginfo, fmeg, fpmeg, ftmeg,
+                                          fintronic,
+                                          f_multif_out, est_multif_out,
+                                          NULL, NULL,
+                                          pt_alg, pt_comp, pt_io, config);
       }
+      n_est+= n_batch;
+      list_destroy(est_list, (delete_function)EST_info_destroy);
+    }
+  } else {
+    pEST_info est, rev_est;
+    while (read_next_transcript(est_reader, gen, pt_io, &est, &rev_est)) {
+      compute_transcript_fact(gen, est, rev_est, idx, pg,
+                              floginfo, fmeg, fpmeg, ftmeg,
+                              fintronic,
+                              f_multif_out, est_multif_out,
+                              NULL, NULL,
+                              pt_alg, pt_comp, pt_io, config);
+      EST_info_destroy(est);
+      EST_info_destroy(rev_est);
+      ++n_est;
     }
-
-    EST_destroy_just_factorizations(factorized_est);
-
-    ++id_p;
-
-    log_info(floginfo, "est-processing-end");
   }
+  INFO("Processed %zu sequences.", n_est);
+  multifasta_reader_destroy(est_reader);
+  fclose(fests);
 
-  DEBUG("Destroying the GST additional informations");
-  MYTIME_start(pt_alg);
-  stree_info_destroy(tree);
-  MYTIME_stop(pt_alg);
-  DEBUG("Destroying the GST");
+  DEBUG("Destroying the genomic index");
   MYTIME_start(pt_st);
-  lst_stree_free(tree);
-  pfree(set);
+  gen_index_destroy(idx);
   MYTIME_stop(pt_st);
 
-  listit_destroy(estit);
-
-  DEBUG("Finalizing structures");
-  config_destroy(config);
   pg->gen= NULL;
   PGen_destroy(pg);
   EST_info_destroy(gen);
-  list_destroy(est_list, (delete_function)EST_info_destroy);
 
   fclose(fmeg);
   fclose(fpmeg);
@@ -315,6 +196,137 @@ int main(int argc, char** argv) {
   fclose(f_multif_out);
   fclose(est_multif_out);
   fclose(fintronic);
+}
+
+
+// The loci are distributed dynamically among the workers
+struct _batch {
+  struct _locus* loci;
+  size_t n_loci;
+  size_t next_locus;
+  pconfiguration config;
+  FILE* floginfo;
+};
+
+struct _batch_worker {
+  struct _batch* batch;
+  pthread_t thread;
+  pmytime pt_st;
+  pmytime pt_alg;
+  pmytime pt_comp;
+  pmytime pt_io;
+};
+
+static void*
+batch_worker_main(void* arg) {
+  struct _batch_worker* w= (struct _batch_worker*)arg;
+  struct _batch* batch= w->batch;
+  size_t i;
+  while ((i= __sync_fetch_and_add(&batch->next_locus, 1)) < batch->n_loci) {
+	 INFO("Locus %zu/%zu: %s", i+1, batch->n_loci, batch->loci[i].out_dir);
+	 factorize_locus(batch->loci + i, false, batch->config, batch->floginfo,
+						  w->pt_st, w->pt_alg, w->pt_comp, w->pt_io);
+  }
+  list_pool_trim();
+  return NULL;
+}
+
+// Factorize the loci of the manifest with a pool of
+// config->num_threads workers
+static void
+factorize_batch(pconfiguration config, FILE* floginfo,
+					 pmytime pt_st, pmytime pt_alg, pmytime pt_comp, pmytime pt_io) {
+  struct _batch batch;
+  MYTIME_start(pt_io);
+  batch.loci= read_batch_manifest(config->batch_manifest_file, &batch.n_loci);
+  MYTIME_stop(pt_io);
+  batch.next_locus= 0;
+  batch.config= config;
+  batch.floginfo= floginfo;
+
+  unsigned int n_workers= config->num_threads;
+  if (n_workers > batch.n_loci)
+	 n_workers= (batch.n_loci > 0) ? batch.n_loci : 1;
+  INFO("Factorizing %zu loci with %u threads.", batch.n_loci, n_workers);
+
+  struct _batch_worker* workers= NPALLOC(struct _batch_worker, n_workers);
+  for (unsigned int w= 0; w < n_workers; ++w) {
+	 workers[w].batch= &batch;
+	 workers[w].pt_st= MYTIME_create_with_name("Suffix Tree (worker)");
+	 workers[w].pt_alg= MYTIME_create_with_name("Algorithm (worker)");
+	 workers[w].pt_comp= MYTIME_create_with_name("Compositions (worker)");
+	 workers[w].pt_io= MYTIME_create_with_name("IO (worker)");
+  }
+  if (n_workers == 1) {
+	 batch_worker_main(workers);
+  } else {
+	 for (unsigned int w= 0; w < n_workers; ++w) {
+		if (pthread_create(&workers[w].thread, NULL, batch_worker_main, workers + w) != 0) {
+		  FATAL("Cannot create worker thread %u! Terminating", w);
+		  fail();
+		}
+	 }
+	 for (unsigned int w= 0; w < n_workers; ++w) {
+		pthread_join(workers[w].thread, NULL);
+	 }
+  }
+  for (unsigned int w= 0; w < n_workers; ++w) {
+	 MYTIME_add(pt_st, workers[w].pt_st);
+	 MYTIME_add(pt_alg, workers[w].pt_alg);
+	 MYTIME_add(pt_comp, workers[w].pt_comp);
+	 MYTIME_add(pt_io, workers[w].pt_io);
+	 MYTIME_destroy(workers[w].pt_st);
+	 MYTIME_destroy(workers[w].pt_alg);
+	 MYTIME_destroy(workers[w].pt_comp);
+	 MYTIME_destroy(workers[w].pt_io);
+  }
+  pfree(workers);
+
+  batch_manifest_destroy(batch.loci, batch.n_loci);
+}
+
+
+int main(int argc, char** argv) {
+  INFO("EST-FACTORIZATION v2");
+  PRINT_LICENSE_INFORMATION;
+  PRINT_SYSTEM_INFORMATION;
+  DEBUG("Initialization");
+  pmytime pt_tot= MYTIME_create_with_name("Total");
+  pmytime pt_st= MYTIME_create_with_name("Suffix Tree");
+  pmytime pt_alg= MYTIME_create_with_name("Algorithm");
+  pmytime pt_comp= MYTIME_create_with_name("Compositions");
+  pmytime pt_io= MYTIME_create_with_name("IO");
+
+  MYTIME_start(pt_tot);
+  pconfiguration config= config_create(argc, argv);
+
+  char buf[1000];
+  snprintf(buf, 1000, "info-pid-%u.log", (unsigned)getpid());
+
+  FILE* floginfo= fopen(buf, "w");
+  if (!floginfo) {
+	 FATAL("Cannot create file info.log! Terminating");
+	 fail();
+  }
+
+// Log resource utilization
+  log_info(floginfo, "start");
+
+  if (config->batch_manifest_file != NULL) {
+	 factorize_batch(config, floginfo, pt_st, pt_alg, pt_comp, pt_io);
+  } else {
+	 struct _locus locus= {
+		.out_dir= NULL,
+		.gen_file= "genomic.txt",
+		.ests_file= "ests.txt",
+		.index_file= config->genomic_index_file
+	 };
+	 factorize_locus(&locus, config->num_threads > 1, config, floginfo,
+						  pt_st, pt_alg, pt_comp, pt_io);
+  }
+
+  DEBUG("Finalizing structures");
+  config_destroy(config);
 
   MYTIME_stop(pt_tot);
 
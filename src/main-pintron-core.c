@@ -0,0 +1,408 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010  Yuri Pirola, Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+/**
+ *
+ * @file main-pintron-core.c
+ *
+ * Factorization, exon agreement, intron agreement and compaction of the
+ * compositions of the transcripts in a single process (steps est-fact,
+ * min-factorization, intron-agreement and compact-compositions of the
+ * pipeline).
+ * The factorizations are passed in memory from a step to the next one.
+ * The compositions are compacted from the same stream on which the intron
+ * agreement writes them.
+ * The following steps (maximal-transcripts and cds-annotation) are
+ * standalone programs built on global state, hence they remain external
+ * and read build-ests.txt.
+ *
+ **/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "types.h"
+#include "util.h"
+#include "list.h"
+#include "configuration.h"
+
+#include "gen-index.h"
+
+#include "io-multifasta.h"
+#include "io-factorizations.h"
+
+#include "min_factorization.h"
+#include "intron-agreement.h"
+#include "compact-compositions.h"
+#include "nucleotide-codes.h"
+
+#include "my_time.h"
+#include "log.h"
+#include "log-build-info.h"
+
+#include "compute-est-fact.h"
+#include "parallel-est-fact.h"
+
+
+// Open an output file of the locus, or /dev/null if it is not dumped
+static FILE*
+open_output(const struct _locus* const locus, const char* const name,
+				const bool dump) {
+  if (dump)
+	 return open_locus_output(locus, name);
+  FILE* f= fopen("/dev/null", "w");
+  if (!f) {
+	 FATAL("Cannot create file /dev/null! Terminating");
+	 fail();
+  }
+  return f;
+}
+
+// Open an input file
+static FILE*
+open_input(const char* const name) {
+  FILE* f= fopen(name, "r");
+  if (!f) {
+	 FATAL("File %s not found! Terminating", name);
+	 fail();
+  }
+  return f;
+}
+
+// Timers of the steps
+struct _core_timers {
+  pmytime st;
+  pmytime alg;
+  pmytime comp;
+  pmytime agree;
+  pmytime pre;
+  pmytime intr;
+  pmytime cc;
+  pmytime io;
+};
+
+// Write the agreed factorizations as min-factorization does
+static void
+write_agreed_factorizations(plist ests, FILE* fout) {
+  plistit est_it= list_first(ests);
+  while (listit_has_next(est_it)) {
+	 pEST est= listit_next(est_it);
+	 fprintf(fout, ">%s\n", est->info->EST_id);
+	 pfactorization pfact= list_head(est->factorizations);
+	 if (!list_is_empty(pfact)) {
+		fprintf(fout, "#polya=%d\n#polyad=%d\n",
+				  boollist_head(est->polyA_signals) ? 1 : 0,
+				  boollist_head(est->polyadenil_signals) ? 1 : 0);
+		plistit factor_it= list_first(pfact);
+		while (listit_has_next(factor_it)) {
+		  pfactor pf= listit_next(factor_it);
+		  fprintf(fout, "%d\t %d\t %d\t %d\n",
+					 pf->EST_start, pf->EST_end,
+					 pf->GEN_start, pf->GEN_end);
+		}
+		listit_destroy(factor_it);
+	 }
+  }
+  listit_destroy(est_it);
+}
+
+// Factorize the transcripts of the locus.
+// The factorizations are added to fact_ests and the factorized transcripts
+// to fact_infos.
+static void
+factorize_transcripts(const struct _locus* const locus,
+							 pEST_info gen, pconfiguration config, FILE* floginfo,
+							 plist fact_ests, plist fact_infos,
+							 pmytime pt_st, pmytime pt_alg, pmytime pt_comp, pmytime pt_io) {
+  MYTIME_start(pt_io);
+  DEBUG("Opening EST sequences");
+  FILE* fests= open_input(locus->ests_file);
+  pmultifasta_reader est_reader= multifasta_reader_create(fests);
+
+  const bool dump= config->dump_intermediate_files;
+  FILE* f_multif_out= open_output(locus, "raw-multifasta-out.txt", dump);
+  FILE* fmeg= open_output(locus, "megs.txt", dump);
+  FILE* fpmeg= open_output(locus, "processed-megs.txt", dump);
+  FILE* ftmeg= open_output(locus, "processed-megs-info.txt", dump);
+  FILE* est_multif_out= open_output(locus, "processed-ests.txt", dump);
+  FILE* fintronic= open_output(locus, "meg-edges.txt", dump);
+
+// Log resource utilization
+  log_info(floginfo, "data-io-end");
+
+  MYTIME_stop(pt_io);
+
+  DEBUG("Preprocessing the genomic sequence");
+  ppreproc_gen pg= PGen_create();
+  preprocess_text(gen, pg);
+
+  pgen_index idx= get_genomic_index(pg, config, locus->index_file,
+												floginfo, pt_st, pt_alg);
+
+  size_t n_est= 0;
+  if (config->num_threads > 1) {
+	 const size_t batch_size= config->num_threads*TRANSCRIPTS_PER_THREAD_BATCH;
+	 bool more= true;
+	 while (more) {
+		plist est_list= list_create();
+		size_t n_batch= 0;
+		pEST_info est, rev_est;
+		while (n_batch < batch_size &&
+				 (more= read_next_transcript(est_reader, gen, pt_io, &est, &rev_est))) {
+		  list_add_to_tail(est_list, est);
+		  if (rev_est != NULL)
+			 list_add_to_tail(est_list, rev_est);
+		  ++n_batch;
+		}
+		if (n_batch > 0) {
+		  compute_transcripts_fact_parallel(gen, est_list, idx, pg,
+														floginfo, fmeg, fpmeg, ftmeg,
+														fintronic,
+														f_multif_out, est_multif_out,
+														fact_ests, fact_infos,
+														pt_alg, pt_comp, pt_io, config);
+		}
+		n_est+= n_batch;
+		list_destroy(est_list, (delete_function)EST_info_destroy);
+	 }
+  } else {
+	 pEST_info est, rev_est;
+	 while (read_next_transcript(est_reader, gen, pt_io, &est, &rev_est)) {
+		compute_transcript_fact(gen, est, rev_est, idx, pg,
+										floginfo, fmeg, fpmeg, ftmeg,
+										fintronic,
+										f_multif_out, est_multif_out,
+										fact_ests, fact_infos,
+										pt_alg, pt_comp, pt_io, config);
+		EST_info_destroy(est);
+		EST_info_destroy(rev_est);
+		++n_est;
+	 }
+  }
+  INFO("Processed %zu sequences.", n_est);
+  multifasta_reader_destroy(est_reader);
+  fclose(fests);
+
+  DEBUG("Destroying the genomic index");
+  MYTIME_start(pt_st);
+  gen_index_destroy(idx);
+  MYTIME_stop(pt_st);
+
+  pg->gen= NULL;
+  PGen_destroy(pg);
+
+  fclose(fmeg);
+  fclose(fpmeg);
+  fclose(ftmeg);
+  fclose(f_multif_out);
+  fclose(est_multif_out);
+  fclose(fintronic);
+}
+
+
+// Factorize the transcripts of the locus, compute the exon and the intron
+// agreement and compact the compositions
+static void
+process_locus(const struct _locus* const locus, pconfiguration config,
+				  FILE* floginfo, struct _core_timers* pt) {
+  create_locus_dir(locus);
+
+  MYTIME_start(pt->io);
+  DEBUG("Reading genomic sequence");
+  FILE* fgen= open_input(locus->gen_file);
+  plist gen_list= read_multifasta(fgen);
+  fclose(fgen);
+  my_assert(list_size(gen_list)==1);
+  pEST_info gen= (pEST_info)list_head(gen_list);
+  list_destroy(gen_list, noop_free);
+
+// The intron agreement works on the genomic sequence with the N tails,
+// which is kept packed during the factorization
+  char* full_gen_id= alloc_and_copy(gen->EST_id);
+  ppacked_seq full_gen_seq= packed_seq_create(gen->original_EST_seq);
+  DEBUG("Packed the genomic sequence of %zu bp in %zu bytes.",
+		  full_gen_seq->length, packed_seq_size(full_gen_seq));
+
+  parse_genomic_header(gen);
+
+  DEBUG("Removing N tails");
+  Ntails_removal(gen);
+  MYTIME_stop(pt->io);
+
+  INFO("Factorizing the transcripts");
+  plist fact_ests= list_create();
+  plist fact_infos= list_create();
+  factorize_transcripts(locus, gen, config, floginfo, fact_ests, fact_infos,
+								pt->st, pt->alg, pt->comp, pt->io);
+  EST_info_destroy(gen);
+
+  INFO("Computing the exon agreement");
+  MYTIME_start(pt->agree);
+  plist agreed_ests= min_factorization_agreement(fact_ests, config->max_exon_agreement_time);
+  list_destroy(fact_ests, (delete_function)EST_destroy);
+  MYTIME_stop(pt->agree);
+
+  if (config->dump_intermediate_files) {
+	 MYTIME_start(pt->io);
+	 FILE* fagree= open_locus_output(locus, "out-agree.txt");
+	 write_agreed_factorizations(agreed_ests, fagree);
+	 fclose(fagree);
+	 MYTIME_stop(pt->io);
+  }
+
+  INFO("Computing the intron agreement");
+  MYTIME_start(pt->io);
+  pEST_info full_gen= EST_info_create();
+  full_gen->EST_id= full_gen_id;
+  full_gen->EST_seq= packed_seq_unpack(full_gen_seq);
+  full_gen->original_EST_seq= full_gen->EST_seq;
+  packed_seq_destroy(full_gen_seq);
+  parse_genomic_header(full_gen);
+// The file is read back by the compaction of the compositions
+  char* path= locus_path(locus->out_dir, "out-after-intron-agree.txt");
+  FILE* f_multif_out= fopen(path, "w+");
+  if (!f_multif_out) {
+	 FATAL("Cannot create file %s! Terminating", path);
+	 fail();
+  }
+  pfree(path);
+  FILE* gtf_out= open_locus_output(locus, "predicted-introns.txt");
+  MYTIME_stop(pt->io);
+
+  compute_intron_agreement(full_gen, fact_infos, agreed_ests,
+									f_multif_out, gtf_out, floginfo,
+									pt->pre, pt->intr, pt->io, config->num_threads);
+  EST_info_destroy(full_gen);
+  fclose(gtf_out);
+
+  INFO("Compacting the compositions");
+  MYTIME_start(pt->cc);
+  rewind(f_multif_out);
+  FILE* fgen_header= open_input(locus->gen_file);
+  FILE* fbuild= open_locus_output(locus, "build-ests.txt");
+  FILE* fccds= open_locus_output(locus, "genomic-exonforCCDS.txt");
+  compact_compositions(fgen_header, f_multif_out, fbuild, fccds);
+  fclose(fgen_header);
+  fclose(fbuild);
+  fclose(fccds);
+  fclose(f_multif_out);
+  MYTIME_stop(pt->cc);
+}
+
+
+int main(int argc, char** argv) {
+  INFO("PINTRON-CORE v1");
+  PRINT_LICENSE_INFORMATION;
+  PRINT_SYSTEM_INFORMATION;
+  DEBUG("Initialization");
+  pmytime pt_tot= MYTIME_create_with_name("Total");
+  struct _core_timers pt= {
+	 .st= MYTIME_create_with_name("Suffix Tree"),
+	 .alg= MYTIME_create_with_name("Algorithm"),
+	 .comp= MYTIME_create_with_name("Compositions"),
+	 .agree= MYTIME_create_with_name("Exon agreement"),
+	 .pre= MYTIME_create_with_name("Intron agreement preprocessing"),
+	 .intr= MYTIME_create_with_name("Intron agreement"),
+	 .cc= MYTIME_create_with_name("Compositions compaction"),
+	 .io= MYTIME_create_with_name("IO")
+  };
+
+  MYTIME_start(pt_tot);
+  pconfiguration config= config_create(argc, argv);
+  if (config->build_genomic_index_only) {
+	 FATAL("Option build-genomic-index-only is not supported by pintron-core. "
+			 "Use est-fact instead.");
+	 fail();
+  }
+
+  char buf[1000];
+  snprintf(buf, 1000, "info-pid-%u.log", (unsigned)getpid());
+
+  FILE* floginfo= fopen(buf, "w");
+  if (!floginfo) {
+	 FATAL("Cannot create file info.log! Terminating");
+	 fail();
+  }
+
+// Log resource utilization
+  log_info(floginfo, "start");
+
+  if (config->batch_manifest_file != NULL) {
+	 MYTIME_start(pt.io);
+	 size_t n_loci= 0;
+	 struct _locus* loci= read_batch_manifest(config->batch_manifest_file, &n_loci);
+	 MYTIME_stop(pt.io);
+	 INFO("Processing %zu loci.", n_loci);
+	 for (size_t i= 0; i < n_loci; ++i) {
+		INFO("Locus %zu/%zu: %s", i+1, n_loci, loci[i].out_dir);
+		process_locus(loci + i, config, floginfo, &pt);
+	 }
+	 batch_manifest_destroy(loci, n_loci);
+  } else {
+	 struct _locus locus= {
+		.out_dir= NULL,
+		.gen_file= "genomic.txt",
+		.ests_file= "ests.txt",
+		.index_file= config->genomic_index_file
+	 };
+	 process_locus(&locus, config, floginfo, &pt);
+  }
+
+  DEBUG("Finalizing structures");
+  config_destroy(config);
+
+  MYTIME_stop(pt_tot);
+
+  MYTIME_LOG(INFO, pt.st);
+  MYTIME_LOG(INFO, pt.alg);
+  MYTIME_LOG(INFO, pt.comp);
+  MYTIME_LOG(INFO, pt.agree);
+  MYTIME_LOG(INFO, pt.pre);
+  MYTIME_LOG(INFO, pt.intr);
+  MYTIME_LOG(INFO, pt.cc);
+  MYTIME_LOG(INFO, pt.io);
+  MYTIME_LOG(INFO, pt_tot);
+
+  MYTIME_destroy(pt_tot);
+  MYTIME_destroy(pt.st);
+  MYTIME_destroy(pt.alg);
+  MYTIME_destroy(pt.comp);
+  MYTIME_destroy(pt.agree);
+  MYTIME_destroy(pt.pre);
+  MYTIME_destroy(pt.intr);
+  MYTIME_destroy(pt.cc);
+  MYTIME_destroy(pt.io);
+
+  log_info(floginfo, "end");
+
+  INFO("End");
+  resource_usage_log();
+  fclose(floginfo);
+  return 0;
+}
@@ -33,19 +33,11 @@
 
 #include "max-emb-graph.h"
 
-#include "aug_suffix_tree.h"
 #include "list.h"
 #include "util.h"
 
 #include "log.h"
 
-inline static char
-first_char_on_edge(const LST_Edge* const edge) {
-  if (edge->range.start_index == edge->range.string->num_items-1)
-	 return '\0';
-  return ((char*)edge->range.string->data)[edge->range.start_index];
-}
-
 inline static size_t
 get_lcp(const char * const s1, const size_t l1, const char * const s2) {
   size_t i= 0;
@@ -55,76 +47,74 @@ get_lcp(const char * const s1, const size_t l1, const char * const s2) {
 }
 
 
+// The deepest common node is represented by the node @p final and the
+// number of characters matched on the edge entering it.
+// The root (whose entering edge is empty) means that nothing has been matched.
 static void
 find_deepest_common_node_rec(const char const* pattern,
-									  LST_Node* const node,
+									  const pgen_index idx,
+									  const gen_node node,
+									  const size_t node_depth,
 									  const size_t already_matched,
 									  const char avoid_prev_char,
-									  LST_Edge** final, size_t* const matched_len) {
-  NOT_NULL(node);
-  if (pattern[0]=='\0') {
-	 *final= node->up_edge;
-	 *matched_len= lst_edge_get_length(node->up_edge);
-  } else {
+									  gen_node* final, size_t* const matched_len) {
+  gen_node kid;
+  bool found= false;
+  if (pattern[0]!='\0') {
 	 TRACE("The next character on the pattern is >%c<", pattern[0]);
-	 LST_Edge *edge;
-	 for (edge= node->kids.lh_first;
-			(edge!=NULL);
-			edge= edge->siblings.le_next) {
-		TRACE("The first character of the edge is >%c<",
-				first_char_on_edge(edge));
-		if (first_char_on_edge(edge)==pattern[0]) {
-		  if ((edge->dst_node->single_char == '\0') ||
-				(edge->dst_node->single_char != avoid_prev_char)) {
-			 TRACE("Edge found!");
-		  } else {
-			 TRACE("Edge ignored because the subtree contains "
-					 "only occurrences preceeded by char %c that is the same "
-					 "of %c.", edge->dst_node->single_char, avoid_prev_char);
-			 edge= NULL;
-		  }
-		  break;
-		}
-	 }
-	 if (edge==NULL) {
-		*final= node->up_edge;
-		*matched_len= lst_edge_get_length(node->up_edge);
-	 } else {
-		const size_t edge_length= lst_edge_get_length(edge);
-		size_t tmp_lcp= 0;
-		if (edge_length == 1) {
-		  tmp_lcp= 1;
-		} else if (already_matched > 0) {
-		  if (already_matched >= edge_length) {
-			 tmp_lcp= edge_length;
-		  } else {
-			 tmp_lcp= already_matched +
-				get_lcp(((char*)edge->range.string->data)+edge->range.start_index+already_matched,
-						  edge_length-already_matched,
-						  pattern+already_matched);
-		  }
+	 found= gen_index_find_kid(idx, node, node_depth, pattern[0], &kid);
+	 if (found) {
+		const char single_char= gen_index_single_char(idx, kid);
+		if ((single_char == '\0') || (single_char != avoid_prev_char)) {
+		  TRACE("Edge found!");
 		} else {
-		  tmp_lcp= get_lcp(((char*)edge->range.string->data)+edge->range.start_index,
-								 edge_length,
-								 pattern);
+		  TRACE("Edge ignored because the subtree contains "
+				  "only occurrences preceeded by char %c that is the same "
+				  "of %c.", single_char, avoid_prev_char);
+		  found= false;
 		}
-		const size_t lcp= tmp_lcp;
-		TRACE("Edge length %zu-%zu", lcp, edge_length);
-		if ((pattern[lcp] == '\0') || (lcp < edge_length)) {
-		  *final= edge;
-		  *matched_len= lcp;
+	 }
+  }
+  if (!found) {
+	 *final= node;
+	 *matched_len= node_depth - gen_index_parent_depth(idx, node);
+  } else {
+	 const size_t kid_depth= gen_index_depth(idx, kid);
+	 const size_t edge_length= kid_depth - node_depth;
+	 const char* const label= gen_index_edge_label(idx, kid, node_depth);
+	 size_t tmp_lcp= 0;
+	 if (edge_length == 1) {
+		tmp_lcp= 1;
+	 } else if (already_matched > 0) {
+		if (already_matched >= edge_length) {
+		  tmp_lcp= edge_length;
 		} else {
-		  my_assert(lcp==edge_length);
-		  size_t new_already_matched= 0;
-		  if (already_matched > lcp)
-			 new_already_matched= already_matched-lcp;
-		  find_deepest_common_node_rec(pattern+edge_length,
-												 edge->dst_node,
-												 new_already_matched,
-												 avoid_prev_char,
-												 final,
-												 matched_len);
+		  tmp_lcp= already_matched +
+			 get_lcp(label+already_matched,
+						edge_length-already_matched,
+						pattern+already_matched);
 		}
+	 } else {
+		tmp_lcp= get_lcp(label, edge_length, pattern);
+	 }
+	 const size_t lcp= tmp_lcp;
+	 TRACE("Edge length %zu-%zu", lcp, edge_length);
+	 if ((pattern[lcp] == '\0') || (lcp < edge_length)) {
+		*final= kid;
+		*matched_len= lcp;
+	 } else {
+		my_assert(lcp==edge_length);
+		size_t new_already_matched= 0;
+		if (already_matched > lcp)
+		  new_already_matched= already_matched-lcp;
+		find_deepest_common_node_rec(pattern+edge_length,
+											  idx,
+											  kid,
+											  kid_depth,
+											  new_already_matched,
+											  avoid_prev_char,
+											  final,
+											  matched_len);
 	 }
   }
 }
@@ -132,145 +122,133 @@ find_deepest_common_node_rec(const char const* pattern,
 
 static void
 find_deepest_common_node(const char* const pattern,
-								 LST_STree* const tree,
+								 const pgen_index idx,
 								 const char avoid_prev_char,
-								 LST_Edge** final, size_t* const matched_len) {
+								 gen_node* final, size_t* const matched_len) {
   TRACE("Finding deepest common node.");
-  find_deepest_common_node_rec(pattern, tree->root_node, 0, avoid_prev_char, final, matched_len);
+  find_deepest_common_node_rec(pattern, idx, gen_index_root(idx), 0, 0,
+										 avoid_prev_char, final, matched_len);
 }
 
 static void
 follow_suffix_link_and_fast_fwd(const char* pattern,
-										  const LST_Edge* const prev_edge,
+										  const pgen_index idx,
+										  const gen_node prev_node,
 										  size_t matched_len,
 										  const char avoid_prev_char,
-										  LST_Edge** final,
+										  gen_node* final,
 										  size_t* const out_matched_len) {
   TRACE("Following the suffix link.");
-  LST_Node* sl= NULL;
-  if (lst_edge_get_length(prev_edge)==matched_len) {
-	 sl= prev_edge->dst_node->suffix_link_node;
+  const size_t parent_depth= gen_index_parent_depth(idx, prev_node);
+  size_t depth= parent_depth;
+  if (gen_index_depth(idx, prev_node) == parent_depth+matched_len) {
+	 depth= parent_depth+matched_len;
 	 matched_len= 0;
-  } else {
-	 sl= prev_edge->src_node->suffix_link_node;
   }
-  NOT_NULL(sl);
-  TRACE("Matched len %zu and string-depth %zu", matched_len, sl->string_depth);
-  find_deepest_common_node_rec(pattern + sl->string_depth,
-										 sl, matched_len,
+  const gen_node sl= gen_index_suffix_link(idx, prev_node, depth);
+  TRACE("Matched len %zu and string-depth %zu", matched_len, depth-1);
+  find_deepest_common_node_rec(pattern + depth-1,
+										 idx, sl, depth-1, matched_len,
 										 avoid_prev_char,
 										 final, out_matched_len);
 }
 
 
+struct _fill_context {
+  size_t symbol_k;
+  plist Vi;
+  int p;
+  size_t l;
+  parena arena;
+};
 
 static void
-fill_list_pairings(LST_Edge* const edge,
-						 LST_Edge* const block_edge,
-						 const size_t* const occ,
-						 const size_t alph_size,
+add_pairing(void* data,
+				const uint32_t t, const size_t k, const bool before_block) {
+  const struct _fill_context* const ctx= (const struct _fill_context*)data;
+  if (before_block &&
+		!((t>0) || ((t==0) && ((k==0)||((k==1)&&(ctx->symbol_k==0)))))) {
+	 return;
+  }
+  ppairing pairing= pairing_create_in_arena(ctx->arena);
+  pairing->p= ctx->p;
+  pairing->t= t;
+  pairing->l= ctx->l;
+  list_add_to_tail(ctx->Vi, pairing);
+  DEBUG("Found the new pairing (%d, %d, %zd).", ctx->p, (int)t, ctx->l);
+}
+
+static void
+fill_list_pairings(const pgen_index idx,
+						 const gen_node node,
+						 const gen_node* const block_node,
 						 const size_t const symbol_k,
 						 plist Vi,
 						 const int p,
-						 const size_t l) {
-  size_t block_start, block_end;
+						 const size_t l,
+						 parena arena) {
   TRACE("Previous symbol key %zu", symbol_k);
-  for (size_t k= 0; k<alph_size; ++k) {
-	 if (k == symbol_k)
-		continue;
-	 TRACE("Considering symbol %zu.", k);
-	 const size_t start= edge->dst_node->slices[2*k];
-	 const size_t end= edge->dst_node->slices[2*k+1];
-	 if ((block_edge == NULL) || (block_edge->dst_node->slices[2*k+1]==0)) {
-		block_start= block_end= end;
-	 } else {
-		block_start= block_edge->dst_node->slices[2*k];
-		block_end= block_edge->dst_node->slices[2*k+1];
-	 }
-	 TRACE("Considering slice %zu-%zu with block slice %zu-%zu.",
-			 start, end, block_start, block_end);
-	 for (size_t i= start;
-			i<block_start; ++i) {
-		const int t= occ[i];
-		if ((t>0) || ((t==0) && ((k==0)||((k==1)&&(symbol_k==0))))) {
-		  ppairing pairing= pairing_create();
-		  pairing->p= p;
-		  pairing->t= t;
-		  pairing->l= l;
-		  list_add_to_tail(Vi, pairing);
-		  DEBUG("Found the new pairing (%d, %d, %zd).", p, t, l);
-		}
-	 }
-	 for (size_t i= block_end;
-			i<end; ++i) {
-		int t= occ[i];
-		ppairing pairing= pairing_create();
-		pairing->p= p;
-		pairing->t= t;
-		pairing->l= l;
-		list_add_to_tail(Vi, pairing);
-		DEBUG("Found the new pairing (%d, %d, %zd).", p, t, l);
-	 }
-  }
+  struct _fill_context ctx= { symbol_k, Vi, p, l, arena };
+  gen_index_for_each_occurrence(idx, node, block_node, symbol_k,
+										  add_pairing, &ctx);
 }
 
 pext_array
 build_vertex_set(pEST_info pattern,
-					  LST_STree* tree,
+					  const pgen_index idx,
 					  const ppreproc_gen const pg,
-					  pconfiguration config) {
+					  pconfiguration config,
+					  parena arena) {
   INFO("Starting the build of vertex set of the MEG.");
   my_assert(pattern!=NULL);
   my_assert(pattern->EST_seq!=NULL);
   my_assert(pattern->EST_id!=NULL);
-  my_assert(tree!=NULL);
+  my_assert(idx!=NULL);
   my_assert(config!=NULL);
+  my_assert(arena!=NULL);
   const size_t pattern_len= strlen(pattern->EST_seq);
   DEBUG("The pattern is %zd characters long.", pattern_len);
   pext_array V= EA_create();
 
 // Creation of the source pairing
-  plist Vi= list_create();
+  plist Vi= list_create_in_arena(arena);
   plistit Vij= NULL;
   plistit Vii= NULL;
-  ppairing pairing= pairing_create();
+  ppairing pairing= pairing_create_in_arena(arena);
   pairing->p= SOURCE_PAIRING_START;
   pairing->t= SOURCE_PAIRING_START;
   pairing->l= SOURCE_PAIRING_LEN;
   list_add_to_tail(Vi, pairing);
   EA_insert(V, Vi);
 
-  LST_Edge* prev_N= NULL;
+  gen_node prev_N= gen_index_root(idx);
   size_t prev_matched_len= 0;
   char prev_symbol= '\0';
   size_t prev_symbol_key= pg->alph_size;
   for (unsigned int i= 0; i<pattern_len; ++i) {
 	 TRACE("Considering the %dth suffix of the pattern.", i);
-	 LST_Edge* block_edge= NULL;
-	 Vi= list_create();
+	 Vi= list_create_in_arena(arena);
 	 EA_insert(V, Vi);
-	 LST_Edge* N= NULL;
+	 gen_node N;
 	 size_t matched_len;
-	 if (prev_N==NULL || prev_N->src_node->suffix_link_node==NULL) {
-		find_deepest_common_node(pattern->EST_seq+i, tree, prev_symbol, &N, &matched_len);
+	 if (gen_index_is_root(idx, prev_N) || (gen_index_parent_depth(idx, prev_N) == 0)) {
+		find_deepest_common_node(pattern->EST_seq+i, idx, prev_symbol, &N, &matched_len);
 	 } else {
 		follow_suffix_link_and_fast_fwd(pattern->EST_seq+i,
+												  idx,
 												  prev_N,
 												  prev_matched_len,
 												  prev_symbol,
 												  &N, &matched_len);
 	 }
-	 if (N == NULL) {
+	 if (gen_index_is_root(idx, N)) {
 		DEBUG("The suffix cannot be matched.");
-		prev_N= NULL;
+		prev_N= N;
 		prev_matched_len= 0;
 	 } else {
-		NOT_NULL(N);
-		NOT_NULL(N->src_node);
-		NOT_NULL(N->dst_node);
-		TRACE("The deepest common node has string-depth %zd.",
-				N->src_node->string_depth + matched_len);
-		size_t min_string_depth= MAX((N->src_node->string_depth + matched_len)*(config->min_string_depth_rate),
+		size_t depth= gen_index_parent_depth(idx, N) + matched_len;
+		TRACE("The deepest common node has string-depth %zd.", depth);
+		size_t min_string_depth= MAX(depth*(config->min_string_depth_rate),
 											  config->min_factor_len);
 		TRACE("The minimum string-depth that will be considered is %zd.", min_string_depth);
 
@@ -278,25 +256,26 @@ build_vertex_set(pEST_info pattern,
 		prev_N= N;
 		prev_matched_len= matched_len;
 
-		while (N->src_node->string_depth + matched_len
-				 >= min_string_depth) {
-		  TRACE("Analysing the common node at string-depth %zd.",
-				  N->src_node->string_depth + matched_len);
-		  fill_list_pairings(N,
-									block_edge,
-									tree->arr_occs,
-									pg->alph_size,
+// Il padre viene calcolato solo se deve essere analizzato
+		bool has_block= false;
+		gen_node block_N= N;
+		while (depth >= min_string_depth) {
+		  TRACE("Analysing the common node at string-depth %zd.", depth);
+		  fill_list_pairings(idx,
+									N,
+									has_block ? &block_N : NULL,
 									prev_symbol_key,
 									Vi,
 									i,
-									N->src_node->string_depth + matched_len);
-
-		  NOT_NULL(N->src_node->up_edge);
-		  NOT_NULL(N->src_node->up_edge->src_node);
-
-		  block_edge= N;
-		  N= N->src_node->up_edge;
-		  matched_len= lst_edge_get_length(N);
+									depth,
+									arena);
+
+		  block_N= N;
+		  has_block= true;
+		  depth= gen_index_parent_depth(idx, N);
+		  if ((depth == 0) || (depth < min_string_depth))
+			 break;
+		  N= gen_index_parent(idx, N);
 		}
 		list_sort(Vi, (comparator)pairing_compare);
 		plist ltoremove= list_create();
@@ -338,8 +317,8 @@ build_vertex_set(pEST_info pattern,
   }
   listit_destroy(Vij);
   listit_destroy(Vii);
-  Vi= list_create();
-  pairing= pairing_create();
+  Vi= list_create_in_arena(arena);
+  pairing= pairing_create_in_arena(arena);
   pairing->p= SINK_PAIRING_START;
   pairing->t= SINK_PAIRING_START;
   pairing->l= SINK_PAIRING_LEN;
@@ -379,6 +358,38 @@ build_vertex_set(pEST_info pattern,
   return V;
 }
 
+pext_array
+filter_vertex_set(const pext_array V0,
+						const size_t min_factor_len,
+						parena arena) {
+  my_assert(V0!=NULL);
+  my_assert(EA_size(V0)>=2);
+  my_assert(arena!=NULL);
+  DEBUG("Filtering the vertex set with min-factor-len= %zu.", min_factor_len);
+  const size_t n= EA_size(V0);
+  pext_array V= EA_create();
+  for (size_t i= 0; i<n; ++i) {
+	 plist Vi0= EA_get(V0, i);
+	 plist Vi= list_create_in_arena(arena);
+// Il sorgente e il pozzo vengono sempre mantenuti
+	 const bool keep_all= (i==0) || (i==n-1);
+	 struct _listit it;
+	 list_first_stack(Vi0, &it);
+	 while (listit_has_next(&it)) {
+		ppairing p0= listit_next(&it);
+		if (keep_all || (size_t)p0->l >= min_factor_len) {
+		  ppairing p= pairing_create_in_arena(arena);
+		  p->p= p0->p;
+		  p->t= p0->t;
+		  p->l= p0->l;
+		  list_add_to_tail(Vi, p);
+		}
+	 }
+	 EA_insert(V, Vi);
+  }
+  return V;
+}
+
 int compute_fl(const pconfiguration config) {
   my_assert(config!=NULL);
   return 2*(config->min_factor_len)+1;
@@ -529,30 +540,103 @@ is_there_an_edge(const ppairing I,
 }
 
 
+// Index of the vertex set of a MEG.
+// The pairings of V[j] are pairings[first[j]], ..., pairings[first[j+1]-1]
+// and, since they all start at position j-1 of the EST, they are sorted by
+// their starting position on the genomic sequence.
+// The array of pairings is the one of the compact MEG (in MEG order).
+struct _vertex_index {
+  ppairing* pairings;
+  size_t* first;
+};
+
 static void
-add_edges_from(const ppairing I, const pext_array V,
+vertex_index_create(const pext_array V, const pcsr_meg meg, struct _vertex_index* idx) {
+  const size_t n= EA_size(V);
+  idx->first= NPALLOC(size_t, n+1);
+  idx->first[0]= 0;
+  for (size_t j= 0; j<n; ++j) {
+	 idx->first[j+1]= idx->first[j] + list_size(EA_get(V, j));
+  }
+  my_assert(idx->first[n] == meg->n_pairings);
+  idx->pairings= meg->pairings;
+#ifndef NDEBUG
+  for (size_t j= 0; j<n; ++j) {
+	 for (size_t k= idx->first[j]; k<idx->first[j+1]; ++k) {
+		ppairing J= idx->pairings[k];
+		my_assert((j==0) || (j==n-1) || (J->p == (int)j-1));
+		my_assert((k==idx->first[j]) || (idx->pairings[k-1]->t <= J->t));
+	 }
+  }
+#endif
+}
+
+static void
+vertex_index_destroy(struct _vertex_index* idx) {
+  pfree(idx->first);
+}
+
+// Return the position of the first pairing of V[j] that starts after position t
+// of the genomic sequence
+static size_t
+vertex_index_first_after(const struct _vertex_index* idx, const int j, const int t) {
+  size_t lo= idx->first[j];
+  size_t hi= idx->first[j+1];
+  while (lo<hi) {
+	 const size_t mid= lo + (hi-lo)/2;
+	 if (idx->pairings[mid]->t <= t) {
+		lo= mid+1;
+	 } else {
+		hi= mid;
+	 }
+  }
+  return lo;
+}
+
+// Only the pairings J such that I->p < J->p <= I->p+I->l+fl can be adjacent
+// to I (see is_there_an_edge_strict) and, for each J->p, the candidates lie
+// in two consecutive windows on T:
+// - Overlap on T: I->t < J->t < I->t+I->l and J->p+I->t-I->p-J->t <= fl,
+//   that is J->t >= I->t+J->p-I->p-fl;
+// - Simple-sequence on T: J->t >= I->t+I->l, bounded by
+//   I->t+I->l+max_intron_length only if the maximum intron length is given.
+// The candidates are enumerated in the same order of the MEG.
+static void
+add_edges_from(const ppairing I, const struct _vertex_index* idx,
+					pcsr_meg meg,
 					const int l, const int fl, const int n,
 					pconfiguration config) {
   TRACE("Adding edges from (%d, %d, %d)", PAIRING(I));
   TRACE("l= %d, fl= %d, n= %d", l, fl, n);
   const int ubound= MIN(I->p+I->l+fl+1, n-l);
-  plistit Vjt= NULL;
-  for (int j= 0; j<ubound; ++j) {
-	 plist Vj= EA_get(V, j);
-	 list_first_reuse(Vj, &Vjt);
-	 while (listit_has_next(Vjt)) {
-		ppairing J= listit_next(Vjt);
+  const int overlap_end= I->t + I->l;
+  for (int j= MAX(I->p+2, 0); j<ubound; ++j) {
+// The pairings of V[j] start at position j-1 of the EST
+	 const int overlap_start= MAX(I->t+1, I->t + (j-1) - I->p - fl);
+	 size_t k= vertex_index_first_after(idx, j, MIN(overlap_start, overlap_end)-1);
+// Overlap on T
+	 for (; k<idx->first[j+1] && idx->pairings[k]->t < overlap_end; ++k) {
+		ppairing J= idx->pairings[k];
+		if (is_there_an_edge_strict(I, J, l, fl, config)) {
+			csr_meg_add_edge(meg, I->id, J->id);
+		}
+	 }
+// Simple-sequence on T
+	 for (; k<idx->first[j+1]; ++k) {
+		ppairing J= idx->pairings[k];
+		if ((config->max_intron_length!=0) &&
+			 (J->t > overlap_end + config->max_intron_length))
+		  break;
 		if (is_there_an_edge_strict(I, J, l, fl, config)) {
-			list_add_to_tail(I->adjs, J);
-			list_add_to_tail(J->incs, I);
+			csr_meg_add_edge(meg, I->id, J->id);
 		}
 	 }
   }
-  listit_destroy(Vjt);
 }
 
 static void
 add_edges_from_source(pext_array V,
+							 pcsr_meg meg,
 							 pconfiguration config) {
   INFO("Adding the edges from the source pairing.");
   int p_len= EA_size(V)-2;
@@ -574,20 +658,18 @@ add_edges_from_source(pext_array V,
 		ppairing I= listit_next(Vit);
 // Look for a non-overlapped incident
 // If it has a non-overlapped incident, then it is not a source
-		plistit incsit= list_first(I->incs);
+		const size_t n_incs= csr_meg_n_incs(meg, I->id);
 		bool possible_source= true;
-		while (possible_source && listit_has_next(incsit)) {
-		  ppairing inc= listit_next(incsit);
+		for (unsigned int k= 0; possible_source && k<n_incs; ++k) {
+		  ppairing inc= meg->pairings[csr_meg_inc(meg, I->id, k)];
 		  possible_source= ! (((inc->p + inc->l <= I->p) || (I->p + I->l <= inc->p)) &&
 									 ((inc->t + inc->l <= I->t) || (I->t + I->l <= inc->t)));
 		  possible_source= possible_source &&
 			 (((inc->p + L) > I->p) || ((inc->t + L) > I->t));
 		}
-		listit_destroy(incsit);
 		if (possible_source) {
 		  DEBUG("Pairing (%d, %d, %d) can be a source.", PAIRING(I));
-		  list_add_to_tail(source->adjs, I);
-		  list_add_to_tail(I->incs, source);
+		  csr_meg_add_edge(meg, source->id, I->id);
 		} else {
 		  TRACE("Pairing (%d, %d, %d) cannot be a source.", PAIRING(I));
 		}
@@ -599,6 +681,7 @@ add_edges_from_source(pext_array V,
 
 static void
 add_edges_to_sink(pext_array V,
+						pcsr_meg meg,
 						pconfiguration config) {
   INFO("Adding the edges towards the sink pairing.");
   const int L= config->min_factor_len;
@@ -621,21 +704,19 @@ add_edges_to_sink(pext_array V,
 		if (I->p + I->l < min_p) continue;
 // Look for a non-overlapped adjacent
 // If it has a non-overlapped adjacent, then it is not a sink
-		plistit adjsit= list_first(I->adjs);
+		const size_t n_adjs= csr_meg_n_adjs(meg, I->id);
 		bool possible_sink= true;
-		while (possible_sink && listit_has_next(adjsit)) {
-		  ppairing adj= listit_next(adjsit);
+		for (unsigned int k= 0; possible_sink && k<n_adjs; ++k) {
+		  ppairing adj= meg->pairings[csr_meg_adj(meg, I->id, k)];
 		  possible_sink= ! (((adj->p + adj->l <= I->p) || (I->p + I->l <= adj->p)) &&
 								  ((adj->t + adj->l <= I->t) || (I->t + I->l <= adj->t)));
 		  possible_sink= possible_sink &&
 			 (((I->p + I->l + L) > (adj->p + adj->l)) ||
 			  ((I->t + I->l + L) > (adj->t + adj->l)));
 		}
-		listit_destroy(adjsit);
 		if (possible_sink) {
 		  DEBUG("Pairing (%d, %d, %d) can be a sink.", PAIRING(I));
-		  list_add_to_tail(sink->incs, I);
-		  list_add_to_tail(I->adjs, sink);
+		  csr_meg_add_edge(meg, I->id, sink->id);
 		} else {
 		  TRACE("Pairing (%d, %d, %d) cannot be a sink.", PAIRING(I));
 		}
@@ -646,7 +727,7 @@ add_edges_to_sink(pext_array V,
 }
 
 
-void
+pcsr_meg
 build_edge_set(pext_array V,
 					pconfiguration config
 					) {
@@ -655,27 +736,31 @@ build_edge_set(pext_array V,
   my_assert(config!=NULL);
   const size_t n= EA_size(V);
   const int fl= compute_fl(config);
+  pcsr_meg meg= csr_meg_create(V);
+  struct _vertex_index idx;
+  vertex_index_create(V, meg, &idx);
   for (size_t i= 1; i<n-1; ++i) {
 	 TRACE("Analysis of the %zdth pairing list.", i);
-	 plist Vi= EA_get(V, i);
-	 plistit Vit= list_first(Vi);
-	 while (listit_has_next(Vit)) {
-		ppairing I= listit_next(Vit);
+	 for (size_t k= idx.first[i]; k<idx.first[i+1]; ++k) {
+		ppairing I= idx.pairings[k];
 		TRACE("Analysis of pairing (%d, %d, %d)", PAIRING(I));
-		add_edges_from(I, V, config->min_factor_len, fl, n, config);
+		add_edges_from(I, &idx, meg, config->min_factor_len, fl, n, config);
 	 }
-	 listit_destroy(Vit);
   }
-  add_edges_from_source(V, config);
-  add_edges_to_sink(V, config);
+  vertex_index_destroy(&idx);
+  add_edges_from_source(V, meg, config);
+  add_edges_to_sink(V, meg, config);
+  csr_meg_pack(meg, V);
   INFO("Build of edge set of the MEG completed!");
+  return meg;
 }
 
 //Etichetta come intronici gli archi piu' lunghi di questa quantita'
 #define INTRONIC_EDGE 50
 void
-add_intronic_edges_to_file(FILE* f, pext_array V) {
+add_intronic_edges_to_file(FILE* f, pext_array V, const pcsr_meg meg) {
   my_assert(V!=NULL);
+  my_assert(meg!=NULL);
   my_assert(f!=NULL);
   for (size_t i= 0; i< EA_size(V); ++i) {
 	 plist Vi= EA_get(V, i);
@@ -683,9 +768,8 @@ add_intronic_edges_to_file(FILE* f, pext_array V) {
 	 while (listit_has_next(lit)) {
 		ppairing p= listit_next(lit);
 		if ((p->p != SOURCE_PAIRING_START) && (p->p != SINK_PAIRING_START))  {
-		  plistit ait= list_first(p->adjs);
-		  while (listit_has_next(ait)) {
-			 ppairing a= listit_next(ait);
+		  for (unsigned int k= 0; k<csr_meg_n_adjs(meg, p->id); ++k) {
+			 ppairing a= meg->pairings[csr_meg_adj(meg, p->id, k)];
 			 if (a->p != SINK_PAIRING_START) {
 				fprintf(f, "%d %d %d %d %d %d %d %d %d",
 						  p->t + p->l, a->t,
@@ -699,7 +783,6 @@ add_intronic_edges_to_file(FILE* f, pext_array V) {
 				fprintf(f, "\n");
 			 }
 		  }
-		  listit_destroy(ait);
 		}
 	 }
 	 listit_destroy(lit);
@@ -720,22 +803,24 @@ add_intronic_edges_to_file(FILE* f, pext_array V) {
 #define MAX_GAP_ON_P 4
 
 void
-save_meg_to_filename(pext_array V, const char* const filename) {
+save_meg_to_filename(pext_array V, const pcsr_meg meg, const char* const filename) {
   NOT_NULL(V);
+  NOT_NULL(meg);
   NOT_NULL(filename);
   FILE* f= fopen(filename, "w");
   if (f==NULL) {
 	 ERROR("Impossible to save the MEG to file '%s'.", filename);
   } else {
 	 DEBUG("Saving the MEG to file '%s'.", filename);
-	 print_meg(V, f);
+	 print_meg(V, meg, f);
 	 fclose(f);
   }
 }
 
 void
-print_meg(pext_array V, FILE* f) {
+print_meg(pext_array V, const pcsr_meg meg, FILE* f) {
   my_assert(V!=NULL);
+  my_assert(meg!=NULL);
   my_assert(f!=NULL);
   fprintf(f, "digraph MEG {\n");
   for (size_t i= 0; i< EA_size(V); ++i) {
@@ -755,9 +840,8 @@ print_meg(pext_array V, FILE* f) {
 		  fprintf(f, ", style=filled, fillcolor=yellow");
 		}
 		fprintf(f,"];\n");
-		plistit ait= list_first(p->adjs);
-		while (listit_has_next(ait)) {
-		  ppairing a= listit_next(ait);
+		for (unsigned int k= 0; k<csr_meg_n_adjs(meg, p->id); ++k) {
+		  ppairing a= meg->pairings[csr_meg_adj(meg, p->id, k)];
 		  fprintf(f, "\tn%d -> n%d[fontsize=12", p->id, a->id);
 		  if ((p->p != SOURCE_PAIRING_START) && (a->p != SINK_PAIRING_START)) {
 			 fprintf(f, ",label=\"P:%d\\nT:%d\\nD:%d\"",
@@ -771,7 +855,6 @@ print_meg(pext_array V, FILE* f) {
 		  }
 		  fprintf(f, "];\n");
 		}
-		listit_destroy(ait);
 	 }
 	 listit_destroy(lit);
   }
@@ -784,14 +867,16 @@ print_meg(pext_array V, FILE* f) {
 #else // if not defined LOG_GRAPHS
 
 void
-save_meg_to_filename(pext_array V, const char* const filename) {
+save_meg_to_filename(pext_array V, const pcsr_meg meg, const char* const filename) {
   (void)V;
+  (void)meg;
   (void)filename;
 }
 
 void
-print_meg(pext_array V, FILE* f) {
+print_meg(pext_array V, const pcsr_meg meg, FILE* f) {
   (void)V;
+  (void)meg;
   (void)f;
 }
 
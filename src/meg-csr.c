@@ -0,0 +1,323 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010,2012  Yuri Pirola, Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+/**
+ *
+ * @file meg-csr.c
+ *
+ * Compact (CSR-like) representation of a MEG.
+ *
+ **/
+
+#include "meg-csr.h"
+
+#include <limits.h>
+#include <string.h>
+
+#include "util.h"
+#include "list.h"
+#include "log.h"
+
+
+static void*
+resize_array(void* arr, const size_t n, const size_t el_size) {
+  void* buff= realloc(arr, n*el_size);
+  if (buff==NULL) {
+	 FATAL("Allocation memory error. Trying to allocate %zu bytes.", n*el_size);
+	 fail();
+  }
+  return buff;
+}
+
+static void
+edges_init(struct _csr_edges* e, const size_t n_pairings, const size_t alloc_pairings,
+			  const size_t alloc) {
+  e->first= NPALLOC(unsigned int, alloc_pairings);
+  e->size= NPALLOC(unsigned int, alloc_pairings);
+  e->capacity= NPALLOC(unsigned int, alloc_pairings);
+  for (size_t i= 0; i<n_pairings; ++i) {
+	 e->first[i]= 0;
+	 e->size[i]= 0;
+	 e->capacity[i]= 0;
+  }
+  e->edges= NPALLOC(unsigned int, alloc);
+  e->len= 0;
+  e->alloc= alloc;
+}
+
+static void
+edges_destroy(struct _csr_edges* e) {
+  pfree(e->first);
+  pfree(e->size);
+  pfree(e->capacity);
+  pfree(e->edges);
+}
+
+static void
+edges_reserve(struct _csr_edges* e, const size_t n) {
+  if (n > e->alloc) {
+	 e->alloc= MAX(n, 2*e->alloc);
+	 e->edges= (unsigned int*)resize_array(e->edges, e->alloc, sizeof(unsigned int));
+  }
+}
+
+static void
+edges_append(struct _csr_edges* e, const unsigned int i, const unsigned int x) {
+  if (e->size[i] == e->capacity[i]) {
+	 if (e->first[i] + e->capacity[i] != e->len) {
+// Move the block to the end of the array, doubling its capacity
+		const unsigned int capacity= 2*e->size[i];
+		edges_reserve(e, e->len + capacity);
+		memcpy(e->edges + e->len, e->edges + e->first[i], e->size[i]*sizeof(unsigned int));
+		e->first[i]= e->len;
+		e->capacity[i]= capacity;
+		e->len+= capacity;
+	 }
+	 if (e->size[i] == e->capacity[i]) {
+// The block is the last one, hence it grows in place
+		edges_reserve(e, e->len + 1);
+		++e->capacity[i];
+		++e->len;
+	 }
+  }
+  e->edges[e->first[i] + e->size[i]]= x;
+  ++e->size[i];
+}
+
+static void
+edges_remove_at(struct _csr_edges* e, const unsigned int i, const unsigned int k) {
+  my_assert(k < e->size[i]);
+  unsigned int* block= e->edges + e->first[i];
+  memmove(block + k, block + k + 1, (e->size[i] - k - 1)*sizeof(unsigned int));
+  --e->size[i];
+}
+
+static void
+edges_remove(struct _csr_edges* e, const unsigned int i, const unsigned int x) {
+  const unsigned int* block= e->edges + e->first[i];
+  unsigned int k= 0;
+  while (k < e->size[i] && block[k] != x)
+	 ++k;
+  my_assert(k < e->size[i]);
+  edges_remove_at(e, i, k);
+}
+
+// Store the edges contiguously. The j-th pairing of the result is the
+// old_id[j]-th one and the indices are translated by new_id.
+static void
+edges_pack(struct _csr_edges* e, const size_t n, const size_t n_edges,
+			  const unsigned int* old_id, const unsigned int* new_id) {
+  unsigned int* first= NPALLOC(unsigned int, n+1);
+  unsigned int* size= NPALLOC(unsigned int, n+1);
+  unsigned int* edges= NPALLOC(unsigned int, n_edges+1);
+  unsigned int k= 0;
+  for (size_t j= 0; j<n; ++j) {
+	 const unsigned int i= old_id[j];
+	 first[j]= k;
+	 size[j]= e->size[i];
+	 for (unsigned int h= e->first[i]; h < e->first[i] + e->size[i]; ++h) {
+		my_assert(new_id[e->edges[h]] != UINT_MAX);
+		edges[k]= new_id[e->edges[h]];
+		++k;
+	 }
+  }
+  my_assert(k == n_edges);
+  pfree(e->first);
+  pfree(e->capacity);
+  pfree(e->size);
+  pfree(e->edges);
+  e->first= first;
+  e->size= size;
+// Each block is full
+  e->capacity= NPALLOC(unsigned int, n+1);
+  memcpy(e->capacity, size, n*sizeof(unsigned int));
+  e->edges= edges;
+  e->len= k;
+  e->alloc= n_edges+1;
+}
+
+pcsr_meg
+csr_meg_create(pext_array V) {
+  my_assert(V!=NULL);
+  pcsr_meg meg= PALLOC(struct _csr_meg);
+  meg->n_pairings= 0;
+  for (size_t i= 0; i<EA_size(V); ++i) {
+	 meg->n_pairings+= list_size(EA_get(V, i));
+  }
+  meg->n_edges= 0;
+  meg->alloc_pairings= meg->n_pairings+1;
+  meg->pairings= NPALLOC(ppairing, meg->alloc_pairings);
+  size_t j= 0;
+  listit it;
+  for (size_t i= 0; i<EA_size(V); ++i) {
+	 list_first_stack(EA_get(V, i), &it);
+	 while (listit_has_next(&it)) {
+		ppairing p= (ppairing)listit_next(&it);
+		p->id= j;
+		meg->pairings[j]= p;
+		++j;
+	 }
+  }
+  edges_init(&meg->adj, meg->n_pairings, meg->alloc_pairings, 2*meg->n_pairings+16);
+  edges_init(&meg->inc, meg->n_pairings, meg->alloc_pairings, 2*meg->n_pairings+16);
+  return meg;
+}
+
+void
+csr_meg_destroy(pcsr_meg meg) {
+  my_assert(meg!=NULL);
+  pfree(meg->pairings);
+  edges_destroy(&meg->adj);
+  edges_destroy(&meg->inc);
+  pfree(meg);
+}
+
+unsigned int
+csr_meg_add_pairing(pcsr_meg meg, ppairing p) {
+  my_assert(meg!=NULL);
+  my_assert(p!=NULL);
+  if (meg->n_pairings == meg->alloc_pairings) {
+	 meg->alloc_pairings*= 2;
+	 const size_t n= meg->alloc_pairings;
+	 meg->pairings= (ppairing*)resize_array(meg->pairings, n, sizeof(ppairing));
+	 meg->adj.first= (unsigned int*)resize_array(meg->adj.first, n, sizeof(unsigned int));
+	 meg->adj.size= (unsigned int*)resize_array(meg->adj.size, n, sizeof(unsigned int));
+	 meg->adj.capacity= (unsigned int*)resize_array(meg->adj.capacity, n, sizeof(unsigned int));
+	 meg->inc.first= (unsigned int*)resize_array(meg->inc.first, n, sizeof(unsigned int));
+	 meg->inc.size= (unsigned int*)resize_array(meg->inc.size, n, sizeof(unsigned int));
+	 meg->inc.capacity= (unsigned int*)resize_array(meg->inc.capacity, n, sizeof(unsigned int));
+  }
+  const unsigned int i= meg->n_pairings;
+  p->id= i;
+  meg->pairings[i]= p;
+  meg->adj.first[i]= meg->adj.size[i]= meg->adj.capacity[i]= 0;
+  meg->inc.first[i]= meg->inc.size[i]= meg->inc.capacity[i]= 0;
+  ++meg->n_pairings;
+  return i;
+}
+
+void
+csr_meg_add_edge(pcsr_meg meg, const unsigned int i, const unsigned int j) {
+  my_assert(i < meg->n_pairings && j < meg->n_pairings);
+  edges_append(&meg->adj, i, j);
+  edges_append(&meg->inc, j, i);
+  ++meg->n_edges;
+}
+
+void
+csr_meg_remove_adj(pcsr_meg meg, const unsigned int i, const unsigned int k) {
+  const unsigned int j= csr_meg_adj(meg, i, k);
+  edges_remove_at(&meg->adj, i, k);
+  edges_remove(&meg->inc, j, i);
+  --meg->n_edges;
+}
+
+void
+csr_meg_isolate_pairing(pcsr_meg meg, const unsigned int i) {
+  for (unsigned int k= 0; k<csr_meg_n_adjs(meg, i); ++k) {
+	 edges_remove(&meg->inc, csr_meg_adj(meg, i, k), i);
+  }
+  for (unsigned int k= 0; k<csr_meg_n_incs(meg, i); ++k) {
+	 edges_remove(&meg->adj, csr_meg_inc(meg, i, k), i);
+  }
+  meg->n_edges-= csr_meg_n_adjs(meg, i) + csr_meg_n_incs(meg, i);
+  meg->adj.size[i]= 0;
+  meg->inc.size[i]= 0;
+}
+
+void
+csr_meg_clear_edges(pcsr_meg meg) {
+  for (size_t i= 0; i<meg->n_pairings; ++i) {
+	 meg->adj.first[i]= meg->adj.size[i]= meg->adj.capacity[i]= 0;
+	 meg->inc.first[i]= meg->inc.size[i]= meg->inc.capacity[i]= 0;
+  }
+  meg->adj.len= 0;
+  meg->inc.len= 0;
+  meg->n_edges= 0;
+}
+
+void
+csr_meg_pack(pcsr_meg meg, pext_array V) {
+  my_assert(meg!=NULL);
+  const size_t n_old= meg->n_pairings;
+  size_t n= 0;
+  if (V!=NULL) {
+	 for (size_t i= 0; i<EA_size(V); ++i) {
+		n+= list_size(EA_get(V, i));
+	 }
+  } else {
+	 n= n_old;
+  }
+  unsigned int* new_id= NPALLOC(unsigned int, n_old+1);
+  for (size_t i= 0; i<n_old; ++i) {
+	 new_id[i]= UINT_MAX;
+  }
+  ppairing* pairings= NPALLOC(ppairing, n+1);
+  if (V!=NULL) {
+	 size_t j= 0;
+	 listit it;
+	 for (size_t i= 0; i<EA_size(V); ++i) {
+		list_first_stack(EA_get(V, i), &it);
+		while (listit_has_next(&it)) {
+		  ppairing p= (ppairing)listit_next(&it);
+		  my_assert(p->id < n_old && meg->pairings[p->id] == p);
+		  pairings[j]= p;
+		  ++j;
+		}
+	 }
+	 my_assert(j == n);
+  } else {
+	 memcpy(pairings, meg->pairings, n*sizeof(ppairing));
+  }
+// old_id e new_id sono ricavati in un solo passo dal nuovo ordine dei pairing
+  unsigned int* old_id= NPALLOC(unsigned int, n+1);
+  for (size_t j= 0; j<n; ++j) {
+	 old_id[j]= pairings[j]->id;
+	 new_id[old_id[j]]= j;
+  }
+  old_id[n]= UINT_MAX;
+#ifndef NDEBUG
+  for (size_t i= 0; i<n_old; ++i) {
+	 my_assert(new_id[i] != UINT_MAX ||
+				  (csr_meg_n_adjs(meg, i) == 0 && csr_meg_n_incs(meg, i) == 0));
+  }
+#endif
+  edges_pack(&meg->adj, n, meg->n_edges, old_id, new_id);
+  edges_pack(&meg->inc, n, meg->n_edges, old_id, new_id);
+  pfree(meg->pairings);
+  meg->pairings= pairings;
+  meg->n_pairings= n;
+  meg->alloc_pairings= n+1;
+  for (size_t j= 0; j<n; ++j) {
+	 pairings[j]->id= j;
+  }
+  pfree(old_id);
+  pfree(new_id);
+  DEBUG("Compact MEG with %zu pairings and %zu edges.", meg->n_pairings, meg->n_edges);
+}
@@ -39,40 +39,33 @@
 
 #include "meg-simplification.h"
 
+#include <string.h>
+
 #include "types.h"
 #include "util.h"
 #include "int_list.h"
 #include "bit_vector.h"
 
 #include "max-emb-graph.h"
+#include "meg-csr.h"
 
 #include "log.h"
 
 
-void MEG_stats(pext_array V, size_t* tot_pairings, size_t* tot_edges) {
-  *tot_pairings= 0;
-  *tot_edges= 0;
-  for (size_t i= 0; i< EA_size(V); ++i) {
-	 plist Vi= EA_get(V, i);
-	 plistit lit= list_first(Vi);
-	 while (listit_has_next(lit)) {
-		ppairing p= listit_next(lit);
-		++(*tot_pairings);
-		(*tot_edges)+= list_size(p->adjs);
-	 }
-	 listit_destroy(lit);
-  }
+void MEG_stats(const pcsr_meg meg, size_t* tot_pairings, size_t* tot_edges) {
+  *tot_pairings= meg->n_pairings;
+  *tot_edges= meg->n_edges;
 }
 
 
 bool
-is_too_complex_for_compaction(pext_array V, pconfiguration config) {
-  NOT_NULL(V);
+is_too_complex_for_compaction(const pcsr_meg meg, pconfiguration config) {
+  NOT_NULL(meg);
   (void)config;
 
   size_t tot_pairings= 0;
   size_t tot_edges= 0;
-  MEG_stats(V, &tot_pairings, &tot_edges);
+  MEG_stats(meg, &tot_pairings, &tot_edges);
   INFO("The MEG has %7zd vertices and %7zd edges.", tot_pairings, tot_edges);
 //XXX: INSERITO PARAMETRO ARBITRARIO SUL NUMERO MASSIMO DI PAIRING IN UN MEG E DI ARCHI
   if (
@@ -87,27 +80,21 @@ is_too_complex_for_compaction(pext_array V, pconfiguration config) {
 }
 
 bool
-is_too_complex(pext_array V, pconfiguration config) {
+is_too_complex(pext_array V, const pcsr_meg meg, pconfiguration config) {
   int min_len= 0;
   size_t freq_min_len= 0;
   size_t tot_pairings= 0;
   size_t tot_edges= 0;
   const size_t est_len= EA_size(V)-2;
-  for (size_t i= 0; i< EA_size(V); ++i) {
-	 plist Vi= EA_get(V, i);
-	 plistit lit= list_first(Vi);
-	 while (listit_has_next(lit)) {
-		ppairing p= listit_next(lit);
-		++tot_pairings;
-		if (min_len==0 || p->l < min_len) {
-		  min_len= p->l;
-		  freq_min_len= 1;
-		} else if (p->l==min_len) {
-		  ++freq_min_len;
-		}
-		tot_edges+= list_size(p->adjs);
+  MEG_stats(meg, &tot_pairings, &tot_edges);
+  for (size_t i= 0; i< meg->n_pairings; ++i) {
+	 ppairing p= meg->pairings[i];
+	 if (min_len==0 || p->l < min_len) {
+		min_len= p->l;
+		freq_min_len= 1;
+	 } else if (p->l==min_len) {
+		++freq_min_len;
 	 }
-	 listit_destroy(lit);
   }
   INFO("The MEG has %7zd vertices and %7zd edges.", tot_pairings, tot_edges);
   DEBUG("The shortest pairings have length %4d, "
@@ -140,12 +127,10 @@ is_too_complex(pext_array V, pconfiguration config) {
 }
 
 void
-remove_other_sources_and_sinks(pext_array V) {
+remove_other_sources_and_sinks(pext_array V, pcsr_meg meg) {
   bool removed;
   int V_size= EA_size(V);
   plistit Vit= NULL;
-  plistit adjs= NULL;
-  plistit incs= NULL;
   do {
 	 removed= false;
 	 for (int i= 1; i<V_size-1; ++i) {
@@ -153,57 +138,44 @@ remove_other_sources_and_sinks(pext_array V) {
 		list_first_reuse(Vi, &Vit);
 		while (listit_has_next(Vit)) {
 		  ppairing I= listit_next(Vit);
-		  if (list_is_empty(I->adjs) || list_is_empty(I->incs)) {
+		  if ((csr_meg_n_adjs(meg, I->id) == 0) || (csr_meg_n_incs(meg, I->id) == 0)) {
 // Non ho adiacenti o incidenti -> rimuovo I
 			 removed= true;
 #ifdef LOG_DEBUG_ENABLED
-			 if (list_is_empty(I->adjs)) {
+			 if (csr_meg_n_adjs(meg, I->id) == 0) {
 				DEBUG("Remove (%d, %d, %d) because its adjacents are empty.", PAIRING(I));
 			 } else {
 				DEBUG("Remove (%d, %d, %d) because its incidents are empty.", PAIRING(I));
 			 }
 #endif
-// Rimuovo I come incidente dei suoi adiacenti
-			 { list_first_reuse(I->adjs, &adjs);
-				while (listit_has_next(adjs)) {
-				  ppairing adj= listit_next(adjs);
-				  list_remove_element(adj->incs, I, (delete_function)noop_free);
-				}
-			 }
-// Rimuovo I come adiacente dei suoi incidenti
-			 {
-				list_first_reuse(I->incs, &incs);
-				while (listit_has_next(incs)) {
-				  ppairing inc= listit_next(incs);
-				  list_remove_element(inc->adjs, I, (delete_function)noop_free);
-				}
-			 }
+// Rimuovo I come incidente dei suoi adiacenti e come adiacente dei suoi incidenti
+			 csr_meg_isolate_pairing(meg, I->id);
 // Rimuovo I dalla lista Vi
 			 list_remove_at_iterator(Vit, (delete_function)pairing_destroy);
 		  }
 		}
 	 }
   } while (removed);
-  listit_destroy(adjs);
-  listit_destroy(incs);
   listit_destroy(Vit);
+// Rinumero i pairing rimasti
+  csr_meg_pack(meg, V);
 }
 
 
 void
-remove_useless_edges(pext_array V, pconfiguration config) {
+remove_useless_edges(pext_array V, pcsr_meg meg, pconfiguration config) {
   INFO("Removing useless CMEG edges.");
   plistit lit= NULL;
-  plistit ait= NULL;
   const int g= compute_gl(config);
   for (size_t i= 1; i< EA_size(V); ++i) {
 	 plist Vi= EA_get(V, i);
 	 list_first_reuse(Vi, &lit);
 	 while (listit_has_next(lit)) {
 		ppairing p= listit_next(lit);
-		list_first_reuse(p->adjs, &ait);
-		while (listit_has_next(ait)) {
-		  ppairing a= listit_next(ait);
+		unsigned int k= 0;
+		while (k < csr_meg_n_adjs(meg, p->id)) {
+		  ppairing a= meg->pairings[csr_meg_adj(meg, p->id, k)];
+		  bool useless= false;
 // Computing gap on genomic
 		  if (a->t != SINK_PAIRING_START) {
 			 const int gap= MAX(a->t - a->p - p->t + p->p, 0);
@@ -213,53 +185,43 @@ remove_useless_edges(pext_array V, pconfiguration config) {
 				DEBUG("The edge between pairing (%4d, %4d, %4d) and "
 						"(%4d, %4d, %4d) is useless because of the gap %8d.",
 						p->p, p->t, p->l, a->p, a->t, a->l, gap);
-				list_remove_at_iterator(ait, (delete_function)noop_free);
-#ifndef NDEBUG
-				bool ris=
-#endif
-				  list_remove_element(a->incs, p, (delete_function)noop_free);
-#ifndef NDEBUG
-				my_assert(ris);
-#endif
+				useless= true;
 			 }
 		  }
+		  if (useless) {
+			 csr_meg_remove_adj(meg, p->id, k);
+		  } else {
+			 ++k;
+		  }
 		}
 	 }
   }
-  listit_destroy(ait);
   listit_destroy(lit);
 }
 
 static void
-copy_adjacencies(ppairing new_v, ppairing old_v) {
-  plistit old_adjs= list_first(old_v->adjs);
-  while (listit_has_next(old_adjs)) {
-	 ppairing a= (ppairing)listit_next(old_adjs);
+copy_adjacencies(pcsr_meg meg, ppairing new_v, ppairing old_v) {
+  for (unsigned int k= 0; k<csr_meg_n_adjs(meg, old_v->id); ++k) {
+	 ppairing a= meg->pairings[csr_meg_adj(meg, old_v->id, k)];
 	 DEBUG("Connecting (%4d, %4d, %4d) to (%4d, %4d, %4d).", PAIRING(new_v), PAIRING(a));
-	 list_add_to_tail(new_v->adjs, a);
-	 list_add_to_tail(a->incs, new_v);
+	 csr_meg_add_edge(meg, new_v->id, a->id);
   }
-  listit_destroy(old_adjs);
 }
 
 static void
-copy_incidencies(ppairing new_v, ppairing old_v) {
-  plistit old_incs= list_first(old_v->incs);
-  while (listit_has_next(old_incs)) {
-	 ppairing i= (ppairing)listit_next(old_incs);
+copy_incidencies(pcsr_meg meg, ppairing new_v, ppairing old_v) {
+  for (unsigned int k= 0; k<csr_meg_n_incs(meg, old_v->id); ++k) {
+	 ppairing i= meg->pairings[csr_meg_inc(meg, old_v->id, k)];
 	 DEBUG("Connecting (%4d, %4d, %4d) to (%4d, %4d, %4d).", PAIRING(i), PAIRING(new_v));
-	 list_add_to_tail(new_v->incs, i);
-	 list_add_to_tail(i->adjs, new_v);
+	 csr_meg_add_edge(meg, i->id, new_v->id);
   }
-  listit_destroy(old_incs);
 }
 
 
 void
-compact_short_edges(pext_array V, pconfiguration config) {
+compact_short_edges(pext_array V, pcsr_meg meg, pconfiguration config, parena arena) {
   INFO("Compacting short edges.");
   plistit lit= NULL;
-  plistit ait= NULL;
   bool removed= false;
   do {
 	 removed= false;
@@ -268,97 +230,53 @@ compact_short_edges(pext_array V, pconfiguration config) {
 		list_first_reuse(Vi, &lit);
 		while (listit_has_next(lit)) {
 		  ppairing p= listit_next(lit);
-		  list_first_reuse(p->adjs, &ait);
-		  while (listit_has_next(ait)) {
-			 ppairing a= listit_next(ait);
+		  unsigned int k= 0;
+		  while (k < csr_meg_n_adjs(meg, p->id)) {
+			 ppairing a= meg->pairings[csr_meg_adj(meg, p->id, k)];
+			 bool compact= false;
 // Computing gap on genomic
 			 if (a->t != SINK_PAIRING_START) {
-				bool compact= false;
 				if (a->t + a->l - p->t == a->p + a->l - p->p) {
 				  compact= (a->t >= p->t + p->l) && (a->t - p->t - p->l <= 3);
 				}
-				if (compact) {
-				  DEBUG("Compacting edge between pairing (%4d, %4d, %4d) and "
-						  "(%4d, %4d, %4d) because of the small gap.",
-						  p->p, p->t, p->l, a->p, a->t, a->l);
-				  removed= true;
-				  list_remove_at_iterator(ait, (delete_function)noop_free);
+			 }
+			 if (compact) {
+				DEBUG("Compacting edge between pairing (%4d, %4d, %4d) and "
+						"(%4d, %4d, %4d) because of the small gap.",
+						p->p, p->t, p->l, a->p, a->t, a->l);
+				removed= true;
 // Removing edge
-#ifndef NDEBUG
-				  bool ris=
-#endif
-					 list_remove_element(a->incs, p, (delete_function)noop_free);
-#ifndef NDEBUG
-				  my_assert(ris);
-#endif
+				csr_meg_remove_adj(meg, p->id, k);
 // Replacing edge with a vertex
-				  ppairing new_v= pairing_create();
-				  new_v->p= p->p;
-				  new_v->t= p->t;
-				  new_v->l= a->p + a->l - p->p;
-				  DEBUG("Created new vertex (%4d, %4d, %4d).", PAIRING(new_v));
-				  copy_adjacencies(new_v, a);
-				  copy_incidencies(new_v, p);
-				  list_add_to_tail(EA_get(V, i), new_v);
-				}
+				ppairing new_v= pairing_create_in_arena(arena);
+				new_v->p= p->p;
+				new_v->t= p->t;
+				new_v->l= a->p + a->l - p->p;
+				csr_meg_add_pairing(meg, new_v);
+				DEBUG("Created new vertex (%4d, %4d, %4d).", PAIRING(new_v));
+				copy_adjacencies(meg, new_v, a);
+				copy_incidencies(meg, new_v, p);
+				list_add_to_tail(EA_get(V, i), new_v);
+			 } else {
+				++k;
 			 }
 		  }
 		}
 	 }
-	 remove_other_sources_and_sinks(V);
+	 remove_other_sources_and_sinks(V, meg);
   } while (removed);
-  listit_destroy(ait);
   listit_destroy(lit);
 }
 
 void
-simplify_meg(pext_array V, pconfiguration config) {
-  remove_useless_edges(V, config);
-  remove_other_sources_and_sinks(V);
-}
-
-
-static void
-add_vertex(pgraph graph, ppairing v) {
-  static int next_id= 0;
-  NOT_NULL(graph);
-  NOT_NULL(v);
-
-  v->id= next_id;
-  ++next_id;
-
-  EA_insert(graph, v);
-}
-
-pgraph
-meg2graph(pext_array meg) {
-  DEBUG("Transforming the MEG into a graph.");
-  NOT_NULL(meg);
-
-  pgraph graph= EA_create();
-
-  unsigned int i;
-  for (i= 0; i< EA_size(meg); ++i) {
-	 plist Vi= EA_get(meg, i);
-	 plistit lit= list_first(Vi);
-	 while (listit_has_next(lit)) {
-		ppairing p= listit_next(lit);
-		add_vertex(graph, p);
-	 }
-	 listit_destroy(lit);
-  }
-
-  return graph;
+simplify_meg(pext_array V, pcsr_meg meg, pconfiguration config) {
+  remove_useless_edges(V, meg, config);
+  remove_other_sources_and_sinks(V, meg);
 }
 
 
 void
-graph_destroy(pgraph graph) {
-  EA_destroy(graph, (delete_function)noop_free);
-}
-
-void
-dfs_visit(pgraph G,
+dfs_visit(const pcsr_meg G,
 			 int** out_dtime,
 			 int** out_ftime,
 			 int** out_topological_ids,
@@ -366,7 +284,7 @@ dfs_visit(pgraph G,
   DEBUG("Starting the DFS visit of the graph.");
   NOT_NULL(G);
   NOT_NULL(out_is_acyclic);
-  const size_t nv= EA_size(G);
+  const size_t nv= G->n_pairings;
   DEBUG("The graph has %zu vertices.", nv);
 // Allocate the arrays if they are NULLs
   int* dtime= NULL;
@@ -391,18 +309,14 @@ dfs_visit(pgraph G,
 	 ids= *out_topological_ids;
   }
   bool is_acyclic= true;
-// Ensure that the ids are correct and count the inbound edges
   int* color= NPALLOC(int, nv);  // 0 white, 1 grey, 2 black
   for (unsigned int i= 0; i<nv; ++i) {
 	 color[i]= 0;
   }
-  for (unsigned int i= 0; i<nv; ++i) {
-	 ((ppairing)EA_get(G, i))->id= i;
-  }
 // Push source vertices
   pintlist S= intlist_create();
   for (unsigned int i= 0; i<nv; ++i) {
-	 if (list_size(((ppairing)EA_get(G, i))->incs)==0)
+	 if (csr_meg_n_incs(G, i)==0)
 		intlist_add_to_tail(S, i);
   }
   if (intlist_is_empty(S)) { // The graph is cyclic
@@ -411,34 +325,31 @@ dfs_visit(pgraph G,
   unsigned int visited= 0;
   unsigned int time= 0;
   unsigned int progr_id= nv;
-  plistit ait= NULL;
   do {
 	 while (!intlist_is_empty(S)) {
 		int id_v= intlist_remove_from_tail(S);
 		TRACE("Extracted vertex %d.", id_v);
-		ppairing v= EA_get(G, id_v);
 		if (color[id_v]==0) {
-		  TRACE("Discovered pairing (%4d, %5d, %4d)", PAIRING(v));
+		  TRACE("Discovered pairing (%4d, %5d, %4d)", PAIRING(G->pairings[id_v]));
 		  color[id_v]= 1;
 		  dtime[id_v]= time;
 		  ++time;
 		  intlist_add_to_tail(S, id_v);
-		  list_first_reuse(v->adjs, &ait);
-		  while (listit_has_next(ait)) {
-			 ppairing a= (ppairing)listit_next(ait);
-			 my_assert(a->id < nv);
+		  for (unsigned int k= 0; k<csr_meg_n_adjs(G, id_v); ++k) {
+			 const unsigned int id_a= csr_meg_adj(G, id_v, k);
+			 my_assert(id_a < nv);
 // Check the color of the adjacent vertex
-			 if (color[a->id]==0) { // vertex white -> tree edge
-				intlist_add_to_tail(S, a->id);
-				TRACE("Added vertex %d.", a->id);
-			 } else if (color[a->id]==1) { // vertex grey -> back edge
+			 if (color[id_a]==0) { // vertex white -> tree edge
+				intlist_add_to_tail(S, id_a);
+				TRACE("Added vertex %d.", id_a);
+			 } else if (color[id_a]==1) { // vertex grey -> back edge
 				is_acyclic= false;
 			 } else { // vertex black or enqueued but not yet processed -> forward or cross edge
 // do nothing
 			 }
 		  }
 		} else if (color[id_v]==1) {
-		  TRACE("Finished visiting pairing (%4d, %5d, %4d)", PAIRING(v));
+		  TRACE("Finished visiting pairing (%4d, %5d, %4d)", PAIRING(G->pairings[id_v]));
 		  color[id_v]= 2;
 		  ftime[id_v]= time;
 		  ++time;
@@ -462,101 +373,127 @@ dfs_visit(pgraph G,
 
   my_assert(visited==nv);
 
-  listit_destroy(ait);
   intlist_destroy(S);
   pfree(color);
 
   *out_is_acyclic= is_acyclic;
 }
 
-static int
-compare_pairings_by_id(ppairing * p1, ppairing * p2) {
-  return ((*p1)->id-(*p2)->id);
-}
-
 void
-topological_sort(pgraph G, bool* out_is_acyclic) {
+topological_sort(const pcsr_meg G, unsigned int** out_order, bool* out_is_acyclic) {
   DEBUG("Starting the topological sort of the graph.");
   NOT_NULL(G);
+  NOT_NULL(out_order);
   NOT_NULL(out_is_acyclic);
   int* dtime= NULL;
   int* ftime= NULL;
   int* ids= NULL;
   dfs_visit(G, &dtime, &ftime, &ids, out_is_acyclic);
+  const size_t nv= G->n_pairings;
+  unsigned int* order= NPALLOC(unsigned int, nv+1);
   if (*out_is_acyclic) {
-	 const size_t nv= EA_size(G);
 	 for (unsigned int i= 0; i<nv; ++i) {
-		ppairing p= EA_get(G, i);
-		p->id= ids[i];
-	 }
-// Sort the array
-	 for (unsigned int i= 0; i<nv; ++i) {
-		ppairing pa= EA_get(G, i);
-		while (pa->id != i) {
-		  TRACE("Swapping elements in position %4d and %4d.", pa->id, i);
-		  ppairing pb= EA_get(G, pa->id);
-		  EA_set(G, pa->id, pa);
-		  EA_set(G, i, pb);
-		  pa= pb;
-		}
-	 }
-// Sort adjacencies and incidencies
-	 for (unsigned int i= 0; i<nv; ++i) {
-		ppairing pa= EA_get(G, i);
-		list_sort(pa->adjs, (comparator)compare_pairings_by_id);
-		list_sort(pa->incs, (comparator)compare_pairings_by_id);
+		order[ids[i]]= i;
 	 }
   } else {
 	 WARN("The graph was cyclic. Topological sort has not been actually performed.");
+	 for (unsigned int i= 0; i<nv; ++i) {
+		order[i]= i;
+	 }
   }
+  *out_order= order;
   pfree(dtime);
   pfree(ftime);
   pfree(ids);
 }
 
 
+// Append the vertex v to the buffer of the transitive closures
+static void
+append_to_closures(unsigned int** pbuff, size_t* plen, size_t* pcapacity,
+						 const unsigned int v) {
+  if (*plen == *pcapacity) {
+	 *pcapacity*= 2;
+	 unsigned int* buff= (unsigned int*)realloc(*pbuff, (*pcapacity)*sizeof(unsigned int));
+	 if (buff==NULL) {
+		FATAL("Allocation memory error. Trying to allocate %zu bytes.",
+				(*pcapacity)*sizeof(unsigned int));
+		fail();
+	 }
+	 *pbuff= buff;
+  }
+  (*pbuff)[*plen]= v;
+  ++(*plen);
+}
+
 void
-transitive_reduction(pgraph G) {
+transitive_reduction(pcsr_meg G) {
   NOT_NULL(G);
   INFO("Starting transitive reduction.");
   bool is_acyclic= false;
-  topological_sort(G, &is_acyclic);
+  unsigned int* order= NULL;
+  topological_sort(G, &order, &is_acyclic);
   if (!is_acyclic) {
 	 FATAL("The graph is cyclic. Transitive reduction not possible! Terminating.");
 	 fail();
   }
-  const size_t nv= EA_size(G);
-  plist* outs_star= NPALLOC(plist, nv);
-  plist* outs_red= NPALLOC(plist, nv);
-  plist* outs_red_inc= NPALLOC(plist, nv);
-  for (size_t i= 0; i<nv; ++i) {
-	 outs_star[i]= list_create();
-	 outs_red[i]= list_create();
-	 outs_red_inc[i]= list_create();
+  const size_t nv= G->n_pairings;
+// In the following, the vertices are identified by their topological position.
+// The adjacents of each vertex are sorted by position.
+  unsigned int* pos= NPALLOC(unsigned int, nv+1);
+  for (unsigned int x= 0; x<nv; ++x) {
+	 pos[order[x]]= x;
   }
+  unsigned int* adj_first= NPALLOC(unsigned int, nv+1);
+  adj_first[0]= 0;
+  for (unsigned int x= 0; x<nv; ++x) {
+	 adj_first[x+1]= adj_first[x] + csr_meg_n_adjs(G, order[x]);
+  }
+  unsigned int* adjs= NPALLOC(unsigned int, G->n_edges+1);
+  unsigned int* adj_next= NPALLOC(unsigned int, nv+1);
+  memcpy(adj_next, adj_first, nv*sizeof(unsigned int));
+  for (unsigned int y= 0; y<nv; ++y) {
+	 const unsigned int w= order[y];
+	 for (unsigned int k= 0; k<csr_meg_n_incs(G, w); ++k) {
+		const unsigned int x= pos[csr_meg_inc(G, w, k)];
+		adjs[adj_next[x]]= y;
+		++adj_next[x];
+	 }
+  }
+  pfree(adj_next);
+  pfree(pos);
+// The vertices are analyzed in reverse topological order, hence the transitive
+// closure of each vertex is complete when its incidents are analyzed and
+// all the closures can be stored in a single buffer.
+  size_t closures_capacity= 2*nv+1;
+  size_t closures_len= 0;
+  unsigned int* closures= NPALLOC(unsigned int, closures_capacity);
+  size_t* closure_begin= NPALLOC(size_t, nv+1);
+  size_t* closure_end= NPALLOC(size_t, nv+1);
+// The edges that are kept by the reduction
+  bool* kept= NPALLOC(bool, G->n_edges+1);
   pbit_vect out_star_v= BV_create(nv);
-  plistit ait= NULL;
-  plistit wai= NULL;
   size_t removed_edges= 0;
   for (size_t i= nv; i>=1;) {
 	 --i;
-	 ppairing v= EA_get(G, i);
-	 DEBUG("Analysis of pairing %4d (%4d,%7d,%4d).", v->id, PAIRING(v));
-	 my_assert(v->id == i);
+	 ppairing v= G->pairings[order[i]];
+	 DEBUG("Analysis of pairing %4zd (%4d,%7d,%4d).", i, PAIRING(v));
 	 BV_clear(out_star_v);
 
 	 BV_set(out_star_v, i, true);
-	 list_add_to_tail(outs_star[i], v);
-
-	 list_first_reuse(v->adjs, &ait);
-	 while (listit_has_next(ait)) {
-		ppairing w= listit_next(ait);
-		TRACE("  adjacent pairing %4d (%4d,%7d,%4d)...", w->id, PAIRING(w));
-		if ((! BV_get(out_star_v, w->id)) ||
+	 closure_begin[i]= closures_len;
+	 append_to_closures(&closures, &closures_len, &closures_capacity, i);
+
+	 for (unsigned int k= adj_first[i]; k<adj_first[i+1]; ++k) {
+		const unsigned int y= adjs[k];
+		ppairing w= G->pairings[order[y]];
+		TRACE("  adjacent pairing %4d (%4d,%7d,%4d)...", y, PAIRING(w));
+		kept[k]= false;
+		if ((! BV_get(out_star_v, y)) ||
 			 ((w->p < v->p) || (w->t < v->t)) ||
 			 ((w->p + w->l < v->p + v->l) || (w->t + w->l < v->t + v->l))) {
 #if LOG_LEVEL_TRACE <= LOG_THRESHOLD
-		  if (!BV_get(out_star_v, w->id)) {
+		  if (!BV_get(out_star_v, y)) {
 			 TRACE("    ...NOT in the transitive closure.");
 		  } else if ((w->p < v->p) || (w->t < v->t)) {
 			 TRACE("    ...in the transitive closure BUT it starts earlier, so it will be kept.");
@@ -582,20 +519,20 @@ transitive_reduction(pgraph G) {
 					PAIRING(w), PAIRING(v));
 		  }
 #endif
-		  list_add_to_tail(outs_red[i], w);
-		  list_add_to_tail(outs_red_inc[w->id], v);
+		  kept[k]= true;
 		  if (!((w->p + w->l < v->p + v->l) || (w->t + w->l < v->t + v->l))) {
-			 list_first_reuse(outs_star[w->id], &wai);
-			 while (listit_has_next(wai)) {
-				ppairing wa= listit_next(wai);
-				if (!BV_get(out_star_v, wa->id)) {
+			 my_assert(y > i);
+			 for (size_t j= closure_begin[y]; j<closure_end[y]; ++j) {
+				const unsigned int z= closures[j];
+				ppairing wa= G->pairings[order[z]];
+				if (!BV_get(out_star_v, z)) {
 				  if ((v->t <= wa->t) && (v->p <= wa->p) &&
 						(v->t + v->l <= wa->t + wa->l) && (v->p + v->l <= wa->p + wa->l)) {
 					 TRACE("    Adding %4d (%4d,%7d,%4d) to the "
 							 "transitive closure of pairing %4zd.",
-							 wa->id, PAIRING(wa), i);
-					 BV_set(out_star_v, wa->id, true);
-					 list_add_to_tail(outs_star[i], wa);
+							 z, PAIRING(wa), i);
+					 BV_set(out_star_v, z, true);
+					 append_to_closures(&closures, &closures_len, &closures_capacity, z);
 				  } else {
 					 WARN("Edge (%4d,%7d,%4d) -> (%4d,%7d,%4d) "
 							"not added to transitive closure because of "
@@ -613,20 +550,27 @@ transitive_reduction(pgraph G) {
 		  ++removed_edges;
 		}
 	 }
+	 closure_end[i]= closures_len;
   }
   BV_destroy(out_star_v);
-  listit_destroy(ait);
-  listit_destroy(wai);
-  for (size_t i= 0; i<nv; ++i) {
-	 list_destroy(outs_star[i], (delete_function)noop_free);
-	 ppairing v= EA_get(G, i);
-	 list_destroy(v->adjs, (delete_function)noop_free);
-	 list_destroy(v->incs, (delete_function)noop_free);
-	 v->adjs= outs_red[i];
-	 v->incs= outs_red_inc[i];
+  free(closures);
+  pfree(closure_begin);
+  pfree(closure_end);
+// Replace the edges with the kept ones. The adjacents of each vertex are
+// sorted by topological position, its incidents by decreasing position.
+  csr_meg_clear_edges(G);
+  for (size_t i= nv; i>=1;) {
+	 --i;
+	 for (unsigned int k= adj_first[i]; k<adj_first[i+1]; ++k) {
+		if (kept[k]) {
+		  csr_meg_add_edge(G, order[i], order[adjs[k]]);
+		}
+	 }
   }
-  pfree(outs_star);
-  pfree(outs_red);
-  pfree(outs_red_inc);
+  csr_meg_pack(G, NULL);
+  pfree(kept);
+  pfree(adjs);
+  pfree(adj_first);
+  pfree(order);
   INFO("Transitive reduction terminated. Removed %4zd edges.", removed_edges);
 }
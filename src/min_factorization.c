@@ -30,8 +30,10 @@
 #include "min_factorization.h"
 #include "color_matrix.h"
 #include "list.h"
+#include "my_time.h"
 #include <assert.h>
 #include <stdint.h>
+#include <string.h>
 
 static bool
 evaluate_list(pbit_vect comb, plist p)
@@ -322,67 +324,188 @@ compute_coverage_and_exons(pfactorization pfact,
 }
 
 
+// See issue #7
+// Return the index (from 1) of the factorization of est to be kept, i.e.
+// the one with maximum coverage (and then minimum number of exons) among
+// those using only the factors of the optimum (0 if no such factorization)
+static size_t
+best_factorization_of(pEST est, psimpl psimp)
+{
+  pfactorization pfact;
+  plistit list_it_bin, list_it_fact;
+  pbit_vect bv;
+
+  size_t best_factorization= 0;
+  size_t best_coverage= 0;
+  size_t best_n_exons= SIZE_MAX;
+  size_t current_factorization= 0;
+
+  list_it_bin= list_first(est->bin_factorizations);
+  list_it_fact= list_first(est->factorizations);
+
+  while (listit_has_next(list_it_bin)){
+	 my_assert(listit_has_next(list_it_fact));
+
+	 current_factorization= current_factorization+1;
+
+	 bv= listit_next(list_it_bin);
+	 pfact= listit_next(list_it_fact);
+	 if (BV_contained(bv, psimp->factors_used)){
+		size_t current_coverage= 0;
+		size_t current_n_exons= SIZE_MAX;
+		compute_coverage_and_exons(pfact, &current_coverage, &current_n_exons);
+		if ((best_coverage < current_coverage) ||
+			 ((best_coverage == current_coverage) &&
+			  (best_n_exons > current_n_exons))) {
+		  DEBUG("Found a better factorization. Currently: coverage %zunt, no. of exons %zu.",
+				  current_coverage, current_n_exons);
+		  best_coverage= current_coverage;
+		  best_n_exons= current_n_exons;
+		  best_factorization= current_factorization;
+		}
+	 }
+  }
+  listit_destroy(list_it_bin);
+  listit_destroy(list_it_fact);
+
+  INFO("Saving factorization %zu (coverage: %zunt, no. of exons: %zu) for EST '%s'",
+		 best_factorization, best_coverage, best_n_exons, est->info->EST_id);
+  return best_factorization;
+}
+
 // See issue #7
 void print_factorizations_result(pbit_vect min_factors, plist p,
 											plist list_of_unique_fact, psimpl psimp)
 {
-  pfactorization pfact;
-  plistit list_it_est, list_it_bin, list_it_fact;
+  plistit list_it_est;
   pEST est;
-  pbit_vect bv;
-  int count_est;
 
   if(min_factors!=NULL)inglobe(min_factors,psimp);
 
   list_it_est=list_first(p);
 
-  count_est=0;
   while(listit_has_next(list_it_est)){
 	 est=listit_next(list_it_est);
 
-	 size_t best_factorization= 0;
-	 size_t best_coverage= 0;
-	 size_t best_n_exons= SIZE_MAX;
-	 size_t current_factorization= 0;
-
-	 list_it_bin= list_first(est->bin_factorizations);
-	 list_it_fact= list_first(est->factorizations);
-
-	 while (listit_has_next(list_it_bin)){
-		my_assert(listit_has_next(list_it_fact));
-
-		current_factorization= current_factorization+1;
-
-		bv= listit_next(list_it_bin);
-		pfact= listit_next(list_it_fact);
-		if (BV_contained(bv, psimp->factors_used)){
-		  size_t current_coverage= 0;
-		  size_t current_n_exons= SIZE_MAX;
-		  compute_coverage_and_exons(pfact, &current_coverage, &current_n_exons);
-		  if ((best_coverage < current_coverage) ||
-				((best_coverage == current_coverage) &&
-				 (best_n_exons > current_n_exons))) {
-			 DEBUG("Found a better factorization. Currently: coverage %zunt, no. of exons %zu.",
-					 current_coverage, current_n_exons);
-			 best_coverage= current_coverage;
-			 best_n_exons= current_n_exons;
-			 best_factorization= current_factorization;
-		  }
-		}
-	 }
-	 listit_destroy(list_it_bin);
-	 listit_destroy(list_it_fact);
+	 const size_t best_factorization= best_factorization_of(est, psimp);
 
 // Print the "best" factorization of the current EST
-	 INFO("Saving factorization %zu (coverage: %zunt, no. of exons: %zu) for EST '%s'",
-			best_factorization, best_coverage, best_n_exons, est->info->EST_id);
 	 printf(">%s\n",est->info->EST_id);
 	 print_n_factorization_complete(est, best_factorization);
-	 count_est++;
   }
   listit_destroy(list_it_est);
 }
 
+plist get_factorizations_result(pbit_vect min_factors, plist p,
+										  plist list_of_unique_fact, psimpl psimp)
+{
+  plistit list_it_est;
+  pEST est;
+
+  if(min_factors!=NULL)inglobe(min_factors,psimp);
+
+  plist result= list_create();
+  list_it_est=list_first(p);
+
+  while(listit_has_next(list_it_est)){
+	 est=listit_next(list_it_est);
+
+	 const size_t best_factorization= best_factorization_of(est, psimp);
+
+	 pEST best= EST_create();
+	 best->info= EST_info_create();
+	 best->info->EST_id= alloc_and_copy(est->info->EST_id);
+	 best->factorizations= list_create();
+	 best->polyA_signals= boollist_create();
+	 best->polyadenil_signals= boollist_create();
+
+	 pfactorization best_fact= list_create();
+	 bool polya= false;
+	 bool polyadenil= false;
+	 if (best_factorization > 0) {
+		pfactorization pfact= NULL;
+		plistit plist_it_factorizations= list_first(est->factorizations);
+		pboollistit pboollist_it_polya= boollist_first(est->polyA_signals);
+		pboollistit pboollist_it_polyadenil= boollist_first(est->polyadenil_signals);
+		for (size_t i= 0; i < best_factorization; ++i) {
+		  pfact= listit_next(plist_it_factorizations);
+		  polya= (bool)boollistit_next(pboollist_it_polya);
+		  polyadenil= (bool)boollistit_next(pboollist_it_polyadenil);
+		}
+		listit_destroy(plist_it_factorizations);
+		boollistit_destroy(pboollist_it_polya);
+		boollistit_destroy(pboollist_it_polyadenil);
+		plistit plist_it_factor= list_first(pfact);
+		while(listit_has_next(plist_it_factor)) {
+		  pfactor pf= listit_next(plist_it_factor);
+		  pfactor copy= factor_create();
+		  copy->EST_start= pf->EST_start;
+		  copy->EST_end= pf->EST_end;
+		  copy->GEN_start= pf->GEN_start;
+		  copy->GEN_end= pf->GEN_end;
+		  list_add_to_tail(best_fact, copy);
+		}
+		listit_destroy(plist_it_factor);
+	 }
+	 list_add_to_tail(best->factorizations, best_fact);
+	 boollist_add_to_tail(best->polyA_signals, polya);
+	 boollist_add_to_tail(best->polyadenil_signals, polyadenil);
+	 list_add_to_tail(result, best);
+  }
+  listit_destroy(list_it_est);
+  return result;
+}
+
+pbit_vect compute_min_factorization(plist p, plist* punique_factors, psimpl* ppsimp,
+												const unsigned int max_search_time)
+{
+  NOT_NULL(p);
+
+  INFO("Colored matrix creation...");
+ //Colorazione della matrice sulla base delle finestre di contenimento degli esoni
+  const bool is_not_window= false;
+  plist unique_factors= color_matrix_create(p, is_not_window);
+  INFO("Colored matrix created!");
+#if defined (LOG_MSG) && (LOG_LEVEL_DEBUG <= LOG_THRESHOLD)
+  print_factors_list(unique_factors,is_not_window);
+#endif
+
+  INFO("Starting simplification");
+  psimpl psimp= simplification(p,unique_factors);
+  psimpl_print(psimp);
+
+  plist pl= color_matrix_simplified_create(p,psimp);
+  INFO("Simplification terminated!");
+
+  INFO("Start search of the minimum factorization");
+  pbit_vect bv= NULL;
+  if(!BV_all_true(psimp->ests_ok)){
+	 bv= min_fact_anytime(pl, max_search_time);
+	 INFO("Search of the minimum factorization completed");
+  } else {
+	 INFO("Minimum factorization is already found by simplification.");
+  }
+  color_matrix_simplified_destroy(pl);
+
+  *punique_factors= unique_factors;
+  *ppsimp= psimp;
+  return bv;
+}
+
+plist min_factorization_agreement(plist p, const unsigned int max_search_time)
+{
+  plist unique_factors= NULL;
+  psimpl psimp= NULL;
+  pbit_vect bv= compute_min_factorization(p, &unique_factors, &psimp, max_search_time);
+  plist result= get_factorizations_result(bv, p, unique_factors, psimp);
+
+  list_destroy(unique_factors,(delete_function)factor_destroy);
+  psimpl_destroy(psimp);
+  if(bv != NULL)
+	 BV_destroy(bv);
+  return result;
+}
+
 
 void add_factorization(pbit_vect bv,plist bin_fact,psimpl psimp)
 {
@@ -403,7 +526,7 @@ void add_factorization(pbit_vect bv,plist bin_fact,psimpl psimp)
 }
 
 static void
-add_EST(pEST p,plist col_mat_simp,psimpl psimp)
+add_simplified_EST(pEST p,plist col_mat_simp,psimpl psimp)
 {
 
   plistit list_it;
@@ -445,7 +568,7 @@ plist color_matrix_simplified_create(plist ests_factorizations,psimpl psimp)
   while(listit_has_next(plist_it_id)){
 	 p= listit_next(plist_it_id);
 
-	 if(!BV_get(psimp->ests_ok,cont)){add_EST(p,col_mat_simp,psimp);}
+	 if(!BV_get(psimp->ests_ok,cont)){add_simplified_EST(p,col_mat_simp,psimp);}
 	 cont=cont+1;
   }
   listit_destroy(plist_it_id);
@@ -468,41 +591,495 @@ void color_matrix_simplified_destroy(plist p)
 }
 
 
-
 /*****************************************************************************
 *******************************************************************************/
 
-pbit_vect min_fact(plist color_matrix) {
+/*
+ * Branch-and-bound search of the minimum factorization.
+ *
+ * The factorizations of the colored matrix are stored as arrays of 64-bit
+ * words, so that the containment in a combination and the number of
+ * factors missing from it are computed with AND-NOT and popcount on whole
+ * words.
+ * The combinations of k factors are visited in the same (lexicographic)
+ * order of create_combinations, hence the solution is the same of the
+ * exhaustive search, but a partial combination is abandoned as soon as a
+ * lower bound on the factors still needed exceeds the factors that can be
+ * added to it.
+ */
+
+#define MF_WORD_BITS 64
+#define MF_NODES_BETWEEN_TIME_CHECKS 1024
+
+struct _mf_instance {
+  size_t n_factors;
+  size_t n_words;
+  size_t n_ests;
+// The factorizations of the i-th EST are first_fact[i]..first_fact[i+1]-1
+  size_t* first_fact;
+// n_words words for each factorization
+  uint64_t* facts;
+};
+
+struct _mf_search {
+  const struct _mf_instance* inst;
+// The current (partial) combination
+  uint64_t* chosen;
+// For each level, the factors that can complete the combination
+  uint64_t* useful;
+// For each EST, the factors missing from its compatible factorizations
+  uint64_t* support;
+  size_t* need;
+  uint64_t* covered;
+// true iff no combination with fewer factors is a solution
+  bool minimum_size;
+  pmytime_timeout timeout;
+  unsigned long nodes;
+  bool expired;
+};
+
+static inline const uint64_t*
+mf_fact(const struct _mf_instance* const inst, const size_t f)
+{
+  return inst->facts + f*inst->n_words;
+}
 
-  NOT_NULL(color_matrix);
+static inline bool
+mf_is_subset(const uint64_t* const a, const uint64_t* const b, const size_t nw)
+{
+  for (size_t w= 0; w<nw; ++w)
+	 if ((a[w] & ~b[w]) != 0)
+		return false;
+  return true;
+}
 
-  bool factorized=false;
+static inline size_t
+mf_count_missing(const uint64_t* const a, const uint64_t* const b, const size_t nw)
+{
+  size_t c= 0;
+  for (size_t w= 0; w<nw; ++w)
+	 c+= (size_t)__builtin_popcountll(a[w] & ~b[w]);
+  return c;
+}
 
-  pEST e=list_head(color_matrix);
-  pbit_vect bv=list_head(e->bin_factorizations);
+// The bits of word w corresponding to the positions lower than pos
+static inline uint64_t
+mf_mask_below(const size_t w, const size_t pos)
+{
+  if ((w+1)*MF_WORD_BITS <= pos)
+	 return ~(uint64_t)0;
+  if (w*MF_WORD_BITS >= pos)
+	 return 0;
+  return (((uint64_t)1) << (pos%MF_WORD_BITS)) - 1;
+}
+
+// true iff every EST of est_a contains a factorization of est_b
+// (i.e. any combination that factorizes a also factorizes b)
+static bool
+mf_est_implies(const struct _mf_instance* const inst,
+					const size_t* const first, const size_t est_a, const size_t est_b)
+{
+  for (size_t fa= first[est_a]; fa<first[est_a+1]; ++fa) {
+	 bool found= false;
+	 for (size_t fb= first[est_b]; !found && fb<first[est_b+1]; ++fb)
+		found= mf_is_subset(mf_fact(inst, fb), mf_fact(inst, fa), inst->n_words);
+	 if (!found)
+		return false;
+  }
+  return true;
+}
 
-  pbit_vect test=BV_create(bv->n);
+/*
+ * Build the instance from the colored matrix, removing the dominated
+ * factorizations (supersets of another factorization of the same EST) and
+ * the dominated ESTs (factorized by every combination that factorizes
+ * another EST). The removals do not change the set of the solutions.
+ */
+static struct _mf_instance*
+mf_instance_create(plist color_matrix, const size_t n_factors)
+{
+  struct _mf_instance* inst= PALLOC(struct _mf_instance);
+  inst->n_factors= n_factors;
+  inst->n_words= (n_factors+MF_WORD_BITS-1)/MF_WORD_BITS;
+  const size_t nw= inst->n_words;
+
+  size_t tot_facts= 0;
+  const size_t tot_ests= list_size(color_matrix);
+  plistit list_it_est= list_first(color_matrix);
+  while (listit_has_next(list_it_est)) {
+	 pEST est= listit_next(list_it_est);
+	 tot_facts+= list_size(est->bin_factorizations);
+  }
+  listit_destroy(list_it_est);
 
-  size_t start= max_of_min(color_matrix);
+  inst->facts= NPALLOC(uint64_t, tot_facts*nw+1);
+  memset(inst->facts, 0, (tot_facts*nw+1)*sizeof(uint64_t));
+  size_t* first= NPALLOC(size_t, tot_ests+1);
+
+// Conversion of the factorizations and removal of the dominated ones
+  size_t n_facts= 0;
+  size_t n_ests= 0;
+  list_it_est= list_first(color_matrix);
+  while (listit_has_next(list_it_est)) {
+	 pEST est= listit_next(list_it_est);
+	 first[n_ests]= n_facts;
+	 plistit list_it_fact= list_first(est->bin_factorizations);
+	 while (listit_has_next(list_it_fact)) {
+		pbit_vect bv= listit_next(list_it_fact);
+		my_assert(bv->n == n_factors);
+		uint64_t* const f= inst->facts + n_facts*nw;
+		memset(f, 0, nw*sizeof(uint64_t));
+		for (size_t i= 0; i<n_factors; ++i)
+		  if (BV_get(bv, i))
+			 f[i/MF_WORD_BITS] |= ((uint64_t)1) << (i%MF_WORD_BITS);
+		bool dominated= false;
+		for (size_t g= first[n_ests]; !dominated && g<n_facts; ++g)
+		  dominated= mf_is_subset(mf_fact(inst, g), f, nw);
+		if (!dominated) {
+		  size_t kept= first[n_ests];
+		  for (size_t g= first[n_ests]; g<n_facts; ++g) {
+			 if (!mf_is_subset(f, mf_fact(inst, g), nw)) {
+				if (kept != g)
+				  memcpy(inst->facts + kept*nw, mf_fact(inst, g), nw*sizeof(uint64_t));
+				++kept;
+			 }
+		  }
+		  if (kept != n_facts)
+			 memcpy(inst->facts + kept*nw, f, nw*sizeof(uint64_t));
+		  n_facts= kept+1;
+		}
+	 }
+	 listit_destroy(list_it_fact);
+	 if (n_facts > first[n_ests]) {
+		++n_ests;
+	 } else {
+		WARN("EST '%s' has no factorization. It is not considered by the "
+			  "search of the minimum factorization.", est->info->EST_id);
+	 }
+  }
+  listit_destroy(list_it_est);
+  first[n_ests]= n_facts;
+
+// Removal of the dominated ESTs
+  bool* dropped= NPALLOC(bool, n_ests+1);
+  for (size_t b= 0; b<n_ests; ++b)
+	 dropped[b]= false;
+  for (size_t b= 0; b<n_ests; ++b) {
+	 for (size_t a= 0; !dropped[b] && a<n_ests; ++a) {
+		if ((a != b) && !dropped[a] && mf_est_implies(inst, first, a, b) &&
+			 ((a < b) || !mf_est_implies(inst, first, b, a)))
+		  dropped[b]= true;
+	 }
+  }
+  inst->first_fact= NPALLOC(size_t, n_ests+1);
+  inst->n_ests= 0;
+  size_t n_kept_facts= 0;
+  for (size_t e= 0; e<n_ests; ++e) {
+	 if (dropped[e])
+		continue;
+	 inst->first_fact[inst->n_ests]= n_kept_facts;
+	 for (size_t f= first[e]; f<first[e+1]; ++f, ++n_kept_facts)
+		if (n_kept_facts != f)
+		  memcpy(inst->facts + n_kept_facts*nw, mf_fact(inst, f), nw*sizeof(uint64_t));
+	 ++inst->n_ests;
+  }
+  inst->first_fact[inst->n_ests]= n_kept_facts;
+  pfree(dropped);
+  pfree(first);
+
+  INFO("Search on %zu factors, %zu ESTs and %zu factorizations "
+		 "(%zu ESTs and %zu factorizations before the dominance pruning).",
+		 n_factors, inst->n_ests, n_kept_facts, tot_ests, tot_facts);
+  return inst;
+}
 
-  INFO("Starting search of an optimal solution...");
-  while (!factorized) {
+static void
+mf_instance_destroy(struct _mf_instance* inst)
+{
+  pfree(inst->first_fact);
+  pfree(inst->facts);
+  pfree(inst);
+}
 
-	 INFO("Trying with %zu factors...", start);
-	 factorized=create_combinations(0,start,test,color_matrix);
-	 if (factorized) {
-		INFO("A solution with %zu factors has been found!", start);
+static bool
+mf_is_solution(const struct _mf_instance* const inst, const uint64_t* const comb)
+{
+  for (size_t e= 0; e<inst->n_ests; ++e) {
+	 bool factorized= false;
+	 for (size_t f= inst->first_fact[e]; !factorized && f<inst->first_fact[e+1]; ++f)
+		factorized= mf_is_subset(mf_fact(inst, f), comb, inst->n_words);
+	 if (!factorized)
+		return false;
+  }
+  return true;
+}
+
+/*
+ * Greedy solution: add the factorization with the fewest missing factors
+ * until every EST is factorized, then remove the redundant factors.
+ * Return the number of factors of the solution.
+ */
+static size_t
+mf_greedy_solution(const struct _mf_instance* const inst, uint64_t* const comb)
+{
+  const size_t nw= inst->n_words;
+  memset(comb, 0, nw*sizeof(uint64_t));
+  while (true) {
+	 size_t best_fact= 0;
+	 size_t best_missing= SIZE_MAX;
+	 for (size_t e= 0; e<inst->n_ests; ++e) {
+		size_t est_fact= 0;
+		size_t est_missing= SIZE_MAX;
+		for (size_t f= inst->first_fact[e]; est_missing>0 && f<inst->first_fact[e+1]; ++f) {
+		  const size_t missing= mf_count_missing(mf_fact(inst, f), comb, nw);
+		  if (missing < est_missing) {
+			 est_missing= missing;
+			 est_fact= f;
+		  }
+		}
+		if ((est_missing > 0) && (est_missing < best_missing)) {
+		  best_missing= est_missing;
+		  best_fact= est_fact;
+		}
 	 }
-	 start=start+1;
+	 if (best_missing == SIZE_MAX)
+		break;
+	 const uint64_t* const f= mf_fact(inst, best_fact);
+	 for (size_t w= 0; w<nw; ++w)
+		comb[w] |= f[w];
   }
-  INFO("Search of an optimal solution terminated!");
-  return test;
+  size_t n_chosen= 0;
+  for (size_t i= inst->n_factors; i>0; --i) {
+	 const uint64_t bit= ((uint64_t)1) << ((i-1)%MF_WORD_BITS);
+	 if ((comb[(i-1)/MF_WORD_BITS] & bit) != 0) {
+		comb[(i-1)/MF_WORD_BITS] &= ~bit;
+		if (!mf_is_solution(inst, comb)) {
+		  comb[(i-1)/MF_WORD_BITS] |= bit;
+		  ++n_chosen;
+		}
+	 }
+  }
+  return n_chosen;
 }
 
+/*
+ * Search a combination of r more factors among those starting from 'start'
+ * which completes the current combination.
+ * For each EST, only the factorizations whose factors lower than start are
+ * already chosen (the compatible ones) can be used. The number of missing
+ * factors of an EST is the minimum over its compatible factorizations;
+ * the lower bound is the maximum of such numbers or the sum over ESTs whose
+ * missing factors are disjoint.
+ * Moreover, the next factor of the solution cannot be greater than the
+ * first missing factor of every compatible factorization of an EST, and,
+ * if no smaller combination is a solution, a factor that is not missing
+ * from any compatible factorization cannot be part of the combination.
+ */
+static bool
+mf_search(struct _mf_search* const s, const size_t start, const size_t r,
+			 const size_t level)
+{
+  if (s->expired)
+	 return false;
+  if ((s->timeout != NULL) &&
+		((++s->nodes % MF_NODES_BETWEEN_TIME_CHECKS) == 0) &&
+		MYTIME_timeout_expired(s->timeout)) {
+	 s->expired= true;
+	 return false;
+  }
 
+  const struct _mf_instance* const inst= s->inst;
+  const size_t nw= inst->n_words;
+  uint64_t* const chosen= s->chosen;
+  uint64_t* const useful= s->useful + level*nw;
+  memset(useful, 0, nw*sizeof(uint64_t));
+
+  size_t max_need= 0;
+  size_t max_need_est= 0;
+  size_t last_next= inst->n_factors;
+  for (size_t e= 0; e<inst->n_ests; ++e) {
+	 uint64_t* const support= s->support + e*nw;
+	 memset(support, 0, nw*sizeof(uint64_t));
+	 size_t need= SIZE_MAX;
+	 size_t max_first_missing= 0;
+	 for (size_t f= inst->first_fact[e]; need>0 && f<inst->first_fact[e+1]; ++f) {
+		const uint64_t* const fact= mf_fact(inst, f);
+		bool compatible= true;
+		for (size_t w= 0; compatible && w<nw; ++w)
+		  compatible= (fact[w] & ~chosen[w] & mf_mask_below(w, start)) == 0;
+		if (!compatible)
+		  continue;
+		size_t missing= 0;
+		size_t first_missing= SIZE_MAX;
+		for (size_t w= 0; w<nw; ++w) {
+		  const uint64_t m= fact[w] & ~chosen[w];
+		  if (m != 0) {
+			 if (first_missing == SIZE_MAX)
+				first_missing= w*MF_WORD_BITS + (size_t)__builtin_ctzll(m);
+			 missing+= (size_t)__builtin_popcountll(m);
+			 support[w] |= m;
+		  }
+		}
+		if (missing < need)
+		  need= missing;
+		if ((missing > 0) && (first_missing > max_first_missing))
+		  max_first_missing= first_missing;
+	 }
+	 if (need == SIZE_MAX)
+		return false;
+	 s->need[e]= need;
+	 if (need > 0) {
+		for (size_t w= 0; w<nw; ++w)
+		  useful[w] |= support[w];
+		if (max_first_missing < last_next)
+		  last_next= max_first_missing;
+		if (need > max_need) {
+		  max_need= need;
+		  max_need_est= e;
+		}
+	 }
+  }
 
+// Every EST is factorized: as the exhaustive search, complete the
+// combination with the first available factors
+  if (max_need == 0) {
+	 if (inst->n_factors - start < r)
+		return false;
+	 for (size_t i= start; i<start+r; ++i)
+		chosen[i/MF_WORD_BITS] |= ((uint64_t)1) << (i%MF_WORD_BITS);
+	 return true;
+  }
+  if (max_need > r)
+	 return false;
+
+  size_t lower_bound= max_need;
+  memcpy(s->covered, s->support + max_need_est*nw, nw*sizeof(uint64_t));
+  for (size_t e= 0; e<inst->n_ests && lower_bound<=r; ++e) {
+	 if ((e == max_need_est) || (s->need[e] == 0))
+		continue;
+	 const uint64_t* const support= s->support + e*nw;
+	 bool disjoint= true;
+	 for (size_t w= 0; disjoint && w<nw; ++w)
+		disjoint= (support[w] & s->covered[w]) == 0;
+	 if (disjoint) {
+		lower_bound+= s->need[e];
+		for (size_t w= 0; w<nw; ++w)
+		  s->covered[w] |= support[w];
+	 }
+  }
+  if (lower_bound > r)
+	 return false;
+
+  for (size_t i= start; i<=last_next && inst->n_factors-i >= r; ++i) {
+	 const uint64_t bit= ((uint64_t)1) << (i%MF_WORD_BITS);
+	 if (s->minimum_size && ((useful[i/MF_WORD_BITS] & bit) == 0))
+		continue;
+	 chosen[i/MF_WORD_BITS] |= bit;
+	 if (mf_search(s, i+1, r-1, level+1))
+		return true;
+	 chosen[i/MF_WORD_BITS] &= ~bit;
+	 if (s->expired)
+		return false;
+  }
+  return false;
+}
 
+// Search of the minimum solution, interrupted when timeout (if not NULL)
+// expires. max_search_time is only logged.
+static pbit_vect
+mf_anytime_search(plist color_matrix, pmytime_timeout timeout,
+						const unsigned int max_search_time) {
 
+  NOT_NULL(color_matrix);
+
+  pEST e=list_head(color_matrix);
+  pbit_vect bv=list_head(e->bin_factorizations);
+  const size_t n_factors= bv->n;
+
+  struct _mf_instance* inst= mf_instance_create(color_matrix, n_factors);
+  const size_t nw= inst->n_words;
+  uint64_t* best= NPALLOC(uint64_t, nw+1);
+  const size_t greedy_size= mf_greedy_solution(inst, best);
+  INFO("The greedy solution has %zu factors.", greedy_size);
+
+  struct _mf_search s;
+  s.inst= inst;
+  s.chosen= NPALLOC(uint64_t, nw+1);
+  s.useful= NPALLOC(uint64_t, (n_factors+2)*nw+1);
+  s.support= NPALLOC(uint64_t, inst->n_ests*nw+1);
+  s.need= NPALLOC(size_t, inst->n_ests+1);
+  s.covered= NPALLOC(uint64_t, nw+1);
+  s.timeout= timeout;
+  s.nodes= 0;
+  s.expired= false;
+
+// As the exhaustive search, start from max_of_min and choose at least one
+// factor. max_of_min could exceed the size of the minimum solution if some
+// factorization is empty, hence we check that no smaller combination exists.
+  size_t k= max_of_min(color_matrix);
+  if (k == 0)
+	 k= 1;
+  memset(s.chosen, 0, nw*sizeof(uint64_t));
+  size_t min_size= 0;
+  for (size_t est= 0; est<inst->n_ests; ++est) {
+	 size_t min_est= SIZE_MAX;
+	 for (size_t f= inst->first_fact[est]; f<inst->first_fact[est+1]; ++f) {
+		const size_t size= mf_count_missing(mf_fact(inst, f), s.chosen, nw);
+		if (size < min_est)
+		  min_est= size;
+	 }
+	 if (min_est > min_size)
+		min_size= min_est;
+  }
+  s.minimum_size= (k <= min_size);
+  bool factorized= false;
+  INFO("Starting search of an optimal solution...");
+  while (!factorized && !s.expired && k <= n_factors) {
+	 if ((s.timeout != NULL) && MYTIME_timeout_expired(s.timeout)) {
+		s.expired= true;
+		break;
+	 }
+	 INFO("Trying with %zu factors...", k);
+	 memset(s.chosen, 0, nw*sizeof(uint64_t));
+	 factorized= mf_search(&s, 0, k, 0);
+	 if (factorized) {
+		INFO("A solution with %zu factors has been found!", k);
+		memcpy(best, s.chosen, nw*sizeof(uint64_t));
+	 } else if (!s.expired) {
+		k= k+1;
+		s.minimum_size= true;
+	 }
+  }
+  if (s.expired) {
+	 WARN("The search of an optimal solution has been interrupted after %u seconds! "
+			"Using a solution with %zu factors (at least %zu are needed).",
+			max_search_time, greedy_size, s.minimum_size ? k : min_size);
+  }
+  INFO("Search of an optimal solution terminated!");
 
+  pbit_vect test=BV_create(n_factors);
+  for (size_t i= 0; i<n_factors; ++i)
+	 BV_set(test, i, (best[i/MF_WORD_BITS] >> (i%MF_WORD_BITS)) & 1);
+
+  pfree(s.covered);
+  pfree(s.need);
+  pfree(s.support);
+  pfree(s.useful);
+  pfree(s.chosen);
+  pfree(best);
+  mf_instance_destroy(inst);
+  return test;
+}
 
+pbit_vect min_fact_anytime(plist color_matrix, const unsigned int max_search_time) {
+  pmytime_timeout timeout= (max_search_time > 0) ?
+	 MYTIME_timeout_create(max_search_time) : NULL;
+  pbit_vect bv= mf_anytime_search(color_matrix, timeout, max_search_time);
+  if (timeout != NULL)
+	 MYTIME_timeout_destroy(timeout);
+  return bv;
+}
 
+pbit_vect min_fact(plist color_matrix) {
+  return min_fact_anytime(color_matrix, 0);
+}
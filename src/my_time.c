@@ -143,6 +143,14 @@ MYTIME_reset(pmytime pt)
   pt->interval= 0;
 }
 
+void
+MYTIME_add(pmytime pt, pmytime src)
+{
+  my_assert(pt!=NULL);
+  my_assert(src!=NULL);
+  pt->interval+= src->interval;
+}
+
 void
 MYTIME_stop(pmytime pt)
 {
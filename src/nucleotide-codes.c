@@ -0,0 +1,346 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010,2012  Yuri Pirola, Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+/**
+ *
+ * @file nucleotide-codes.c
+ *
+ * Constant tables of the nucleotide codes and packed sequences.
+ *
+ **/
+
+#include <string.h>
+
+#include "nucleotide-codes.h"
+#include "util.h"
+#include "log.h"
+
+const unsigned char nt_code_table[256]= {
+  ['A']= NT_A, ['a']= NT_A,
+  ['C']= NT_C, ['c']= NT_C,
+  ['G']= NT_G, ['g']= NT_G,
+  ['T']= NT_T, ['t']= NT_T,
+  ['N']= NT_N, ['n']= NT_N
+};
+
+const char nt_complement_table[256]= {
+  ['A']= 'T', ['a']= 't', ['T']= 'A', ['t']= 'a',
+  ['C']= 'G', ['c']= 'g', ['G']= 'C', ['g']= 'c',
+  ['R']= 'Y', ['r']= 'y', ['Y']= 'R', ['y']= 'r',
+  ['M']= 'K', ['m']= 'k', ['K']= 'M', ['k']= 'm',
+  ['B']= 'V', ['b']= 'v', ['V']= 'B', ['v']= 'b',
+  ['D']= 'H', ['d']= 'h', ['H']= 'D', ['h']= 'd'
+};
+
+#define DN( x, y ) ((((NT_##x)-NT_A) << 2) | ((NT_##y)-NT_A))
+
+//Frequenze dei pattern donor-acceptor secondo Burset et al.
+const int burset_frequency_table[NT_DINUCLEOTIDES][NT_DINUCLEOTIDES]= {
+  [DN(A,A)][DN(A,G)]= 1,
+  [DN(A,A)][DN(A,T)]= 1,
+  [DN(A,A)][DN(G,T)]= 1,
+  [DN(A,C)][DN(C,C)]= 1,
+  [DN(A,G)][DN(A,C)]= 1,
+  [DN(A,G)][DN(A,G)]= 5,
+  [DN(A,G)][DN(C,T)]= 2,
+  [DN(A,G)][DN(G,C)]= 1,
+  [DN(A,G)][DN(T,G)]= 2,
+  [DN(A,T)][DN(A,A)]= 1,
+  [DN(A,T)][DN(A,C)]= 8,
+  [DN(A,T)][DN(A,G)]= 7,
+  [DN(A,T)][DN(A,T)]= 2,
+  [DN(A,T)][DN(G,C)]= 1,
+  [DN(A,T)][DN(G,T)]= 1,
+  [DN(C,A)][DN(A,G)]= 1,
+  [DN(C,A)][DN(T,T)]= 1,
+  [DN(C,C)][DN(A,G)]= 2,
+  [DN(C,G)][DN(A,G)]= 1,
+  [DN(C,G)][DN(C,A)]= 1,
+  [DN(C,T)][DN(A,C)]= 2,
+  [DN(C,T)][DN(C,A)]= 1,
+  [DN(G,A)][DN(A,G)]= 8,
+  [DN(G,A)][DN(G,T)]= 1,
+  [DN(G,A)][DN(T,C)]= 1,
+  [DN(G,A)][DN(T,G)]= 1,
+  [DN(G,C)][DN(A,G)]= 126,
+  [DN(G,C)][DN(G,G)]= 1,
+  [DN(G,C)][DN(T,A)]= 1,
+  [DN(G,G)][DN(A,C)]= 1,
+  [DN(G,G)][DN(A,G)]= 11,
+  [DN(G,G)][DN(C,A)]= 1,
+  [DN(G,G)][DN(G,A)]= 2,
+  [DN(G,G)][DN(T,C)]= 2,
+  [DN(G,T)][DN(A,G)]= 200,
+  [DN(G,T)][DN(A,C)]= 4,
+  [DN(G,T)][DN(A,T)]= 2,
+  [DN(G,T)][DN(C,A)]= 9,
+  [DN(G,T)][DN(C,G)]= 4,
+  [DN(G,T)][DN(C,T)]= 3,
+  [DN(G,T)][DN(G,C)]= 1,
+  [DN(G,T)][DN(G,G)]= 10,
+  [DN(G,T)][DN(G,T)]= 1,
+  [DN(G,T)][DN(T,A)]= 7,
+  [DN(G,T)][DN(T,C)]= 2,
+  [DN(G,T)][DN(T,G)]= 8,
+  [DN(G,T)][DN(T,T)]= 2,
+  [DN(T,A)][DN(A,G)]= 6,
+  [DN(T,A)][DN(C,G)]= 1,
+  [DN(T,A)][DN(T,C)]= 1,
+  [DN(T,C)][DN(A,G)]= 1,
+  [DN(T,C)][DN(G,G)]= 1,
+  [DN(T,G)][DN(A,C)]= 1,
+  [DN(T,G)][DN(A,G)]= 7,
+  [DN(T,G)][DN(G,G)]= 2,
+  [DN(T,T)][DN(A,G)]= 5,
+  [DN(T,T)][DN(A,T)]= 1,
+  [DN(T,T)][DN(G,G)]= 1,
+};
+
+#undef DN
+
+
+/*
+ * Packed sequences
+ */
+
+#define NT_PER_WORD 32
+
+static inline bool
+is_lower(const char c) {
+  return (c >= 'a') && (c <= 'z');
+}
+
+// Number of runs of the symbols of seq[0..len) that satisfy pred
+static size_t
+count_runs(const char* const seq, const size_t len, bool (*pred)(const char)) {
+  size_t n_runs= 0;
+  bool in_run= false;
+  for (size_t i= 0; i < len; ++i) {
+	 const bool sat= pred(seq[i]);
+	 if (sat && !in_run)
+		++n_runs;
+	 in_run= sat;
+  }
+  return n_runs;
+}
+
+// Store in runs the runs of the symbols of seq[0..len) that satisfy pred
+static void
+fill_runs(const char* const seq, const size_t len, bool (*pred)(const char),
+			 struct _nt_run* const runs) {
+  size_t r= 0;
+  bool in_run= false;
+  for (size_t i= 0; i < len; ++i) {
+	 const bool sat= pred(seq[i]);
+	 if (sat && !in_run) {
+		runs[r].start= i;
+	 } else if (!sat && in_run) {
+		runs[r].end= i;
+		++r;
+	 }
+	 in_run= sat;
+  }
+  if (in_run) {
+	 runs[r].end= len;
+  }
+}
+
+static bool
+is_N_symbol(const char c) {
+  return nt_code(c) == NT_N;
+}
+
+static bool
+is_lower_symbol(const char c) {
+  return is_lower(c);
+}
+
+ppacked_seq
+packed_seq_create(const char* const seq) {
+  my_assert(seq != NULL);
+  ppacked_seq pseq= PALLOC(struct _packed_seq);
+  const size_t len= strlen(seq);
+  pseq->length= len;
+  const size_t n_words= (len+NT_PER_WORD-1)/NT_PER_WORD;
+  pseq->codes= NPALLOC(uint64_t, (n_words > 0) ? n_words : 1);
+  memset(pseq->codes, 0, ((n_words > 0) ? n_words : 1)*sizeof(uint64_t));
+
+  size_t n_exceptions= 0;
+  for (size_t i= 0; i < len; ++i) {
+	 const unsigned int code= nt_code(seq[i]);
+	 if (nt_is_acgt(code)) {
+		pseq->codes[i/NT_PER_WORD] |=
+		  ((uint64_t)(code-NT_A)) << (2*(i%NT_PER_WORD));
+	 } else if (code != NT_N) {
+		++n_exceptions;
+	 }
+  }
+
+  pseq->n_N_runs= count_runs(seq, len, is_N_symbol);
+  pseq->N_runs= NPALLOC(struct _nt_run, pseq->n_N_runs+1);
+  fill_runs(seq, len, is_N_symbol, pseq->N_runs);
+
+  pseq->n_lower_runs= count_runs(seq, len, is_lower_symbol);
+  pseq->lower_runs= NPALLOC(struct _nt_run, pseq->n_lower_runs+1);
+  fill_runs(seq, len, is_lower_symbol, pseq->lower_runs);
+
+  pseq->n_exceptions= n_exceptions;
+  pseq->exceptions= NPALLOC(struct _nt_exception, n_exceptions+1);
+  for (size_t i= 0, e= 0; i < len; ++i) {
+	 const unsigned int code= nt_code(seq[i]);
+	 if (!nt_is_acgt(code) && (code != NT_N)) {
+		pseq->exceptions[e].pos= i;
+		pseq->exceptions[e].symbol= seq[i];
+		++e;
+	 }
+  }
+  return pseq;
+}
+
+void
+packed_seq_destroy(ppacked_seq pseq) {
+  my_assert(pseq != NULL);
+  pfree(pseq->codes);
+  pfree(pseq->N_runs);
+  pfree(pseq->lower_runs);
+  pfree(pseq->exceptions);
+  pfree(pseq);
+}
+
+size_t
+packed_seq_size(const ppacked_seq pseq) {
+  my_assert(pseq != NULL);
+  return sizeof(struct _packed_seq)+
+	 ((pseq->length+NT_PER_WORD-1)/NT_PER_WORD)*sizeof(uint64_t)+
+	 (pseq->n_N_runs+pseq->n_lower_runs)*sizeof(struct _nt_run)+
+	 pseq->n_exceptions*sizeof(struct _nt_exception);
+}
+
+// Index of the first run that ends after pos (n_runs if it does not exist)
+static size_t
+first_run_after(const struct _nt_run* const runs, const size_t n_runs,
+					 const size_t pos) {
+  size_t lo= 0, hi= n_runs;
+  while (lo < hi) {
+	 const size_t mid= lo+(hi-lo)/2;
+	 if (runs[mid].end <= pos) {
+		lo= mid+1;
+	 } else {
+		hi= mid;
+	 }
+  }
+  return lo;
+}
+
+static bool
+in_runs(const struct _nt_run* const runs, const size_t n_runs,
+		  const size_t pos) {
+  const size_t r= first_run_after(runs, n_runs, pos);
+  return (r < n_runs) && (runs[r].start <= pos);
+}
+
+// Index of the first exception in a position not less than pos
+static size_t
+first_exception_from(const ppacked_seq pseq, const size_t pos) {
+  size_t lo= 0, hi= pseq->n_exceptions;
+  while (lo < hi) {
+	 const size_t mid= lo+(hi-lo)/2;
+	 if (pseq->exceptions[mid].pos < pos) {
+		lo= mid+1;
+	 } else {
+		hi= mid;
+	 }
+  }
+  return lo;
+}
+
+static const char nt_symbols[4]= { 'A', 'C', 'G', 'T' };
+
+char
+packed_seq_get(const ppacked_seq pseq, const size_t pos) {
+  my_assert(pseq != NULL);
+  my_assert(pos < pseq->length);
+  const size_t e= first_exception_from(pseq, pos);
+  if ((e < pseq->n_exceptions) && (pseq->exceptions[e].pos == pos))
+	 return pseq->exceptions[e].symbol;
+  char c= in_runs(pseq->N_runs, pseq->n_N_runs, pos) ?
+	 'N' :
+	 nt_symbols[(pseq->codes[pos/NT_PER_WORD] >> (2*(pos%NT_PER_WORD))) & 3];
+  if (in_runs(pseq->lower_runs, pseq->n_lower_runs, pos))
+	 c= c-'A'+'a';
+  return c;
+}
+
+// Apply the runs to dest, which holds the symbols [start, end), replacing
+// them by N or by their lowercase
+static void
+apply_runs(const struct _nt_run* const runs, const size_t n_runs,
+			  const size_t start, const size_t end, char* const dest,
+			  const bool to_lower) {
+  for (size_t r= first_run_after(runs, n_runs, start);
+		 (r < n_runs) && (runs[r].start < end);
+		 ++r) {
+	 const size_t b= (runs[r].start > start) ? runs[r].start : start;
+	 const size_t e= (runs[r].end < end) ? runs[r].end : end;
+	 for (size_t i= b; i < e; ++i) {
+		dest[i-start]= to_lower ? (char)(dest[i-start]-'A'+'a') : 'N';
+	 }
+  }
+}
+
+void
+packed_seq_unpack_range(const ppacked_seq pseq, const size_t start,
+								const size_t len, char* const dest) {
+  my_assert(pseq != NULL);
+  my_assert(dest != NULL);
+  my_assert(start+len <= pseq->length);
+  const size_t end= start+len;
+  for (size_t i= start; i < end; ++i) {
+	 dest[i-start]=
+		nt_symbols[(pseq->codes[i/NT_PER_WORD] >> (2*(i%NT_PER_WORD))) & 3];
+  }
+  apply_runs(pseq->N_runs, pseq->n_N_runs, start, end, dest, false);
+  apply_runs(pseq->lower_runs, pseq->n_lower_runs, start, end, dest, true);
+  for (size_t e= first_exception_from(pseq, start);
+		 (e < pseq->n_exceptions) && (pseq->exceptions[e].pos < end);
+		 ++e) {
+	 dest[pseq->exceptions[e].pos-start]= pseq->exceptions[e].symbol;
+  }
+  dest[len]= '\0';
+}
+
+char*
+packed_seq_unpack(const ppacked_seq pseq) {
+  my_assert(pseq != NULL);
+  char* seq= NPALLOC(char, pseq->length+1);
+  packed_seq_unpack_range(pseq, 0, pseq->length, seq);
+  return seq;
+}
+
+#undef NT_PER_WORD
@@ -0,0 +1,297 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010,2012  Yuri Pirola, Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+/**
+ *
+ * @file parallel-est-fact.c
+ *
+ * Multi-threaded factorization of a set of transcripts based on a
+ * work-stealing scheduler.
+ *
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "util.h"
+#include "list.h"
+#include "log.h"
+
+#include "io-multifasta.h"
+#include "compute-est-fact.h"
+#include "parallel-est-fact.h"
+
+// Output files produced for each transcript
+enum {
+  OUT_MEG= 0,
+  OUT_PMEG,
+  OUT_TMEG,
+  OUT_INTRONIC,
+  OUT_MULTIF,
+  OUT_EST_MULTIF,
+  N_OUTPUTS
+};
+
+// A transcript (with its reverse and complement, if any) and its
+// buffered output
+struct _transcript_job {
+  pEST_info est;
+  pEST_info rev_est;
+  char* buff[N_OUTPUTS];
+  size_t len[N_OUTPUTS];
+// Factorizations and sequences collected in memory (if requested)
+  plist fact_ests;
+  plist fact_infos;
+  bool completed;
+};
+
+// The jobs owned by a worker. The owner takes jobs from the front,
+// the other workers steal them from the back.
+struct _job_deque {
+  pthread_mutex_t lock;
+  size_t* jobs;
+  size_t first;
+  size_t last;
+};
+
+struct _scheduler {
+  struct _transcript_job* jobs;
+  size_t n_jobs;
+  struct _job_deque* deques;
+  unsigned int n_workers;
+  pthread_mutex_t completed_lock;
+  pthread_cond_t completed_cond;
+// Shared (read-only) data
+  pEST_info gen;
+  pgen_index idx;
+  ppreproc_gen pg;
+  FILE* floginfoext;
+  pconfiguration config;
+};
+
+struct _worker {
+  struct _scheduler* sched;
+  unsigned int id;
+  pthread_t thread;
+  pmytime pt_alg;
+  pmytime pt_comp;
+  pmytime pt_io;
+};
+
+
+static bool
+take_job(struct _scheduler* sched, unsigned int id, size_t* job) {
+  struct _job_deque* dq= sched->deques + id;
+  bool found= false;
+  pthread_mutex_lock(&dq->lock);
+  if (dq->first < dq->last) {
+	 *job= dq->jobs[dq->first];
+	 ++dq->first;
+	 found= true;
+  }
+  pthread_mutex_unlock(&dq->lock);
+  return found;
+}
+
+static bool
+steal_job(struct _scheduler* sched, unsigned int id, size_t* job) {
+  bool found= false;
+  for (unsigned int k= 1; !found && k < sched->n_workers; ++k) {
+	 struct _job_deque* dq= sched->deques + ((id+k) % sched->n_workers);
+	 pthread_mutex_lock(&dq->lock);
+	 if (dq->first < dq->last) {
+		--dq->last;
+		*job= dq->jobs[dq->last];
+		found= true;
+	 }
+	 pthread_mutex_unlock(&dq->lock);
+  }
+  return found;
+}
+
+static void
+run_job(struct _worker* w, struct _transcript_job* job) {
+  struct _scheduler* sched= w->sched;
+  FILE* out[N_OUTPUTS];
+  for (unsigned int i= 0; i < N_OUTPUTS; ++i) {
+	 out[i]= open_memstream(&job->buff[i], &job->len[i]);
+	 if (out[i] == NULL) {
+		FATAL("Cannot create the output buffer for EST %s! Terminating", job->est->EST_id);
+		fail();
+	 }
+  }
+  compute_transcript_fact(sched->gen, job->est, job->rev_est,
+								  sched->idx, sched->pg, sched->floginfoext,
+								  out[OUT_MEG], out[OUT_PMEG], out[OUT_TMEG],
+								  out[OUT_INTRONIC],
+								  out[OUT_MULTIF], out[OUT_EST_MULTIF],
+								  job->fact_ests, job->fact_infos,
+								  w->pt_alg, w->pt_comp, w->pt_io,
+								  sched->config);
+  for (unsigned int i= 0; i < N_OUTPUTS; ++i) {
+	 fclose(out[i]);
+  }
+  pthread_mutex_lock(&sched->completed_lock);
+  job->completed= true;
+  pthread_cond_signal(&sched->completed_cond);
+  pthread_mutex_unlock(&sched->completed_lock);
+}
+
+static void*
+worker_main(void* arg) {
+  struct _worker* w= (struct _worker*)arg;
+  size_t job;
+  while (take_job(w->sched, w->id, &job) ||
+			steal_job(w->sched, w->id, &job)) {
+	 TRACE("Worker %u: processing transcript %zu.", w->id, job);
+	 run_job(w, w->sched->jobs + job);
+  }
+  DEBUG("Worker %u: no more transcripts.", w->id);
+  list_pool_trim();
+  return NULL;
+}
+
+void
+compute_transcripts_fact_parallel(pEST_info gen,
+											 plist est_list,
+											 const pgen_index idx,
+											 ppreproc_gen pg,
+											 FILE* floginfoext,
+											 FILE* fmeg, FILE* fpmeg, FILE* ftmeg,
+											 FILE* fintronic,
+											 FILE* f_multif_out, FILE* est_multif_out,
+											 plist fact_ests, plist fact_infos,
+											 pmytime pt_alg, pmytime pt_comp, pmytime pt_io,
+											 pconfiguration config) {
+  my_assert(config->num_threads > 0);
+  struct _scheduler sched;
+  sched.gen= gen;
+  sched.idx= idx;
+  sched.pg= pg;
+  sched.floginfoext= floginfoext;
+  sched.config= config;
+  sched.n_workers= config->num_threads;
+
+// Group each transcript with its reverse and complement
+  sched.jobs= NPALLOC(struct _transcript_job, list_size(est_list)+1);
+  sched.n_jobs= 0;
+  plistit estit= list_first(est_list);
+  while (listit_has_next(estit)) {
+	 struct _transcript_job* job= sched.jobs + sched.n_jobs;
+	 job->est= (pEST_info)listit_next(estit);
+	 job->rev_est= NULL;
+	 if (!job->est->fixed_strand) {
+		my_assert(listit_has_next(estit));
+		job->rev_est= (pEST_info)listit_next(estit);
+	 }
+	 job->fact_ests= (fact_ests != NULL) ? list_create() : NULL;
+	 job->fact_infos= (fact_infos != NULL) ? list_create() : NULL;
+	 job->completed= false;
+	 ++sched.n_jobs;
+  }
+  listit_destroy(estit);
+  INFO("Factorizing %zu transcripts with %u threads.", sched.n_jobs, sched.n_workers);
+
+// Distribute the jobs in a round-robin fashion, so that the earliest
+// transcripts (which are written first) are processed first
+  sched.deques= NPALLOC(struct _job_deque, sched.n_workers);
+  for (unsigned int w= 0; w < sched.n_workers; ++w) {
+	 struct _job_deque* dq= sched.deques + w;
+	 pthread_mutex_init(&dq->lock, NULL);
+	 dq->jobs= NPALLOC(size_t, sched.n_jobs/sched.n_workers + 1);
+	 dq->first= 0;
+	 dq->last= 0;
+  }
+  for (size_t j= 0; j < sched.n_jobs; ++j) {
+	 struct _job_deque* dq= sched.deques + (j % sched.n_workers);
+	 dq->jobs[dq->last]= j;
+	 ++dq->last;
+  }
+  pthread_mutex_init(&sched.completed_lock, NULL);
+  pthread_cond_init(&sched.completed_cond, NULL);
+
+  struct _worker* workers= NPALLOC(struct _worker, sched.n_workers);
+  for (unsigned int w= 0; w < sched.n_workers; ++w) {
+	 workers[w].sched= &sched;
+	 workers[w].id= w;
+	 workers[w].pt_alg= MYTIME_create_with_name("Algorithm (worker)");
+	 workers[w].pt_comp= MYTIME_create_with_name("Compositions (worker)");
+	 workers[w].pt_io= MYTIME_create_with_name("IO (worker)");
+	 if (pthread_create(&workers[w].thread, NULL, worker_main, workers + w) != 0) {
+		FATAL("Cannot create worker thread %u! Terminating", w);
+		fail();
+	 }
+  }
+
+// Write the output of each transcript as soon as it and all the
+// preceding transcripts have been processed
+  FILE* const files[N_OUTPUTS]= { fmeg, fpmeg, ftmeg, fintronic,
+											 f_multif_out, est_multif_out };
+  for (size_t j= 0; j < sched.n_jobs; ++j) {
+	 struct _transcript_job* job= sched.jobs + j;
+	 pthread_mutex_lock(&sched.completed_lock);
+	 while (!job->completed) {
+		pthread_cond_wait(&sched.completed_cond, &sched.completed_lock);
+	 }
+	 pthread_mutex_unlock(&sched.completed_lock);
+	 MYTIME_start(pt_io);
+	 for (unsigned int i= 0; i < N_OUTPUTS; ++i) {
+		if (job->len[i] > 0) {
+		  fwrite(job->buff[i], 1, job->len[i], files[i]);
+		}
+		free(job->buff[i]);
+	 }
+	 if (fact_ests != NULL) {
+		append_factorized_ESTs(fact_ests, job->fact_ests);
+		list_destroy(job->fact_ests, noop_free);
+	 }
+	 if (fact_infos != NULL) {
+		list_merge(fact_infos, job->fact_infos);
+	 }
+	 MYTIME_stop(pt_io);
+  }
+
+  for (unsigned int w= 0; w < sched.n_workers; ++w) {
+	 pthread_join(workers[w].thread, NULL);
+	 MYTIME_add(pt_alg, workers[w].pt_alg);
+	 MYTIME_add(pt_comp, workers[w].pt_comp);
+	 MYTIME_add(pt_io, workers[w].pt_io);
+	 MYTIME_destroy(workers[w].pt_alg);
+	 MYTIME_destroy(workers[w].pt_comp);
+	 MYTIME_destroy(workers[w].pt_io);
+	 pthread_mutex_destroy(&sched.deques[w].lock);
+	 pfree(sched.deques[w].jobs);
+  }
+  pthread_cond_destroy(&sched.completed_cond);
+  pthread_mutex_destroy(&sched.completed_lock);
+  pfree(workers);
+  pfree(sched.deques);
+  pfree(sched.jobs);
+}
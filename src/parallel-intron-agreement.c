@@ -0,0 +1,454 @@
+/**
+ *
+ *
+ *                              PIntron
+ *
+ * A novel pipeline for computational gene-structure prediction based on
+ * spliced alignment of expressed sequences (ESTs and mRNAs).
+ *
+ * Copyright (C) 2010,2012  Yuri Pirola, Raffaella Rizzi
+ *
+ * Distributed under the terms of the GNU Affero General Public License (AGPL)
+ *
+ *
+ * This file is part of PIntron.
+ *
+ * PIntron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PIntron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with PIntron.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ **/
+/**
+ *
+ * @file parallel-intron-agreement.c
+ *
+ * Multi-threaded classification and agreement of the introns.
+ *
+ **/
+
+#include "parallel-intron-agreement.h"
+
+#include <limits.h>
+#include <pthread.h>
+
+#include "util.h"
+#include "agree-introns.h"
+#include "classify-intron.h"
+
+#include "log.h"
+
+/*
+  Pool of threads.
+  A job is a function applied to the items 0..n_items-1, which are given
+  to the threads (the calling one included) in chunks of ITEMS_PER_CHUNK
+  consecutive items.
+*/
+
+#define ITEMS_PER_CHUNK 8
+
+typedef void (*pool_job_function)(void* ctx, const size_t item,
+											 const unsigned int thread_id);
+
+struct _agreement_pool {
+  unsigned int n_threads;
+  pthread_t* threads;
+  pthread_mutex_t lock;
+  pthread_cond_t work_cond;
+  pthread_cond_t done_cond;
+// Current job
+  pool_job_function job_fn;
+  void* job_ctx;
+  size_t n_items;
+  size_t next_item;
+  unsigned int n_busy;
+  unsigned long generation;
+  bool quit;
+};
+
+struct _pool_worker_arg {
+  pagreement_pool pool;
+  unsigned int thread_id;
+};
+
+// Take the next chunk of items of the current job (under lock)
+static bool
+take_chunk(pagreement_pool pool, pool_job_function* fn, void** ctx,
+			  size_t* first, size_t* last) {
+  if (pool->next_item >= pool->n_items)
+	 return false;
+  *fn= pool->job_fn;
+  *ctx= pool->job_ctx;
+  *first= pool->next_item;
+  *last= MIN(pool->n_items, pool->next_item + ITEMS_PER_CHUNK);
+  pool->next_item= *last;
+  ++pool->n_busy;
+  return true;
+}
+
+static void
+run_chunks(pagreement_pool pool, const unsigned int thread_id) {
+  pool_job_function fn;
+  void* ctx;
+  size_t first, last;
+  pthread_mutex_lock(&pool->lock);
+  while (take_chunk(pool, &fn, &ctx, &first, &last)) {
+	 pthread_mutex_unlock(&pool->lock);
+	 for (size_t i= first; i < last; ++i)
+		fn(ctx, i, thread_id);
+	 pthread_mutex_lock(&pool->lock);
+	 --pool->n_busy;
+	 if ((pool->n_busy == 0) && (pool->next_item >= pool->n_items))
+		pthread_cond_broadcast(&pool->done_cond);
+  }
+  pthread_mutex_unlock(&pool->lock);
+}
+
+static void*
+pool_worker_main(void* arg) {
+  pagreement_pool pool= ((struct _pool_worker_arg*)arg)->pool;
+  const unsigned int thread_id= ((struct _pool_worker_arg*)arg)->thread_id;
+  pfree(arg);
+  unsigned long seen_generation= 0;
+  while (true) {
+	 pthread_mutex_lock(&pool->lock);
+	 while (!pool->quit && (pool->generation == seen_generation))
+		pthread_cond_wait(&pool->work_cond, &pool->lock);
+	 const bool quit= pool->quit;
+	 seen_generation= pool->generation;
+	 pthread_mutex_unlock(&pool->lock);
+	 if (quit)
+		break;
+	 run_chunks(pool, thread_id);
+  }
+  list_pool_trim();
+  return NULL;
+}
+
+pagreement_pool
+agreement_pool_create(const unsigned int n_threads) {
+  my_assert(n_threads > 0);
+  pagreement_pool pool= PALLOC(struct _agreement_pool);
+  pool->n_threads= n_threads;
+  pool->threads= NPALLOC(pthread_t, n_threads);
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->work_cond, NULL);
+  pthread_cond_init(&pool->done_cond, NULL);
+  pool->job_fn= NULL;
+  pool->job_ctx= NULL;
+  pool->n_items= 0;
+  pool->next_item= 0;
+  pool->n_busy= 0;
+  pool->generation= 0;
+  pool->quit= false;
+  for (unsigned int t= 1; t < n_threads; ++t) {
+	 struct _pool_worker_arg* arg= PALLOC(struct _pool_worker_arg);
+	 arg->pool= pool;
+	 arg->thread_id= t;
+	 if (pthread_create(&pool->threads[t], NULL, pool_worker_main, arg) != 0) {
+		FATAL("Cannot create worker thread %u! Terminating", t);
+		fail();
+	 }
+  }
+  return pool;
+}
+
+void
+agreement_pool_destroy(pagreement_pool pool) {
+  my_assert(pool != NULL);
+  pthread_mutex_lock(&pool->lock);
+  pool->quit= true;
+  pthread_cond_broadcast(&pool->work_cond);
+  pthread_mutex_unlock(&pool->lock);
+  for (unsigned int t= 1; t < pool->n_threads; ++t)
+	 pthread_join(pool->threads[t], NULL);
+  pthread_cond_destroy(&pool->done_cond);
+  pthread_cond_destroy(&pool->work_cond);
+  pthread_mutex_destroy(&pool->lock);
+  pfree(pool->threads);
+  pfree(pool);
+}
+
+// Apply fn to the items 0..n_items-1 and wait for its completion
+static void
+pool_run(pagreement_pool pool, pool_job_function fn, void* ctx,
+			const size_t n_items) {
+  if (pool->n_threads == 1) {
+	 for (size_t i= 0; i < n_items; ++i)
+		fn(ctx, i, 0);
+	 return;
+  }
+  pthread_mutex_lock(&pool->lock);
+  pool->job_fn= fn;
+  pool->job_ctx= ctx;
+  pool->n_items= n_items;
+  pool->next_item= 0;
+  ++pool->generation;
+  pthread_cond_broadcast(&pool->work_cond);
+  pthread_mutex_unlock(&pool->lock);
+  run_chunks(pool, 0);
+  pthread_mutex_lock(&pool->lock);
+  while (pool->n_busy > 0)
+	 pthread_cond_wait(&pool->done_cond, &pool->lock);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+
+/*
+  Classification
+*/
+
+struct _classification_job {
+  char* genomic_sequence;
+  pgenomic_intron* introns;
+};
+
+static void
+classify_item(void* ctx, const size_t item, const unsigned int thread_id) {
+  struct _classification_job* job= (struct _classification_job*)ctx;
+  (void)thread_id;
+  classify_genomic_intron(job->genomic_sequence, job->introns[item]);
+}
+
+void
+classify_genomic_intron_list_parallel(pagreement_pool pool,
+												  char* genomic_sequence,
+												  plist gen_intron_list) {
+  my_assert(pool != NULL);
+  my_assert(genomic_sequence != NULL);
+  my_assert(gen_intron_list != NULL);
+  struct _classification_job job;
+  job.genomic_sequence= genomic_sequence;
+  job.introns= NPALLOC(pgenomic_intron, list_size(gen_intron_list)+1);
+  size_t n= 0;
+  plistit it= list_first(gen_intron_list);
+  while (listit_has_next(it)) {
+	 job.introns[n++]= (pgenomic_intron)listit_next(it);
+  }
+  listit_destroy(it);
+  pool_run(pool, classify_item, &job, n);
+  pfree(job.introns);
+}
+
+
+/*
+  Agreement
+*/
+
+#define ERROR_NOT_COMPUTED UINT_MAX
+
+// The coordinates of the factors of an intron, which determine the
+// agreement errors
+struct _factor_coords {
+  int EST_start;
+  int EST_end;
+  int GEN_start;
+  int GEN_end;
+};
+
+struct _intron_speculation {
+  pgenomic_intron gen_intron;
+  struct _factor_coords donor;
+  struct _factor_coords acceptor;
+  size_t n_candidates;
+  pgenomic_intron* candidates;
+  unsigned int* errors;
+};
+
+struct _agreement_pass {
+  char* genomic_sequence;
+  pgenomic_intron_index target;
+  int allowed_error;
+  bool only_supported;
+  bool only_better;
+  size_t n_introns;
+  pintron* introns;
+  struct _intron_speculation* spec;
+// A buffer for the queries of each thread
+  struct _genomic_intron_index_entry** buffers;
+};
+
+static void
+get_factor_coords(pfactor f, struct _factor_coords* c) {
+  c->EST_start= f->EST_start;
+  c->EST_end= f->EST_end;
+  c->GEN_start= f->GEN_start;
+  c->GEN_end= f->GEN_end;
+}
+
+static bool
+same_factor_coords(pfactor f, const struct _factor_coords* c) {
+  return (c->EST_start == f->EST_start) && (c->EST_end == f->EST_end) &&
+	 (c->GEN_start == f->GEN_start) && (c->GEN_end == f->GEN_end);
+}
+
+static void
+free_speculation(struct _intron_speculation* s) {
+  if (s->candidates != NULL) {
+	 pfree(s->candidates);
+	 pfree(s->errors);
+	 s->candidates= NULL;
+	 s->errors= NULL;
+  }
+}
+
+// Filters of the candidates that do not depend on the agreement error
+static bool
+is_admissible(const pagreement_pass pass, const pintron intron_from,
+				  const pgenomic_intron gen_intron_to) {
+  if (pass->only_supported && (gen_intron_to->supportingESTs <= 0))
+	 return false;
+  if (pass->only_better &&
+		(((gen_intron_to->start == intron_from->gen_intron->start) &&
+		  (gen_intron_to->end == intron_from->gen_intron->end)) ||
+		 (gen_intron_to->burset_frequency <= intron_from->gen_intron->burset_frequency)))
+	 return false;
+  return (intron_from->donor->GEN_start < gen_intron_to->start) &&
+	 (intron_from->acceptor->GEN_end > gen_intron_to->end);
+}
+
+// Compute the candidates of the intron and their errors
+// (until an agreeable candidate is found)
+static void
+speculate_item(void* ctx, const size_t item, const unsigned int thread_id) {
+  pagreement_pass pass= (pagreement_pass)ctx;
+  struct _intron_speculation* s= pass->spec + item;
+  pintron intron_from= pass->introns[item];
+  s->gen_intron= NULL;
+  s->n_candidates= 0;
+  s->candidates= NULL;
+  s->errors= NULL;
+  if (intron_from->agreed)
+	 return;
+  s->gen_intron= intron_from->gen_intron;
+  get_factor_coords(intron_from->donor, &s->donor);
+  get_factor_coords(intron_from->acceptor, &s->acceptor);
+  struct _genomic_intron_index_entry* const buffer= pass->buffers[thread_id];
+  s->n_candidates=
+	 genomic_intron_index_query_into(pass->target,
+												intron_from->gen_intron->start,
+												intron_from->gen_intron->end,
+												AGREEMENT_RANGE, true, buffer);
+  if (s->n_candidates == 0)
+	 return;
+  s->candidates= NPALLOC(pgenomic_intron, s->n_candidates);
+  s->errors= NPALLOC(unsigned int, s->n_candidates);
+  bool found= false;
+  for (size_t k= 0; k < s->n_candidates; ++k) {
+	 s->candidates[k]= buffer[k].intron;
+	 s->errors[k]= ERROR_NOT_COMPUTED;
+	 if (!found && is_admissible(pass, intron_from, s->candidates[k])) {
+		s->errors[k]= get_agreement_error(pass->genomic_sequence, intron_from,
+													 s->candidates[k]);
+		found= ((int)s->errors[k] <= pass->allowed_error);
+	 }
+  }
+}
+
+pagreement_pass
+agreement_pass_create(pagreement_pool pool,
+							 char* genomic_sequence,
+							 plist intron_list,
+							 pgenomic_intron_index target,
+							 const int allowed_error,
+							 const bool only_supported,
+							 const bool only_better) {
+  my_assert(pool != NULL);
+  my_assert(genomic_sequence != NULL);
+  my_assert(intron_list != NULL);
+  my_assert(target != NULL);
+  pagreement_pass pass= PALLOC(struct _agreement_pass);
+  pass->genomic_sequence= genomic_sequence;
+  pass->target= target;
+  pass->allowed_error= allowed_error;
+  pass->only_supported= only_supported;
+  pass->only_better= only_better;
+  pass->n_introns= list_size(intron_list);
+  pass->introns= NPALLOC(pintron, pass->n_introns+1);
+  pass->spec= NPALLOC(struct _intron_speculation, pass->n_introns+1);
+  size_t n= 0;
+  plistit it= list_first(intron_list);
+  while (listit_has_next(it)) {
+	 pass->introns[n++]= (pintron)((ppointer)listit_next(it))->pointer;
+  }
+  listit_destroy(it);
+  const size_t buffer_size= genomic_intron_index_n_introns(target)+1;
+  pass->buffers= NPALLOC(struct _genomic_intron_index_entry*, pool->n_threads);
+  for (unsigned int t= 0; t < pool->n_threads; ++t)
+	 pass->buffers[t]= NPALLOC(struct _genomic_intron_index_entry, buffer_size);
+  if (pool->n_threads > 1) {
+	 pool_run(pool, speculate_item, pass, pass->n_introns);
+  } else {
+// The errors are computed when the introns are tried
+	 for (size_t i= 0; i < pass->n_introns; ++i) {
+		pass->spec[i].gen_intron= NULL;
+		pass->spec[i].n_candidates= 0;
+		pass->spec[i].candidates= NULL;
+		pass->spec[i].errors= NULL;
+	 }
+  }
+  for (unsigned int t= 1; t < pool->n_threads; ++t)
+	 pfree(pass->buffers[t]);
+  return pass;
+}
+
+bool
+agreement_pass_try(pagreement_pass pass, const size_t i) {
+  my_assert(pass != NULL);
+  my_assert(i < pass->n_introns);
+  pintron intron_from= pass->introns[i];
+  my_assert(intron_from->agreed == false);
+  struct _intron_speculation* s= pass->spec + i;
+// The precomputed errors are valid only if the intron has not changed
+  if ((s->gen_intron != intron_from->gen_intron) ||
+		!same_factor_coords(intron_from->donor, &s->donor) ||
+		!same_factor_coords(intron_from->acceptor, &s->acceptor)) {
+	 free_speculation(s);
+	 s->n_candidates=
+		genomic_intron_index_query_into(pass->target,
+												  intron_from->gen_intron->start,
+												  intron_from->gen_intron->end,
+												  AGREEMENT_RANGE, true, pass->buffers[0]);
+	 s->candidates= NPALLOC(pgenomic_intron, s->n_candidates+1);
+	 s->errors= NPALLOC(unsigned int, s->n_candidates+1);
+	 for (size_t k= 0; k < s->n_candidates; ++k) {
+		s->candidates[k]= pass->buffers[0][k].intron;
+		s->errors[k]= ERROR_NOT_COMPUTED;
+	 }
+  }
+  for (size_t k= 0; k < s->n_candidates; ++k) {
+	 pgenomic_intron gen_intron_to= s->candidates[k];
+	 if (is_admissible(pass, intron_from, gen_intron_to)) {
+		if (s->errors[k] == ERROR_NOT_COMPUTED)
+		  s->errors[k]= get_agreement_error(pass->genomic_sequence, intron_from,
+														gen_intron_to);
+		TRACE("...to %d-%d with agreeing error ==> %u",
+				gen_intron_to->start, gen_intron_to->end, s->errors[k]);
+		if ((int)s->errors[k] <= pass->allowed_error) {
+		  agree_to_genomic_intron(pass->genomic_sequence, intron_from, gen_intron_to);
+		  return true;
+		}
+	 }
+  }
+  return false;
+}
+
+void
+agreement_pass_destroy(pagreement_pass pass) {
+  my_assert(pass != NULL);
+  for (size_t i= 0; i < pass->n_introns; ++i)
+	 free_speculation(pass->spec + i);
+  pfree(pass->buffers[0]);
+  pfree(pass->buffers);
+  pfree(pass->spec);
+  pfree(pass->introns);
+  pfree(pass);
+}
@@ -30,6 +30,7 @@
 #include <ctype.h>
 
 #include "refine-intron.h"
+#include "nucleotide-codes.h"
 #include "refine.h"
 #include "est-factorizations.h"
 #include "list.h"
@@ -344,215 +345,27 @@ int Try_Burset_after_match(char *est_sequence, char *genomic_sequence, int *acce
 
 //Returns the frequency of the pairs, or 0 it the pairs does not exist
 int Check_Burset_patterns(char *genomic_sequence, int donor_left_on_gen, int acceptor_right_on_gen){
-	int frequency=0;
+	if(donor_left_on_gen+1 < 0 || acceptor_right_on_gen-2 < 0)
+		return 0;
 
-	char *donor_pt=real_substring(donor_left_on_gen+1, 2, genomic_sequence);
-	char *acceptor_pt=real_substring(acceptor_right_on_gen-2, 2, genomic_sequence);
+	const char *donor_pt=genomic_sequence+donor_left_on_gen+1;
+	const char *acceptor_pt=genomic_sequence+acceptor_right_on_gen-2;
 
-	TRACE("\t...pattern (%d-%d) %s-%s", donor_left_on_gen+1, acceptor_right_on_gen-2, donor_pt, acceptor_pt);
+	TRACE("\t...pattern (%d-%d) %.2s-%.2s", donor_left_on_gen+1, acceptor_right_on_gen-2, donor_pt, acceptor_pt);
 
-	frequency=getBursetFrequency(donor_pt, acceptor_pt);
-
-	pfree(donor_pt);
-	pfree(acceptor_pt);
-
-	return frequency;
+	return burset_frequency(donor_pt, acceptor_pt);
 }
 
 int getBursetFrequency_adaptor(const char* const t,
 										 const size_t cut1, const size_t cut2) {
   if (cut2<2)
 	 return 0;
-  char donor[3], acceptor[3];
-  donor[2]= acceptor[2]= '\0';
-  donor[0]= t[cut1];
-  donor[1]= t[cut1+1];
-  acceptor[0]= t[cut2-2];
-  acceptor[1]= t[cut2-1];
-  TRACE("Get Burset frequency of intron %s-%s.", donor, acceptor);
-  return getBursetFrequency(donor, acceptor);
+  TRACE("Get Burset frequency of intron %.2s-%.2s.", t+cut1, t+cut2-2);
+  return burset_frequency(t+cut1, t+cut2-2);
 }
 
-int getBursetFrequency(char *donor_pt, char *acceptor_pt){
-
-	char *up_donor_pt=To_upper(donor_pt);
-	char *up_acceptor_pt=To_upper(acceptor_pt);
-
-	if(!strcmp(up_donor_pt, "AA") && !strcmp(up_acceptor_pt, "AG"))
-	 return 1;
-
-	if(!strcmp(up_donor_pt, "AA") && !strcmp(up_acceptor_pt, "AT"))
-	 return 1;
-
-	if(!strcmp(up_donor_pt, "AA") && !strcmp(up_acceptor_pt, "GT"))
-	 return 1;
-
-	if(!strcmp(up_donor_pt, "AC") && !strcmp(up_acceptor_pt, "CC"))
-	 return 1;
-
-	if(!strcmp(up_donor_pt, "AG") && !strcmp(up_acceptor_pt, "AC"))
-	 return 1;
-
-	if(!strcmp(up_donor_pt, "AG") && !strcmp(up_acceptor_pt, "AG"))
-	 return 5;
-
-	if(!strcmp(up_donor_pt, "AG") && !strcmp(up_acceptor_pt, "CT"))
-	 return 2;
-
-	if(!strcmp(up_donor_pt, "AG") && !strcmp(up_acceptor_pt, "GC"))
-	 return 1;
-
-	if(!strcmp(up_donor_pt, "AG") && !strcmp(up_acceptor_pt, "TG"))
-	 return 2;
-
-	if(!strcmp(up_donor_pt, "AT") && !strcmp(up_acceptor_pt, "AA"))
-	 return 1;
-
-	if(!strcmp(up_donor_pt, "AT") && !strcmp(up_acceptor_pt, "AC"))
-	 return 8;
-
-	if(!strcmp(up_donor_pt, "AT") && !strcmp(up_acceptor_pt, "AG"))
-	 return 7;
-
-	if(!strcmp(up_donor_pt, "AT") && !strcmp(up_acceptor_pt, "AT"))
-		return 2;
-
-	if(!strcmp(up_donor_pt, "AT") && !strcmp(up_acceptor_pt, "GC"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "AT") && !strcmp(up_acceptor_pt, "GT"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "CA") && !strcmp(up_acceptor_pt, "AG"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "CA") && !strcmp(up_acceptor_pt, "TT"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "CC") && !strcmp(up_acceptor_pt, "AG"))
-		return 2;
-
-	if(!strcmp(up_donor_pt, "CG") && !strcmp(up_acceptor_pt, "AG"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "CG") && !strcmp(up_acceptor_pt, "CA"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "CT") && !strcmp(up_acceptor_pt, "AC"))
-		return 2;
-
-	if(!strcmp(up_donor_pt, "CT") && !strcmp(up_acceptor_pt, "CA"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "GA") && !strcmp(up_acceptor_pt, "AG"))
-		return 8;
-
-	if(!strcmp(up_donor_pt, "GA") && !strcmp(up_acceptor_pt, "GT"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "GA") && !strcmp(up_acceptor_pt, "TC"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "GA") && !strcmp(up_acceptor_pt, "TG"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "GC") && !strcmp(up_acceptor_pt, "AG"))
-		return 126;
-
-	if(!strcmp(up_donor_pt, "GC") && !strcmp(up_acceptor_pt, "GG"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "GC") && !strcmp(up_acceptor_pt, "TA"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "GG") && !strcmp(up_acceptor_pt, "AC"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "GG") && !strcmp(up_acceptor_pt, "AG"))
-		return 11;
-
-	if(!strcmp(up_donor_pt, "GG") && !strcmp(up_acceptor_pt, "CA"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "GG") && !strcmp(up_acceptor_pt, "GA"))
-		return 2;
-
-	if(!strcmp(up_donor_pt, "GG") && !strcmp(up_acceptor_pt, "TC"))
-		return 2;
-
-	if(!strcmp(up_donor_pt, "GT") && !strcmp(up_acceptor_pt, "AG"))
-		return 200;
-
-	if(!strcmp(up_donor_pt, "GT") && !strcmp(up_acceptor_pt, "AC"))
-		return 4;
-
-	if(!strcmp(up_donor_pt, "GT") && !strcmp(up_acceptor_pt, "AT"))
-		return 2;
-
-	if(!strcmp(up_donor_pt, "GT") && !strcmp(up_acceptor_pt, "CA"))
-		return 9;
-
-	if(!strcmp(up_donor_pt, "GT") && !strcmp(up_acceptor_pt, "CG"))
-		return 4;
-
-	if(!strcmp(up_donor_pt, "GT") && !strcmp(up_acceptor_pt, "CT"))
-		return 3;
-
-	if(!strcmp(up_donor_pt, "GT") && !strcmp(up_acceptor_pt, "GC"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "GT") && !strcmp(up_acceptor_pt, "GG"))
-		return 10;
-
-	if(!strcmp(up_donor_pt, "GT") && !strcmp(up_acceptor_pt, "GT"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "GT") && !strcmp(up_acceptor_pt, "TA"))
-		return 7;
-
-	if(!strcmp(up_donor_pt, "GT") && !strcmp(up_acceptor_pt, "TC"))
-		return 2;
-
-	if(!strcmp(up_donor_pt, "GT") && !strcmp(up_acceptor_pt, "TG"))
-		return 8;
-
-	if(!strcmp(up_donor_pt, "GT") && !strcmp(up_acceptor_pt, "TT"))
-		return 2;
-
-	if(!strcmp(up_donor_pt, "TA") && !strcmp(up_acceptor_pt, "AG"))
-		return 6;
-
-	if(!strcmp(up_donor_pt, "TA") && !strcmp(up_acceptor_pt, "CG"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "TA") && !strcmp(up_acceptor_pt, "TC"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "TC") && !strcmp(up_acceptor_pt, "AG"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "TC") && !strcmp(up_acceptor_pt, "GG"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "TG") && !strcmp(up_acceptor_pt, "AC"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "TG") && !strcmp(up_acceptor_pt, "AG"))
-		return 7;
-
-	if(!strcmp(up_donor_pt, "TG") && !strcmp(up_acceptor_pt, "GG"))
-		return 2;
-
-	if(!strcmp(up_donor_pt, "TT") && !strcmp(up_acceptor_pt, "AG"))
-		return 5;
-
-	if(!strcmp(up_donor_pt, "TT") && !strcmp(up_acceptor_pt, "AT"))
-		return 1;
-
-	if(!strcmp(up_donor_pt, "TT") && !strcmp(up_acceptor_pt, "GG"))
-		return 1;
-
-	return 0;
+int getBursetFrequency(const char *donor_pt, const char *acceptor_pt){
+	return burset_frequency(donor_pt, acceptor_pt);
 }
 
 //Returns a list of gap alignments
@@ -570,31 +383,18 @@ plist compute_gap_alignment(char *EST_seq, char *genomic_seq, bool only_one_alig
 
 	plist alignments=list_create();
 
-	char **Ldir=NPALLOC(char*, 4);
-	char **Gdir=NPALLOC(char*, 4);
-	char **Rdir=NPALLOC(char*, 4);
-
-	my_assert(Ldir != NULL && Gdir != NULL && Rdir != NULL);
-
-	unsigned int i;
-
-	for(i=0; i<4; i++){
-		Ldir[i]=NPALLOC(char, (n+1)*(m+1));
-		Gdir[i]=NPALLOC(char, (n+1)*(m+1));
-		Rdir[i]=NPALLOC(char, (n+1)*(m+1));
-		memset(Ldir[i], 0, (n+1)*(m+1)*sizeof(char));
-		memset(Gdir[i], 0, (n+1)*(m+1)*sizeof(char));
-		memset(Rdir[i], 0, (n+1)*(m+1)*sizeof(char));
-	}
-
+	//Una sola matrice di direzioni (un byte per cella, vedi GAP_DIR_*).
+	//La riga 0 e la colonna 0 non vengono mai lette dal traceback.
+	char *dir=NPALLOC(char, (n+1)*(m+1));
+	my_assert(dir != NULL);
 
 	char start_matrix;
 
 	//Per ora fare calcolare un solo allineamento
 	if(only_one_align){
-		ComputeGapAlignMatrix(EST_seq, genomic_seq, Ldir, Gdir, Rdir, &start_matrix, only_one_align);
+		ComputeGapAlignMatrix(EST_seq, genomic_seq, n, m, dir, &start_matrix);
 		pgap_alignment alignment=gap_alignment_create(n+m+10);
-		TracebackGapAlignment(m, alignment, EST_seq, genomic_seq, Ldir, Gdir, Rdir, (int)n, (int)m, start_matrix);
+		TracebackGapAlignment(m, alignment, EST_seq, genomic_seq, dir, (int)n, (int)m, start_matrix);
 
 		alignment->EST_gap_alignment[alignment->gap_alignment_dim]='\0';
 		alignment->GEN_gap_alignment[alignment->gap_alignment_dim]='\0';
@@ -605,242 +405,152 @@ plist compute_gap_alignment(char *EST_seq, char *genomic_seq, bool only_one_alig
 		//Computazione di piu' allineamenti ==> DA FARE
 	}
 
-	for(i=0; i<4; i++){
-		pfree(Ldir[i]);
-		pfree(Gdir[i]);
-		pfree(Rdir[i]);
-	}
-
-	pfree(Ldir);
-	pfree(Gdir);
-	pfree(Rdir);
+	pfree(dir);
 
 	return alignments;
 }
 
-//n: EST_seq length
-//m: genomic_seq length
-void ComputeGapAlignMatrix(char *EST_seq, char *genomic_seq, char **Ldir, char **Gdir, char **Rdir, char *start_matrix, bool only_one_align){
-	int *L=NULL;
-	int *G=NULL;
-	int *R=NULL;
-
-	unsigned int i, j;
+//Codifica delle direzioni nella matrice dir (un byte per cella):
+//  bit 0-1: direzione in L (0 diagonale, 1 cancellazione in genomic_seq,
+//           2 cancellazione in EST_seq)
+//  bit 2:   direzione in G (0 cancellazione in EST_seq, 1 salto alla L)
+//  bit 3-4: direzione in R (come in L, piu' 3 per il salto alla G)
+#define GAP_DIR_L_SHIFT 0
+#define GAP_DIR_G_SHIFT 2
+#define GAP_DIR_R_SHIFT 3
+#define GAP_DIR_JUMP 3
 
-	int i_del;
+#define GAP_IS_MATCH( e, g ) ((e) == (g) || nt_is_N(e) || nt_is_N(g))
 
+//n: EST_seq length
+//m: genomic_seq length
+//Le matrici L, G e R vengono calcolate per righe e ne vengono mantenute
+//solo la riga corrente e la precedente; le direzioni sono salvate in dir,
+//che deve avere dimensione (n+1)*(m+1).
+void ComputeGapAlignMatrix(const char *EST_seq, const char *genomic_seq, const size_t n, const size_t m, char *dir, char *start_matrix){
 	my_assert(EST_seq != NULL);
 	my_assert(genomic_seq != NULL);
-	my_assert(Ldir != NULL);
-	my_assert(Gdir != NULL);
-	my_assert(Rdir != NULL);
-
-	size_t n=strlen(EST_seq);
-	size_t m=strlen(genomic_seq);
-
-	L=NPALLOC(int, (n+1)*(m+1));
-	G=NPALLOC(int, (n+1)*(m+1));
-	R=NPALLOC(int, (n+1)*(m+1));
-	my_assert(L != NULL && G != NULL && R != NULL);
-
-	for(i=0; i<n+1; i++){
-		for(j=0; j<m+1; j++){
-			L[i*(m+1)+j]=0;
-			G[i*(m+1)+j]=0;
-			R[i*(m+1)+j]=0;
-		}
-	}
-
-	//Casi base
-	for(i=0; i<n+1; i++){
-		Rdir[2][i*(m+1)]=1;
-		Gdir[2][i*(m+1)]=1;
-		Ldir[2][i*(m+1)]=1;
-	}
-	for(i=1; i<m+1; i++){
-		Rdir[3][i]=1;
-		Gdir[3][i]=1;
-		Ldir[3][i]=1;
-	}
-
-	//Costruzione della matrice L
-	for(i=1; i<n+1; i++){
-		for(j=1; j<m+1; j++){
-
-			L[i*(m+1)+j]=L[(i-1)*(m+1)+j-1];
-
-			if(EST_seq[i-1] == genomic_seq[j-1] || EST_seq[i-1] == 'n' || genomic_seq[j-1] == 'n' || EST_seq[i-1] == 'N' || genomic_seq[j-1] == 'N')
-				L[i*(m+1)+j]=L[i*(m+1)+j]+1;	//Costo match a +1
-			else
-				L[i*(m+1)+j]=L[i*(m+1)+j]-1;	//Costo mismatch a -1
-
-			if(only_one_align)
-				Ldir[0][i*(m+1)+j]=0;		//0 per allineamento caratteri in i-1 e j-1
-			else
-				Ldir[1][i*(m+1)+j]=1;		//0 per allineamento caratteri in i-1 e j-1
-
-
-			if(L[i*(m+1)+j] < L[(i-1)*(m+1)+j]-1){
-				L[i*(m+1)+j]= L[(i-1)*(m+1)+j]-1;	//Costo spazio a -1
-				if(only_one_align)
-					Ldir[0][i*(m+1)+j]=1;	//1 per cancellazione in genomic_seq; il carattere in i-1 matcha con -
-				else{
-					Ldir[2][i*(m+1)+j]=1;	//1 per cancellazione in genomic_seq; il carattere in i-1 matcha con -
-					Ldir[1][i*(m+1)+j]=0;
-				}
-			}
-			else{
-				if(L[i*(m+1)+j] == L[(i-1)*(m+1)+j]-1 && !only_one_align)
-					Ldir[2][i*(m+1)+j]=1;
-			}
-
-			if(L[i*(m+1)+j] < L[i*(m+1)+j-1]-1){
-				L[i*(m+1)+j]= L[i*(m+1)+j-1]-1;	//Costo spazio a -1
-				if(only_one_align)
-					Ldir[0][i*(m+1)+j]=2;	//2 per cancellazione in EST_seq; il carattere in j-1 matcha con -
-				else{
-					Ldir[3][i*(m+1)+j]=1;	//2 per cancellazione in EST_seq; il carattere in j-1 matcha con -
-					Ldir[1][i*(m+1)+j]=0;
-					Ldir[2][i*(m+1)+j]=0;
-				}
-			}
-			else{
-				if(L[i*(m+1)+j] == L[i*(m+1)+j-1]-1 && !only_one_align)
-					Ldir[3][i*(m+1)+j]=1;
-			}
-		}
-	}
-
-	//Costruzione della matrice G
-	for(i=1; i<n+1; i++){
-		for(j=1; j<m+1; j++){
-			if(only_one_align)
-				Gdir[0][i*(m+1)+j]=2;		//2 per cancellazione in EST_seq; il carattere in j-1 matcha con -
-			else
-				Gdir[3][i*(m+1)+j]=1;		//2 per cancellazione in EST_seq; il carattere in j-1 matcha con -
-
-			G[i*(m+1)+j]=G[i*(m+1)+j-1];	//Costo gap a 0
-
-			if(G[i*(m+1)+j] < L[i*(m+1)+j-1]){
-				G[i*(m+1)+j]=L[i*(m+1)+j-1];	//Costo gap a 0
-				if(only_one_align)
-					Gdir[0][i*(m+1)+j]=-2;		//Salto alla L
-				else{
-					Gdir[0][i*(m+1)+j]=1;		//Salto alla L
-					Gdir[3][i*(m+1)+j]=0;
-				}
+	my_assert(dir != NULL);
+
+	int *rows=NPALLOC(int, 6*(m+1));
+	my_assert(rows != NULL);
+	int *Lprev=rows;
+	int *Lcur=rows+(m+1);
+	int *Gcur=rows+2*(m+1);
+	int *Rprev=rows+3*(m+1);
+	int *Rcur=rows+4*(m+1);
+	int *Gprev=rows+5*(m+1);
+
+	//Casi base: riga 0 e colonna 0 sono nulle
+	memset(rows, 0, 6*(m+1)*sizeof(int));
+
+	for(size_t i=1; i<n+1; i++){
+		const char e=EST_seq[i-1];
+		char *dir_i=dir+i*(m+1);
+		//Nell'ultima riga lo spazio in R ha costo 0 (gap finale)
+		const int r_del_cost=(i != n)? 1: 0;
+		for(size_t j=1; j<m+1; j++){
+			const char g=genomic_seq[j-1];
+			const int s=GAP_IS_MATCH(e, g)? 1: -1;	//Costo match a +1, mismatch a -1
+
+			//Matrice L
+			int l=Lprev[j-1]+s;
+			char dl=0;						//0 per allineamento caratteri in i-1 e j-1
+			if(l < Lprev[j]-1){
+				l=Lprev[j]-1;				//1 per cancellazione in genomic_seq
+				dl=1;
 			}
-			else{
-				if(G[i*(m+1)+j] == L[i*(m+1)+j-1] && !only_one_align)
-					Gdir[0][i*(m+1)+j]=1;		//Salto alla L
+			if(l < Lcur[j-1]-1){
+				l=Lcur[j-1]-1;				//2 per cancellazione in EST_seq
+				dl=2;
 			}
-		}
-	}
-
-	//Costruzione della matrice R
-	for(i=1; i<n+1; i++){
-		for(j=1; j<m+1; j++){
-
-			R[i*(m+1)+j]=R[(i-1)*(m+1)+j-1];
-
-			if(EST_seq[i-1] == genomic_seq[j-1] || EST_seq[i-1] == 'n' || genomic_seq[j-1] == 'n' || EST_seq[i-1] == 'N' || genomic_seq[j-1] == 'N')
-				R[i*(m+1)+j]=R[i*(m+1)+j]+1;	//Costo match a +1
-			else
-				R[i*(m+1)+j]=R[i*(m+1)+j]-1;	//Costo mismatch a -1
-
-			if(only_one_align)
-				Rdir[0][i*(m+1)+j]=0;		//0 per allineamento caratteri in i-1 e j-1
-			else
-				Rdir[1][i*(m+1)+j]=1;		//0 per allineamento caratteri in i-1 e j-1
-
-			if(i != n)
-				i_del=R[i*(m+1)+j-1]-1;	//Costo spazio a -1
-			else
-				i_del=R[i*(m+1)+j-1];		//Costo gap a 0
-
-			if(R[i*(m+1)+j] < i_del){
-				R[i*(m+1)+j]=i_del;
-				if(only_one_align)
-					Rdir[0][i*(m+1)+j]=2;	//2 per cancellazione in EST_seq; il carattere in j-1 matcha con -
-				else{
-					Rdir[3][i*(m+1)+j]=1;	//2 per cancellazione in EST_seq; il carattere in j-1 matcha con -
-					Rdir[1][i*(m+1)+j]=0;
-				}
+			Lcur[j]=l;
+
+			//Matrice G (costo gap a 0)
+			int gg=Gcur[j-1];
+			char dg=0;
+			if(gg < Lcur[j-1]){
+				gg=Lcur[j-1];				//Salto alla L
+				dg=1;
 			}
-			else{
-				if(R[i*(m+1)+j] == i_del && !only_one_align)
-					Rdir[3][i*(m+1)+j]=1;
+			Gcur[j]=gg;
+
+			//Matrice R
+			int r=Rprev[j-1]+s;
+			char dr=0;
+			const int i_del=Rcur[j-1]-r_del_cost;
+			if(r < i_del){
+				r=i_del;
+				dr=2;
 			}
-
-			if(R[i*(m+1)+j] < G[i*(m+1)+j-1]){
-				R[i*(m+1)+j]=G[i*(m+1)+j-1];
-				if(only_one_align)
-					Rdir[0][i*(m+1)+j]=-2;	//2 per cancellazione in EST_seq; il carattere in j-1 matcha con -
-				else{
-					Rdir[0][i*(m+1)+j]=1;	//2 per cancellazione in EST_seq; il carattere in j-1 matcha con -
-					Rdir[1][i*(m+1)+j]=0;
-					Rdir[3][i*(m+1)+j]=0;
-				}
+			if(r < Gcur[j-1]){
+				r=Gcur[j-1];				//Salto alla G
+				dr=GAP_DIR_JUMP;
 			}
-			else{
-				if(R[i*(m+1)+j] == G[i*(m+1)+j-1] && !only_one_align)
-					Rdir[0][i*(m+1)+j]=1;
+			if(r < Rprev[j]-1){
+				r=Rprev[j]-1;
+				dr=1;
 			}
+			Rcur[j]=r;
 
-
-			if(R[i*(m+1)+j] < R[(i-1)*(m+1)+j]-1){
-				R[i*(m+1)+j]=R[(i-1)*(m+1)+j]-1;	//Costo spazio a -1
-				if(only_one_align)
-					Rdir[0][i*(m+1)+j]=1;	//1 per cancellazione in genomic_seq; il carattere in i-1 matcha con -
-				else{
-					Rdir[2][i*(m+1)+j]=1;	//1 per cancellazione in genomic_seq; il carattere in i-1 matcha con -
-					Rdir[1][i*(m+1)+j]=0;
-					Rdir[3][i*(m+1)+j]=0;
-				}
-			}
-			else{
-				if(R[i*(m+1)+j] == R[(i-1)*(m+1)+j]-1 && !only_one_align)
-					Rdir[2][i*(m+1)+j]=1;
-			}
+			dir_i[j]=(char)((dl << GAP_DIR_L_SHIFT) | (dg << GAP_DIR_G_SHIFT) | (dr << GAP_DIR_R_SHIFT));
 		}
+		int *tmp;
+		tmp=Lprev; Lprev=Lcur; Lcur=tmp;
+		tmp=Rprev; Rprev=Rcur; Rcur=tmp;
+		tmp=Gprev; Gprev=Gcur; Gcur=tmp;
 	}
 
-	if(R[n*(m+1)+m] >= G[n*(m+1)+m]){
-		if(R[n*(m+1)+m] >= L[n*(m+1)+m])
+	//Dopo l'ultimo scambio le righe n-esime sono in *prev
+	const int Lnm=Lprev[m];
+	const int Gnm=Gprev[m];
+	const int Rnm=Rprev[m];
+	if(Rnm >= Gnm){
+		if(Rnm >= Lnm)
 			*start_matrix=2;
 		else
 			*start_matrix=0;
 	}
 	else{
-		if(G[n*(m+1)+m] >= L[n*(m+1)+m])
+		if(Gnm >= Lnm)
 			*start_matrix=1;
 		else
 			*start_matrix=0;
 	}
 
-	pfree(L);
-	pfree(G);
-	pfree(R);
+	pfree(rows);
+}
+
+//Restituisce la direzione della cella nella matrice start_matrix
+//con la codifica originale (0, 1, 2 e -2 per il salto di matrice)
+static inline char gap_direction(const char cell, const char start_matrix){
+	if(start_matrix == 2){
+		const char d=(cell >> GAP_DIR_R_SHIFT) & 3;
+		return (d == GAP_DIR_JUMP)? -2: d;
+	}
+	if(start_matrix == 1)
+		return ((cell >> GAP_DIR_G_SHIFT) & 1)? -2: 2;
+	return (cell >> GAP_DIR_L_SHIFT) & 3;
 }
 
 //Argument alignment must be created before calling this procedure
 //Arguments EST_seq and genomic_seq are the sequence regions to be aligned
-void TracebackGapAlignment(size_t m, pgap_alignment alignment, char *EST_seq, char *genomic_seq, char **Ldir, char **Gdir, char **Rdir, int i, int j, char start_matrix){
+void TracebackGapAlignment(size_t m, pgap_alignment alignment, char *EST_seq, char *genomic_seq, const char *dir, int i, int j, char start_matrix){
 
 	char direction=0;
 
 	if(i > 0 && j > 0){
-		direction=(start_matrix == 2)?(Rdir[0][i*(m+1)+j]):((start_matrix == 1)?(Gdir[0][i*(m+1)+j]):(Ldir[0][i*(m+1)+j]));
+		direction=gap_direction(dir[i*(m+1)+j], start_matrix);
 
 		if (direction == 0){
-			TracebackGapAlignment(m, alignment, EST_seq, genomic_seq, Ldir, Gdir, Rdir, i-1, j-1, start_matrix);
+			TracebackGapAlignment(m, alignment, EST_seq, genomic_seq, dir, i-1, j-1, start_matrix);
 			alignment->EST_gap_alignment[alignment->gap_alignment_dim]=EST_seq[i-1];
 			alignment->GEN_gap_alignment[alignment->gap_alignment_dim]=genomic_seq[j-1];
 			alignment->gap_alignment_dim=alignment->gap_alignment_dim+1;
 		}
 		else{
 			if (direction == 1){
-				TracebackGapAlignment(m, alignment, EST_seq, genomic_seq, Ldir, Gdir, Rdir, i-1, j, start_matrix);
+				TracebackGapAlignment(m, alignment, EST_seq, genomic_seq, dir, i-1, j, start_matrix);
 				alignment->EST_gap_alignment[alignment->gap_alignment_dim]=EST_seq[i-1];
 				alignment->GEN_gap_alignment[alignment->gap_alignment_dim]='-';
 				alignment->gap_alignment_dim=alignment->gap_alignment_dim+1;
@@ -857,7 +567,7 @@ void TracebackGapAlignment(size_t m, pgap_alignment alignment, char *EST_seq, ch
 					start_matrix=start_matrix-1;
 				}
 
-				TracebackGapAlignment(m, alignment, EST_seq, genomic_seq, Ldir, Gdir, Rdir, i, j-1, start_matrix);
+				TracebackGapAlignment(m, alignment, EST_seq, genomic_seq, dir, i, j-1, start_matrix);
 				alignment->EST_gap_alignment[alignment->gap_alignment_dim]='-';
 
 				if(direction == -2){
@@ -873,14 +583,14 @@ void TracebackGapAlignment(size_t m, pgap_alignment alignment, char *EST_seq, ch
 	}
 	else{
 		if(i > 0){
-			TracebackGapAlignment(m, alignment, EST_seq, genomic_seq, Ldir, Gdir, Rdir, i-1, j, start_matrix);
+			TracebackGapAlignment(m, alignment, EST_seq, genomic_seq, dir, i-1, j, start_matrix);
 			alignment->EST_gap_alignment[alignment->gap_alignment_dim]=EST_seq[i-1];
 			alignment->GEN_gap_alignment[alignment->gap_alignment_dim]='-';
 			alignment->gap_alignment_dim=alignment->gap_alignment_dim+1;
 		}
 		else{
 			if(j > 0){
-				TracebackGapAlignment(m, alignment, EST_seq, genomic_seq, Ldir, Gdir, Rdir, i, j-1, start_matrix);
+				TracebackGapAlignment(m, alignment, EST_seq, genomic_seq, dir, i, j-1, start_matrix);
 				alignment->EST_gap_alignment[alignment->gap_alignment_dim]='-';
 				alignment->GEN_gap_alignment[alignment->gap_alignment_dim]=genomic_seq[j-1];
 				alignment->gap_alignment_dim=alignment->gap_alignment_dim+1;
@@ -1141,24 +851,19 @@ bool Shift_right_to_left_1(char *estseq, char *genseq, int cycle, pgap_alignment
 			if(cut_factor[i] != NULL && match_str[j] != NULL){
 				size_t l1=strlen(cut_factor[i]);
 				size_t l2=strlen(prev_match_str[i]);
-				unsigned int* M=edit_distance(cut_factor[i], l1, prev_match_str[i], l2);
-				edit_prev=M[(l1+1)*(l2+1)-1];
-				pfree(M);
+				edit_prev=bp_edit_distance(cut_factor[i], l1, prev_match_str[i], l2);
 				if(edit_prev <= 5){					
 					//Per gene PKM2, lista 4916, gb=BE908023
 					if(ext_cut_factor[i] != NULL && ext_match_str[j] != NULL){
 						l1=strlen(ext_cut_factor[i]);
 						l2=strlen(ext_match_str[j]);					
-						M=edit_distance(ext_cut_factor[i], l1, ext_match_str[j], l2);					
-						error=M[(l1+1)*(l2+1)-1]-edit_prev-ext_error;
+						error=bp_edit_distance(ext_cut_factor[i], l1, ext_match_str[j], l2)-edit_prev-ext_error;
 					}
 					else{
 						l1=strlen(cut_factor[i]);
 						l2=strlen(match_str[j]);					
-						M=edit_distance(cut_factor[i], l1, match_str[j], l2);
-						error=M[(l1+1)*(l2+1)-1]-edit_prev;
+						error=bp_edit_distance(cut_factor[i], l1, match_str[j], l2)-edit_prev;
 					}				
-					pfree(M);
 				}
 			}
 			//XXX - ridiscutere questo parametro
@@ -1362,17 +1067,13 @@ bool Shift_right_to_left_2(char *estseq, char *genseq, int cycle, pgap_alignment
 			if(ext_cut_factor[i] != NULL && ext_match_str[j] != NULL){
 				size_t l1=strlen(ext_cut_factor[i]);
 				size_t l2=strlen(ext_match_str[j]);
-				unsigned int *M=edit_distance(ext_cut_factor[i], l1, ext_match_str[j], l2);
-				edit=M[(l1+1)*(l2+1)-1]-ext_error;
-				pfree(M);
+				edit=bp_edit_distance(ext_cut_factor[i], l1, ext_match_str[j], l2)-ext_error;
 			}
 			else{
 				if(cut_factor[i] != NULL && match_str[j] != NULL){
 					size_t l1=strlen(cut_factor[i]);
 					size_t l2=strlen(match_str[j]);
-					unsigned int *M=edit_distance(cut_factor[i], l1, match_str[j], l2);
-					edit=M[(l1+1)*(l2+1)-1];
-					pfree(M);
+					edit=bp_edit_distance(cut_factor[i], l1, match_str[j], l2);
 				}
 				else
 					edit=1000;
@@ -1571,25 +1272,20 @@ bool Shift_left_to_right_1(char *estseq, char *genseq, int cycle, pgap_alignment
 			if(cut_factor[i] != NULL && match_str[j] != NULL){				
 				size_t l1=strlen(cut_factor[i]);
 				size_t l2=strlen(prev_match_str[i]);
-				unsigned int *M=edit_distance(cut_factor[i], l1, prev_match_str[i], l2);
-				edit_prev=M[(l1+1)*(l2+1)-1];
-				pfree(M);
+				edit_prev=bp_edit_distance(cut_factor[i], l1, prev_match_str[i], l2);
 				if(edit_prev <= 5){
 					//Per gene PKM2, lista 4916, gb=BE908023
 					if(ext_cut_factor[i] != NULL && ext_match_str[j] != NULL){
 						l1=strlen(ext_cut_factor[i]);
 						l2=strlen(ext_match_str[j]);					
-						M=edit_distance(ext_cut_factor[i], l1, ext_match_str[j], l2);					
-						error=M[(l1+1)*(l2+1)-1]-edit_prev-ext_error;
+						error=bp_edit_distance(ext_cut_factor[i], l1, ext_match_str[j], l2)-edit_prev-ext_error;
 					}
 					else{
 						l1=strlen(cut_factor[i]);
 						l2=strlen(match_str[j]);					
-						M=edit_distance(cut_factor[i], l1, match_str[j], l2);
-						error=M[(l1+1)*(l2+1)-1]-edit_prev;
+						error=bp_edit_distance(cut_factor[i], l1, match_str[j], l2)-edit_prev;
 					}
 				
-					pfree(M);
 				}
 			}
 			//XXX - ridiscutere questo parametro
@@ -1786,17 +1482,13 @@ bool Shift_left_to_right_2(char *estseq, char *genseq, int cycle, pgap_alignment
 			if(ext_cut_factor[i] != NULL && ext_match_str[j] != NULL){
 				size_t l1=strlen(ext_cut_factor[i]);
 				size_t l2=strlen(ext_match_str[j]);
-				unsigned int *M=edit_distance(ext_cut_factor[i], l1, ext_match_str[j], l2);
-				edit=M[(l1+1)*(l2+1)-1]-ext_error;
-				pfree(M);
+				edit=bp_edit_distance(ext_cut_factor[i], l1, ext_match_str[j], l2)-ext_error;
 			}
 			else{
 				if(cut_factor[i] != NULL && match_str[j] != NULL){
 					size_t l1=strlen(cut_factor[i]);
 					size_t l2=strlen(match_str[j]);
-					unsigned int *M=edit_distance(cut_factor[i], l1, match_str[j], l2);
-					edit=M[(l1+1)*(l2+1)-1];
-					pfree(M);
+					edit=bp_edit_distance(cut_factor[i], l1, match_str[j], l2);
 				}
 				else
 					edit=1000;
@@ -39,9 +39,12 @@
 
 #include "refine.h"
 
+#include <stdint.h>
+
 #include "util.h"
 #include "log.h"
 #include "refine-intron.h"
+#include "nucleotide-codes.h"
 
 #define INDEL_COST 1
 #define MISMATCH_COST 1
@@ -82,6 +85,179 @@ unsigned int* M= NPALLOC(unsigned int, (ls1+1)*(ls2+1));
   return M;
 }
 
+// Distanza di edit con l'algoritmo bit-parallelo di Myers (nella versione
+// a blocchi di Hyyro') per l'allineamento globale.
+// Il pattern e' la stringa piu' corta ed e' rappresentato in blocchi da
+// BP_WORD_BITS righe; ogni carattere del testo aggiorna una colonna intera
+// con O(ceil(m/BP_WORD_BITS)) operazioni.
+#define BP_WORD_BITS 64
+#define BP_HIGH_BIT ((uint64_t)1 << (BP_WORD_BITS-1))
+
+unsigned int
+bp_edit_distance(const char* const s1, const size_t ls1,
+					  const char* const s2, const size_t ls2) {
+  const char* p= s1;
+  size_t m= ls1;
+  const char* t= s2;
+  size_t n= ls2;
+  if (m > n) {
+	 p= s2; m= ls2;
+	 t= s1; n= ls1;
+  }
+  if (m == 0)
+	 return (unsigned int)n;
+
+  const size_t nw= (m+BP_WORD_BITS-1)/BP_WORD_BITS;
+// Maschere dei caratteri del pattern (una riga di nw parole per simbolo
+// distinto; i simboli del testo assenti dal pattern hanno maschera nulla)
+  int sym[256];
+  for (size_t c= 0; c<256; ++c)
+	 sym[c]= -1;
+  size_t nsym= 0;
+  for (size_t i= 0; i<m; ++i) {
+	 const unsigned char c= (unsigned char)p[i];
+	 if (sym[c] < 0)
+		sym[c]= (int)nsym++;
+  }
+  uint64_t* const peq= NPALLOC(uint64_t, (nsym+1)*nw+2*nw);
+  memset(peq, 0, (nsym+1)*nw*sizeof(uint64_t));
+  for (size_t i= 0; i<m; ++i) {
+	 peq[sym[(unsigned char)p[i]]*nw + i/BP_WORD_BITS] |= (uint64_t)1 << (i%BP_WORD_BITS);
+  }
+  const uint64_t* const no_match= peq+nsym*nw;
+  uint64_t* const Pv= peq+(nsym+1)*nw;
+  uint64_t* const Mv= Pv+nw;
+  for (size_t b= 0; b<nw; ++b) {
+	 Pv[b]= ~(uint64_t)0;
+	 Mv[b]= 0;
+  }
+  const uint64_t last_bit= (uint64_t)1 << ((m-1)%BP_WORD_BITS);
+  unsigned int score= (unsigned int)m;
+  for (size_t j= 0; j<n; ++j) {
+	 const int k= sym[(unsigned char)t[j]];
+	 const uint64_t* const eq= (k < 0) ? no_match : peq+k*nw;
+// La prima riga della matrice cresce di 1 ad ogni colonna
+	 int hin= 1;
+	 for (size_t b= 0; b<nw; ++b) {
+		const uint64_t pv= Pv[b];
+		const uint64_t mv= Mv[b];
+		const uint64_t hin_neg= (hin < 0) ? 1 : 0;
+		const uint64_t xv= eq[b] | mv;
+		const uint64_t e= eq[b] | hin_neg;
+		const uint64_t xh= (((e & pv) + pv) ^ pv) | e;
+		uint64_t ph= mv | ~(xh | pv);
+		uint64_t mh= pv & xh;
+		const uint64_t out_bit= (b == nw-1) ? last_bit : BP_HIGH_BIT;
+		const int hout= ((ph & out_bit) ? 1 : 0) - ((mh & out_bit) ? 1 : 0);
+		ph= (ph << 1) | ((hin > 0) ? 1 : 0);
+		mh= (mh << 1) | hin_neg;
+		Pv[b]= mh | ~(xv | ph);
+		Mv[b]= ph & xv;
+		hin= hout;
+	 }
+	 score+= hin;
+  }
+  pfree(peq);
+  return score;
+}
+
+// Fattore comune piu' lungo con un algoritmo bit-parallelo.
+// Le posizioni di s2 sono i bit di un vettore di nw parole; per la riga i1
+// il vettore dei match e' eq(s1[i1]) e un fattore comune lungo almeno k
+// termina in (i1, i2) se e solo se il bit i2 e' attivo in
+//   AND_{d=0..k-1} (eq(s1[i1-d]) << d).
+// Poiche' la lunghezza massima cresce al piu' di 1 per riga, basta
+// verificare k= len+1, e il primo bit attivo da' la stessa occorrenza
+// (prima riga e, a parita', prima colonna) della programmazione dinamica.
+void
+bp_longest_common_factor(const char* const s1, const size_t l1,
+								 const char* const s2, const size_t l2,
+								 const bool n_always_match,
+								 size_t* const pocc1, size_t* const pocc2,
+								 size_t* const plen) {
+  *pocc1= 0;
+  *pocc2= 0;
+  *plen= 0;
+  if (l1 == 0 || l2 == 0)
+	 return;
+
+  const size_t nw= (l2+BP_WORD_BITS-1)/BP_WORD_BITS;
+  const uint64_t last_mask= (l2%BP_WORD_BITS == 0) ?
+	 ~(uint64_t)0 : (((uint64_t)1 << (l2%BP_WORD_BITS)) - 1);
+  int sym[256];
+  for (size_t c= 0; c<256; ++c)
+	 sym[c]= -1;
+  size_t nsym= 0;
+  for (size_t i= 0; i<l2; ++i) {
+	 const unsigned char c= (unsigned char)s2[i];
+	 if (sym[c] < 0)
+		sym[c]= (int)nsym++;
+  }
+// Righe: un simbolo per riga, poi le N di s2, poi tutti i bit, poi il
+// vettore di lavoro
+  uint64_t* const masks= NPALLOC(uint64_t, (nsym+3)*nw);
+  memset(masks, 0, (nsym+2)*nw*sizeof(uint64_t));
+  uint64_t* const nmask= masks+nsym*nw;
+  uint64_t* const all= masks+(nsym+1)*nw;
+  uint64_t* const V= masks+(nsym+2)*nw;
+  for (size_t i= 0; i<l2; ++i) {
+	 const uint64_t bit= (uint64_t)1 << (i%BP_WORD_BITS);
+	 masks[sym[(unsigned char)s2[i]]*nw + i/BP_WORD_BITS] |= bit;
+	 if (n_always_match && nt_is_N(s2[i]))
+		nmask[i/BP_WORD_BITS] |= bit;
+  }
+  for (size_t b= 0; b<nw; ++b)
+	 all[b]= ~(uint64_t)0;
+  all[nw-1]= last_mask;
+  if (n_always_match) {
+	 for (size_t k= 0; k<nsym; ++k)
+		for (size_t b= 0; b<nw; ++b)
+		  masks[k*nw+b]|= nmask[b];
+  }
+
+  size_t len= 0;
+  for (size_t i1= 0; i1<l1; ++i1) {
+	 if (i1 < len)
+		continue;
+// Si cerca un fattore lungo len+1 che termina in i1
+	 bool any= true;
+	 for (size_t d= 0; any && d<=len; ++d) {
+		const char c= s1[i1-d];
+		const uint64_t* eq;
+		if (n_always_match && nt_is_N(c)) {
+		  eq= all;
+		} else {
+		  const int k= sym[(unsigned char)c];
+		  eq= (k < 0) ? nmask : masks+k*nw;
+		}
+		const size_t q= d/BP_WORD_BITS;
+		const size_t r= d%BP_WORD_BITS;
+		uint64_t acc= 0;
+		for (size_t b= nw; b-- > 0; ) {
+		  uint64_t w= 0;
+		  if (b >= q) {
+			 w= eq[b-q] << r;
+			 if (r > 0 && b > q)
+				w|= eq[b-q-1] >> (BP_WORD_BITS-r);
+		  }
+		  V[b]= (d == 0) ? w : (V[b] & w);
+		  acc|= V[b];
+		}
+		any= (acc != 0);
+	 }
+	 if (any) {
+		size_t b= 0;
+		while (V[b] == 0) ++b;
+		const size_t i2= b*BP_WORD_BITS + (size_t)__builtin_ctzll(V[b]);
+		++len;
+		*plen= len;
+		*pocc1= i1+1-len;
+		*pocc2= i2+1-len;
+	 }
+  }
+  pfree(masks);
+}
+
 bool
 refine_borders(const char* const p,
 					const size_t len_p,
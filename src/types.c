@@ -139,6 +139,14 @@ pEST_info  EST_info_create(void)
   pesti->EST_strand_as_read= NULL;
   pesti->EST_strand= 1;
   pesti->fixed_strand= false;
+  pesti->abs_start= 0;
+  pesti->abs_end= 0;
+  pesti->pref_polyA_length= -1;
+  pesti->suff_polyA_length= -1;
+  pesti->pref_polyT_length= -1;
+  pesti->suff_polyT_length= -1;
+  pesti->pref_N_length= 0;
+  pesti->suff_N_length= 0;
 
   return pesti;
 }
@@ -146,7 +154,9 @@ pEST_info  EST_info_create(void)
 void EST_info_destroy(pEST_info pest_info)
 {
  if (pest_info!=NULL) {
-	 if (pest_info->original_EST_seq!=NULL)
+// La sequenza originale puo' essere condivisa con EST_seq
+	 if (pest_info->original_EST_seq!=NULL &&
+		  pest_info->original_EST_seq!=pest_info->EST_seq)
 		pfree(pest_info->original_EST_seq);
 	 if (pest_info->EST_seq!=NULL)
 		pfree(pest_info->EST_seq);
@@ -357,14 +367,15 @@ void subtree_embeddings_destroy(psubtree_embeddings pe)
   if(pe!=NULL)pfree(pe);
 }
 
-ppairing pairing_create(void) {
+// Identificatore progressivo condiviso da tutti i pairing (heap e arena)
+static int next_pairing_id= 0;
 
-  static int next_id= 0;
+ppairing pairing_create(void) {
 
   ppairing p= PALLOC(struct _pairing);
 
-  p->id= next_id;
-  ++next_id;
+// Pairings can be created concurrently by several threads
+  p->id= __sync_fetch_and_add(&next_pairing_id, 1);
 
   p->p= 0;
   p->t= 0;
@@ -372,20 +383,47 @@ ppairing pairing_create(void) {
   p->adjs= list_create();
   p->incs= list_create();
   p->visited=false;
+  p->arena_allocated=false;
+  return p;
+}
+
+/**
+ * Crea un pairing nell'arena @p a, senza liste di adiacenti e incidenti
+ * (gli archi dei MEG sono memorizzati in un pcsr_meg).
+ * Le funzioni di distruzione non deallocano la memoria di tali pairing,
+ * che viene recuperata al rilascio dell'arena.
+ **/
+ppairing pairing_create_in_arena(parena a) {
+
+  ppairing p= ARENA_PALLOC(a, struct _pairing);
+
+  p->id= __sync_fetch_and_add(&next_pairing_id, 1);
+
+  p->p= 0;
+  p->t= 0;
+  p->l= 0;
+  p->adjs= NULL;
+  p->incs= NULL;
+  p->visited=false;
+  p->arena_allocated=true;
   return p;
 }
 
 void pairing_destroy(ppairing p) {
   my_assert(p!=NULL);
-  list_destroy(p->incs, noop_free);
-  list_destroy(p->adjs, noop_free);
-  pfree(p);
+  if (p->incs!=NULL)
+	 list_destroy(p->incs, noop_free);
+  if (p->adjs!=NULL)
+	 list_destroy(p->adjs, noop_free);
+  if (!p->arena_allocated)
+	 pfree(p);
 }
 
 //Senza distruzione delle liste di adiacenti e incidenti
 void pairing_destroy_2(ppairing p) {
   my_assert(p!=NULL);
-  pfree(p);
+  if (!p->arena_allocated)
+	 pfree(p);
 }
 
 int pairing_compare(const ppairing* pp1, const ppairing* pp2) {
@@ -36,6 +36,7 @@
 #include <sys/resource.h>
 #include <sys/time.h>
 #include <unistd.h>
+#include <pthread.h>
 //#include <sys/types.h>
 //#include <sys/stat.h>
 
@@ -223,9 +224,13 @@ log_info(FILE* const logfile, char* description) {
   log_info_extended(logfile, description, NULL);
 }
 
+// log_info_extended can be called by several threads
+static pthread_mutex_t log_info_mutex= PTHREAD_MUTEX_INITIALIZER;
+
 void
 log_info_extended(FILE* const logfile, char* description, void* additional_info) {
   my_assert(logfile!=NULL);
+  pthread_mutex_lock(&log_info_mutex);
   if (description==NULL)
 	 description= "not-specified";
   char* additional_info_str= NULL;
@@ -265,4 +270,5 @@ log_info_extended(FILE* const logfile, char* description, void* additional_info)
   if (additional_info!=NULL) {
 	 pfree(additional_info_str);
   }
+  pthread_mutex_unlock(&log_info_mutex);
 }
@@ -0,0 +1,70 @@
+//gcc est-id-index_test.c -o est-id-index_test -l criterion -I '../include'
+
+#include "est-id-index.h"
+#include "util.h"
+#include "log.h"
+
+#include "../src/est-id-index.c"
+#include "../src/util.c"
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char *argv[]){
+	//for test execution
+	struct criterion_test_set *tests = criterion_initialize();
+	int result = 0;
+	if (criterion_handle_args(argc, argv, true))
+	result = !criterion_run_all_tests(tests);
+	criterion_finalize(tests);
+	return result;
+}
+
+Test(est_id_indexTest,findTest) {
+	pest_id_index idx=est_id_index_create();
+	int v[3];
+	cr_expect(est_id_index_add(idx, "EST1", &v[0]));
+	cr_expect(est_id_index_add(idx, "EST2", &v[1]));
+	cr_expect(est_id_index_add(idx, "EST3", &v[2]));
+	cr_expect(est_id_index_find(idx, "EST2")==&v[1]);
+	cr_expect(est_id_index_find(idx, "EST4")==NULL);
+	cr_expect(est_id_index_take(idx, "EST4")==NULL);
+	est_id_index_destroy(idx);
+}
+
+/*
+	the objects with the same id are returned in insertion order,
+	each of them once
+*/
+Test(est_id_indexTest,duplicateTest) {
+	pest_id_index idx=est_id_index_create();
+	int v[3];
+	cr_expect(est_id_index_add(idx, "EST1", &v[0]));
+	cr_expect(!est_id_index_add(idx, "EST1", &v[1]));
+	cr_expect(!est_id_index_add(idx, "EST1", &v[2]));
+	cr_expect(est_id_index_size(idx)==3);
+	cr_expect(est_id_index_find(idx, "EST1")==&v[0]);
+	cr_expect(est_id_index_take(idx, "EST1")==&v[0]);
+	cr_expect(est_id_index_take(idx, "EST1")==&v[1]);
+	cr_expect(est_id_index_take(idx, "EST1")==&v[2]);
+	cr_expect(est_id_index_take(idx, "EST1")==NULL);
+	cr_expect(est_id_index_find(idx, "EST1")==&v[0]);
+	est_id_index_destroy(idx);
+}
+
+Test(est_id_indexTest,growTest) {
+	pest_id_index idx=est_id_index_create();
+	char ids[5000][16];
+	for(int i=0; i<5000; ++i){
+		snprintf(ids[i], 16, "EST%d", i%4000);
+		cr_expect(est_id_index_add(idx, ids[i], ids[i])==(i<4000));
+	}
+	for(int i=0; i<4000; ++i){
+		cr_expect(est_id_index_find(idx, ids[i])==ids[i]);
+		cr_expect(est_id_index_take(idx, ids[i])==ids[i]);
+	}
+	for(int i=4000; i<5000; ++i)
+		cr_expect(est_id_index_take(idx, ids[i])==ids[i]);
+	cr_expect(est_id_index_take(idx, "EST0")==NULL);
+	est_id_index_destroy(idx);
+}
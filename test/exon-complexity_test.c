@@ -11,6 +11,7 @@
 #include <string.h>
 #include "../src/exon-complexity.c"
 #include "../src/util.c"
+#include "../src/nucleotide-codes.c"
 #include <criterion/criterion.h>
 #include <stdio.h>
 #include <stdlib.h>
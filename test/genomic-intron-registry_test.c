@@ -0,0 +1,114 @@
+//gcc genomic-intron-registry_test.c -o genomic-intron-registry_test -l criterion -I '../include'
+
+#include "genomic-intron-registry.h"
+#include "types.h"
+#include "list.h"
+#include "util.h"
+#include "log.h"
+
+#include "../src/genomic-intron-registry.c"
+#include "../src/types.c"
+#include "../src/util.c"
+#include "../src/list.c"
+#include "../src/arena.c"
+#include "../src/ext_array.c"
+#include "../src/bit_vector.c"
+#include "../src/bool_list.c"
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char *argv[]){
+	//for test execution
+	struct criterion_test_set *tests = criterion_initialize();
+	int result = 0;
+	if (criterion_handle_args(argc, argv, true))
+	result = !criterion_run_all_tests(tests);
+	criterion_finalize(tests);
+	return result;
+}
+
+Test(genomic_intron_registryTest,findTest) {
+	pgenomic_intron_registry reg=genomic_intron_registry_create(1000);
+	genomic_intron_registry_insert(reg, genomic_intron_create(10, 100));
+	genomic_intron_registry_insert(reg, genomic_intron_create(10, 200));
+	cr_expect(genomic_intron_registry_size(reg)==2);
+	pgenomic_intron gi=genomic_intron_registry_find(reg, 10, 200);
+	cr_expect(gi!=NULL && gi->start==10 && gi->end==200);
+	cr_expect(genomic_intron_registry_find(reg, 100, 10)==NULL);
+	cr_expect(genomic_intron_registry_find(reg, 10, 150)==NULL);
+	genomic_intron_registry_destroy(reg);
+}
+
+Test(genomic_intron_registryTest,listOrderTest) {
+	pgenomic_intron_registry reg=genomic_intron_registry_create(1000);
+	genomic_intron_registry_insert(reg, genomic_intron_create(10, 100));
+	genomic_intron_registry_insert(reg, genomic_intron_create(5, 50));
+	pgenomic_intron gi=(pgenomic_intron)list_head(reg->introns);
+	cr_expect(gi->start==5 && gi->end==50);
+	genomic_intron_registry_destroy(reg);
+}
+
+Test(genomic_intron_registryTest,sortedTest) {
+	pgenomic_intron_registry reg=genomic_intron_registry_create(100000);
+	srand(7);
+	for(int i=0; i<5000; ++i){
+		const int start=rand()%1000, end=start+1+rand()%1000;
+		if(genomic_intron_registry_find(reg, start, end)==NULL)
+			genomic_intron_registry_insert(reg, genomic_intron_create(start, end));
+	}
+	const size_t n=genomic_intron_registry_size(reg);
+	cr_expect(n==list_size(reg->introns));
+	pgenomic_intron* sorted=genomic_intron_registry_sorted(reg);
+	for(size_t i=1; i<n; ++i){
+		cr_expect(genomic_intron_compare(&sorted[i-1], &sorted[i])<0);
+		cr_expect(genomic_intron_registry_find(reg, sorted[i]->start, sorted[i]->end)==sorted[i]);
+	}
+	size_t lb=genomic_intron_registry_lower_bound(reg, 500, 0);
+	cr_expect(lb==n || sorted[lb]->start>=500);
+	cr_expect(lb==0 || sorted[lb-1]->start<500);
+	cr_expect(genomic_intron_registry_lower_bound(reg, 5000, 0)==n);
+	genomic_intron_registry_destroy(reg);
+}
+
+/*
+	the candidates of the index must be the introns of the list
+	that satisfy the distance conditions, in the order of the list
+*/
+Test(genomic_intron_registryTest,indexQueryTest) {
+	pgenomic_intron_registry reg=genomic_intron_registry_create(100000);
+	plist l=list_create();
+	srand(11);
+	for(int i=0; i<2000; ++i){
+		const int start=rand()%2000, end=start+1+rand()%200;
+		if(genomic_intron_registry_find(reg, start, end)==NULL){
+			pgenomic_intron gi=genomic_intron_create(start, end);
+			genomic_intron_registry_insert(reg, gi);
+			ppointer pp=pointer_create();
+			pp->pointer=gi;
+			list_add_to_tail(l, pp);
+		}
+	}
+	pgenomic_intron_index idx=genomic_intron_index_create(l);
+	for(int q=0; q<200; ++q){
+		const int start=rand()%2000, end=start+1+rand()%200;
+		for(int both=0; both<2; ++both){
+			const size_t n=genomic_intron_index_query(idx, start, end, 12, both);
+			size_t k=0;
+			plistit it=list_first(l);
+			while(listit_has_next(it)){
+				pgenomic_intron gi=(pgenomic_intron)((ppointer)listit_next(it))->pointer;
+				const bool close_start=abs(gi->start-start)<12, close_end=abs(gi->end-end)<12;
+				if(both ? (close_start && close_end) : (close_start || close_end)){
+					cr_expect(k<n && genomic_intron_index_candidate(idx, k)==gi);
+					++k;
+				}
+			}
+			listit_destroy(it);
+			cr_expect(k==n);
+		}
+	}
+	genomic_intron_index_destroy(idx);
+	list_destroy(l, (delete_function)pointer_destroy);
+	genomic_intron_registry_destroy(reg);
+}
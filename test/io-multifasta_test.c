@@ -9,8 +9,10 @@
 
 #include "../src/io-multifasta.c"
 #include "../src/list.c"
+#include "../src/arena.c"
 #include "../src/bool_list.c"
 #include "../src/util.c"
+#include "../src/nucleotide-codes.c"
 #include "../src/types.c"
 #include "../src/bit_vector.c"
 #include "../src/ext_array.c"
@@ -31,176 +33,200 @@ int main(int argc, char *argv[]){
 }
 
 /*
-	verify that the function get_Complement returns the input if it can not find the letter
+	verify that the function nt_complement returns the input if it can not find the letter
 */
 Test(ioMultifastaTest,getComplementErrorTest) {
-	cr_expect(get_Complement('z')=='z');
+	cr_expect(nt_complement('z')=='z');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest) {
-	cr_expect(get_Complement('A')=='T');
+	cr_expect(nt_complement('A')=='T');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest2) {
-	cr_expect(get_Complement('a')=='t');
+	cr_expect(nt_complement('a')=='t');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest3) {
-	cr_expect(get_Complement('T')=='A');
+	cr_expect(nt_complement('T')=='A');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest4) {
-	cr_expect(get_Complement('t')=='a');
+	cr_expect(nt_complement('t')=='a');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest5) {
-	cr_expect(get_Complement('C')=='G');
+	cr_expect(nt_complement('C')=='G');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest6) {
-	cr_expect(get_Complement('c')=='g');
+	cr_expect(nt_complement('c')=='g');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest7) {
-	cr_expect(get_Complement('G')=='C');
+	cr_expect(nt_complement('G')=='C');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest8) {
-	cr_expect(get_Complement('g')=='c');
+	cr_expect(nt_complement('g')=='c');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest9) {
-	cr_expect(get_Complement('R')=='Y');
+	cr_expect(nt_complement('R')=='Y');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest10) {
-	cr_expect(get_Complement('r')=='y');
+	cr_expect(nt_complement('r')=='y');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest11) {
-	cr_expect(get_Complement('Y')=='R');
+	cr_expect(nt_complement('Y')=='R');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest12) {
-	cr_expect(get_Complement('y')=='r');
+	cr_expect(nt_complement('y')=='r');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest13) {
-	cr_expect(get_Complement('M')=='K');
+	cr_expect(nt_complement('M')=='K');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest14) {
-	cr_expect(get_Complement('m')=='k');
+	cr_expect(nt_complement('m')=='k');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest15) {
-	cr_expect(get_Complement('K')=='M');
+	cr_expect(nt_complement('K')=='M');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest16) {
-	cr_expect(get_Complement('k')=='m');
+	cr_expect(nt_complement('k')=='m');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest17) {
-	cr_expect(get_Complement('B')=='V');
+	cr_expect(nt_complement('B')=='V');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest18) {
-	cr_expect(get_Complement('b')=='v');
+	cr_expect(nt_complement('b')=='v');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest19) {
-	cr_expect(get_Complement('V')=='B');
+	cr_expect(nt_complement('V')=='B');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest20) {
-	cr_expect(get_Complement('v')=='b');
+	cr_expect(nt_complement('v')=='b');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest21) {
-	cr_expect(get_Complement('D')=='H');
+	cr_expect(nt_complement('D')=='H');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest22) {
-	cr_expect(get_Complement('d')=='h');
+	cr_expect(nt_complement('d')=='h');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest23) {
-	cr_expect(get_Complement('H')=='D');
+	cr_expect(nt_complement('H')=='D');
 }
 
 /*
-	verify that the function get_Complement return the correct complement
+	verify that the function nt_complement return the correct complement
 */
 Test(ioMultifastaTest,getComplementTest24) {
-	cr_expect(get_Complement('h')=='d');
+	cr_expect(nt_complement('h')=='d');
+}
+
+/*
+	verify that the multi-FASTA reader joins the lines of a sequence,
+	strips the line terminators and returns an empty sequence when needed
+*/
+Test(ioMultifastaTest,multifastaReaderTest) {
+	char input[]= ">first\r\nACGT\r\nTTGA\n>second\n>third\nGG\n\nCC";
+	FILE* f= fmemopen(input, strlen(input), "r");
+	pmultifasta_reader reader= multifasta_reader_create(f);
+	struct _multifasta_record rec;
+	cr_assert(multifasta_reader_next(reader, &rec));
+	cr_expect(strcmp(rec.id, "first")==0);
+	cr_expect(strcmp(rec.seq, "ACGTTTGA")==0);
+	cr_expect(rec.seq_len==8);
+	cr_assert(multifasta_reader_next(reader, &rec));
+	cr_expect(strcmp(rec.id, "second")==0);
+	cr_expect(rec.seq_len==0);
+	cr_assert(multifasta_reader_next(reader, &rec));
+	cr_expect(strcmp(rec.id, "third")==0);
+	cr_expect(strcmp(rec.seq, "GGCC")==0);
+	cr_expect(!multifasta_reader_next(reader, &rec));
+	multifasta_reader_destroy(reader);
+	fclose(f);
 }
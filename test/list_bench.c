@@ -0,0 +1,113 @@
+//gcc -O2 -DNDEBUG list_bench.c -o list_bench -I '../include'
+//gcc -O2 -DNDEBUG -DLIST_POOL_SIZE=0 list_bench.c -o list_bench_nopool -I '../include'
+
+/*
+ * Microbenchmark of the list container.
+ * Compare the times of the two builds above (with and without the node pool)
+ * to evaluate the effect of the pool on allocation-heavy workloads.
+ */
+
+#include "list.h"
+#include "log.h"
+#include "util.h"
+
+#include "../src/list.c"
+#include "../src/arena.c"
+#include "../src/util.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define N_ELEMENTS 1000
+#define N_ROUNDS 20000
+
+static int elements[N_ELEMENTS];
+
+static double elapsed_ms(struct timespec* start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return (end.tv_sec - start->tv_sec)*1e3 + (end.tv_nsec - start->tv_nsec)/1e6;
+}
+
+/*
+	build a list with list_add_to_tail,
+	scan it with a heap iterator,
+	destroy it
+*/
+static long heap_iterator_workload(void) {
+  long sum= 0;
+  for (int r= 0; r<N_ROUNDS; ++r) {
+	 plist l= list_create();
+	 for (int i= 0; i<N_ELEMENTS; ++i)
+		list_add_to_tail(l, elements+i);
+	 plistit it= list_first(l);
+	 while (listit_has_next(it))
+		sum+= *(int*)listit_next(it);
+	 listit_destroy(it);
+	 list_destroy(l, noop_free);
+  }
+  return sum;
+}
+
+/*
+	same as above, but the list is scanned with a stack iterator
+*/
+static long stack_iterator_workload(void) {
+  long sum= 0;
+  for (int r= 0; r<N_ROUNDS; ++r) {
+	 plist l= list_create();
+	 for (int i= 0; i<N_ELEMENTS; ++i)
+		list_add_to_tail(l, elements+i);
+	 listit it;
+	 list_first_stack(l, &it);
+	 while (listit_has_next(&it))
+		sum+= *(int*)listit_next(&it);
+	 list_destroy(l, noop_free);
+  }
+  return sum;
+}
+
+/*
+	use a list as a FIFO queue and create many short-lived iterators
+*/
+static long queue_workload(void) {
+  long sum= 0;
+  plist l= list_create();
+  for (int i= 0; i<N_ELEMENTS; ++i)
+	 list_add_to_tail(l, elements+i);
+  for (int r= 0; r<N_ROUNDS*N_ELEMENTS/10; ++r) {
+	 int* p= list_remove_from_head(l);
+	 sum+= *p;
+	 list_add_to_tail(l, p);
+	 if ((r & 15) == 0) {
+		plistit it= list_first(l);
+		sum+= *(int*)listit_next(it);
+		listit_destroy(it);
+	 }
+  }
+  list_destroy(l, noop_free);
+  return sum;
+}
+
+int main(void) {
+  for (int i= 0; i<N_ELEMENTS; ++i)
+	 elements[i]= i;
+  printf("list node pool size: %d\n", LIST_POOL_SIZE);
+  struct timespec start;
+  long sum;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  sum= heap_iterator_workload();
+  printf("add_to_tail + heap iterator:  %8.1f ms (%ld)\n", elapsed_ms(&start), sum);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  sum= stack_iterator_workload();
+  printf("add_to_tail + stack iterator: %8.1f ms (%ld)\n", elapsed_ms(&start), sum);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  sum= queue_workload();
+  printf("queue (remove_from_head + add_to_tail): %8.1f ms (%ld)\n", elapsed_ms(&start), sum);
+
+  list_pool_trim();
+  return 0;
+}
@@ -6,6 +6,7 @@
 #include <stdlib.h>
 
 #include "../src/list.c"
+#include "../src/arena.c"
 #include <criterion/criterion.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -100,3 +101,49 @@ Test(listTest,removeTailEmptyTest,.signal = SIGSEGV) {
 	plist l1=list_create();
 	cr_expect(list_remove_from_tail(l1));
 }
+
+/*
+	create a list of three elements,
+	scan it backward with a stack iterator and a stack copy of it,
+	verify that the elements are returned in reverse order
+*/
+Test(listTest,stackIteratorTest) {
+	int a[3]={1,2,3};
+	plist l1=list_create();
+	for(int i=0;i<3;i++)
+		list_add_to_tail(l1,a+i);
+	listit it, it2;
+	list_last_stack(l1,&it);
+	cr_expect(*(int*)listit_prev(&it)==3);
+	listit_copy_stack(&it,&it2);
+	cr_expect(*(int*)listit_prev(&it2)==2);
+	cr_expect(*(int*)listit_prev(&it2)==1);
+	cr_expect(listit_has_prev(&it2)==0);
+	cr_expect(*(int*)listit_prev(&it)==2);
+	list_destroy(l1,NULL);
+}
+
+/*
+	create and destroy a list, so that its nodes are kept in the pool,
+	create a new list reusing them,
+	verify that the new list contains exactly the new elements,
+	release the pool
+*/
+Test(listTest,nodePoolReuseTest) {
+	int a[4]={1,2,3,4};
+	plist l1=list_create();
+	for(int i=0;i<4;i++)
+		list_add_to_tail(l1,a+i);
+	list_destroy(l1,NULL);
+	plist l2=list_create();
+	list_add_to_head(l2,a+3);
+	list_add_to_head(l2,a+2);
+	cr_expect(list_size(l2)==2);
+	cr_expect(*(int*)list_head(l2)==3);
+	cr_expect(*(int*)list_tail(l2)==4);
+	cr_expect(*(int*)list_remove_from_head(l2)==3);
+	cr_expect(*(int*)list_remove_from_head(l2)==4);
+	cr_expect(list_is_empty(l2)==1);
+	list_destroy(l2,NULL);
+	list_pool_trim();
+}
@@ -0,0 +1,200 @@
+//gcc -O2 -DNDEBUG min_factorization_bench.c -o min_factorization_bench -I '../include'
+
+/*
+ * Benchmark of the search of the minimum factorization.
+ * The branch-and-bound search (min_fact) is compared with the exhaustive
+ * search of the combinations previously used (create_combinations) on the
+ * factorizations given as arguments (files raw-multifasta-out.txt produced
+ * by est-fact, for example on the regression tests) and on random instances
+ * that mimic the alternative factorizations of the transcripts of a gene.
+ * The results must be equal.
+ *
+ * Usage: min_factorization_bench [raw-multifasta-out.txt ...]
+ */
+
+#include "min_factorization.h"
+#include "io-factorizations.h"
+#include "color_matrix.h"
+#include "log.h"
+#include "util.h"
+
+#include "../src/min_factorization.c"
+#include "../src/color_matrix.c"
+#include "../src/simplify_matrix.c"
+#include "../src/simpl_info.c"
+#include "../src/io-factorizations.c"
+#include "../src/my_time.c"
+#include "../src/util.c"
+#include "../src/list.c"
+#include "../src/arena.c"
+#include "../src/ext_array.c"
+#include "../src/types.c"
+#include "../src/bit_vector.c"
+#include "../src/bool_list.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+	random instances: the transcripts cover consecutive exons, and each
+	exon can be factorized by a few alternative (shifted) factors
+*/
+struct instance_type {
+  size_t n_exons;
+  size_t n_variants;
+  size_t n_ests;
+  size_t max_factorizations;
+  bool exhaustive;
+// time limit of the branch-and-bound search (0 means no limit)
+  unsigned int max_search_time;
+};
+
+static const struct instance_type instance_types[]= {
+  { 6, 2, 8, 3, true, 0 },
+  { 8, 2, 10, 3, true, 0 },
+  { 8, 3, 12, 4, true, 0 },
+  { 10, 2, 12, 4, true, 0 },
+  { 9, 3, 14, 4, true, 0 },
+  { 10, 3, 16, 4, false, 0 },
+  { 20, 3, 30, 4, false, 0 },
+  { 40, 3, 60, 6, false, 1 },
+};
+
+#define N_INSTANCES_PER_TYPE 5
+
+static double elapsed_ms(struct timespec* start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return (end.tv_sec - start->tv_sec)*1e3 + (end.tv_nsec - start->tv_nsec)/1e6;
+}
+
+/*
+	the search previously performed by min_fact
+*/
+static pbit_vect
+exhaustive_min_fact(plist color_matrix) {
+  pEST e=list_head(color_matrix);
+  pbit_vect bv=list_head(e->bin_factorizations);
+  pbit_vect test=BV_create(bv->n);
+  size_t start= max_of_min(color_matrix);
+  while (!create_combinations(0,start,test,color_matrix)) {
+	 start=start+1;
+  }
+  return test;
+}
+
+static bool
+BV_equal(pbit_vect bv1, pbit_vect bv2) {
+  if (bv1->n != bv2->n)
+	 return false;
+  for (size_t i= 0; i<bv1->n; ++i)
+	 if (BV_get(bv1, i) != BV_get(bv2, i))
+		return false;
+  return true;
+}
+
+/*
+	run both searches on the colored matrix and return false if the
+	results differ
+*/
+static bool
+compare_searches(const char* const name, plist color_matrix, const bool exhaustive,
+					  const unsigned int max_search_time) {
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  pbit_vect bb= min_fact_anytime(color_matrix, max_search_time);
+  const double bb_ms= elapsed_ms(&start);
+  const size_t n_factors= bb->n;
+  const int size= count_true(bb);
+  bool equal= true;
+  if (exhaustive) {
+	 clock_gettime(CLOCK_MONOTONIC, &start);
+	 pbit_vect ex= exhaustive_min_fact(color_matrix);
+	 const double ex_ms= elapsed_ms(&start);
+	 equal= BV_equal(ex, bb);
+	 printf("%-28s %4zu factors, optimum %3d: exhaustive %10.2f ms, "
+			  "branch-and-bound %8.2f ms%s\n",
+			  name, n_factors, size, ex_ms, bb_ms, equal ? "" : " DIFFERENT!");
+	 BV_destroy(ex);
+  } else {
+	 printf("%-28s %4zu factors, %s %3d: exhaustive    skipped    , "
+			  "branch-and-bound %8.2f ms\n",
+			  name, n_factors, (max_search_time > 0) ? "anytime" : "optimum",
+			  size, bb_ms);
+  }
+  BV_destroy(bb);
+  return equal;
+}
+
+static bool
+bench_file(const char* const filename) {
+  FILE* f= fopen(filename, "r");
+  if (f == NULL) {
+	 printf("Cannot open file '%s'!\n", filename);
+	 return false;
+  }
+  plist p= read_factorizations(f);
+  fclose(f);
+  plist unique_factors= color_matrix_create(p, false);
+  psimpl psimp= simplification(p, unique_factors);
+  bool equal= true;
+  if (BV_all_true(psimp->ests_ok)) {
+	 printf("%-28s solved by the simplification\n", filename);
+  } else {
+	 plist pl= color_matrix_simplified_create(p, psimp);
+	 equal= compare_searches(filename, pl, true, 0);
+	 color_matrix_simplified_destroy(pl);
+  }
+  psimpl_destroy(psimp);
+  list_destroy(unique_factors, (delete_function)factor_destroy);
+  list_destroy(p, (delete_function)EST_destroy);
+  return equal;
+}
+
+static plist
+random_instance(const struct instance_type* const t) {
+  const size_t n_factors= t->n_exons*t->n_variants;
+  plist color_matrix= list_create();
+  for (size_t e= 0; e<t->n_ests; ++e) {
+	 pEST est= EST_create();
+	 est->bin_factorizations= list_create();
+	 const size_t first= rand()%t->n_exons;
+	 const size_t last= first + rand()%(t->n_exons-first);
+	 const size_t n_fact= 1 + rand()%t->max_factorizations;
+	 for (size_t k= 0; k<n_fact; ++k) {
+		pbit_vect bv= BV_create(n_factors);
+		for (size_t x= first; x<=last; ++x)
+		  BV_set(bv, x*t->n_variants + rand()%t->n_variants, true);
+		list_add_to_tail(est->bin_factorizations, bv);
+	 }
+	 list_add_to_tail(color_matrix, est);
+  }
+  return color_matrix;
+}
+
+int main(int argc, char** argv) {
+  srand(42);
+  size_t mismatches= 0;
+  for (int i= 1; i<argc; ++i)
+	 if (!bench_file(argv[i]))
+		++mismatches;
+
+  for (size_t i= 0; i<sizeof(instance_types)/sizeof(instance_types[0]); ++i) {
+	 const struct instance_type* const t= instance_types+i;
+	 for (int k= 0; k<N_INSTANCES_PER_TYPE; ++k) {
+		char name[100];
+		snprintf(name, 100, "random %zux%zu, %zu ESTs #%d",
+					t->n_exons, t->n_variants, t->n_ests, k);
+		plist color_matrix= random_instance(t);
+		if (!compare_searches(name, color_matrix, t->exhaustive, t->max_search_time))
+		  ++mismatches;
+		list_destroy(color_matrix, (delete_function)EST_destroy);
+	 }
+  }
+
+  if (mismatches > 0) {
+	 printf("The results of the two searches differ!\n");
+	 return 1;
+  }
+  return 0;
+}
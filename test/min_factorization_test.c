@@ -7,9 +7,13 @@
 #include <stdint.h>
 
 #include "../src/min_factorization.c"
+#include "../src/color_matrix.c"
+#include "../src/simplify_matrix.c"
+#include "../src/simpl_info.c"
 #include "../src/my_time.c"
 #include "../src/util.c"
 #include "../src/list.c"
+#include "../src/arena.c"
 #include "../src/ext_array.c"
 #include "../src/types.c"
 #include <criterion/criterion.h>
@@ -129,3 +133,138 @@ Test(min_factorizationTest,count_true_test6) {
 	BV_set(v1,4,1);
 	cr_expect(count_true(v1)==2);
 }
+
+/*
+	add to the colored matrix an EST whose factorizations are given
+	as strings of '0' and '1'
+*/
+static void add_est(plist color_matrix, const char* const* facts, int n_facts) {
+	pEST est=EST_create();
+	est->bin_factorizations=list_create();
+	for (int i=0; i<n_facts; ++i) {
+		pbit_vect bv=BV_create(strlen(facts[i]));
+		for (unsigned int j=0; j<bv->n; ++j)
+			BV_set(bv,j,facts[i][j]=='1');
+		list_add_to_tail(est->bin_factorizations,bv);
+	}
+	list_add_to_tail(color_matrix,est);
+}
+
+static pbit_vect exhaustive_search(plist color_matrix) {
+	pEST e=list_head(color_matrix);
+	pbit_vect bv=list_head(e->bin_factorizations);
+	pbit_vect comb=BV_create(bv->n);
+	int k=max_of_min(color_matrix);
+	while (!create_combinations(0,k,comb,color_matrix))
+		++k;
+	return comb;
+}
+
+/*
+	three ESTs with alternative factorizations,
+	verify that the branch-and-bound search finds the minimum set of factors
+	found by the exhaustive search
+*/
+Test(min_factorizationTest,min_fact_test1) {
+	plist cm=list_create();
+	const char* e1[]={ "110000", "011000" };
+	const char* e2[]={ "000110", "001100" };
+	const char* e3[]={ "100001", "010100" };
+	add_est(cm,e1,2);
+	add_est(cm,e2,2);
+	add_est(cm,e3,2);
+	pbit_vect ex=exhaustive_search(cm);
+	pbit_vect bb=min_fact(cm);
+	cr_expect(count_true(bb)==3);
+	cr_expect(BV_comp(ex,bb));
+	BV_destroy(ex);
+	BV_destroy(bb);
+	list_destroy(cm,(delete_function)EST_destroy);
+}
+
+/*
+	a dominated factorization and a dominated EST,
+	verify that the result is the same of the exhaustive search
+*/
+Test(min_factorizationTest,min_fact_test2) {
+	plist cm=list_create();
+	const char* e1[]={ "11100", "10000", "00011" };
+	const char* e2[]={ "10010", "00011" };
+	const char* e3[]={ "00100", "01000" };
+	add_est(cm,e1,3);
+	add_est(cm,e2,2);
+	add_est(cm,e3,2);
+	pbit_vect ex=exhaustive_search(cm);
+	pbit_vect bb=min_fact(cm);
+	cr_expect(BV_comp(ex,bb));
+	BV_destroy(ex);
+	BV_destroy(bb);
+	list_destroy(cm,(delete_function)EST_destroy);
+}
+
+/*
+	every EST is factorized without any factor,
+	verify that, as the exhaustive search, the first factor is chosen
+*/
+Test(min_factorizationTest,min_fact_test3) {
+	plist cm=list_create();
+	const char* e1[]={ "0110", "0000" };
+	const char* e2[]={ "0000" };
+	add_est(cm,e1,2);
+	add_est(cm,e2,1);
+	pbit_vect ex=exhaustive_search(cm);
+	pbit_vect bb=min_fact(cm);
+	cr_expect(BV_get(bb,0));
+	cr_expect(count_true(bb)==1);
+	cr_expect(BV_comp(ex,bb));
+	BV_destroy(ex);
+	BV_destroy(bb);
+	list_destroy(cm,(delete_function)EST_destroy);
+}
+
+/*
+	verify that the solution of the search with a time limit
+	factorizes every EST
+*/
+Test(min_factorizationTest,min_fact_anytime_test1) {
+	plist cm=list_create();
+	const char* e1[]={ "1100000000", "0110000000" };
+	const char* e2[]={ "0001100000", "0000110000" };
+	const char* e3[]={ "0000001110", "1000000001" };
+	add_est(cm,e1,2);
+	add_est(cm,e2,2);
+	add_est(cm,e3,2);
+	pbit_vect bb=min_fact_anytime(cm,1);
+	cr_expect(evaluate_combination(bb,cm));
+	BV_destroy(bb);
+	list_destroy(cm,(delete_function)EST_destroy);
+}
+
+/*
+	the greedy solution ({0,3,4}) is not minimum ({1,2}),
+	search with an already expired time limit,
+	verify that the search is interrupted and that the greedy solution,
+	which factorizes every EST, is returned
+*/
+Test(min_factorizationTest,min_fact_anytime_expired_test) {
+	plist cm=list_create();
+	const char* e1[]={ "100000", "011000" };
+	const char* e2[]={ "000100", "010000" };
+	const char* e3[]={ "000010", "001000" };
+	add_est(cm,e1,2);
+	add_est(cm,e2,2);
+	add_est(cm,e3,2);
+	pmytime_timeout timeout=MYTIME_timeout_create(1);
+	timeout->expired=true;
+	pbit_vect bb=mf_anytime_search(cm,timeout,1);
+	MYTIME_timeout_destroy(timeout);
+	cr_expect(evaluate_combination(bb,cm));
+	cr_expect(count_true(bb)==3);
+	cr_expect(BV_get(bb,0) && BV_get(bb,3) && BV_get(bb,4));
+	pbit_vect opt=min_fact_anytime(cm,1);
+	cr_expect(evaluate_combination(opt,cm));
+	cr_expect(count_true(opt)==2);
+	BV_destroy(opt);
+	BV_destroy(bb);
+	list_destroy(cm,(delete_function)EST_destroy);
+}
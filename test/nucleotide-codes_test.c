@@ -0,0 +1,118 @@
+//gcc nucleotide-codes_test.c -o nucleotide-codes_test -l criterion -I '/home/lorenzo/PIntron/include'
+
+#include "util.h"
+#include "log.h"
+#include "nucleotide-codes.h"
+
+#include <string.h>
+#include "../src/util.c"
+#include "../src/nucleotide-codes.c"
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char *argv[]){
+	//for test execution
+	struct criterion_test_set *tests = criterion_initialize();
+	int result = 0;
+	if (criterion_handle_args(argc, argv, true))
+	result = !criterion_run_all_tests(tests);
+	criterion_finalize(tests);
+	return result;
+}
+
+/*
+	pack the sequence s,
+	verify that each symbol and the whole sequence are restored
+*/
+static void check_packing(const char* s) {
+	ppacked_seq p=packed_seq_create(s);
+	cr_expect(p->length==strlen(s));
+	for (size_t i=0; i<p->length; ++i) {
+		cr_expect(packed_seq_get(p,i)==s[i]);
+	}
+	char* u=packed_seq_unpack(p);
+	cr_expect(strcmp(u,s)==0);
+	pfree(u);
+	packed_seq_destroy(p);
+}
+
+/*
+	the nucleotides are packed in words of 32 symbols,
+	verify sequences shorter and longer than a word
+*/
+Test(nucleotideCodesTest,packUppercaseTest) {
+	check_packing("ACGT");
+	check_packing("ACGTTGCAACGTTGCAACGTTGCAACGTTGCA");
+	check_packing("ACGTTGCAACGTTGCAACGTTGCAACGTTGCAG");
+	check_packing("GATTACAGATTACAGATTACAGATTACAGATTACAGATTACAGATTACAGATTACAGATTACA");
+}
+
+/*
+	verify that the case of the symbols is preserved
+*/
+Test(nucleotideCodesTest,packCaseTest) {
+	check_packing("acgtACGTacgtACGTacgtACGTacgtACGTacgtACGTaaaaa");
+	check_packing("aCgTccAAtGTaC");
+	check_packing("t");
+}
+
+/*
+	verify that the runs of N (uppercase and lowercase) are preserved
+*/
+Test(nucleotideCodesTest,packNTest) {
+	check_packing("NNNNACGTNNNNnnnnACGTnNnN");
+	check_packing("NNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNN");
+	check_packing("acgtn");
+}
+
+/*
+	verify that the symbols different from the nucleotides are preserved
+*/
+Test(nucleotideCodesTest,packExceptionsTest) {
+	check_packing("ACRYGTmkACGT-ACGTBDHV*acgt");
+	check_packing("");
+}
+
+/*
+	pack a sequence with long runs of N and of lowercase symbols,
+	verify that it takes about 2 bits for each symbol
+*/
+Test(nucleotideCodesTest,packSizeTest) {
+	const size_t n=100000;
+	char* s=NPALLOC(char, n+1);
+	for (size_t i=0; i<n; ++i) {
+		s[i]="ACGT"[(i*7+i/3)%4];
+		if (i<1000 || i>=n-1000)
+			s[i]='N';
+		else if ((i/5000)%2==1)
+			s[i]=s[i]-'A'+'a';
+	}
+	s[n]='\0';
+	ppacked_seq p=packed_seq_create(s);
+	cr_expect(packed_seq_size(p)<=n/4+1024);
+	char* u=packed_seq_unpack(p);
+	cr_expect(strcmp(u,s)==0);
+	pfree(u);
+	packed_seq_destroy(p);
+	pfree(s);
+}
+
+/*
+	unpack a range of the sequence,
+	verify that it is the corresponding substring
+*/
+Test(nucleotideCodesTest,unpackRangeTest) {
+	const char* s="NNacgtACGTNNRYacgtnnACGTTGCAACGTTGCAACGTTGCAAcgt";
+	ppacked_seq p=packed_seq_create(s);
+	char buf[64];
+	const size_t len=strlen(s);
+	for (size_t start=0; start<len; ++start) {
+		for (size_t l=0; start+l<=len; ++l) {
+			packed_seq_unpack_range(p,start,l,buf);
+			cr_expect(strncmp(buf,s+start,l)==0);
+			cr_expect(buf[l]=='\0');
+		}
+	}
+	packed_seq_destroy(p);
+}
@@ -4,7 +4,9 @@
 #include "../src/refine.c"
 #include "../src/refine-intron.c"
 #include "../src/util.c"
+#include "../src/nucleotide-codes.c"
 #include "../src/list.c"
+#include "../src/arena.c"
 #include "../src/types.c"
 #include "../src/bit_vector.c"
 #include "../src/bool_list.c"
@@ -86,14 +88,27 @@ Test(refineIntronTest,checkBursetPatternsTest4) {
 }
 
 /*
-	create variables needed for the function getBursetFrequency,
-	set these variables with wrong values,
-	verify that this will cause a failure
+	verify that getBursetFrequency reads only the first two symbols
+	of the (read-only) patterns, without changing them
 */
-Test(refineIntronTest,getBursetFrequencyErrorTest,.signal = SIGSEGV) {
-	char *gsd="acctgaaagtacagtaaac";
-	char *gsa="acctgaaagtacagtaaac";
-	cr_expect(getBursetFrequency(gsd,gsa));
+Test(refineIntronTest,getBursetFrequencyReadOnlyTest) {
+	const char *gsd="acctgaaagtacagtaaac";
+	const char *gsa="acctgaaagtacagtaaac";
+	cr_expect(getBursetFrequency(gsd,gsa)==0);
+	cr_expect(strcmp(gsd, "acctgaaagtacagtaaac")==0);
+}
+
+/*
+	verify that the frequencies of the patterns do not depend on the case
+	and that the patterns with other symbols have frequency 0
+*/
+Test(refineIntronTest,getBursetFrequencyCaseTest) {
+	cr_expect(getBursetFrequency("gt","ag")==200);
+	cr_expect(getBursetFrequency("Gc","aG")==126);
+	cr_expect(getBursetFrequency("gn","ag")==0);
+	cr_expect(getBursetFrequency("g","ag")==0);
+	cr_expect(getBursetFrequency_adaptor("aaGTccccAGaa", 2, 10)==200);
+	cr_expect(Check_Burset_patterns("aaGTccccAGaa", 1, 10)==200);
 }
 
 /*
@@ -920,3 +935,25 @@ Test(refineIntronTest,getBursetFrequencyTest60) {
 	asprintf(&gsa, "GG");
 	cr_expect(getBursetFrequency(gsd,gsa)==1);
 }
+
+/*
+	create an EST that skips an intron of the genomic region,
+	verify that the function compute_gap_alignment places the gap
+	on the intron and returns the correct cut positions
+*/
+Test(refineIntronTest,computeGapAlignmentTest) {
+	char est[]="ctgaccgtactgcaggt";
+	char gen[]="ctgaccgtagtaagttttcagctgcaggt";
+	plist alignments=compute_gap_alignment(est, gen, true, 0, 0, 0);
+	cr_assert(list_size(alignments)==1);
+	pgap_alignment alignment=list_head(alignments);
+	cr_expect(strcmp(alignment->EST_gap_alignment, "ctgaccgta------------ctgcaggt")==0);
+	cr_expect(strcmp(alignment->GEN_gap_alignment, gen)==0);
+	cr_expect(alignment->gap_alignment_dim==29);
+	cr_expect(alignment->factor_cut==9);
+	cr_expect(alignment->intron_start==9);
+	cr_expect(alignment->intron_end==20);
+	cr_expect(alignment->intron_start_on_align==9);
+	cr_expect(alignment->intron_end_on_align==20);
+	list_destroy(alignments, (delete_function)gap_alignment_destroy);
+}
@@ -0,0 +1,158 @@
+//gcc -O2 -DNDEBUG refine_bench.c -o refine_bench -I '../include' -I '../stree_src'
+
+/*
+ * Microbenchmark of the edit distance and longest common factor kernels
+ * used by the factorization refinement.
+ * The bit-parallel versions are compared with the quadratic dynamic
+ * programming on pairs of sequences with the typical lengths of
+ * exons and of the regions around them; the results must be equal.
+ */
+
+#include "refine.h"
+#include "log.h"
+#include "util.h"
+
+#include "../src/refine.c"
+#include "../src/refine-intron.c"
+#include "../src/util.c"
+#include "../src/nucleotide-codes.c"
+#include "../src/list.c"
+#include "../src/arena.c"
+#include "../src/types.c"
+#include "../src/bit_vector.c"
+#include "../src/bool_list.c"
+#include "../src/ext_array.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define N_PAIRS 2000
+#define MIN_LEN 20
+#define MAX_LEN 400
+
+static char* seq1[N_PAIRS];
+static char* seq2[N_PAIRS];
+
+static double elapsed_ms(struct timespec* start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return (end.tv_sec - start->tv_sec)*1e3 + (end.tv_nsec - start->tv_nsec)/1e6;
+}
+
+/*
+	the quadratic dynamic programming previously used by
+	find_longest_common_factor_dp ('n' and 'N' always match)
+*/
+static void
+dp_longest_common_factor(const char* const s1, const size_t l1,
+								 const char* const s2, const size_t l2,
+								 size_t* const pocc1, size_t* const pocc2,
+								 size_t* const plen) {
+  size_t* curr= NPALLOC(size_t, l2+1);
+  size_t* prev= NPALLOC(size_t, l2+1);
+  size_t* swap= NULL;
+  *pocc1= *pocc2= *plen= 0;
+  for (size_t i2= 0; i2<=l2; ++i2)
+	 prev[i2]= 0;
+  for (size_t i1= 0; i1<l1; ++i1) {
+	 curr[0]= 0;
+	 const bool is_s1_i1_a_n= (s1[i1]=='n') || (s1[i1]=='N');
+	 for (size_t i2= 0; i2<l2; ++i2) {
+		if (!is_s1_i1_a_n && (s2[i2] != 'n') && (s2[i2] != 'N') &&
+			 (s1[i1] != s2[i2])) {
+		  curr[i2+1]= 0;
+		} else {
+		  curr[i2+1]= 1 + prev[i2];
+		}
+		if (*plen < curr[i2+1]) {
+		  *plen= curr[i2+1];
+		  *pocc1= i1+1-*plen;
+		  *pocc2= i2+1-*plen;
+		}
+	 }
+	 swap= curr; curr= prev; prev= swap;
+  }
+  pfree(curr);
+  pfree(prev);
+}
+
+/*
+	a random sequence and, half of the times, a copy of it
+	with a few substitutions and indels (as an exon and its transcript)
+*/
+static void generate_pairs(void) {
+  const char* const alph= "acgt";
+  for (int k= 0; k<N_PAIRS; ++k) {
+	 const size_t l1= MIN_LEN + rand()%(MAX_LEN-MIN_LEN);
+	 seq1[k]= NPALLOC(char, l1+1);
+	 for (size_t i= 0; i<l1; ++i)
+		seq1[k][i]= (rand()%100==0) ? 'n' : alph[rand()%4];
+	 seq1[k][l1]= '\0';
+	 seq2[k]= NPALLOC(char, 2*MAX_LEN+1);
+	 size_t l2= 0;
+	 if (k%2==0) {
+		for (size_t i= 0; i<l1; ++i) {
+		  const int r= rand()%50;
+		  if (r==0) continue;
+		  seq2[k][l2++]= (r==1) ? alph[rand()%4] : seq1[k][i];
+		  if (r==2) seq2[k][l2++]= alph[rand()%4];
+		}
+	 } else {
+		const size_t l= MIN_LEN + rand()%(MAX_LEN-MIN_LEN);
+		for (; l2<l; ++l2)
+		  seq2[k][l2]= alph[rand()%4];
+	 }
+	 seq2[k][l2]= '\0';
+  }
+}
+
+int main(void) {
+  srand(42);
+  generate_pairs();
+  struct timespec start;
+  unsigned long sum_dp= 0, sum_bp= 0;
+  size_t mismatches= 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int k= 0; k<N_PAIRS; ++k) {
+	 const size_t l1= strlen(seq1[k]), l2= strlen(seq2[k]);
+	 unsigned int* M= edit_distance(seq1[k], l1, seq2[k], l2);
+	 sum_dp+= M[(l1+1)*(l2+1)-1];
+	 pfree(M);
+  }
+  printf("edit distance, matrix:        %8.1f ms (%lu)\n", elapsed_ms(&start), sum_dp);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int k= 0; k<N_PAIRS; ++k)
+	 sum_bp+= bp_edit_distance(seq1[k], strlen(seq1[k]), seq2[k], strlen(seq2[k]));
+  printf("edit distance, bit-parallel:  %8.1f ms (%lu)\n", elapsed_ms(&start), sum_bp);
+  if (sum_dp != sum_bp)
+	 ++mismatches;
+
+  sum_dp= sum_bp= 0;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int k= 0; k<N_PAIRS; ++k) {
+	 size_t o1, o2, l;
+	 dp_longest_common_factor(seq1[k], strlen(seq1[k]), seq2[k], strlen(seq2[k]), &o1, &o2, &l);
+	 sum_dp+= l + 3*o1 + 7*o2;
+  }
+  printf("longest common factor, DP:    %8.1f ms (%lu)\n", elapsed_ms(&start), sum_dp);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int k= 0; k<N_PAIRS; ++k) {
+	 size_t o1, o2, l;
+	 bp_longest_common_factor(seq1[k], strlen(seq1[k]), seq2[k], strlen(seq2[k]), true, &o1, &o2, &l);
+	 sum_bp+= l + 3*o1 + 7*o2;
+  }
+  printf("longest common factor, b-p:   %8.1f ms (%lu)\n", elapsed_ms(&start), sum_bp);
+  if (sum_dp != sum_bp)
+	 ++mismatches;
+
+  for (int k= 0; k<N_PAIRS; ++k) {
+	 pfree(seq1[k]);
+	 pfree(seq2[k]);
+  }
+  if (mismatches > 0) {
+	 printf("The results of the two implementations differ!\n");
+	 return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,270 @@
+//gcc refine_test.c -o refine_test -l criterion -I '/home/lorenzo/PIntron/include' -I '/home/lorenzo/PIntron/stree_src'
+
+#define _GNU_SOURCE
+#include "../src/refine.c"
+#include "../src/refine-intron.c"
+#include "../src/util.c"
+#include "../src/nucleotide-codes.c"
+#include "../src/list.c"
+#include "../src/arena.c"
+#include "../src/types.c"
+#include "../src/bit_vector.c"
+#include "../src/bool_list.c"
+#include "../src/ext_array.c"
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "refine.h"
+#include "util.h"
+#include "log.h"
+
+int main(int argc, char *argv[]){
+	//for test execution
+	struct criterion_test_set *tests = criterion_initialize();
+	int result = 0;
+	if (criterion_handle_args(argc, argv, true))
+	result = !criterion_run_all_tests(tests);
+	criterion_finalize(tests);
+	return result;
+}
+
+/*
+	edit distance computed by the quadratic dynamic programming
+	(last cell of the matrix of edit_distance)
+*/
+static unsigned int dp_edit_distance(const char* s1, const char* s2) {
+	const size_t l1=strlen(s1), l2=strlen(s2);
+	unsigned int* M=edit_distance(s1,l1,s2,l2);
+	const unsigned int d=M[(l1+1)*(l2+1)-1];
+	pfree(M);
+	return d;
+}
+
+/*
+	longest common factor computed by the quadratic dynamic programming,
+	the first occurrence on s1 and then on s2 is returned
+*/
+static void dp_longest_common_factor(const char* s1, const char* s2,
+												 const bool n_always_match,
+												 size_t* pocc1, size_t* pocc2, size_t* plen) {
+	const size_t l1=strlen(s1), l2=strlen(s2);
+	size_t* prev=NPALLOC(size_t, l2+1);
+	size_t* curr=NPALLOC(size_t, l2+1);
+	*pocc1=*pocc2=*plen=0;
+	for (size_t i2=0; i2<=l2; ++i2)
+		prev[i2]=0;
+	for (size_t i1=0; i1<l1; ++i1) {
+		curr[0]=0;
+		for (size_t i2=0; i2<l2; ++i2) {
+			const bool match=(s1[i1]==s2[i2]) ||
+				(n_always_match && (nt_is_N(s1[i1]) || nt_is_N(s2[i2])));
+			curr[i2+1]=match ? prev[i2]+1 : 0;
+			if (*plen<curr[i2+1]) {
+				*plen=curr[i2+1];
+				*pocc1=i1+1-*plen;
+				*pocc2=i2+1-*plen;
+			}
+		}
+		size_t* swap=curr; curr=prev; prev=swap;
+	}
+	pfree(prev);
+	pfree(curr);
+}
+
+/*
+	random sequence of length len on the alphabet alph
+*/
+static char* random_seq(const size_t len, const char* alph) {
+	const size_t n=strlen(alph);
+	char* s=NPALLOC(char, len+1);
+	for (size_t i=0; i<len; ++i)
+		s[i]=alph[rand()%n];
+	s[len]='\0';
+	return s;
+}
+
+/*
+	copy of s with a few substitutions, insertions and deletions
+*/
+static char* mutate_seq(const char* s, const char* alph) {
+	const size_t n=strlen(alph);
+	const size_t len=strlen(s);
+	char* m=NPALLOC(char, 2*len+1);
+	size_t l=0;
+	for (size_t i=0; i<len; ++i) {
+		const int r=rand()%20;
+		if (r==0) continue;
+		m[l++]=(r==1) ? alph[rand()%n] : s[i];
+		if (r==2) m[l++]=alph[rand()%n];
+	}
+	m[l]='\0';
+	return m;
+}
+
+static void check_edit_distance(const char* s1, const char* s2) {
+	const unsigned int d=dp_edit_distance(s1,s2);
+	cr_expect(bp_edit_distance(s1,strlen(s1),s2,strlen(s2))==d,
+				 "edit distance of '%s' and '%s'", s1, s2);
+	cr_expect(bp_edit_distance(s2,strlen(s2),s1,strlen(s1))==d,
+				 "edit distance of '%s' and '%s'", s2, s1);
+}
+
+static void check_longest_common_factor(const char* s1, const char* s2,
+													 const bool n_always_match) {
+	size_t o1, o2, l, bo1, bo2, bl;
+	dp_longest_common_factor(s1,s2,n_always_match,&o1,&o2,&l);
+	bp_longest_common_factor(s1,strlen(s1),s2,strlen(s2),n_always_match,&bo1,&bo2,&bl);
+	cr_expect(bl==l && bo1==o1 && bo2==o2,
+				 "longest common factor of '%s' and '%s': (%zu,%zu,%zu) instead of (%zu,%zu,%zu)",
+				 s1, s2, bo1, bo2, bl, o1, o2, l);
+}
+
+/*
+	the pattern of the edit distance is the shortest string and it is
+	split in words of 64 symbols,
+	compare with the dynamic programming on patterns of one, two and
+	three words (and on the lengths at the word boundaries)
+*/
+Test(refineTest,bpEditDistanceMultiWordTest) {
+	srand(1);
+	const size_t lens[]={1, 5, 63, 64, 65, 100, 127, 128, 129, 150, 192, 193, 300};
+	for (size_t k=0; k<sizeof(lens)/sizeof(lens[0]); ++k) {
+		for (int rep=0; rep<5; ++rep) {
+			char* s1=random_seq(lens[k],"acgt");
+			char* s2=mutate_seq(s1,"acgt");
+			char* s3=random_seq(lens[k]+rand()%50,"acgt");
+			check_edit_distance(s1,s2);
+			check_edit_distance(s1,s3);
+			pfree(s1);
+			pfree(s2);
+			pfree(s3);
+		}
+	}
+}
+
+/*
+	verify that the edit distance from the empty string is the length
+	of the other string
+*/
+Test(refineTest,bpEditDistanceEmptyTest) {
+	cr_expect(bp_edit_distance("",0,"",0)==0);
+	cr_expect(bp_edit_distance("",0,"acgt",4)==4);
+	cr_expect(bp_edit_distance("acgt",4,"",0)==4);
+	check_edit_distance("","acgtacgt");
+}
+
+/*
+	the text of the longest common factor (s2) is split in words of 64
+	symbols,
+	compare with the dynamic programming on texts of one, two and three
+	words and on common factors longer than a word
+*/
+Test(refineTest,bpLongestCommonFactorMultiWordTest) {
+	srand(2);
+	const size_t lens[]={1, 5, 63, 64, 65, 100, 127, 128, 129, 150, 192, 193, 300};
+	for (size_t k=0; k<sizeof(lens)/sizeof(lens[0]); ++k) {
+		for (int rep=0; rep<5; ++rep) {
+			char* s1=random_seq(lens[k],"acgt");
+			char* s2=random_seq(lens[k]+rand()%50,"acgt");
+			char* s3=NPALLOC(char, strlen(s1)+strlen(s2)+1);
+			// s1 is a factor of s3, not aligned to the words
+			strcpy(s3,s2);
+			strcpy(s3+rand()%(strlen(s2)+1),s1);
+			check_longest_common_factor(s1,s2,false);
+			check_longest_common_factor(s1,s3,false);
+			check_longest_common_factor(s3,s1,false);
+			check_longest_common_factor(s1,s3,true);
+			pfree(s1);
+			pfree(s2);
+			pfree(s3);
+		}
+	}
+}
+
+/*
+	verify that there is no common factor if a string is empty
+*/
+Test(refineTest,bpLongestCommonFactorEmptyTest) {
+	size_t o1=1, o2=1, l=1;
+	bp_longest_common_factor("",0,"acgt",4,true,&o1,&o2,&l);
+	cr_expect(o1==0 && o2==0 && l==0);
+	o1=o2=l=1;
+	bp_longest_common_factor("acgt",4,"",0,false,&o1,&o2,&l);
+	cr_expect(o1==0 && o2==0 && l==0);
+	o1=o2=l=1;
+	bp_longest_common_factor("",0,"",0,true,&o1,&o2,&l);
+	cr_expect(o1==0 && o2==0 && l==0);
+}
+
+/*
+	put 'n' and 'N' in both strings,
+	verify that they match any symbol only if n_always_match is true
+*/
+Test(refineTest,bpLongestCommonFactorNTest) {
+	size_t o1, o2, l;
+	bp_longest_common_factor("ttNcgt",6,"aaacngtaa",9,true,&o1,&o2,&l);
+	cr_expect(l==4 && o1==2 && o2==3);
+	bp_longest_common_factor("ttNcgt",6,"aaacngtaa",9,false,&o1,&o2,&l);
+	cr_expect(l==2 && o1==4 && o2==5);
+	bp_longest_common_factor("NNNN",4,"nnnn",4,true,&o1,&o2,&l);
+	cr_expect(l==4 && o1==0 && o2==0);
+	bp_longest_common_factor("NNNN",4,"nnnn",4,false,&o1,&o2,&l);
+	cr_expect(l==0);
+	check_longest_common_factor("acNgtnnacgt","ttnacgtNacgtaa",true);
+	check_longest_common_factor("acNgtnnacgt","ttnacgtNacgtaa",false);
+
+	srand(3);
+	const size_t lens[]={10, 70, 140};
+	for (size_t k=0; k<sizeof(lens)/sizeof(lens[0]); ++k) {
+		for (int rep=0; rep<10; ++rep) {
+			char* s1=random_seq(lens[k],"acgtnN");
+			char* s2=random_seq(lens[k]+rand()%30,"acgtnN");
+			check_longest_common_factor(s1,s2,true);
+			check_longest_common_factor(s1,s2,false);
+			check_longest_common_factor(s2,s1,true);
+			pfree(s1);
+			pfree(s2);
+		}
+	}
+}
+
+/*
+	strings with several longest common factors,
+	verify that the occurrence returned is the one of the dynamic
+	programming (the first ending on s1 and then on s2)
+*/
+Test(refineTest,bpLongestCommonFactorTieTest) {
+	size_t o1, o2, l;
+	bp_longest_common_factor("acgxacg",7,"yacgyacgy",9,false,&o1,&o2,&l);
+	cr_expect(l==3 && o1==0 && o2==1);
+	bp_longest_common_factor("ccaattgg",8,"ggttaacc",8,false,&o1,&o2,&l);
+	cr_expect(l==2 && o1==0 && o2==6);
+	check_longest_common_factor("ccaattgg","ggttaacc",false);
+
+	// the two occurrences on s2 are in the first and in the third word
+	char s2[200];
+	memset(s2,'y',sizeof(s2));
+	memcpy(s2+10,"acgt",4);
+	memcpy(s2+150,"acgt",4);
+	s2[199]='\0';
+	bp_longest_common_factor("zacgtz",6,s2,199,false,&o1,&o2,&l);
+	cr_expect(l==4 && o1==1 && o2==10);
+
+	srand(4);
+	const size_t lens[]={8, 50, 70, 130};
+	for (size_t k=0; k<sizeof(lens)/sizeof(lens[0]); ++k) {
+		for (int rep=0; rep<20; ++rep) {
+			char* s1=random_seq(lens[k],"ab");
+			char* s2=random_seq(lens[k]+rand()%10,"ab");
+			char* s3=random_seq(3*lens[k]+100,"ab");
+			check_longest_common_factor(s1,s2,false);
+			check_longest_common_factor(s2,s1,false);
+			check_longest_common_factor(s1,s3,false);
+			pfree(s1);
+			pfree(s2);
+			pfree(s3);
+		}
+	}
+}
@@ -10,6 +10,7 @@
 #include "../src/my_time.c"
 #include "../src/util.c"
 #include "../src/list.c"
+#include "../src/arena.c"
 #include "../src/ext_array.c"
 #include "../src/types.c"
 #include <criterion/criterion.h>
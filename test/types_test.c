@@ -6,6 +6,7 @@
 #include "../src/my_time.c"
 #include "../src/util.c"
 #include "../src/list.c"
+#include "../src/arena.c"
 #include "../src/ext_array.c"
 #include <criterion/criterion.h>
 #include <stdio.h>
@@ -86,6 +87,21 @@ Test(typesTest,estInfoTest) {
 	EST_info_destroy(pei1);
 }
 
+/*
+	create an EST_info and verify that the lengths of the
+	removed tails are initialized (no polyA/T and no N tails)
+*/
+Test(typesTest,estInfoInitTest) {
+	pEST_info pei1=EST_info_create();
+	cr_assert(pei1->pref_polyA_length == -1);
+	cr_assert(pei1->suff_polyA_length == -1);
+	cr_assert(pei1->pref_polyT_length == -1);
+	cr_assert(pei1->suff_polyT_length == -1);
+	cr_assert(pei1->pref_N_length == 0);
+	cr_assert(pei1->suff_N_length == 0);
+	EST_info_destroy(pei1);
+}
+
 /*
 	create an empty factorization,
 	try to destroy it and verify that this will work correctly